@@ -30,17 +30,11 @@
 #ifdef HAVE_TIME_H
 #include <time.h>
 #endif
-#ifdef HAVE_STDIO_H
-#include <stdio.h>
-#endif
 
 #include <exo/exo.h>
 
 #include <thunar-sbr/thunar-sbr-date-renamer.h>
-
-#ifdef HAVE_EXIF
-#include <libexif/exif-data.h>
-#endif
+#include <thunar-sbr/thunar-sbr-exif-cache.h>
 
 
 
@@ -67,15 +61,14 @@ static void    thunar_sbr_date_renamer_set_property (GObject                   *
                                                      GParamSpec                *pspec);
 static gchar  *thunar_sbr_get_time_string           (guint64                    file_time,
                                                      const gchar               *custom_format);
-#ifdef HAVE_EXIF
-static guint64 thunar_sbr_get_time_from_string      (const gchar               *string);
-#endif
 static guint64 thunar_sbr_get_time                  (ThunarxFileInfo           *file,
                                                      ThunarSbrDateMode          mode);
 static gchar  *thunar_sbr_date_renamer_process      (ThunarxRenamer            *renamer,
                                                      ThunarxFileInfo           *file,
                                                      const gchar               *text,
                                                      guint                      idx);
+static void    thunar_sbr_date_renamer_prepare      (ThunarxRenamer            *renamer,
+                                                     GList                     *files);
 
 
 
@@ -112,6 +105,7 @@ thunar_sbr_date_renamer_class_init (ThunarSbrDateRenamerClass *klass)
 
   thunarxrenamer_class = THUNARX_RENAMER_CLASS (klass);
   thunarxrenamer_class->process = thunar_sbr_date_renamer_process;
+  thunarxrenamer_class->prepare = thunar_sbr_date_renamer_prepare;
 
   /**
    * ThunarSbrDateRenamer:mode:
@@ -385,62 +379,12 @@ thunar_sbr_get_time_string (guint64      file_time,
 
 
 
-#ifdef HAVE_EXIF
-static guint64
-thunar_sbr_get_time_from_string (const gchar *string)
-{
-  struct tm tm;
-
-#ifdef HAVE_STRPTIME
-  /* parse the string with strptime */
-  strptime (string, "%Y:%m:%d %T", &tm);
-#else
-  gint result;
-  gint year, month, day, hour, min, sec;
-
-  result = sscanf (string, "%d:%d:%d %d:%d:%d", &year, &month, &day, &hour, &min, &sec);
-
-  /* only continue when atleast the date is parsed succesfully */
-  if (G_LIKELY (result >= 3 && g_date_valid_dmy (day, month, year)))
-    {
-      /* be sure to start with a clean tm */
-      memset (&tm, 0, sizeof (tm));
-
-      /* set the date */
-      tm.tm_year = year - 1900;
-      tm.tm_mon = month - 1;
-      tm.tm_mday = day;
-
-      /* set the time */
-      tm.tm_hour = result >= 4? hour : 0;
-      tm.tm_min = result >= 5 ? min : 0;
-      tm.tm_sec = result >= 6 ? sec : 0;
-    }
-  else
-    {
-      return 0;
-    }
-#endif
-  /* return the local time */
-  return mktime (&tm);
-}
-#endif
-
-
-
 static guint64
 thunar_sbr_get_time (ThunarxFileInfo   *file,
                      ThunarSbrDateMode  mode)
 {
-
   GFileInfo *file_info;
   guint64    file_time = 0;
-#ifdef HAVE_EXIF
-  gchar     *uri, *filename;
-  ExifEntry *exif_entry;
-  ExifData  *exif_data;
-  gchar     exif_buffer[128];
-#endif
 
   switch (mode)
     {
@@ -472,46 +416,8 @@ thunar_sbr_get_time (ThunarxFileInfo   *file,
 
 #ifdef HAVE_EXIF
     case THUNAR_SBR_DATE_MODE_TAKEN:
-      /* get the uri */
-      uri = thunarx_file_info_get_uri (file);
-      if (G_LIKELY (uri != NULL))
-        {
-          /* determine the local path of the file */
-          filename = g_filename_from_uri (uri, NULL, NULL);
-          if (G_LIKELY (filename != NULL))
-            {
-              /* try to load the exif data for the file */
-              exif_data = exif_data_new_from_file (filename);
-              if (G_LIKELY (exif_data != NULL))
-                {
-                  /* lookup the entry for the tag, fallback on less common ones */
-                  exif_entry = exif_data_get_entry (exif_data, EXIF_TAG_DATE_TIME);
-
-                  if (exif_entry == NULL)
-                    exif_entry = exif_data_get_entry (exif_data, EXIF_TAG_DATE_TIME_ORIGINAL);
-
-                  if (exif_entry == NULL)
-                    exif_entry = exif_data_get_entry (exif_data, EXIF_TAG_DATE_TIME_DIGITIZED);
-
-                  if (G_LIKELY (exif_entry != NULL))
-                    {
-                      /* determine the value */
-                      if (exif_entry_get_value (exif_entry, exif_buffer, sizeof (exif_buffer)) != NULL)
-                        file_time = thunar_sbr_get_time_from_string (exif_buffer);
-                    }
-
-                  /* cleanup */
-                  exif_data_free (exif_data);
-                }
-
-              /* cleanup */
-              g_free (filename);
-            }
-
-          /* cleanup */
-          g_free (uri);
-        }
-
+      /* lookup the time in the EXIF cache */
+      file_time = thunar_sbr_exif_cache_get_time (file);
       break;
 #endif
     }
@@ -578,6 +484,20 @@ thunar_sbr_date_renamer_process (ThunarxRenamer  *renamer,
 
 
 
+static void
+thunar_sbr_date_renamer_prepare (ThunarxRenamer *renamer,
+                                 GList          *files)
+{
+  ThunarSbrDateRenamer *date_renamer = THUNAR_SBR_DATE_RENAMER (renamer);
+
+  /* read the EXIF data of new images in the background, so
+   * the preview only needs to format the cached timestamps */
+  if (date_renamer->mode == THUNAR_SBR_DATE_MODE_TAKEN)
+    thunar_sbr_exif_cache_prefetch (files);
+}
+
+
+
 /**
  * thunar_sbr_date_renamer_new:
  *
@@ -0,0 +1,494 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Xfce development team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_SYS_TYPES_H
+#include <sys/types.h>
+#endif
+#ifdef HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+
+#ifdef HAVE_STDIO_H
+#include <stdio.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_TIME_H
+#include <time.h>
+#endif
+
+#include <glib/gstdio.h>
+
+#include <thunar-sbr/thunar-sbr-exif-cache.h>
+
+#ifdef HAVE_EXIF
+#include <libexif/exif-data.h>
+#endif
+
+
+
+/* the maximum number of cached files, the cache is cleared when exceeded */
+#define THUNAR_SBR_EXIF_CACHE_MAX_ENTRIES (65536)
+
+/* the number of threads reading files in the background */
+#define THUNAR_SBR_EXIF_CACHE_MAX_THREADS (4)
+
+
+
+#ifdef HAVE_EXIF
+#if GLIB_CHECK_VERSION (2, 32, 0)
+#define _exif_cache_wait()      g_cond_wait (&exif_cache_cond, &G_LOCK_NAME (exif_cache))
+#define _exif_cache_broadcast() g_cond_broadcast (&exif_cache_cond)
+#else
+#define _exif_cache_wait()      g_cond_wait (exif_cache_cond, g_static_mutex_get_mutex (&G_LOCK_NAME (exif_cache)))
+#define _exif_cache_broadcast() g_cond_broadcast (exif_cache_cond)
+#endif
+
+
+
+/* the state of a file handed to the thread pool */
+enum
+{
+  THUNAR_SBR_EXIF_CACHE_QUEUED = 1,
+  THUNAR_SBR_EXIF_CACHE_READING,
+};
+
+
+
+typedef struct
+{
+  /* the key, identifying a version of a file */
+  guint64 device;
+  guint64 inode;
+  guint64 mtime;
+
+  /* the time the picture was taken, 0 if unknown */
+  guint64 time;
+} ThunarSbrExifCacheEntry;
+
+
+
+static GHashTable  *exif_cache = NULL;
+static GHashTable  *exif_cache_pending = NULL;
+static GThreadPool *exif_cache_pool = NULL;
+static gint         exif_cache_shutdown = FALSE;
+#if GLIB_CHECK_VERSION (2, 32, 0)
+static GCond        exif_cache_cond;
+#else
+static GCond       *exif_cache_cond = NULL;
+#endif
+G_LOCK_DEFINE_STATIC (exif_cache);
+
+
+
+static guint
+thunar_sbr_exif_cache_entry_hash (gconstpointer data)
+{
+  const ThunarSbrExifCacheEntry *entry = data;
+
+  return (guint) (entry->inode ^ (entry->inode >> 32) ^ entry->mtime ^ entry->device);
+}
+
+
+
+static gboolean
+thunar_sbr_exif_cache_entry_equal (gconstpointer a,
+                                   gconstpointer b)
+{
+  const ThunarSbrExifCacheEntry *entry_a = a;
+  const ThunarSbrExifCacheEntry *entry_b = b;
+
+  return (entry_a->inode == entry_b->inode
+       && entry_a->mtime == entry_b->mtime
+       && entry_a->device == entry_b->device);
+}
+
+
+
+static guint64
+thunar_sbr_exif_cache_parse_time (const gchar *string)
+{
+  struct tm tm;
+
+  /* be sure to start with a clean tm */
+  memset (&tm, 0, sizeof (tm));
+
+#ifdef HAVE_STRPTIME
+  /* parse the string with strptime */
+  strptime (string, "%Y:%m:%d %T", &tm);
+#else
+  gint result;
+  gint year, month, day, hour, min, sec;
+
+  result = sscanf (string, "%d:%d:%d %d:%d:%d", &year, &month, &day, &hour, &min, &sec);
+
+  /* only continue when atleast the date is parsed succesfully */
+  if (G_LIKELY (result >= 3 && g_date_valid_dmy (day, month, year)))
+    {
+      /* set the date */
+      tm.tm_year = year - 1900;
+      tm.tm_mon = month - 1;
+      tm.tm_mday = day;
+
+      /* set the time */
+      tm.tm_hour = result >= 4? hour : 0;
+      tm.tm_min = result >= 5 ? min : 0;
+      tm.tm_sec = result >= 6 ? sec : 0;
+    }
+  else
+    {
+      return 0;
+    }
+#endif
+  /* return the local time */
+  return mktime (&tm);
+}
+
+
+
+static ExifData *
+thunar_sbr_exif_cache_load (const gchar *filename)
+{
+  ExifData *exif_data = NULL;
+  guchar    header[4];
+  guchar   *buffer;
+  gsize     length;
+  FILE     *fp;
+
+  fp = g_fopen (filename, "rb");
+  if (G_UNLIKELY (fp == NULL))
+    return NULL;
+
+  /* check for the JPEG start of image marker */
+  if (fread (header, 1, 2, fp) != 2 || header[0] != 0xff || header[1] != 0xd8)
+    {
+      /* not a JPEG file, let libexif try to load the whole file */
+      fclose (fp);
+      return exif_data_new_from_file (filename);
+    }
+
+  /* walk the segments in front of the image data, only reading the EXIF
+   * APP1 segment and skipping all others (which may be quite large) */
+  while (exif_data == NULL && fread (header, 1, 4, fp) == 4 && header[0] == 0xff)
+    {
+      /* stop at the start of scan or end of image */
+      length = (header[2] << 8) | header[3];
+      if (header[1] == 0xda || header[1] == 0xd9 || length < 2)
+        break;
+      length -= 2;
+
+      if (header[1] == 0xe1)
+        {
+          /* APP1 is also used for XMP, so check for the EXIF header */
+          buffer = g_malloc (length);
+          if (fread (buffer, 1, length, fp) == length
+              && length > 6 && memcmp (buffer, "Exif\0\0", 6) == 0)
+            exif_data = exif_data_new_from_data (buffer, length);
+          g_free (buffer);
+        }
+      else if (fseek (fp, length, SEEK_CUR) != 0)
+        {
+          break;
+        }
+    }
+
+  fclose (fp);
+
+  return exif_data;
+}
+
+
+
+static guint64
+thunar_sbr_exif_cache_read_time (const gchar *filename)
+{
+  ExifEntry *exif_entry;
+  ExifData  *exif_data;
+  guint64    file_time = 0;
+  gchar      exif_buffer[128];
+
+  /* try to load the exif data for the file */
+  exif_data = thunar_sbr_exif_cache_load (filename);
+  if (G_LIKELY (exif_data != NULL))
+    {
+      /* lookup the entry for the tag, fallback on less common ones */
+      exif_entry = exif_data_get_entry (exif_data, EXIF_TAG_DATE_TIME);
+
+      if (exif_entry == NULL)
+        exif_entry = exif_data_get_entry (exif_data, EXIF_TAG_DATE_TIME_ORIGINAL);
+
+      if (exif_entry == NULL)
+        exif_entry = exif_data_get_entry (exif_data, EXIF_TAG_DATE_TIME_DIGITIZED);
+
+      if (G_LIKELY (exif_entry != NULL))
+        {
+          /* determine the value */
+          if (exif_entry_get_value (exif_entry, exif_buffer, sizeof (exif_buffer)) != NULL)
+            file_time = thunar_sbr_exif_cache_parse_time (exif_buffer);
+        }
+
+      /* cleanup */
+      exif_data_free (exif_data);
+    }
+
+  return file_time;
+}
+
+
+
+static guint64
+thunar_sbr_exif_cache_lookup (const gchar *filename,
+                              gboolean     prefetching)
+{
+  ThunarSbrExifCacheEntry  key;
+  ThunarSbrExifCacheEntry *entry;
+  struct stat              statb;
+  gboolean                 reading = FALSE;
+  guint                    state;
+
+  /* the inode and modification time identify the version of the file */
+  if (g_stat (filename, &statb) < 0)
+    return 0;
+
+  key.device = statb.st_dev;
+  key.inode = statb.st_ino;
+  key.mtime = statb.st_mtime;
+
+  G_LOCK (exif_cache);
+  for (;;)
+    {
+      /* check if the file is already cached */
+      entry = (exif_cache != NULL) ? g_hash_table_lookup (exif_cache, &key) : NULL;
+      if (entry != NULL)
+        {
+          key.time = entry->time;
+          G_UNLOCK (exif_cache);
+          return key.time;
+        }
+
+      state = (exif_cache_pending != NULL) ? GPOINTER_TO_UINT (g_hash_table_lookup (exif_cache_pending, filename)) : 0;
+      if (state == THUNAR_SBR_EXIF_CACHE_READING && !prefetching)
+        {
+          /* another thread is reading the file, wait for its result */
+          _exif_cache_wait ();
+        }
+      else if (state == THUNAR_SBR_EXIF_CACHE_QUEUED)
+        {
+          /* a queued file is read by whoever gets to it first */
+          g_hash_table_insert (exif_cache_pending, g_strdup (filename),
+                               GUINT_TO_POINTER (THUNAR_SBR_EXIF_CACHE_READING));
+          reading = TRUE;
+          break;
+        }
+      else if (prefetching)
+        {
+          /* the file is no longer queued, someone else took care of it */
+          G_UNLOCK (exif_cache);
+          return 0;
+        }
+      else
+        {
+          break;
+        }
+    }
+  G_UNLOCK (exif_cache);
+
+  /* read the file without holding the lock */
+  key.time = thunar_sbr_exif_cache_read_time (filename);
+
+  G_LOCK (exif_cache);
+  if (G_UNLIKELY (exif_cache == NULL))
+    {
+      exif_cache = g_hash_table_new_full (thunar_sbr_exif_cache_entry_hash,
+                                          thunar_sbr_exif_cache_entry_equal,
+                                          g_free, NULL);
+    }
+  else if (g_hash_table_size (exif_cache) >= THUNAR_SBR_EXIF_CACHE_MAX_ENTRIES)
+    {
+      /* start over instead of growing without bounds */
+      g_hash_table_remove_all (exif_cache);
+    }
+
+  /* the entry is both key and value, so replace the previous entry */
+  entry = g_memdup (&key, sizeof (key));
+  g_hash_table_replace (exif_cache, entry, entry);
+
+  /* wake up the threads waiting for this file */
+  if (reading)
+    {
+      g_hash_table_remove (exif_cache_pending, filename);
+      _exif_cache_broadcast ();
+    }
+  G_UNLOCK (exif_cache);
+
+  return key.time;
+}
+
+
+
+static void
+thunar_sbr_exif_cache_prefetch_func (gpointer data,
+                                     gpointer user_data)
+{
+  gchar *filename = data;
+
+  /* skip the remaining files on shutdown */
+  if (!g_atomic_int_get (&exif_cache_shutdown))
+    thunar_sbr_exif_cache_lookup (filename, TRUE);
+
+  g_free (filename);
+}
+#endif
+
+
+
+/**
+ * thunar_sbr_exif_cache_get_time:
+ * @file : a #ThunarxFileInfo.
+ *
+ * Returns the time the picture in @file was taken, according to
+ * its EXIF data. The result is cached for the inode and modification
+ * time of @file, so asking again for an unchanged file is cheap. If
+ * @file is being read in the background, this waits for the result
+ * instead of reading @file again.
+ *
+ * Return value: the time the picture was taken or 0 if unknown.
+ **/
+guint64
+thunar_sbr_exif_cache_get_time (ThunarxFileInfo *file)
+{
+  guint64 file_time = 0;
+#ifdef HAVE_EXIF
+  gchar  *filename;
+  gchar  *uri;
+
+  g_return_val_if_fail (THUNARX_IS_FILE_INFO (file), 0);
+
+  /* determine the local path of the file */
+  uri = thunarx_file_info_get_uri (file);
+  filename = g_filename_from_uri (uri, NULL, NULL);
+  if (G_LIKELY (filename != NULL))
+    {
+      file_time = thunar_sbr_exif_cache_lookup (filename, FALSE);
+      g_free (filename);
+    }
+  g_free (uri);
+#endif
+
+  return file_time;
+}
+
+
+
+/**
+ * thunar_sbr_exif_cache_prefetch:
+ * @files : a #GList of #ThunarxFileInfo<!---->s.
+ *
+ * Reads the EXIF data of the images in @files into the cache
+ * in the background, using a few threads in parallel.
+ **/
+void
+thunar_sbr_exif_cache_prefetch (GList *files)
+{
+#ifdef HAVE_EXIF
+  gchar *mime_type;
+  gchar *filename;
+  gchar *uri;
+  GList *lp;
+
+  for (lp = files; lp != NULL; lp = lp->next)
+    {
+      /* only images carry EXIF data */
+      mime_type = thunarx_file_info_get_mime_type (lp->data);
+      if (mime_type != NULL && g_str_has_prefix (mime_type, "image/"))
+        {
+          uri = thunarx_file_info_get_uri (lp->data);
+          filename = g_filename_from_uri (uri, NULL, NULL);
+          g_free (uri);
+
+          if (G_LIKELY (filename != NULL))
+            {
+              /* allocate the thread pool on-demand */
+              if (G_UNLIKELY (exif_cache_pool == NULL))
+                {
+#if !GLIB_CHECK_VERSION (2, 32, 0)
+                  exif_cache_cond = g_cond_new ();
+#endif
+                  exif_cache_pending = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+                  exif_cache_pool = g_thread_pool_new (thunar_sbr_exif_cache_prefetch_func, NULL,
+                                                       THUNAR_SBR_EXIF_CACHE_MAX_THREADS, FALSE, NULL);
+                }
+
+              /* remember the file is queued, unless a thread is already reading it */
+              G_LOCK (exif_cache);
+              if (g_hash_table_lookup (exif_cache_pending, filename) == NULL)
+                {
+                  g_hash_table_insert (exif_cache_pending, g_strdup (filename),
+                                       GUINT_TO_POINTER (THUNAR_SBR_EXIF_CACHE_QUEUED));
+                }
+              G_UNLOCK (exif_cache);
+
+              /* the pool takes over the filename */
+              g_thread_pool_push (exif_cache_pool, filename, NULL);
+            }
+        }
+      g_free (mime_type);
+    }
+#endif
+}
+
+
+
+/**
+ * thunar_sbr_exif_cache_shutdown:
+ *
+ * Stops the background threads and releases the cache.
+ **/
+void
+thunar_sbr_exif_cache_shutdown (void)
+{
+#ifdef HAVE_EXIF
+  /* wait for the threads, skipping the files still queued */
+  if (exif_cache_pool != NULL)
+    {
+      g_atomic_int_set (&exif_cache_shutdown, TRUE);
+      g_thread_pool_free (exif_cache_pool, FALSE, TRUE);
+      exif_cache_pool = NULL;
+
+      g_hash_table_destroy (exif_cache_pending);
+      exif_cache_pending = NULL;
+#if !GLIB_CHECK_VERSION (2, 32, 0)
+      g_cond_free (exif_cache_cond);
+      exif_cache_cond = NULL;
+#endif
+    }
+
+  if (exif_cache != NULL)
+    {
+      g_hash_table_destroy (exif_cache);
+      exif_cache = NULL;
+    }
+#endif
+}
@@ -0,0 +1,36 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Xfce development team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __THUNAR_SBR_EXIF_CACHE_H__
+#define __THUNAR_SBR_EXIF_CACHE_H__
+
+#include <thunarx/thunarx.h>
+
+G_BEGIN_DECLS;
+
+guint64 thunar_sbr_exif_cache_get_time (ThunarxFileInfo *file);
+
+void    thunar_sbr_exif_cache_prefetch (GList           *files);
+
+void    thunar_sbr_exif_cache_shutdown (void);
+
+G_END_DECLS;
+
+#endif /* !__THUNAR_SBR_EXIF_CACHE_H__ */
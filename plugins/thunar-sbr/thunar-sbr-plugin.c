@@ -29,6 +29,7 @@
 #include <thunar-sbr/thunar-sbr-remove-renamer.h>
 #include <thunar-sbr/thunar-sbr-replace-renamer.h>
 #include <thunar-sbr/thunar-sbr-date-renamer.h>
+#include <thunar-sbr/thunar-sbr-exif-cache.h>
 
 
 
@@ -84,6 +85,9 @@ thunar_extension_shutdown (void)
 #ifdef G_ENABLE_DEBUG
   g_message ("Shutting down ThunarSbr extension");
 #endif
+
+  /* release the cached EXIF data */
+  thunar_sbr_exif_cache_shutdown ();
 }
 
 
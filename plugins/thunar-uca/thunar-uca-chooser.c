@@ -149,6 +149,7 @@ thunar_uca_chooser_init (ThunarUcaChooser *uca_chooser)
   gtk_widget_show (uca_chooser->treeview);
 
   uca_model = thunar_uca_model_get_default ();
+  thunar_uca_model_load (uca_model);
   gtk_tree_view_set_model (GTK_TREE_VIEW (uca_chooser->treeview), GTK_TREE_MODEL (uca_model));
   g_object_unref (G_OBJECT (uca_model));
 
@@ -62,9 +62,14 @@
 #define _PATH_BSHELL "/bin/sh"
 #endif
 
+/* binary cache of the uca.xml, see thunar_uca_model_load_from_cache() */
+#define THUNAR_UCA_CACHE_MAGIC   (0x41435554) /* "TUCA" */
+#define THUNAR_UCA_CACHE_VERSION (1)
 
 
-typedef struct _ThunarUcaModelItem ThunarUcaModelItem;
+
+typedef struct _ThunarUcaModelItem   ThunarUcaModelItem;
+typedef struct _ThunarUcaCacheHeader ThunarUcaCacheHeader;
 
 
 
@@ -124,7 +129,14 @@ static gboolean           thunar_uca_model_iter_parent      (GtkTreeModel
 static gboolean           thunar_uca_model_load_from_file   (ThunarUcaModel       *uca_model,
                                                              const gchar          *filename,
                                                              GError              **error);
+static gboolean           thunar_uca_model_load_from_cache  (ThunarUcaModel       *uca_model,
+                                                             const gchar          *filename);
+static void               thunar_uca_model_save_cache       (ThunarUcaModel       *uca_model,
+                                                             const gchar          *filename);
 static void               thunar_uca_model_item_reset       (ThunarUcaModelItem   *item);
+static void               thunar_uca_model_item_compile     (ThunarUcaModelItem   *item);
+static gboolean           thunar_uca_model_item_matches     (ThunarUcaModelItem   *item,
+                                                             const gchar          *name);
 static void               thunar_uca_model_item_free        (gpointer              data);
 static void               start_element_handler             (GMarkupParseContext  *context,
                                                              const gchar          *element_name,
@@ -157,6 +169,9 @@ struct _ThunarUcaModel
 
   GList          *items;
   gint            stamp;
+
+  /* whether the uca.xml (or its cache) was loaded */
+  guint           loaded : 1;
 };
 
 struct _ThunarUcaModelItem
@@ -173,8 +188,42 @@ struct _ThunarUcaModelItem
 
   /* derived attributes */
   guint          multiple_selection : 1;
+
+  /* the compiled patterns: "*" matches everything, patterns like
+   * "*.tar.gz" are plain suffixes (pointing into the patterns) and
+   * only the remaining patterns need a GPatternSpec */
+  guint          match_all : 1;
+  guint          match_by_suffix : 1; /* if only the name from the first dot matters */
+  const gchar  **suffixes;
+  GPatternSpec **pattern_specs;
+};
+
+/* The uca.cache starts with this header, followed by the path of
+ * the uca.xml, the locale and n_items records of six strings (name,
+ * unique id, description, icon, command and patterns) and two
+ * guint32s (startup notify and types). Strings are stored as a
+ * guint32 length followed by the nul-terminated text. The cache is
+ * only valid for the uca.xml it was generated from.
+ */
+struct _ThunarUcaCacheHeader
+{
+  guint32 magic;
+  guint32 version;
+  guint64 xml_inode;
+  gint64  xml_mtime;
+  gint64  xml_size;
+  guint32 n_items;
+  guint32 reserved;
 };
 
+/* A file to match, identified by its types and (depending
+ * on the patterns) its name or the name from the first dot */
+typedef struct
+{
+  gchar          *name;
+  ThunarUcaTypes  types;
+} ThunarUcaFile;
+
 typedef XFCE_GENERIC_STACK(ParserState) ParserStack;
 
 typedef struct
@@ -251,9 +300,6 @@ thunar_uca_model_tree_model_init (GtkTreeModelIface *iface)
 static void
 thunar_uca_model_init (ThunarUcaModel *uca_model)
 {
-  GError *error = NULL;
-  gchar  *filename;
-
   /* allocate a new icon factory for our action icons
    * and add it to the default icon factories
    */
@@ -263,20 +309,7 @@ thunar_uca_model_init (ThunarUcaModel *uca_model)
   /* generate a unique stamp */
   uca_model->stamp = g_random_int ();
 
-  /* determine the path to the uca.xml config */
-  filename = xfce_resource_lookup (XFCE_RESOURCE_CONFIG, "Thunar/uca.xml");
-  if (G_LIKELY (filename != NULL))
-    {
-      /* try to load the file */
-      if (!thunar_uca_model_load_from_file (uca_model, filename, &error))
-        {
-          g_warning ("Failed to load `%s': %s", filename, error->message);
-          g_error_free (error);
-        }
-
-      /* release the filename */
-      g_free (filename);
-    }
+  /* the uca.xml is loaded on demand, see thunar_uca_model_load() */
 }
 
 
@@ -617,10 +650,253 @@ thunar_uca_model_load_from_file (ThunarUcaModel *uca_model,
 
 
 
+static gchar*
+thunar_uca_model_get_cache_path (gboolean create)
+{
+  return xfce_resource_save_location (XFCE_RESOURCE_CACHE, "Thunar/uca.cache", create);
+}
+
+
+
+static const gchar*
+thunar_uca_cache_read_string (const gchar **p,
+                              const gchar  *end)
+{
+  const gchar *str;
+  guint32      length;
+
+  if (G_UNLIKELY ((gsize) (end - *p) < sizeof (length)))
+    return NULL;
+
+  memcpy (&length, *p, sizeof (length));
+  *p += sizeof (length);
+
+  /* the string must be inside the cache and nul-terminated */
+  if (G_UNLIKELY ((gsize) (end - *p) <= length || (*p)[length] != '\0'))
+    return NULL;
+
+  str = *p;
+  *p += length + 1;
+
+  return str;
+}
+
+
+
+static gboolean
+thunar_uca_cache_read_uint (const gchar **p,
+                            const gchar  *end,
+                            guint32      *value)
+{
+  if (G_UNLIKELY ((gsize) (end - *p) < sizeof (*value)))
+    return FALSE;
+
+  memcpy (value, *p, sizeof (*value));
+  *p += sizeof (*value);
+
+  return TRUE;
+}
+
+
+
+static gboolean
+thunar_uca_cache_read_item (const gchar **p,
+                            const gchar  *end,
+                            const gchar **strings,
+                            guint32      *startup_notify,
+                            guint32      *types)
+{
+  guint n;
+
+  for (n = 0; n < 6; ++n)
+    {
+      strings[n] = thunar_uca_cache_read_string (p, end);
+      if (G_UNLIKELY (strings[n] == NULL))
+        return FALSE;
+    }
+
+  return thunar_uca_cache_read_uint (p, end, startup_notify)
+      && thunar_uca_cache_read_uint (p, end, types);
+}
+
+
+
+static gboolean
+thunar_uca_model_load_from_cache (ThunarUcaModel *uca_model,
+                                  const gchar    *filename)
+{
+  ThunarUcaCacheHeader header;
+  const gchar         *strings[6];
+  const gchar         *contents;
+  const gchar         *end;
+  const gchar         *p;
+  const gchar         *str;
+  GMappedFile         *mapped_file;
+  GtkTreeIter          iter;
+  GStatBuf             statb;
+  gboolean             succeed = FALSE;
+  guint32              startup_notify;
+  guint32              types;
+  gchar               *cache_path;
+  guint                n;
+
+  /* determine the stat of the uca.xml, which the cache must match */
+  if (g_stat (filename, &statb) < 0)
+    return FALSE;
+
+  /* map the cache into memory */
+  cache_path = thunar_uca_model_get_cache_path (FALSE);
+  mapped_file = (cache_path != NULL) ? g_mapped_file_new (cache_path, FALSE, NULL) : NULL;
+  g_free (cache_path);
+  if (G_UNLIKELY (mapped_file == NULL))
+    return FALSE;
+
+  contents = g_mapped_file_get_contents (mapped_file);
+  end = contents + g_mapped_file_get_length (mapped_file);
+  if (g_mapped_file_get_length (mapped_file) < sizeof (header))
+    goto done;
+
+  /* verify the header */
+  memcpy (&header, contents, sizeof (header));
+  if (header.magic != THUNAR_UCA_CACHE_MAGIC
+      || header.version != THUNAR_UCA_CACHE_VERSION
+      || header.xml_inode != (guint64) statb.st_ino
+      || header.xml_mtime != (gint64) statb.st_mtime
+      || header.xml_size != (gint64) statb.st_size)
+    goto done;
+
+  /* verify the uca.xml path and the locale the names were picked for */
+  p = contents + sizeof (header);
+  str = thunar_uca_cache_read_string (&p, end);
+  if (str == NULL || strcmp (str, filename) != 0)
+    goto done;
+  str = thunar_uca_cache_read_string (&p, end);
+  if (str == NULL || g_strcmp0 (str, setlocale (LC_MESSAGES, NULL)) != 0)
+    goto done;
+
+  /* verify all records before touching the model */
+  for (str = p, n = 0; n < header.n_items; ++n)
+    if (!thunar_uca_cache_read_item (&str, end, strings, &startup_notify, &types))
+      goto done;
+
+  /* load the actions */
+  for (n = 0; n < header.n_items; ++n)
+    {
+      thunar_uca_cache_read_item (&p, end, strings, &startup_notify, &types);
+      thunar_uca_model_append (uca_model, &iter);
+      thunar_uca_model_update (uca_model, &iter,
+                               strings[0], strings[1], strings[2],
+                               strings[3], strings[4], startup_notify != 0,
+                               strings[5], types);
+    }
+
+  succeed = TRUE;
+
+done:
+  g_mapped_file_unref (mapped_file);
+
+  return succeed;
+}
+
+
+
+static void
+thunar_uca_cache_append_string (GString     *cache,
+                                const gchar *str)
+{
+  guint32 length;
+
+  if (str == NULL)
+    str = "";
+
+  length = strlen (str);
+  g_string_append_len (cache, (const gchar *) &length, sizeof (length));
+  g_string_append_len (cache, str, length + 1);
+}
+
+
+
+static void
+thunar_uca_cache_append_uint (GString *cache,
+                              guint32  value)
+{
+  g_string_append_len (cache, (const gchar *) &value, sizeof (value));
+}
+
+
+
+static void
+thunar_uca_model_save_cache (ThunarUcaModel *uca_model,
+                             const gchar    *filename)
+{
+  ThunarUcaCacheHeader header;
+  ThunarUcaModelItem  *item;
+  GStatBuf             statb;
+  GString             *cache;
+  GList               *lp;
+  gchar               *cache_path;
+  gchar               *patterns;
+
+  /* the cache is bound to the current state of the uca.xml */
+  if (g_stat (filename, &statb) < 0)
+    return;
+
+  cache_path = thunar_uca_model_get_cache_path (TRUE);
+  if (G_UNLIKELY (cache_path == NULL))
+    return;
+
+  memset (&header, 0, sizeof (header));
+  header.magic = THUNAR_UCA_CACHE_MAGIC;
+  header.version = THUNAR_UCA_CACHE_VERSION;
+  header.xml_inode = statb.st_ino;
+  header.xml_mtime = statb.st_mtime;
+  header.xml_size = statb.st_size;
+  header.n_items = g_list_length (uca_model->items);
+
+  cache = g_string_sized_new (1024);
+  g_string_append_len (cache, (const gchar *) &header, sizeof (header));
+  thunar_uca_cache_append_string (cache, filename);
+  thunar_uca_cache_append_string (cache, setlocale (LC_MESSAGES, NULL));
+
+  for (lp = uca_model->items; lp != NULL; lp = lp->next)
+    {
+      item = (ThunarUcaModelItem *) lp->data;
+      patterns = g_strjoinv (";", item->patterns);
+      thunar_uca_cache_append_string (cache, item->name);
+      thunar_uca_cache_append_string (cache, item->unique_id);
+      thunar_uca_cache_append_string (cache, item->description);
+      thunar_uca_cache_append_string (cache, item->icon_name);
+      thunar_uca_cache_append_string (cache, item->command);
+      thunar_uca_cache_append_string (cache, patterns);
+      thunar_uca_cache_append_uint (cache, item->startup_notify);
+      thunar_uca_cache_append_uint (cache, item->types);
+      g_free (patterns);
+    }
+
+  /* the cache is optional, a failure just means parsing the xml next time */
+  g_file_set_contents (cache_path, cache->str, cache->len, NULL);
+
+  g_string_free (cache, TRUE);
+  g_free (cache_path);
+}
+
+
+
 static void
 thunar_uca_model_item_reset (ThunarUcaModelItem *item)
 {
-  /* release the previous values... */
+  guint n;
+
+  /* release the compiled patterns... */
+  if (item->pattern_specs != NULL)
+    {
+      for (n = 0; item->pattern_specs[n] != NULL; ++n)
+        g_pattern_spec_free (item->pattern_specs[n]);
+      g_free (item->pattern_specs);
+    }
+  g_free (item->suffixes);
+
+  /* ...and the previous values... */
   g_strfreev (item->patterns);
   g_free (item->description);
   g_free (item->command);
@@ -637,6 +913,78 @@ thunar_uca_model_item_reset (ThunarUcaModelItem *item)
 
 
 
+static void
+thunar_uca_model_item_compile (ThunarUcaModelItem *item)
+{
+  const gchar *pattern;
+  guint        n_suffixes = 0;
+  guint        n_specs = 0;
+  guint        n;
+
+  n = g_strv_length (item->patterns);
+  item->suffixes = g_new (const gchar *, n + 1);
+  item->pattern_specs = g_new (GPatternSpec *, n + 1);
+  item->match_all = FALSE;
+  item->match_by_suffix = TRUE;
+
+  for (n = 0; item->patterns[n] != NULL; ++n)
+    {
+      pattern = item->patterns[n];
+      if (strcmp (pattern, "*") == 0)
+        {
+          item->match_all = TRUE;
+        }
+      else if (pattern[0] == '*' && strpbrk (pattern + 1, "*?") == NULL)
+        {
+          /* a suffix starting with a dot always matches within the name
+           * from its first dot, which is what the matching is keyed on */
+          item->suffixes[n_suffixes++] = pattern + 1;
+          if (pattern[1] != '.')
+            item->match_by_suffix = FALSE;
+        }
+      else
+        {
+          item->pattern_specs[n_specs++] = g_pattern_spec_new (pattern);
+          item->match_by_suffix = FALSE;
+        }
+    }
+
+  item->suffixes[n_suffixes] = NULL;
+  item->pattern_specs[n_specs] = NULL;
+}
+
+
+
+static gboolean
+thunar_uca_model_item_matches (ThunarUcaModelItem *item,
+                               const gchar        *name)
+{
+  gsize length;
+  guint n;
+
+  /* the item was never set up */
+  if (G_UNLIKELY (item->suffixes == NULL))
+    return FALSE;
+
+  if (item->match_all)
+    return TRUE;
+
+  /* check the suffixes without the pattern matcher */
+  for (n = 0; item->suffixes[n] != NULL; ++n)
+    if (g_str_has_suffix (name, item->suffixes[n]))
+      return TRUE;
+
+  /* fallback to the real patterns */
+  length = strlen (name);
+  for (n = 0; item->pattern_specs[n] != NULL; ++n)
+    if (g_pattern_match (item->pattern_specs[n], length, name, NULL))
+      return TRUE;
+
+  return FALSE;
+}
+
+
+
 static void
 thunar_uca_model_item_free (gpointer data)
 {
@@ -996,6 +1344,57 @@ thunar_uca_model_get_unique_id (void)
 
 
 
+/**
+ * thunar_uca_model_load:
+ * @uca_model : a #ThunarUcaModel.
+ *
+ * Loads the actions into @uca_model, unless that was already
+ * done. The actions are read from the uca.cache if it is still
+ * valid for the uca.xml, otherwise the uca.xml is parsed and
+ * the cache is regenerated.
+ *
+ * This is done implicitly by thunar_uca_model_match(), so the
+ * actions are not loaded before the first menu is requested.
+ **/
+void
+thunar_uca_model_load (ThunarUcaModel *uca_model)
+{
+  GError *error = NULL;
+  gchar  *filename;
+
+  g_return_if_fail (THUNAR_UCA_IS_MODEL (uca_model));
+
+  if (G_LIKELY (uca_model->loaded))
+    return;
+
+  /* set before loading, the parser appends and may save */
+  uca_model->loaded = TRUE;
+
+  /* determine the path to the uca.xml config */
+  filename = xfce_resource_lookup (XFCE_RESOURCE_CONFIG, "Thunar/uca.xml");
+  if (G_LIKELY (filename != NULL))
+    {
+      /* try the cache first, fallback to the file */
+      if (!thunar_uca_model_load_from_cache (uca_model, filename))
+        {
+          if (thunar_uca_model_load_from_file (uca_model, filename, &error))
+            {
+              thunar_uca_model_save_cache (uca_model, filename);
+            }
+          else
+            {
+              g_warning ("Failed to load `%s': %s", filename, error->message);
+              g_error_free (error);
+            }
+        }
+
+      /* release the filename */
+      g_free (filename);
+    }
+}
+
+
+
 /**
  * thunar_uca_model_get_default:
  *
@@ -1063,6 +1462,39 @@ types_from_mime_type (const gchar *mime_type)
 
 
 
+static guint
+thunar_uca_file_hash (gconstpointer data)
+{
+  const ThunarUcaFile *file = data;
+
+  return g_str_hash (file->name) ^ file->types;
+}
+
+
+
+static gboolean
+thunar_uca_file_equal (gconstpointer a,
+                       gconstpointer b)
+{
+  const ThunarUcaFile *file_a = a;
+  const ThunarUcaFile *file_b = b;
+
+  return file_a->types == file_b->types && strcmp (file_a->name, file_b->name) == 0;
+}
+
+
+
+static void
+thunar_uca_file_free (gpointer data)
+{
+  ThunarUcaFile *file = data;
+
+  g_free (file->name);
+  g_free (file);
+}
+
+
+
 /**
  * thunar_uca_model_match:
  * @uca_model  : a #ThunarUcaModel.
@@ -1084,33 +1516,42 @@ GList*
 thunar_uca_model_match (ThunarUcaModel *uca_model,
                         GList          *file_infos)
 {
-  typedef struct
-  {
-    gchar          *name;
-    ThunarUcaTypes  types;
-  } ThunarUcaFile;
-
   ThunarUcaModelItem *item;
   ThunarUcaFile      *files;
+  ThunarUcaFile       key;
+  GHashTable         *signatures;
+  GHashTableIter      iter;
+  ThunarUcaTypes      types;
   GFile              *location;
+  gboolean            match_by_suffix = TRUE;
+  const gchar        *dot;
+  gpointer            signature;
   gchar              *mime_type;
-  gboolean            matches;
+  gchar              *name;
   GList              *paths = NULL;
   GList              *lp;
   gint                n_files;
-  gint                i, m, n;
+  gint                n_signatures;
+  gint                i, n;
 
   g_return_val_if_fail (THUNAR_UCA_IS_MODEL (uca_model), NULL);
   g_return_val_if_fail (file_infos != NULL, NULL);
 
+  /* load the actions on the first menu */
+  thunar_uca_model_load (uca_model);
+
   /* special case to avoid overhead */
   if (G_UNLIKELY (uca_model->items == NULL))
     return NULL;
 
-  /* determine the ThunarUcaFile's for the given file_infos */
-  n_files = g_list_length (file_infos);
-  files = g_new (ThunarUcaFile, n_files);
-  for (lp = file_infos, n = 0; lp != NULL; lp = lp->next, ++n)
+  /* check whether the items only care about the name from the first dot */
+  for (lp = uca_model->items; lp != NULL && match_by_suffix; lp = lp->next)
+    match_by_suffix = ((ThunarUcaModelItem *) lp->data)->match_by_suffix;
+
+  /* collapse the file_infos to their distinct signatures, which for
+   * large selections are usually just a few name suffixes and types */
+  signatures = g_hash_table_new_full (thunar_uca_file_hash, thunar_uca_file_equal, thunar_uca_file_free, NULL);
+  for (lp = file_infos, n_files = 0; lp != NULL; lp = lp->next, ++n_files)
     {
       location = thunarx_file_info_get_location (lp->data);
 
@@ -1118,23 +1559,42 @@ thunar_uca_model_match (ThunarUcaModel *uca_model,
         {
           /* cannot handle non-local files */
           g_object_unref (location);
-          g_free (files);
+          g_hash_table_destroy (signatures);
           return NULL;
         }
 
       g_object_unref (location);
 
       mime_type = thunarx_file_info_get_mime_type (lp->data);
+      types = types_from_mime_type (mime_type);
+      g_free (mime_type);
 
-      files[n].name = thunarx_file_info_get_name (lp->data);
-      files[n].types = types_from_mime_type (mime_type);
+      if (G_UNLIKELY (types == 0))
+        types = THUNAR_UCA_TYPE_OTHER_FILES;
 
-      if (G_UNLIKELY (files[n].types == 0))
-        files[n].types = THUNAR_UCA_TYPE_OTHER_FILES;
+      name = thunarx_file_info_get_name (lp->data);
+      dot = match_by_suffix ? strchr (name, '.') : name;
 
-      g_free (mime_type);
+      key.name = (gchar *) ((dot != NULL) ? dot : "");
+      key.types = types;
+      if (g_hash_table_lookup (signatures, &key) == NULL)
+        {
+          files = g_new (ThunarUcaFile, 1);
+          files->name = g_strdup (key.name);
+          files->types = types;
+          g_hash_table_insert (signatures, files, files);
+        }
+
+      g_free (name);
     }
 
+  /* flatten the distinct signatures, there may be one per selected file */
+  n_signatures = g_hash_table_size (signatures);
+  files = g_new (ThunarUcaFile, n_signatures);
+  g_hash_table_iter_init (&iter, signatures);
+  for (n = 0; g_hash_table_iter_next (&iter, &signature, NULL); ++n)
+    files[n] = *((ThunarUcaFile *) signature);
+
   /* lookup the matching items */
   for (i = 0, lp = uca_model->items; lp != NULL; ++i, lp = lp->next)
     {
@@ -1144,32 +1604,27 @@ thunar_uca_model_match (ThunarUcaModel *uca_model,
         continue;
 
       /* match the specified files */
-      for (n = 0; n < n_files; ++n)
+      for (n = 0; n < n_signatures; ++n)
         {
           /* verify that we support this type of file */
           if ((files[n].types & item->types) == 0)
             break;
 
           /* atleast on pattern must match the file name */
-          for (m = 0, matches = FALSE; item->patterns[m] != NULL && !matches; ++m)
-            matches = g_pattern_match_simple (item->patterns[m], files[n].name);
-
-          /* no need to continue if none of the patterns match */
-          if (!matches)
+          if (!thunar_uca_model_item_matches (item, files[n].name))
             break;
         }
 
       /* add the path if all files match one of the patterns */
-      if (G_UNLIKELY (n == n_files))
-        paths = g_list_append (paths, gtk_tree_path_new_from_indices (i, -1));
+      if (G_UNLIKELY (n == n_signatures))
+        paths = g_list_prepend (paths, gtk_tree_path_new_from_indices (i, -1));
     }
 
   /* cleanup */
-  for (n = 0; n < n_files; ++n)
-    g_free (files[n].name);
+  g_hash_table_destroy (signatures);
   g_free (files);
 
-  return paths;
+  return g_list_reverse (paths);
 }
 
 
@@ -1192,6 +1647,9 @@ thunar_uca_model_append (ThunarUcaModel *uca_model,
   g_return_if_fail (THUNAR_UCA_IS_MODEL (uca_model));
   g_return_if_fail (iter != NULL);
 
+  /* make sure the existing actions are loaded */
+  thunar_uca_model_load (uca_model);
+
   /* append the new item */
   item = g_new0 (ThunarUcaModelItem, 1);
   uca_model->items = g_list_append (uca_model->items, item);
@@ -1360,6 +1818,7 @@ thunar_uca_model_update (ThunarUcaModel *uca_model,
         item->patterns[n++] = g_strstrip (item->patterns[m]);
     }
   item->patterns[n] = NULL;
+  thunar_uca_model_item_compile (item);
 
   /* check if this item will work for multiple files */
   item->multiple_selection = (command != NULL && (strstr (command, "%F") != NULL
@@ -1402,6 +1861,9 @@ thunar_uca_model_save (ThunarUcaModel *uca_model,
   g_return_val_if_fail (THUNAR_UCA_IS_MODEL (uca_model), FALSE);
   g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
+  /* never overwrite the actions with a model that was not loaded */
+  thunar_uca_model_load (uca_model);
+
   /* determine the save location */
   path = xfce_resource_save_location (XFCE_RESOURCE_CONFIG, "Thunar/uca.xml", TRUE);
   if (G_UNLIKELY (path == NULL))
@@ -1477,6 +1939,9 @@ thunar_uca_model_save (ThunarUcaModel *uca_model,
     {
       /* yeppa, successful */
       result = TRUE;
+
+      /* regenerate the cache for the new file */
+      thunar_uca_model_save_cache (uca_model, path);
     }
 
 done:
@@ -74,6 +74,8 @@ void            thunar_uca_model_register_type  (ThunarxProviderPlugin  *plugin)
 
 ThunarUcaModel *thunar_uca_model_get_default    (void);
 
+void            thunar_uca_model_load           (ThunarUcaModel         *uca_model);
+
 GList          *thunar_uca_model_match          (ThunarUcaModel         *uca_model,
                                                  GList                  *file_infos);
 
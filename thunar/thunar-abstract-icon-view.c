@@ -51,6 +51,7 @@ static void         thunar_abstract_icon_view_select_path           (ThunarStand
 static void         thunar_abstract_icon_view_set_cursor            (ThunarStandardView           *standard_view,
                                                                      GtkTreePath                  *path,
                                                                      gboolean                      start_editing);
+static GtkTreePath *thunar_abstract_icon_view_get_cursor            (ThunarStandardView           *standard_view);
 static void         thunar_abstract_icon_view_scroll_to_path        (ThunarStandardView           *standard_view,
                                                                      GtkTreePath                  *path,
                                                                      gboolean                      use_align,
@@ -158,6 +159,7 @@ thunar_abstract_icon_view_class_init (ThunarAbstractIconViewClass *klass)
   thunarstandard_view_class->selection_invert = thunar_abstract_icon_view_selection_invert;
   thunarstandard_view_class->select_path = thunar_abstract_icon_view_select_path;
   thunarstandard_view_class->set_cursor = thunar_abstract_icon_view_set_cursor;
+  thunarstandard_view_class->get_cursor = thunar_abstract_icon_view_get_cursor;
   thunarstandard_view_class->scroll_to_path = thunar_abstract_icon_view_scroll_to_path;
   thunarstandard_view_class->get_path_at_pos = thunar_abstract_icon_view_get_path_at_pos;
   thunarstandard_view_class->get_visible_range = thunar_abstract_icon_view_get_visible_range;
@@ -362,6 +364,20 @@ thunar_abstract_icon_view_set_cursor (ThunarStandardView *standard_view,
 
 
 
+static GtkTreePath*
+thunar_abstract_icon_view_get_cursor (ThunarStandardView *standard_view)
+{
+  GtkTreePath *path = NULL;
+
+  _thunar_return_val_if_fail (THUNAR_IS_ABSTRACT_ICON_VIEW (standard_view), NULL);
+
+  exo_icon_view_get_cursor (EXO_ICON_VIEW (GTK_BIN (standard_view)->child), &path, NULL);
+
+  return path;
+}
+
+
+
 static void
 thunar_abstract_icon_view_scroll_to_path (ThunarStandardView *standard_view,
                                           GtkTreePath        *path,
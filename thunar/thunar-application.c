@@ -53,6 +53,7 @@
 #include <thunar/thunar-preferences.h>
 #include <thunar/thunar-private.h>
 #include <thunar/thunar-progress-dialog.h>
+#include <thunar/thunar-rename-job.h>
 #include <thunar/thunar-renamer-dialog.h>
 #include <thunar/thunar-thumbnail-cache.h>
 #include <thunar/thunar-thumbnailer.h>
@@ -218,6 +219,8 @@ thunar_application_init (ThunarApplication *application)
 #ifdef HAVE_GUDEV
   static const gchar *subsystems[] = { "block", "input", "usb", NULL };
 #endif
+  ThunarJob          *job;
+  GtkWidget          *dialog;
   gchar              *path;
 
   /* initialize the application */
@@ -226,6 +229,19 @@ thunar_application_init (ThunarApplication *application)
   application->files_to_launch = NULL;
   application->progress_dialog = NULL;
 
+  /* offer to roll back bulk renames interrupted by a crash, the
+   * job asks the user and shows its progress in the dialog */
+  job = thunar_rename_job_recover ();
+  if (G_UNLIKELY (job != NULL))
+    {
+      dialog = thunar_application_get_progress_dialog (application);
+      thunar_progress_dialog_add_job (THUNAR_PROGRESS_DIALOG (dialog), job, "edit-undo",
+                                      _("Restoring interrupted renames..."));
+      g_object_unref (job);
+
+      gtk_window_present (GTK_WINDOW (dialog));
+    }
+
   /* check if we have a saved accel map */
   path = xfce_resource_lookup (XFCE_RESOURCE_CONFIG, ACCEL_MAP_PATH);
   if (G_LIKELY (path != NULL))
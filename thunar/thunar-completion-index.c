@@ -0,0 +1,543 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Xfce development team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <thunar/thunar-completion-index.h>
+#include <thunar/thunar-file-monitor.h>
+#include <thunar/thunar-private.h>
+
+
+
+typedef struct _ThunarCompletionEntry ThunarCompletionEntry;
+
+
+
+static void     thunar_completion_index_finalize       (GObject               *object);
+static void     thunar_completion_index_folder_destroy (ThunarFolder          *folder,
+                                                        ThunarCompletionIndex *completion_index);
+static void     thunar_completion_index_files_added    (ThunarFolder          *folder,
+                                                        GList                 *files,
+                                                        ThunarCompletionIndex *completion_index);
+static void     thunar_completion_index_files_removed  (ThunarFolder          *folder,
+                                                        GList                 *files,
+                                                        ThunarCompletionIndex *completion_index);
+static void     thunar_completion_index_file_changed   (ThunarFileMonitor     *file_monitor,
+                                                        ThunarFile            *file,
+                                                        ThunarCompletionIndex *completion_index);
+static void     thunar_completion_index_clear          (ThunarCompletionIndex *completion_index);
+static void     thunar_completion_index_ensure_sorted  (ThunarCompletionIndex *completion_index);
+
+
+
+struct _ThunarCompletionIndexClass
+{
+  GObjectClass __parent__;
+};
+
+struct _ThunarCompletionIndex
+{
+  GObject __parent__;
+
+  ThunarFolder      *folder;
+  ThunarFileMonitor *file_monitor;
+
+  /* entries sorted by their file name, plus a lookup
+   * table to find the entry for a given ThunarFile */
+  GPtrArray         *entries;
+  GHashTable        *file_entries;
+  guint              n_removed;
+  guint              sorted : 1;
+
+  /* normalized version of the last text passed to
+   * thunar_completion_index_matches() */
+  gchar             *match_text;
+  gchar             *match_text_normalized;
+  const gchar       *match_key;
+};
+
+struct _ThunarCompletionEntry
+{
+  ThunarFile *file;
+  gchar      *name;
+  gchar      *name_normalized;
+};
+
+
+
+G_DEFINE_TYPE (ThunarCompletionIndex, thunar_completion_index, G_TYPE_OBJECT)
+
+
+
+static void
+thunar_completion_index_class_init (ThunarCompletionIndexClass *klass)
+{
+  GObjectClass *gobject_class;
+
+  gobject_class = G_OBJECT_CLASS (klass);
+  gobject_class->finalize = thunar_completion_index_finalize;
+}
+
+
+
+static void
+thunar_completion_index_init (ThunarCompletionIndex *completion_index)
+{
+  completion_index->entries = g_ptr_array_new ();
+  completion_index->file_entries = g_hash_table_new (g_direct_hash, g_direct_equal);
+  completion_index->sorted = TRUE;
+
+  /* watch for renamed files */
+  completion_index->file_monitor = thunar_file_monitor_get_default ();
+  g_signal_connect (G_OBJECT (completion_index->file_monitor), "file-changed",
+                    G_CALLBACK (thunar_completion_index_file_changed), completion_index);
+}
+
+
+
+static void
+thunar_completion_index_finalize (GObject *object)
+{
+  ThunarCompletionIndex *completion_index = THUNAR_COMPLETION_INDEX (object);
+
+  /* disconnect from the folder */
+  thunar_completion_index_set_folder (completion_index, NULL);
+
+  /* disconnect from the file monitor */
+  g_signal_handlers_disconnect_by_func (G_OBJECT (completion_index->file_monitor), thunar_completion_index_file_changed, completion_index);
+  g_object_unref (G_OBJECT (completion_index->file_monitor));
+
+  g_ptr_array_free (completion_index->entries, TRUE);
+  g_hash_table_destroy (completion_index->file_entries);
+
+  g_free (completion_index->match_text);
+  g_free (completion_index->match_text_normalized);
+
+  (*G_OBJECT_CLASS (thunar_completion_index_parent_class)->finalize) (object);
+}
+
+
+
+static gint
+thunar_completion_entry_compare (gconstpointer a,
+                                 gconstpointer b)
+{
+  const ThunarCompletionEntry *entry_a = *((const ThunarCompletionEntry **) a);
+  const ThunarCompletionEntry *entry_b = *((const ThunarCompletionEntry **) b);
+
+  /* removed entries are moved to the end of the array */
+  if (G_UNLIKELY (entry_a->file == NULL || entry_b->file == NULL))
+    return (entry_a->file == NULL) - (entry_b->file == NULL);
+
+  return strcmp (entry_a->name, entry_b->name);
+}
+
+
+
+static void
+thunar_completion_entry_free (ThunarCompletionEntry *entry)
+{
+  g_free (entry->name);
+  g_free (entry->name_normalized);
+  g_slice_free (ThunarCompletionEntry, entry);
+}
+
+
+
+static void
+thunar_completion_index_folder_destroy (ThunarFolder          *folder,
+                                        ThunarCompletionIndex *completion_index)
+{
+  _thunar_return_if_fail (THUNAR_IS_FOLDER (folder));
+  _thunar_return_if_fail (completion_index->folder == folder);
+
+  thunar_completion_index_set_folder (completion_index, NULL);
+}
+
+
+
+static void
+thunar_completion_index_files_added (ThunarFolder          *folder,
+                                     GList                 *files,
+                                     ThunarCompletionIndex *completion_index)
+{
+  ThunarCompletionEntry *entry;
+  GList                 *lp;
+
+  _thunar_return_if_fail (THUNAR_IS_COMPLETION_INDEX (completion_index));
+  _thunar_return_if_fail (completion_index->folder == folder);
+
+  for (lp = files; lp != NULL; lp = lp->next)
+    {
+      /* skip files we already know about */
+      if (g_hash_table_lookup (completion_index->file_entries, lp->data) != NULL)
+        continue;
+
+      /* the file reference is owned by the folder, which outlives
+       * the entry, because we drop the entry on "files-removed" */
+      entry = g_slice_new0 (ThunarCompletionEntry);
+      entry->file = THUNAR_FILE (lp->data);
+      entry->name = g_strdup (thunar_file_get_basename (entry->file));
+
+      g_ptr_array_add (completion_index->entries, entry);
+      g_hash_table_insert (completion_index->file_entries, entry->file, entry);
+    }
+
+  /* sort lazily on the next query, the folder usually
+   * delivers its files in several chunks */
+  completion_index->sorted = FALSE;
+}
+
+
+
+static void
+thunar_completion_index_files_removed (ThunarFolder          *folder,
+                                       GList                 *files,
+                                       ThunarCompletionIndex *completion_index)
+{
+  ThunarCompletionEntry *entry;
+  GList                 *lp;
+
+  _thunar_return_if_fail (THUNAR_IS_COMPLETION_INDEX (completion_index));
+  _thunar_return_if_fail (completion_index->folder == folder);
+
+  for (lp = files; lp != NULL; lp = lp->next)
+    {
+      entry = g_hash_table_lookup (completion_index->file_entries, lp->data);
+      if (G_LIKELY (entry != NULL))
+        {
+          /* mark the entry as removed, it is dropped from
+           * the array when the index is sorted again */
+          g_hash_table_remove (completion_index->file_entries, lp->data);
+          entry->file = NULL;
+          completion_index->n_removed += 1;
+          completion_index->sorted = FALSE;
+        }
+    }
+}
+
+
+
+static void
+thunar_completion_index_file_changed (ThunarFileMonitor     *file_monitor,
+                                      ThunarFile            *file,
+                                      ThunarCompletionIndex *completion_index)
+{
+  ThunarCompletionEntry *entry;
+  const gchar           *name;
+
+  _thunar_return_if_fail (THUNAR_IS_FILE_MONITOR (file_monitor));
+  _thunar_return_if_fail (THUNAR_IS_COMPLETION_INDEX (completion_index));
+
+  entry = g_hash_table_lookup (completion_index->file_entries, file);
+  if (G_LIKELY (entry == NULL))
+    return;
+
+  /* update the entry if the file was renamed */
+  name = thunar_file_get_basename (file);
+  if (G_UNLIKELY (strcmp (entry->name, name) != 0))
+    {
+      g_free (entry->name);
+      entry->name = g_strdup (name);
+
+      g_free (entry->name_normalized);
+      entry->name_normalized = NULL;
+
+      completion_index->sorted = FALSE;
+    }
+}
+
+
+
+static void
+thunar_completion_index_clear (ThunarCompletionIndex *completion_index)
+{
+  guint n;
+
+  for (n = 0; n < completion_index->entries->len; ++n)
+    thunar_completion_entry_free (g_ptr_array_index (completion_index->entries, n));
+  g_ptr_array_set_size (completion_index->entries, 0);
+  g_hash_table_remove_all (completion_index->file_entries);
+
+  completion_index->n_removed = 0;
+  completion_index->sorted = TRUE;
+}
+
+
+
+static void
+thunar_completion_index_ensure_sorted (ThunarCompletionIndex *completion_index)
+{
+  guint n;
+
+  if (G_LIKELY (completion_index->sorted))
+    return;
+
+  g_ptr_array_sort (completion_index->entries, thunar_completion_entry_compare);
+
+  /* the removed entries are at the end of the array now */
+  if (completion_index->n_removed > 0)
+    {
+      for (n = completion_index->entries->len - completion_index->n_removed; n < completion_index->entries->len; ++n)
+        thunar_completion_entry_free (g_ptr_array_index (completion_index->entries, n));
+      g_ptr_array_set_size (completion_index->entries, completion_index->entries->len - completion_index->n_removed);
+      completion_index->n_removed = 0;
+    }
+
+  completion_index->sorted = TRUE;
+}
+
+
+
+static guint
+thunar_completion_index_bound (ThunarCompletionIndex *completion_index,
+                               const gchar           *text,
+                               gsize                  text_len,
+                               gboolean               upper)
+{
+  ThunarCompletionEntry *entry;
+  guint                  lo = 0;
+  guint                  hi = completion_index->entries->len;
+  guint                  mid;
+  gint                   result;
+
+  /* binary search for the first entry whose name is not
+   * less than (or, for the upper bound, greater than) the
+   * first text_len bytes of text */
+  while (lo < hi)
+    {
+      mid = lo + (hi - lo) / 2;
+      entry = g_ptr_array_index (completion_index->entries, mid);
+      result = strncmp (entry->name, text, text_len);
+      if (result < 0 || (upper && result == 0))
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  return lo;
+}
+
+
+
+/**
+ * thunar_completion_index_new:
+ *
+ * Allocates a new #ThunarCompletionIndex, which is not
+ * connected to any folder.
+ *
+ * Return value: the newly allocated #ThunarCompletionIndex.
+ **/
+ThunarCompletionIndex*
+thunar_completion_index_new (void)
+{
+  return g_object_new (THUNAR_TYPE_COMPLETION_INDEX, NULL);
+}
+
+
+
+/**
+ * thunar_completion_index_get_folder:
+ * @completion_index : a #ThunarCompletionIndex.
+ *
+ * Return value: the #ThunarFolder indexed by @completion_index or %NULL.
+ **/
+ThunarFolder*
+thunar_completion_index_get_folder (ThunarCompletionIndex *completion_index)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_COMPLETION_INDEX (completion_index), NULL);
+  return completion_index->folder;
+}
+
+
+
+/**
+ * thunar_completion_index_set_folder:
+ * @completion_index : a #ThunarCompletionIndex.
+ * @folder           : a #ThunarFolder or %NULL.
+ *
+ * Indexes the file names of @folder. The index is kept up
+ * to date while the @folder loads in the background and
+ * whenever files are added to or removed from @folder.
+ **/
+void
+thunar_completion_index_set_folder (ThunarCompletionIndex *completion_index,
+                                    ThunarFolder          *folder)
+{
+  _thunar_return_if_fail (THUNAR_IS_COMPLETION_INDEX (completion_index));
+  _thunar_return_if_fail (folder == NULL || THUNAR_IS_FOLDER (folder));
+
+  if (G_UNLIKELY (completion_index->folder == folder))
+    return;
+
+  /* disconnect from the previous folder */
+  if (G_LIKELY (completion_index->folder != NULL))
+    {
+      g_signal_handlers_disconnect_matched (G_OBJECT (completion_index->folder), G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, completion_index);
+      g_object_unref (G_OBJECT (completion_index->folder));
+    }
+
+  thunar_completion_index_clear (completion_index);
+
+  completion_index->folder = folder;
+
+  if (G_LIKELY (folder != NULL))
+    {
+      g_object_ref (G_OBJECT (folder));
+
+      /* index the files the folder already knows about */
+      thunar_completion_index_files_added (folder, thunar_folder_get_files (folder), completion_index);
+
+      g_signal_connect (G_OBJECT (folder), "destroy", G_CALLBACK (thunar_completion_index_folder_destroy), completion_index);
+      g_signal_connect (G_OBJECT (folder), "files-added", G_CALLBACK (thunar_completion_index_files_added), completion_index);
+      g_signal_connect (G_OBJECT (folder), "files-removed", G_CALLBACK (thunar_completion_index_files_removed), completion_index);
+    }
+}
+
+
+
+/**
+ * thunar_completion_index_lookup_prefix:
+ * @completion_index : a #ThunarCompletionIndex.
+ * @text             : the file name part entered by the user.
+ * @prefix_return    : return location for the longest common prefix.
+ * @file_return      : return location for the single matching file.
+ *
+ * Determines the longest common prefix of all file names that start
+ * with @text using two binary searches. If exactly one file matches,
+ * @file_return is set to that file.
+ *
+ * The caller is responsible to free @prefix_return using g_free() and
+ * @file_return using g_object_unref().
+ **/
+void
+thunar_completion_index_lookup_prefix (ThunarCompletionIndex *completion_index,
+                                       const gchar           *text,
+                                       gchar                **prefix_return,
+                                       ThunarFile           **file_return)
+{
+  ThunarCompletionEntry *first;
+  ThunarCompletionEntry *last;
+  const gchar           *s;
+  const gchar           *t;
+  gsize                  text_len;
+  guint                  lo;
+  guint                  hi;
+
+  _thunar_return_if_fail (THUNAR_IS_COMPLETION_INDEX (completion_index));
+  _thunar_return_if_fail (text != NULL);
+  _thunar_return_if_fail (prefix_return != NULL);
+  _thunar_return_if_fail (file_return != NULL);
+
+  *prefix_return = NULL;
+  *file_return = NULL;
+
+  thunar_completion_index_ensure_sorted (completion_index);
+
+  /* all names with the prefix form one range in the sorted array */
+  text_len = strlen (text);
+  lo = thunar_completion_index_bound (completion_index, text, text_len, FALSE);
+  hi = thunar_completion_index_bound (completion_index, text, text_len, TRUE);
+  if (G_UNLIKELY (lo >= hi))
+    return;
+
+  first = g_ptr_array_index (completion_index->entries, lo);
+  if (hi - lo == 1)
+    {
+      /* unique match */
+      *prefix_return = g_strdup (first->name);
+      *file_return = g_object_ref (G_OBJECT (first->file));
+    }
+  else
+    {
+      /* the common prefix of the range is the common
+       * prefix of its first and last name */
+      last = g_ptr_array_index (completion_index->entries, hi - 1);
+      for (s = first->name, t = last->name; *s != '\0' && *s == *t; ++s, ++t)
+        ;
+      *prefix_return = g_strndup (first->name, s - first->name);
+    }
+}
+
+
+
+/**
+ * thunar_completion_index_matches:
+ * @completion_index : a #ThunarCompletionIndex.
+ * @file             : a #ThunarFile in the indexed folder.
+ * @text             : the text of the path entry.
+ *
+ * Checks whether @file should be offered as completion for @text. The
+ * normalized forms of @text and the file names are cached, so calling
+ * this for every row of the completion model is cheap.
+ *
+ * Return value: %TRUE if @file matches @text.
+ **/
+gboolean
+thunar_completion_index_matches (ThunarCompletionIndex *completion_index,
+                                 ThunarFile            *file,
+                                 const gchar           *text)
+{
+  ThunarCompletionEntry *entry;
+  const gchar           *last_slash;
+
+  _thunar_return_val_if_fail (THUNAR_IS_COMPLETION_INDEX (completion_index), FALSE);
+  _thunar_return_val_if_fail (THUNAR_IS_FILE (file), FALSE);
+  _thunar_return_val_if_fail (text != NULL, FALSE);
+
+  /* normalize the text only once per key */
+  if (completion_index->match_text == NULL || strcmp (completion_index->match_text, text) != 0)
+    {
+      g_free (completion_index->match_text);
+      g_free (completion_index->match_text_normalized);
+      completion_index->match_text = g_strdup (text);
+      completion_index->match_text_normalized = g_utf8_normalize (text, -1, G_NORMALIZE_ALL);
+      if (G_UNLIKELY (completion_index->match_text_normalized == NULL))
+        completion_index->match_text_normalized = g_strdup (text);
+
+      /* lookup the last slash character in the key */
+      last_slash = strrchr (completion_index->match_text_normalized, G_DIR_SEPARATOR);
+      completion_index->match_key = (last_slash != NULL) ? last_slash + 1 : completion_index->match_text_normalized;
+    }
+
+  /* offer all non-hidden files if the key ends with a slash */
+  if (*completion_index->match_key == '\0' && completion_index->match_key != completion_index->match_text_normalized)
+    return !thunar_file_is_hidden (file);
+
+  entry = g_hash_table_lookup (completion_index->file_entries, file);
+  if (G_UNLIKELY (entry == NULL))
+    return FALSE;
+
+  /* normalize the file name on-demand */
+  if (G_UNLIKELY (entry->name_normalized == NULL))
+    {
+      entry->name_normalized = g_utf8_normalize (entry->name, -1, G_NORMALIZE_ALL);
+      if (G_UNLIKELY (entry->name_normalized == NULL))
+        entry->name_normalized = g_strdup (entry->name);
+    }
+
+  return g_str_has_prefix (entry->name_normalized, completion_index->match_key);
+}
@@ -0,0 +1,57 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Xfce development team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __THUNAR_COMPLETION_INDEX_H__
+#define __THUNAR_COMPLETION_INDEX_H__
+
+#include <thunar/thunar-folder.h>
+
+G_BEGIN_DECLS;
+
+typedef struct _ThunarCompletionIndexClass ThunarCompletionIndexClass;
+typedef struct _ThunarCompletionIndex      ThunarCompletionIndex;
+
+#define THUNAR_TYPE_COMPLETION_INDEX            (thunar_completion_index_get_type ())
+#define THUNAR_COMPLETION_INDEX(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), THUNAR_TYPE_COMPLETION_INDEX, ThunarCompletionIndex))
+#define THUNAR_COMPLETION_INDEX_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), THUNAR_TYPE_COMPLETION_INDEX, ThunarCompletionIndexClass))
+#define THUNAR_IS_COMPLETION_INDEX(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), THUNAR_TYPE_COMPLETION_INDEX))
+#define THUNAR_IS_COMPLETION_INDEX_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), THUNAR_TYPE_COMPLETION_INDEX))
+#define THUNAR_COMPLETION_INDEX_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), THUNAR_TYPE_COMPLETION_INDEX, ThunarCompletionIndexClass))
+
+GType                  thunar_completion_index_get_type      (void) G_GNUC_CONST;
+
+ThunarCompletionIndex *thunar_completion_index_new           (void) G_GNUC_MALLOC;
+
+ThunarFolder          *thunar_completion_index_get_folder    (ThunarCompletionIndex *completion_index);
+void                   thunar_completion_index_set_folder    (ThunarCompletionIndex *completion_index,
+                                                              ThunarFolder          *folder);
+
+void                   thunar_completion_index_lookup_prefix (ThunarCompletionIndex *completion_index,
+                                                              const gchar           *text,
+                                                              gchar                **prefix_return,
+                                                              ThunarFile           **file_return);
+
+gboolean               thunar_completion_index_matches       (ThunarCompletionIndex *completion_index,
+                                                              ThunarFile            *file,
+                                                              const gchar           *text);
+
+G_END_DECLS;
+
+#endif /* !__THUNAR_COMPLETION_INDEX_H__ */
@@ -46,6 +46,7 @@
 #include <thunar/thunar-preferences-dialog.h>
 #include <thunar/thunar-private.h>
 #include <thunar/thunar-properties-dialog.h>
+#include <thunar/thunar-transfer-job.h>
 #include <thunar/thunar-util.h>
 
 
@@ -196,6 +197,19 @@ static gboolean thunar_dbus_service_unlink_files                (ThunarDBusServi
                                                                  GError                **error);
 static gboolean thunar_dbus_service_terminate                   (ThunarDBusService      *dbus_service,
                                                                  GError                **error);
+static gboolean thunar_dbus_service_get_transfer_summary        (ThunarDBusService      *dbus_service,
+                                                                 guint                  *n_jobs,
+                                                                 guint64                *n_files,
+                                                                 guint64                *bytes_done,
+                                                                 guint64                *bytes_total,
+                                                                 guint64                *bytes_per_second,
+                                                                 gdouble                *files_per_second,
+                                                                 gint64                 *remaining_time,
+                                                                 guint64                *collect_time,
+                                                                 guint64                *verify_time,
+                                                                 guint64                *copy_time,
+                                                                 guint64                *thumbnail_time,
+                                                                 GError                **error);
 
 
 
@@ -1326,6 +1340,44 @@ thunar_dbus_service_terminate (ThunarDBusService *dbus_service,
 
 
 
+static gboolean
+thunar_dbus_service_get_transfer_summary (ThunarDBusService *dbus_service,
+                                          guint             *n_jobs,
+                                          guint64           *n_files,
+                                          guint64           *bytes_done,
+                                          guint64           *bytes_total,
+                                          guint64           *bytes_per_second,
+                                          gdouble           *files_per_second,
+                                          gint64            *remaining_time,
+                                          guint64           *collect_time,
+                                          guint64           *verify_time,
+                                          guint64           *copy_time,
+                                          guint64           *thumbnail_time,
+                                          GError           **error)
+{
+  ThunarTransferStats stats;
+
+  thunar_transfer_job_get_stats (&stats);
+
+  *n_jobs = stats.n_jobs;
+  *n_files = stats.n_files;
+  *bytes_done = stats.bytes_done;
+  *bytes_total = stats.bytes_total;
+  *bytes_per_second = stats.bytes_per_second;
+  *files_per_second = stats.files_per_second;
+  *remaining_time = stats.remaining_time;
+
+  /* report the phase timings in milliseconds */
+  *collect_time = stats.phase_time[THUNAR_TRANSFER_PHASE_COLLECT] / 1000;
+  *verify_time = stats.phase_time[THUNAR_TRANSFER_PHASE_VERIFY] / 1000;
+  *copy_time = stats.phase_time[THUNAR_TRANSFER_PHASE_COPY] / 1000;
+  *thumbnail_time = stats.phase_time[THUNAR_TRANSFER_PHASE_THUMBNAILS] / 1000;
+
+  return TRUE;
+}
+
+
+
 gboolean
 thunar_dbus_service_has_connection (ThunarDBusService *dbus_service)
 {
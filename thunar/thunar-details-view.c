@@ -65,6 +65,7 @@ static void         thunar_details_view_select_path             (ThunarStandardV
 static void         thunar_details_view_set_cursor              (ThunarStandardView     *standard_view,
                                                                  GtkTreePath            *path,
                                                                  gboolean                start_editing);
+static GtkTreePath *thunar_details_view_get_cursor              (ThunarStandardView     *standard_view);
 static void         thunar_details_view_scroll_to_path          (ThunarStandardView     *standard_view,
                                                                  GtkTreePath            *path,
                                                                  gboolean                use_align,
@@ -168,6 +169,7 @@ thunar_details_view_class_init (ThunarDetailsViewClass *klass)
   thunarstandard_view_class->selection_invert = thunar_details_view_selection_invert;
   thunarstandard_view_class->select_path = thunar_details_view_select_path;
   thunarstandard_view_class->set_cursor = thunar_details_view_set_cursor;
+  thunarstandard_view_class->get_cursor = thunar_details_view_get_cursor;
   thunarstandard_view_class->scroll_to_path = thunar_details_view_scroll_to_path;
   thunarstandard_view_class->get_path_at_pos = thunar_details_view_get_path_at_pos;
   thunarstandard_view_class->get_visible_range = thunar_details_view_get_visible_range;
@@ -561,6 +563,20 @@ thunar_details_view_set_cursor (ThunarStandardView *standard_view,
 
 
 
+static GtkTreePath*
+thunar_details_view_get_cursor (ThunarStandardView *standard_view)
+{
+  GtkTreePath *path = NULL;
+
+  _thunar_return_val_if_fail (THUNAR_IS_DETAILS_VIEW (standard_view), NULL);
+
+  gtk_tree_view_get_cursor (GTK_TREE_VIEW (GTK_BIN (standard_view)->child), &path, NULL);
+
+  return path;
+}
+
+
+
 static void
 thunar_details_view_scroll_to_path (ThunarStandardView *standard_view,
                                     GtkTreePath        *path,
@@ -68,6 +68,7 @@
 #include <thunar/thunar-util.h>
 #include <thunar/thunar-dialogs.h>
 #include <thunar/thunar-icon-factory.h>
+#include <thunar/thunar-monitor-registry.h>
 #include <thunar/thunar-protected-manager.h>
 
 
@@ -186,6 +187,7 @@ struct _ThunarFile
 typedef struct
 {
   GFileMonitor  *monitor;
+  gulong         changed_id;
   guint          watch_count;
 }
 ThunarFileWatch;
@@ -828,8 +830,9 @@ thunar_file_watch_destroyed (gpointer data)
 
   if (G_LIKELY (file_watch->monitor != NULL))
     {
-      g_file_monitor_cancel (file_watch->monitor);
-      g_object_unref (file_watch->monitor);
+      /* the monitor is shared with other users of the location */
+      g_signal_handler_disconnect (file_watch->monitor, file_watch->changed_id);
+      thunar_monitor_registry_release (file_watch->monitor);
     }
 
   g_slice_free (ThunarFileWatch, file_watch);
@@ -849,16 +852,16 @@ thunar_file_watch_reconnect (ThunarFile *file)
       /* reset the old monitor */
       if (G_LIKELY (file_watch->monitor != NULL))
         {
-          g_file_monitor_cancel (file_watch->monitor);
-          g_object_unref (file_watch->monitor);
+          g_signal_handler_disconnect (file_watch->monitor, file_watch->changed_id);
+          thunar_monitor_registry_release (file_watch->monitor);
         }
 
       /* create a file or directory monitor */
-      file_watch->monitor = g_file_monitor (file->gfile, G_FILE_MONITOR_WATCH_MOUNTS | G_FILE_MONITOR_SEND_MOVED, NULL, NULL);
+      file_watch->monitor = thunar_monitor_registry_get (file->gfile, G_FILE_MONITOR_WATCH_MOUNTS | G_FILE_MONITOR_SEND_MOVED);
       if (G_LIKELY (file_watch->monitor != NULL))
         {
           /* watch monitor for file changes */
-          g_signal_connect (file_watch->monitor, "changed", G_CALLBACK (thunar_file_monitor), file);
+          file_watch->changed_id = g_signal_connect (file_watch->monitor, "changed", G_CALLBACK (thunar_file_monitor), file);
         }
     }
 }
@@ -1092,36 +1095,43 @@ thunar_file_get_async_finish (GObject      *object,
   /* finish querying the file information */
   file_info = g_file_query_info_finish (location, result, &error);
 
-  /* allocate a new file object */
-  file = g_object_new (THUNAR_TYPE_FILE, NULL);
-  file->gfile = g_object_ref (location);
+  /* another lookup for the same location may have finished in
+   * the meantime (i.e. a cancelled one), reuse that instance */
+  file = thunar_file_cache_lookup (location);
+  if (G_UNLIKELY (file != NULL))
+    {
+      if (G_LIKELY (file_info != NULL))
+        g_object_unref (file_info);
+    }
+  else
+    {
+      /* allocate a new file object */
+      file = g_object_new (THUNAR_TYPE_FILE, NULL);
+      file->gfile = g_object_ref (location);
 
-  /* reset the file */
-  thunar_file_info_clear (file);
+      /* reset the file */
+      thunar_file_info_clear (file);
 
-  /* set the file information */
-  file->info = file_info;
+      /* set the file information */
+      file->info = file_info;
 
-  /* update the file from the information */
-  thunar_file_info_reload (file, data->cancellable);
+      /* update the file from the information */
+      thunar_file_info_reload (file, data->cancellable);
 
-  /* update the mounted info */
-  if (error != NULL
-      && error->domain == G_IO_ERROR
-      && error->code == G_IO_ERROR_NOT_MOUNTED)
-   {
-      FLAG_UNSET (file, THUNAR_FILE_FLAG_IS_MOUNTED);
-      g_clear_error (&error);
-   }
+      /* update the mounted info */
+      if (error != NULL
+          && error->domain == G_IO_ERROR
+          && error->code == G_IO_ERROR_NOT_MOUNTED)
+       {
+          FLAG_UNSET (file, THUNAR_FILE_FLAG_IS_MOUNTED);
+          g_clear_error (&error);
+       }
 
-  /* insert the file into the cache */
-  G_LOCK (file_cache_mutex);
-#ifdef G_ENABLE_DEBUG
-  /* check if there is no instance created in the meantime */
-  _thunar_assert (g_hash_table_lookup (file_cache, file->gfile) == NULL);
-#endif
-  g_hash_table_insert (file_cache, g_object_ref (file->gfile), file);
-  G_UNLOCK (file_cache_mutex);
+      /* insert the file into the cache */
+      G_LOCK (file_cache_mutex);
+      g_hash_table_insert (file_cache, g_object_ref (file->gfile), file);
+      G_UNLOCK (file_cache_mutex);
+    }
 
   /* pass the loaded file and possible errors to the return function */
   (data->func) (location, file, error, data->user_data);
@@ -3860,11 +3870,11 @@ thunar_file_watch (ThunarFile *file)
       file_watch->watch_count = 1;
 
       /* create a file or directory monitor */
-      file_watch->monitor = g_file_monitor (file->gfile, G_FILE_MONITOR_WATCH_MOUNTS | G_FILE_MONITOR_SEND_MOVED, NULL, NULL);
+      file_watch->monitor = thunar_monitor_registry_get (file->gfile, G_FILE_MONITOR_WATCH_MOUNTS | G_FILE_MONITOR_SEND_MOVED);
       if (G_LIKELY (file_watch->monitor != NULL))
         {
           /* watch monitor for file changes */
-          g_signal_connect (file_watch->monitor, "changed", G_CALLBACK (thunar_file_monitor), file);
+          file_watch->changed_id = g_signal_connect (file_watch->monitor, "changed", G_CALLBACK (thunar_file_monitor), file);
         }
 
       /* attach to file */
@@ -3964,6 +3974,49 @@ thunar_file_reload_idle (ThunarFile *file)
 
 
 
+/**
+ * thunar_file_update_info:
+ * @file : a #ThunarFile instance.
+ * @info : a #GFileInfo of @file, queried with %THUNARX_FILE_INFO_NAMESPACE.
+ *
+ * Replaces the information of @file with @info, which was already
+ * queried elsewhere (i.e. by a folder listing), if the modification
+ * time or the size of @file changed. Unlike thunar_file_reload(), this
+ * does not touch the file system.
+ *
+ * Return value: %TRUE if @file was updated and ::changed emitted.
+ **/
+gboolean
+thunar_file_update_info (ThunarFile *file,
+                         GFileInfo  *info)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_FILE (file), FALSE);
+  _thunar_return_val_if_fail (G_IS_FILE_INFO (info), FALSE);
+
+  /* nothing to do if the file did not change */
+  if (G_LIKELY (file->info != NULL)
+      && g_file_info_get_size (file->info) == g_file_info_get_size (info)
+      && g_file_info_get_attribute_uint64 (file->info, G_FILE_ATTRIBUTE_TIME_MODIFIED)
+         == g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED))
+    return FALSE;
+
+  /* clear file pxmap cache */
+  thunar_icon_factory_clear_pixmap_cache (file);
+
+  /* take over the new information */
+  g_object_ref (G_OBJECT (info));
+  thunar_file_info_clear (file);
+  file->info = info;
+  thunar_file_info_reload (file, NULL);
+
+  /* ... and tell others */
+  thunar_file_changed (file);
+
+  return TRUE;
+}
+
+
+
 /**
  * thunar_file_destroy:
  * @file : a #ThunarFile instance.
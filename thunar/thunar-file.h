@@ -241,6 +241,8 @@ void              thunar_file_unwatch                    (ThunarFile
 
 gboolean          thunar_file_reload                     (ThunarFile              *file);
 void              thunar_file_reload_idle                (ThunarFile              *file);
+gboolean          thunar_file_update_info                (ThunarFile              *file,
+                                                          GFileInfo               *info);
 void              thunar_file_reload_parent              (ThunarFile              *file);
 
 void              thunar_file_destroy                    (ThunarFile              *file);
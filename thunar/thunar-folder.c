@@ -27,10 +27,20 @@
 #include <thunar/thunar-gobject-extensions.h>
 #include <thunar/thunar-io-jobs.h>
 #include <thunar/thunar-job.h>
+#include <thunar/thunar-monitor-registry.h>
 #include <thunar/thunar-private.h>
 
 #define DEBUG_FILE_CHANGES FALSE
 
+/* number of closed folders kept in memory for quick reopening */
+#define THUNAR_FOLDER_CACHE_SIZE          (10)
+
+/* maximum number of files in all closed folders kept in memory */
+#define THUNAR_FOLDER_CACHE_MAX_FILES     (100000)
+
+/* the timeout until closed folders are suspended (in seconds) */
+#define THUNAR_FOLDER_CACHE_SWEEP_TIMEOUT (10)
+
 
 
 /* property identifiers */
@@ -83,6 +93,10 @@ static void     thunar_folder_monitor                     (GFileMonitor
                                                            GFile                  *other_file,
                                                            GFileMonitorEvent       event_type,
                                                            gpointer                user_data);
+static void     thunar_folder_suspend                     (ThunarFolder           *folder);
+static gboolean thunar_folder_cache_sweep_timer           (gpointer                user_data);
+static void     thunar_folder_cache_sweep_timer_destroy   (gpointer                user_data);
+static void     thunar_folder_cache_add                   (ThunarFolder           *folder);
 
 
 
@@ -111,6 +125,12 @@ struct _ThunarFolder
   GList             *files;
   gboolean           reload_info;
 
+  /* whether files are shown while the folder is loading */
+  guint              progressive : 1;
+
+  /* closed folder in the cache, without job and monitor */
+  guint              suspended : 1;
+
   GList             *content_type_ptr;
   guint              content_type_idle_id;
 
@@ -126,6 +146,10 @@ struct _ThunarFolder
 static guint  folder_signals[LAST_SIGNAL];
 static GQuark thunar_folder_quark;
 
+/* recently opened folders, most recent first */
+static GQueue folder_cache = G_QUEUE_INIT;
+static guint  folder_cache_sweep_id = 0;
+
 
 
 G_DEFINE_TYPE (ThunarFolder, thunar_folder, G_TYPE_OBJECT)
@@ -266,6 +290,10 @@ thunar_folder_dispose (GObject *object)
       folder->in_destruction = FALSE;
     }
 
+  /* a destroyed folder cannot be reopened */
+  if (g_queue_remove (&folder_cache, folder))
+    g_object_unref (G_OBJECT (folder));
+
   (*G_OBJECT_CLASS (thunar_folder_parent_class)->dispose) (object);
 }
 
@@ -284,8 +312,7 @@ thunar_folder_finalize (GObject *object)
   if (G_LIKELY (folder->monitor != NULL))
     {
       g_signal_handlers_disconnect_matched (folder->monitor, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, folder);
-      g_file_monitor_cancel (folder->monitor);
-      g_object_unref (folder->monitor);
+      thunar_monitor_registry_release (folder->monitor);
     }
 
   /* cancel the pending job (if any) */
@@ -402,8 +429,17 @@ thunar_folder_files_ready (ThunarJob    *job,
   _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
   _thunar_return_val_if_fail (folder->monitor == NULL, FALSE);
 
-  /* merge the list with the existing list of new files */
-  folder->new_files = g_list_concat (folder->new_files, files);
+  if (folder->progressive)
+    {
+      /* nothing to merge with, show the files right away */
+      g_signal_emit (G_OBJECT (folder), folder_signals[FILES_ADDED], 0, files);
+      folder->files = g_list_concat (folder->files, files);
+    }
+  else
+    {
+      /* merge the list with the existing list of new files */
+      folder->new_files = g_list_concat (folder->new_files, files);
+    }
 
   /* indicate that we took over ownership of the file list */
   return TRUE;
@@ -465,9 +501,12 @@ static void
 thunar_folder_finished (ExoJob       *job,
                         ThunarFolder *folder)
 {
+  GHashTable *old_files;
+  GHashTable *new_files;
   ThunarFile *file;
   GList      *files;
   GList      *lp;
+  GList      *lnext;
 
   _thunar_return_if_fail (THUNAR_IS_FOLDER (folder));
   _thunar_return_if_fail (THUNAR_IS_JOB (job));
@@ -476,11 +515,20 @@ thunar_folder_finished (ExoJob       *job,
   _thunar_return_if_fail (folder->content_type_idle_id == 0);
 
   /* check if we need to merge new files with existing files */
-  if (G_UNLIKELY (folder->files != NULL))
+  if (G_UNLIKELY (!folder->progressive))
     {
+      /* hash both lists, so large folders are merged in linear time */
+      old_files = g_hash_table_new (g_direct_hash, g_direct_equal);
+      for (lp = folder->files; lp != NULL; lp = lp->next)
+        g_hash_table_insert (old_files, lp->data, lp->data);
+
+      new_files = g_hash_table_new (g_direct_hash, g_direct_equal);
+      for (lp = folder->new_files; lp != NULL; lp = lp->next)
+        g_hash_table_insert (new_files, lp->data, lp->data);
+
       /* determine all added files (files on new_files, but not on files) */
       for (files = NULL, lp = folder->new_files; lp != NULL; lp = lp->next)
-        if (g_list_find (folder->files, lp->data) == NULL)
+        if (g_hash_table_lookup (old_files, lp->data) == NULL)
           {
             /* put the file on the added list */
             files = g_list_prepend (files, lp->data);
@@ -501,25 +549,28 @@ thunar_folder_finished (ExoJob       *job,
         }
 
       /* determine all removed files (files on files, but not on new_files) */
-      for (files = NULL, lp = folder->files; lp != NULL; )
+      for (files = NULL, lp = folder->files; lp != NULL; lp = lnext)
         {
           /* determine the file */
           file = THUNAR_FILE (lp->data);
 
           /* determine the next list item */
-          lp = lp->next;
+          lnext = lp->next;
 
           /* check if the file is not on new_files */
-          if (g_list_find (folder->new_files, file) == NULL)
+          if (g_hash_table_lookup (new_files, file) == NULL)
             {
               /* put the file on the removed list (owns the reference now) */
               files = g_list_prepend (files, file);
 
               /* remove from the internal files list */
-              folder->files = g_list_remove (folder->files, file);
+              folder->files = g_list_delete_link (folder->files, lp);
             }
         }
 
+      g_hash_table_destroy (old_files);
+      g_hash_table_destroy (new_files);
+
       /* check if any files were removed */
       if (G_UNLIKELY (files != NULL))
         {
@@ -534,18 +585,9 @@ thunar_folder_finished (ExoJob       *job,
       thunar_g_file_list_free (folder->new_files);
       folder->new_files = NULL;
     }
-  else
-    {
-      /* just use the new files for the files list */
-      folder->files = folder->new_files;
-      folder->new_files = NULL;
 
-      if (folder->files != NULL)
-        {
-          /* emit a "files-added" signal for the new files */
-          g_signal_emit (G_OBJECT (folder), folder_signals[FILES_ADDED], 0, folder->files);
-        }
-    }
+  /* the files were added while loading otherwise */
+  folder->progressive = FALSE;
 
   /* schedule a reload of the file information of all files if requested */
   if (folder->reload_info)
@@ -568,8 +610,8 @@ thunar_folder_finished (ExoJob       *job,
   thunar_folder_content_type_loader (folder);
 
   /* add us to the file alteration monitor */
-  folder->monitor = g_file_monitor_directory (thunar_file_get_file (folder->corresponding_file),
-                                              G_FILE_MONITOR_SEND_MOVED, NULL, NULL);
+  folder->monitor = thunar_monitor_registry_get_directory (thunar_file_get_file (folder->corresponding_file),
+                                                           G_FILE_MONITOR_SEND_MOVED);
   if (G_LIKELY (folder->monitor != NULL))
     g_signal_connect (folder->monitor, "changed", G_CALLBACK (thunar_folder_monitor), folder);
 
@@ -589,7 +631,7 @@ thunar_folder_file_changed (ThunarFileMonitor *file_monitor,
   _thunar_return_if_fail (THUNAR_IS_FILE_MONITOR (file_monitor));
 
   /* check if the corresponding file changed... */
-  if (G_UNLIKELY (folder->corresponding_file == file))
+  if (G_UNLIKELY (folder->corresponding_file == file && !folder->suspended))
     {
       /* ...and if so, reload the folder */
       thunar_folder_reload (folder, FALSE);
@@ -832,6 +874,117 @@ thunar_folder_monitor (GFileMonitor     *monitor,
 
 
 
+static void
+thunar_folder_suspend (ThunarFolder *folder)
+{
+  _thunar_return_if_fail (THUNAR_IS_FOLDER (folder));
+
+  /* stop metadata collector */
+  if (folder->content_type_idle_id != 0)
+    g_source_remove (folder->content_type_idle_id);
+
+  /* stop loading, the folder is reloaded when reopened */
+  if (G_UNLIKELY (folder->job != NULL))
+    {
+      g_signal_handlers_disconnect_matched (folder->job, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, folder);
+      g_object_unref (folder->job);
+      folder->job = NULL;
+
+      thunar_g_file_list_free (folder->new_files);
+      folder->new_files = NULL;
+    }
+
+  /* no need to watch a folder nobody looks at */
+  if (G_LIKELY (folder->monitor != NULL))
+    {
+      g_signal_handlers_disconnect_matched (folder->monitor, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, folder);
+      thunar_monitor_registry_release (folder->monitor);
+      folder->monitor = NULL;
+    }
+
+  folder->suspended = TRUE;
+}
+
+
+
+static gboolean
+thunar_folder_cache_sweep_timer (gpointer user_data)
+{
+  ThunarFolder *folder;
+  GList        *lp;
+  GList        *lnext;
+  guint         n_closed = 0;
+  guint         n_files = 0;
+  gboolean      in_use = FALSE;
+
+  for (lp = folder_cache.head; lp != NULL; lp = lnext)
+    {
+      lnext = lp->next;
+      folder = THUNAR_FOLDER (lp->data);
+
+      /* folders still referenced elsewhere are in use */
+      if (G_OBJECT (folder)->ref_count > 1)
+        {
+          in_use = TRUE;
+          continue;
+        }
+
+      /* keep the most recently closed folders within the limits */
+      n_files += g_list_length (folder->files);
+      if (++n_closed > THUNAR_FOLDER_CACHE_SIZE
+          || (n_closed > 1 && n_files > THUNAR_FOLDER_CACHE_MAX_FILES))
+        {
+          g_queue_delete_link (&folder_cache, lp);
+          g_object_unref (G_OBJECT (folder));
+        }
+      else if (!folder->suspended)
+        {
+          thunar_folder_suspend (folder);
+        }
+    }
+
+  /* keep checking until all folders are closed */
+  return in_use;
+}
+
+
+
+static void
+thunar_folder_cache_sweep_timer_destroy (gpointer user_data)
+{
+  folder_cache_sweep_id = 0;
+}
+
+
+
+static void
+thunar_folder_cache_add (ThunarFolder *folder)
+{
+  _thunar_return_if_fail (THUNAR_IS_FOLDER (folder));
+
+  /* move the folder to the front of the cache */
+  if (g_queue_remove (&folder_cache, folder))
+    g_queue_push_head (&folder_cache, folder);
+  else
+    g_queue_push_head (&folder_cache, g_object_ref (G_OBJECT (folder)));
+
+  /* reopened from the cache, show the old files and rescan. The listing
+   * refreshes the cached files that changed while the folder was not
+   * monitored from the information it reads anyway */
+  if (folder->suspended)
+    thunar_folder_reload (folder, FALSE);
+
+  /* schedule the sweeper */
+  if (G_UNLIKELY (folder_cache_sweep_id == 0))
+    {
+      folder_cache_sweep_id = g_timeout_add_seconds_full (G_PRIORITY_LOW, THUNAR_FOLDER_CACHE_SWEEP_TIMEOUT,
+                                                          thunar_folder_cache_sweep_timer, NULL,
+                                                          thunar_folder_cache_sweep_timer_destroy);
+    }
+}
+
+
+
 /**
  * thunar_folder_get_for_file:
  * @file : a #ThunarFile.
@@ -885,6 +1038,9 @@ thunar_folder_get_for_file (ThunarFile *file)
       thunar_folder_reload (folder, FALSE);
     }
 
+  /* keep the folder around for a while after it was closed */
+  thunar_folder_cache_add (folder);
+
   return folder;
 }
 
@@ -963,6 +1119,7 @@ thunar_folder_reload (ThunarFolder *folder,
 
   /* reload file info too? */
   folder->reload_info = reload_info;
+  folder->suspended = FALSE;
 
   /* stop metadata collector */
   if (folder->content_type_idle_id != 0)
@@ -981,8 +1138,7 @@ thunar_folder_reload (ThunarFolder *folder,
   if (G_UNLIKELY (folder->monitor != NULL))
     {
       g_signal_handlers_disconnect_matched (folder->monitor, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, folder);
-      g_file_monitor_cancel (folder->monitor);
-      g_object_unref (folder->monitor);
+      thunar_monitor_registry_release (folder->monitor);
       folder->monitor = NULL;
     }
 
@@ -990,6 +1146,9 @@ thunar_folder_reload (ThunarFolder *folder,
   thunar_g_file_list_free (folder->new_files);
   folder->new_files = NULL;
 
+  /* without files to merge with, the files can be shown in batches */
+  folder->progressive = (folder->files == NULL);
+
   /* start a new job */
   folder->job = thunar_io_jobs_list_directory (thunar_file_get_file (folder->corresponding_file));
   g_signal_connect (folder->job, "error", G_CALLBACK (thunar_folder_error), folder);
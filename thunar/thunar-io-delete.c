@@ -0,0 +1,469 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Xfce development team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_SYS_TYPES_H
+#include <sys/types.h>
+#endif
+#ifdef HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+
+#ifdef HAVE_DIRENT_H
+#include <dirent.h>
+#endif
+#ifdef HAVE_ERRNO_H
+#include <errno.h>
+#endif
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#include <gio/gio.h>
+
+#include <exo/exo.h>
+
+#include <thunar/thunar-io-delete.h>
+#include <thunar/thunar-private.h>
+
+#if defined (HAVE_FDOPENDIR) && defined (HAVE_FSTATAT) && defined (HAVE_OPENAT) && defined (HAVE_UNLINKAT)
+#define THUNAR_IO_DELETE_AT 1
+#endif
+
+#ifndef O_CLOEXEC
+#define O_CLOEXEC 0
+#endif
+
+
+
+/* number of threads deleting sub folders concurrently */
+#define THUNAR_IO_DELETE_THREADS (4)
+
+/* minimum time between two progress updates */
+#define THUNAR_IO_DELETE_UPDATE_INTERVAL (500 * 1000) /* 500 ms */
+
+
+
+#ifdef THUNAR_IO_DELETE_AT
+typedef struct
+{
+  ThunarJob     *job;
+
+  /* the folder being deleted */
+  gint           fd;
+
+  /* sub folders queued or being deleted by the thread pool */
+  volatile gint  n_pending;
+  volatile gint  n_deleted;
+
+  /* the first error, stops all threads */
+  GError        *error;
+
+  gint64         last_update_time;
+} ThunarIODelete;
+
+
+
+static void
+thunar_io_delete_set_error (ThunarIODelete *delete,
+                            const gchar    *name,
+                            gint            errsv)
+{
+  GError *error;
+  gchar  *display_name;
+
+  display_name = g_filename_display_name (name);
+  error = g_error_new (G_IO_ERROR, g_io_error_from_errno (errsv),
+                       _("Could not delete file \"%s\": %s"),
+                       display_name, g_strerror (errsv));
+  g_free (display_name);
+
+  /* only remember the first error */
+  if (!g_atomic_pointer_compare_and_exchange (&delete->error, NULL, error))
+    g_error_free (error);
+}
+
+
+
+static gboolean
+thunar_io_delete_is_stopped (ThunarIODelete *delete)
+{
+  return (g_atomic_pointer_get (&delete->error) != NULL
+          || exo_job_is_cancelled (EXO_JOB (delete->job)));
+}
+
+
+
+static void
+thunar_io_delete_progress (ThunarIODelete *delete)
+{
+  gint64 current_time;
+  guint  n_deleted;
+
+  /* notify callers not more then every 500ms */
+  current_time = g_get_monotonic_time ();
+  if (current_time - delete->last_update_time < THUNAR_IO_DELETE_UPDATE_INTERVAL)
+    return;
+  delete->last_update_time = current_time;
+
+  n_deleted = g_atomic_int_get (&delete->n_deleted);
+  exo_job_info_message (EXO_JOB (delete->job),
+                        ngettext ("Deleted %u file", "Deleted %u files", n_deleted),
+                        n_deleted);
+}
+
+
+
+static gboolean
+thunar_io_delete_contents (ThunarIODelete *delete,
+                           gint            dir_fd)
+{
+  struct dirent *dp;
+  struct stat    statb;
+  gboolean       is_dir;
+  DIR           *dir;
+  gint           child_fd;
+
+  /* the DIR owns the file descriptor from now on */
+  dir = fdopendir (dir_fd);
+  if (G_UNLIKELY (dir == NULL))
+    {
+      thunar_io_delete_set_error (delete, ".", errno);
+      close (dir_fd);
+      return FALSE;
+    }
+
+  while (!thunar_io_delete_is_stopped (delete))
+    {
+      errno = 0;
+      dp = readdir (dir);
+      if (dp == NULL)
+        {
+          if (G_UNLIKELY (errno != 0))
+            thunar_io_delete_set_error (delete, ".", errno);
+          break;
+        }
+
+      /* skip "." and ".." */
+      if (dp->d_name[0] == '.'
+          && (dp->d_name[1] == '\0' || (dp->d_name[1] == '.' && dp->d_name[2] == '\0')))
+        continue;
+
+      /* only stat the entry if the file system does not tell the type */
+#ifdef _DIRENT_HAVE_D_TYPE
+      if (dp->d_type != DT_UNKNOWN)
+        is_dir = (dp->d_type == DT_DIR);
+      else
+#endif
+      if (fstatat (dirfd (dir), dp->d_name, &statb, AT_SYMLINK_NOFOLLOW) == 0)
+        is_dir = S_ISDIR (statb.st_mode);
+      else
+        is_dir = FALSE;
+
+      if (is_dir)
+        {
+          /* delete the contents of the sub folder first */
+          child_fd = openat (dirfd (dir), dp->d_name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+          if (G_UNLIKELY (child_fd < 0))
+            {
+              thunar_io_delete_set_error (delete, dp->d_name, errno);
+              break;
+            }
+
+          if (!thunar_io_delete_contents (delete, child_fd))
+            break;
+        }
+
+      if (unlinkat (dirfd (dir), dp->d_name, is_dir ? AT_REMOVEDIR : 0) < 0
+          && errno != ENOENT)
+        {
+          thunar_io_delete_set_error (delete, dp->d_name, errno);
+          break;
+        }
+
+      g_atomic_int_inc (&delete->n_deleted);
+    }
+
+  closedir (dir);
+
+  return !thunar_io_delete_is_stopped (delete);
+}
+
+
+
+static void
+thunar_io_delete_sub_folder (gpointer data,
+                             gpointer user_data)
+{
+  ThunarIODelete *delete = user_data;
+  gchar          *name = data;
+  gint            fd;
+
+  if (!thunar_io_delete_is_stopped (delete))
+    {
+      fd = openat (delete->fd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+      if (G_UNLIKELY (fd < 0))
+        {
+          thunar_io_delete_set_error (delete, name, errno);
+        }
+      else if (thunar_io_delete_contents (delete, fd))
+        {
+          if (unlinkat (delete->fd, name, AT_REMOVEDIR) < 0 && errno != ENOENT)
+            thunar_io_delete_set_error (delete, name, errno);
+          else
+            g_atomic_int_inc (&delete->n_deleted);
+        }
+    }
+
+  g_free (name);
+
+  g_atomic_int_add (&delete->n_pending, -1);
+}
+
+
+
+static gboolean
+thunar_io_delete_folder (ThunarIODelete *delete)
+{
+  struct dirent *dp;
+  struct stat    statb;
+  GThreadPool   *pool;
+  gboolean       is_dir;
+  DIR           *dir;
+  gint           fd;
+
+  /* the DIR needs its own file descriptor, delete->fd is shared with the pool */
+  fd = dup (delete->fd);
+  dir = (fd < 0) ? NULL : fdopendir (fd);
+  if (G_UNLIKELY (dir == NULL))
+    {
+      thunar_io_delete_set_error (delete, ".", errno);
+      if (fd >= 0)
+        close (fd);
+      return FALSE;
+    }
+
+  pool = g_thread_pool_new (thunar_io_delete_sub_folder, delete,
+                            THUNAR_IO_DELETE_THREADS, FALSE, NULL);
+
+  /* delete the files right away and hand the sub folders to the pool */
+  while (!thunar_io_delete_is_stopped (delete))
+    {
+      errno = 0;
+      dp = readdir (dir);
+      if (dp == NULL)
+        {
+          if (G_UNLIKELY (errno != 0))
+            thunar_io_delete_set_error (delete, ".", errno);
+          break;
+        }
+
+      /* skip "." and ".." */
+      if (dp->d_name[0] == '.'
+          && (dp->d_name[1] == '\0' || (dp->d_name[1] == '.' && dp->d_name[2] == '\0')))
+        continue;
+
+#ifdef _DIRENT_HAVE_D_TYPE
+      if (dp->d_type != DT_UNKNOWN)
+        is_dir = (dp->d_type == DT_DIR);
+      else
+#endif
+      if (fstatat (delete->fd, dp->d_name, &statb, AT_SYMLINK_NOFOLLOW) == 0)
+        is_dir = S_ISDIR (statb.st_mode);
+      else
+        is_dir = FALSE;
+
+      if (is_dir)
+        {
+          g_atomic_int_inc (&delete->n_pending);
+          g_thread_pool_push (pool, g_strdup (dp->d_name), NULL);
+        }
+      else if (unlinkat (delete->fd, dp->d_name, 0) < 0 && errno != ENOENT)
+        {
+          thunar_io_delete_set_error (delete, dp->d_name, errno);
+        }
+      else
+        {
+          g_atomic_int_inc (&delete->n_deleted);
+        }
+
+      thunar_io_delete_progress (delete);
+    }
+
+  closedir (dir);
+
+  /* report the progress until the pool is done */
+  while (g_atomic_int_get (&delete->n_pending) > 0)
+    {
+      g_usleep (G_USEC_PER_SEC / 20);
+      thunar_io_delete_progress (delete);
+    }
+
+  g_thread_pool_free (pool, FALSE, TRUE);
+
+  return !thunar_io_delete_is_stopped (delete);
+}
+#endif
+
+
+
+/**
+ * thunar_io_delete_tree:
+ * @job             : a #ThunarJob.
+ * @file            : the #GFile to delete.
+ * @thumbnail_cache : the #ThunarThumbnailCache to notify.
+ * @n_deleted       : the number of files deleted so far, updated.
+ * @error           : return location for errors or %NULL.
+ *
+ * Deletes the local @file and, if it is a folder, all its contents
+ * without following symlinks. The folder is traversed relative to
+ * open directory file descriptors and its sub folders are deleted
+ * in parallel.
+ *
+ * %G_IO_ERROR_NOT_SUPPORTED is returned for non-local files, which
+ * need to be deleted using g_file_delete(). If deleting fails,
+ * parts of @file might have been deleted already.
+ *
+ * Return value: %TRUE if @file was deleted, %FALSE otherwise.
+ **/
+gboolean
+thunar_io_delete_tree (ThunarJob            *job,
+                       GFile                *file,
+                       ThunarThumbnailCache *thumbnail_cache,
+                       guint                *n_deleted,
+                       GError              **error)
+{
+#ifdef THUNAR_IO_DELETE_AT
+  ThunarIODelete delete;
+  struct stat    statb;
+  gboolean       succeed = FALSE;
+  gchar         *path;
+  gchar         *parent_path;
+  gchar         *name;
+  gint           parent_fd;
+  gint           errsv;
+
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
+  _thunar_return_val_if_fail (G_IS_FILE (file), FALSE);
+  _thunar_return_val_if_fail (n_deleted != NULL, FALSE);
+  _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  if (exo_job_set_error_if_cancelled (EXO_JOB (job), error))
+    return FALSE;
+
+  path = g_file_is_native (file) ? g_file_get_path (file) : NULL;
+  if (G_UNLIKELY (path == NULL))
+    {
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                           "Not a local file");
+      return FALSE;
+    }
+
+  parent_path = g_path_get_dirname (path);
+  name = g_path_get_basename (path);
+  g_free (path);
+
+  delete.job = job;
+  delete.fd = -1;
+  delete.n_pending = 0;
+  delete.n_deleted = *n_deleted;
+  delete.error = NULL;
+  delete.last_update_time = 0;
+
+  parent_fd = open (parent_path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (G_UNLIKELY (parent_fd < 0))
+    {
+      thunar_io_delete_set_error (&delete, name, errno);
+    }
+  else if (fstatat (parent_fd, name, &statb, AT_SYMLINK_NOFOLLOW) < 0)
+    {
+      thunar_io_delete_set_error (&delete, name, errno);
+    }
+  else if (!S_ISDIR (statb.st_mode))
+    {
+      if (unlinkat (parent_fd, name, 0) < 0)
+        {
+          thunar_io_delete_set_error (&delete, name, errno);
+        }
+      else
+        {
+          delete.n_deleted++;
+          thunar_thumbnail_cache_delete_file (thumbnail_cache, file);
+          succeed = TRUE;
+        }
+    }
+  else
+    {
+      delete.fd = openat (parent_fd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+      if (G_UNLIKELY (delete.fd < 0))
+        {
+          thunar_io_delete_set_error (&delete, name, errno);
+        }
+      else
+        {
+          succeed = thunar_io_delete_folder (&delete);
+          close (delete.fd);
+
+          if (succeed && unlinkat (parent_fd, name, AT_REMOVEDIR) < 0)
+            {
+              errsv = errno;
+              thunar_io_delete_set_error (&delete, name, errsv);
+              succeed = FALSE;
+            }
+
+          if (succeed)
+            {
+              delete.n_deleted++;
+
+              /* one cleanup request covers the thumbnails of the whole folder */
+              thunar_thumbnail_cache_cleanup_file (thumbnail_cache, file);
+            }
+        }
+    }
+
+  if (parent_fd >= 0)
+    close (parent_fd);
+
+  g_free (parent_path);
+  g_free (name);
+
+  *n_deleted = delete.n_deleted;
+
+  if (!succeed)
+    {
+      if (!exo_job_set_error_if_cancelled (EXO_JOB (job), error))
+        g_propagate_error (error, delete.error);
+      else if (delete.error != NULL)
+        g_error_free (delete.error);
+    }
+
+  return succeed;
+#else
+  g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                       "Not supported");
+  return FALSE;
+#endif
+}
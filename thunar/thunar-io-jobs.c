@@ -27,10 +27,14 @@
 #include <thunar/thunar-application.h>
 #include <thunar/thunar-enum-types.h>
 #include <thunar/thunar-gio-extensions.h>
+#include <thunar/thunar-io-delete.h>
 #include <thunar/thunar-io-scan-directory.h>
 #include <thunar/thunar-io-jobs.h>
 #include <thunar/thunar-io-jobs-util.h>
+#include <thunar/thunar-io-permissions.h>
+#include <thunar/thunar-io-trash.h>
 #include <thunar/thunar-job.h>
+#include <thunar/thunar-job-scheduler.h>
 #include <thunar/thunar-private.h>
 #include <thunar/thunar-simple-job.h>
 #include <thunar/thunar-thumbnail-cache.h>
@@ -38,6 +42,34 @@
 
 
 
+/* number of files in the first "files-ready" batch of a folder listing,
+ * about a window full, the following batches grow geometrically */
+#define THUNAR_IO_JOBS_LS_FIRST_BATCH (200)
+#define THUNAR_IO_JOBS_LS_MAX_BATCH   (16384)
+
+
+
+static gboolean
+_thunar_io_jobs_ls_refresh_idle (gpointer user_data)
+{
+  GPtrArray *refresh = user_data;
+  guint      n;
+
+  GDK_THREADS_ENTER ();
+
+  /* the array holds pairs of a cached file and its new info */
+  for (n = 0; n + 1 < refresh->len; n += 2)
+    thunar_file_update_info (g_ptr_array_index (refresh, n), g_ptr_array_index (refresh, n + 1));
+
+  GDK_THREADS_LEAVE ();
+
+  g_ptr_array_free (refresh, TRUE);
+
+  return FALSE;
+}
+
+
+
 static GList *
 _tij_collect_nofollow (ThunarJob *job,
                        GList     *base_file_list,
@@ -94,6 +126,7 @@ _thunar_io_jobs_create (ThunarJob  *job,
   GError            *err = NULL;
   GList             *file_list;
   GList             *lp;
+  guint              n_processed;
   gchar             *base_name;
   gchar             *display_name;
   GFile             *template_file;
@@ -109,7 +142,7 @@ _thunar_io_jobs_create (ThunarJob  *job,
   template_file = g_value_get_object (&g_array_index (param_values, GValue, 1));
 
   /* we know the total amount of files to be processed */
-  thunar_job_set_total_files (THUNAR_JOB (job), file_list);
+  thunar_job_set_total_files (THUNAR_JOB (job), g_list_length (file_list));
 
   /* check if we need to open the template */
   if (template_file != NULL)
@@ -124,14 +157,14 @@ _thunar_io_jobs_create (ThunarJob  *job,
     }
 
   /* iterate over all files in the list */
-  for (lp = file_list; 
+  for (lp = file_list, n_processed = 0;
        err == NULL && lp != NULL && !exo_job_is_cancelled (EXO_JOB (job)); 
-       lp = lp->next)
+       lp = lp->next, n_processed++)
     {
       g_assert (G_IS_FILE (lp->data));
 
       /* update progress information */
-      thunar_job_processing_file (THUNAR_JOB (job), lp);
+      thunar_job_processing_file (THUNAR_JOB (job), lp->data, n_processed);
 
 again:
       /* try to create the file */
@@ -270,6 +303,7 @@ _thunar_io_jobs_mkdir (ThunarJob  *job,
   GError           *err = NULL;
   GList            *file_list;
   GList            *lp;
+  guint             n_processed;
   gchar            *base_name;
   gchar            *display_name;
 
@@ -281,16 +315,16 @@ _thunar_io_jobs_mkdir (ThunarJob  *job,
   file_list = g_value_get_boxed (&g_array_index (param_values, GValue, 0));
 
   /* we know the total list of files to process */
-  thunar_job_set_total_files (THUNAR_JOB (job), file_list);
+  thunar_job_set_total_files (THUNAR_JOB (job), g_list_length (file_list));
 
-  for (lp = file_list; 
+  for (lp = file_list, n_processed = 0;
        err == NULL && lp != NULL && !exo_job_is_cancelled (EXO_JOB (job));
-       lp = lp->next)
+       lp = lp->next, n_processed++)
     {
       g_assert (G_IS_FILE (lp->data));
 
       /* update progress information */
-      thunar_job_processing_file (THUNAR_JOB (job), lp);
+      thunar_job_processing_file (THUNAR_JOB (job), lp->data, n_processed);
 
 again:
       /* try to create the directory */
@@ -407,7 +441,10 @@ _thunar_io_jobs_unlink (ThunarJob  *job,
   GFileInfo            *info;
   GError               *err = NULL;
   GList                *file_list;
+  GList                *fallback_list = NULL;
   GList                *lp;
+  guint                 n_processed;
+  guint                 n_deleted;
   gchar                *base_name;
   gchar                *display_name;
 
@@ -419,11 +456,61 @@ _thunar_io_jobs_unlink (ThunarJob  *job,
   /* get the file list */
   file_list = g_value_get_boxed (&g_array_index (param_values, GValue, 0));
 
+  /* take a reference on the thumbnail cache */
+  application = thunar_application_get ();
+  thumbnail_cache = thunar_application_get_thumbnail_cache (application);
+  g_object_unref (application);
+
+  /* we know the total list of files to process */
+  thunar_job_set_total_files (THUNAR_JOB (job), g_list_length (file_list));
+
+  /* delete local files and folders directly, without collecting
+   * the folder contents first */
+  for (lp = file_list, n_processed = 0, n_deleted = 0;
+       lp != NULL && !exo_job_is_cancelled (EXO_JOB (job));
+       lp = lp->next, n_processed++)
+    {
+      /* update progress information */
+      thunar_job_processing_file (THUNAR_JOB (job), lp->data, n_processed);
+
+      /* empty the home trash directly, the trash folders on other
+       * devices are collected below */
+      if (thunar_g_file_is_root (lp->data) && thunar_g_file_is_trashed (lp->data))
+        thunar_io_trash_empty (job, thumbnail_cache, &n_deleted, NULL);
+
+      /* root folders cannot be deleted, but their contents are
+       * collected below, which is how the trash is emptied */
+      if (thunar_g_file_is_root (lp->data)
+          || !thunar_io_delete_tree (job, lp->data, thumbnail_cache, &n_deleted, &err))
+        {
+          /* retry the file below, which allows the user to skip it */
+          g_clear_error (&err);
+          fallback_list = g_list_prepend (fallback_list, lp->data);
+        }
+    }
+
+  /* free the file lists and abort if the job was cancelled */
+  if (exo_job_set_error_if_cancelled (EXO_JOB (job), error))
+    {
+      g_list_free (fallback_list);
+      g_object_unref (thumbnail_cache);
+      return FALSE;
+    }
+
+  /* nothing left for the slow path */
+  if (G_LIKELY (fallback_list == NULL))
+    {
+      g_object_unref (thumbnail_cache);
+      return TRUE;
+    }
+
   /* tell the user that we're preparing to unlink the files */
   exo_job_info_message (EXO_JOB (job), _("Preparing..."));
 
   /* recursively collect files for removal, not following any symlinks */
-  file_list = _tij_collect_nofollow (job, file_list, TRUE, &err);
+  fallback_list = g_list_reverse (fallback_list);
+  file_list = _tij_collect_nofollow (job, fallback_list, TRUE, &err);
+  g_list_free (fallback_list);
 
   /* free the file list and fail if there was an error or the job was cancelled */
   if (err != NULL || exo_job_is_cancelled (EXO_JOB (job)))
@@ -434,30 +521,35 @@ _thunar_io_jobs_unlink (ThunarJob  *job,
         g_propagate_error (error, err);
 
       thunar_g_file_list_free (file_list);
+      g_object_unref (thumbnail_cache);
       return FALSE;
     }
 
   /* we know the total list of files to process */
-  thunar_job_set_total_files (THUNAR_JOB (job), file_list);
-
-  /* take a reference on the thumbnail cache */
-  application = thunar_application_get ();
-  thumbnail_cache = thunar_application_get_thumbnail_cache (application);
-  g_object_unref (application);
+  thunar_job_set_total_files (THUNAR_JOB (job), g_list_length (file_list));
 
   /* remove all the files */
-  for (lp = file_list; lp != NULL && !exo_job_is_cancelled (EXO_JOB (job)); lp = lp->next)
+  for (lp = file_list, n_processed = 0;
+       lp != NULL && !exo_job_is_cancelled (EXO_JOB (job));
+       lp = lp->next, n_processed++)
     {
       g_assert (G_IS_FILE (lp->data));
 
+      /* update progress information */
+      thunar_job_processing_file (THUNAR_JOB (job), lp->data, n_processed);
+
       /* skip root folders which cannot be deleted anyway */
       if (thunar_g_file_is_root (lp->data))
         continue;
 
 again:
-      /* try to delete the file */
-      if (g_file_delete (lp->data, exo_job_get_cancellable (EXO_JOB (job)), &err))
+      /* try to delete the file, which might be gone already if the
+       * trash was emptied directly */
+      if (g_file_delete (lp->data, exo_job_get_cancellable (EXO_JOB (job)), &err)
+          || g_error_matches (err, G_IO_ERROR, G_IO_ERROR_NOT_FOUND))
         {
+          g_clear_error (&err);
+
           /* notify the thumbnail cache that the corresponding thumbnail can also
            * be deleted now */
           thunar_thumbnail_cache_delete_file (thumbnail_cache, lp->data);
@@ -523,6 +615,7 @@ again:
 ThunarJob *
 thunar_io_jobs_unlink_files (GList *file_list)
 {
+  /* deleting doesn't wait for transfers on the same device */
   return thunar_simple_job_launch (_thunar_io_jobs_unlink, 1,
                                    THUNAR_TYPE_G_FILE_LIST, file_list);
 }
@@ -542,7 +635,8 @@ thunar_io_jobs_move_files (GList *source_file_list,
   job = thunar_transfer_job_new (source_file_list, target_file_list, 
                                  THUNAR_TRANSFER_JOB_MOVE);
   
-  return THUNAR_JOB (exo_job_launch (EXO_JOB (job)));
+  /* wait for other operations on the same devices */
+  return thunar_job_scheduler_launch (job, source_file_list, target_file_list, TRUE);
 }
 
 
@@ -560,7 +654,8 @@ thunar_io_jobs_copy_files (GList *source_file_list,
   job = thunar_transfer_job_new (source_file_list, target_file_list,
                                  THUNAR_TRANSFER_JOB_COPY);
 
-  return THUNAR_JOB (exo_job_launch (EXO_JOB (job)));
+  /* wait for other operations on the same devices */
+  return thunar_job_scheduler_launch (job, source_file_list, target_file_list, FALSE);
 }
 
 
@@ -705,6 +800,7 @@ _thunar_io_jobs_link (ThunarJob  *job,
   GList                *sp;
   GList                *target_file_list;
   GList                *tp;
+  guint                 n_processed;
 
   _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
   _thunar_return_val_if_fail (param_values != NULL, FALSE);
@@ -715,7 +811,7 @@ _thunar_io_jobs_link (ThunarJob  *job,
   target_file_list = g_value_get_boxed (&g_array_index (param_values, GValue, 1));
 
   /* we know the total list of paths to process */
-  thunar_job_set_total_files (THUNAR_JOB (job), source_file_list);
+  thunar_job_set_total_files (THUNAR_JOB (job), g_list_length (source_file_list));
 
   /* take a reference on the thumbnail cache */
   application = thunar_application_get ();
@@ -723,15 +819,15 @@ _thunar_io_jobs_link (ThunarJob  *job,
   g_object_unref (application);
 
   /* process all files */
-  for (sp = source_file_list, tp = target_file_list;
+  for (sp = source_file_list, tp = target_file_list, n_processed = 0;
        err == NULL && sp != NULL && tp != NULL;
-       sp = sp->next, tp = tp->next)
+       sp = sp->next, tp = tp->next, n_processed++)
     {
       _thunar_assert (G_IS_FILE (sp->data));
       _thunar_assert (G_IS_FILE (tp->data));
 
       /* update progress information */
-      thunar_job_processing_file (THUNAR_JOB (job), sp);
+      thunar_job_processing_file (THUNAR_JOB (job), sp->data, n_processed);
 
       /* try to create the symbolic link */
       real_target_file = _thunar_io_jobs_link_file (job, sp->data, tp->data, &err);
@@ -796,9 +892,11 @@ _thunar_io_jobs_trash (ThunarJob  *job,
 {
   ThunarThumbnailCache *thumbnail_cache;
   ThunarApplication    *application;
+  ThunarIOTrash        *trash;
   GError               *err = NULL;
   GList                *file_list;
   GList                *lp;
+  guint                 n_processed;
 
   _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
   _thunar_return_val_if_fail (param_values != NULL, FALSE);
@@ -815,17 +913,32 @@ _thunar_io_jobs_trash (ThunarJob  *job,
   thumbnail_cache = thunar_application_get_thumbnail_cache (application);
   g_object_unref (application);
 
-  for (lp = file_list; err == NULL && lp != NULL; lp = lp->next)
+  /* we know the total list of files to process */
+  thunar_job_set_total_files (THUNAR_JOB (job), g_list_length (file_list));
+
+  trash = thunar_io_trash_new ();
+
+  for (lp = file_list, n_processed = 0;
+       err == NULL && lp != NULL && !exo_job_set_error_if_cancelled (EXO_JOB (job), &err);
+       lp = lp->next, n_processed++)
     {
       _thunar_assert (G_IS_FILE (lp->data));
 
-      /* trash the file or folder */
-      g_file_trash (lp->data, exo_job_get_cancellable (EXO_JOB (job)), &err);
+      /* update progress information */
+      thunar_job_processing_file (THUNAR_JOB (job), lp->data, n_processed);
+
+      /* rename the file or folder into the home trash, everything
+       * else is trashed by GIO */
+      if (!thunar_io_trash_file (trash, lp->data, NULL))
+        g_file_trash (lp->data, exo_job_get_cancellable (EXO_JOB (job)), &err);
 
       /* update the thumbnail cache */
       thunar_thumbnail_cache_cleanup_file (thumbnail_cache, lp->data);
     }
 
+  /* sync the remaining .trashinfo files */
+  thunar_io_trash_free (trash);
+
   /* release the thumbnail cache */
   g_object_unref (thumbnail_cache);
 
@@ -847,6 +960,7 @@ thunar_io_jobs_trash_files (GList *file_list)
 {
   _thunar_return_val_if_fail (file_list != NULL, NULL);
 
+  /* trashing renames the files, so it doesn't wait for transfers */
   return thunar_simple_job_launch (_thunar_io_jobs_trash, 1,
                                    THUNAR_TYPE_G_FILE_LIST, file_list);
 }
@@ -866,7 +980,77 @@ thunar_io_jobs_restore_files (GList *source_file_list,
   job = thunar_transfer_job_new (source_file_list, target_file_list, 
                                  THUNAR_TRANSFER_JOB_MOVE);
 
-  return THUNAR_JOB (exo_job_launch (EXO_JOB (job)));
+  /* wait for other operations on the same devices */
+  return thunar_job_scheduler_launch (job, source_file_list, target_file_list, TRUE);
+}
+
+
+
+static GList *
+_tij_change_permissions (ThunarJob                 *job,
+                         GList                     *file_list,
+                         const ThunarIOPermissions *permissions,
+                         GError                   **error)
+{
+  GError *err = NULL;
+  GList  *failed_list = NULL;
+  GList  *failed_folders = NULL;
+  GList  *fallback_list = NULL;
+  GList  *lp;
+  GList  *collected;
+  guint   n_processed;
+  guint   n_changed = 0;
+
+  /* we know the total list of files to process */
+  thunar_job_set_total_files (THUNAR_JOB (job), g_list_length (file_list));
+
+  /* change local files directly, without collecting the folder contents
+   * first. files that fail are handled below, so the user can skip them */
+  for (lp = file_list, n_processed = 0; lp != NULL; lp = lp->next, n_processed++)
+    {
+      /* update progress information */
+      thunar_job_processing_file (THUNAR_JOB (job), lp->data, n_processed);
+
+      if (!thunar_io_permissions_change (job, lp->data, permissions, &n_changed,
+                                         &failed_list, &failed_folders, &err))
+        {
+          if (exo_job_is_cancelled (EXO_JOB (job)))
+            break;
+
+          /* change the file through GIO */
+          g_clear_error (&err);
+          fallback_list = g_list_prepend (fallback_list, g_object_ref (lp->data));
+        }
+    }
+
+  if (exo_job_set_error_if_cancelled (EXO_JOB (job), error))
+    {
+      g_clear_error (&err);
+      thunar_g_file_list_free (failed_list);
+      thunar_g_file_list_free (failed_folders);
+      thunar_g_file_list_free (fallback_list);
+      return NULL;
+    }
+
+  /* collect the files which could not be changed directly, including
+   * the contents of the folders that could not be read */
+  fallback_list = g_list_concat (g_list_reverse (fallback_list), g_list_reverse (failed_folders));
+  if (permissions->recursive && fallback_list != NULL)
+    {
+      collected = _tij_collect_nofollow (job, fallback_list, FALSE, &err);
+      thunar_g_file_list_free (fallback_list);
+      fallback_list = collected;
+
+      if (err != NULL)
+        {
+          g_propagate_error (error, err);
+          thunar_g_file_list_free (failed_list);
+          thunar_g_file_list_free (fallback_list);
+          return NULL;
+        }
+    }
+
+  return g_list_concat (fallback_list, g_list_reverse (failed_list));
 }
 
 
@@ -876,15 +1060,17 @@ _thunar_io_jobs_chown (ThunarJob  *job,
                        GArray     *param_values,
                        GError    **error)
 {
-  ThunarJobResponse response;
-  const gchar      *message;
-  GFileInfo        *info;
-  gboolean          recursive;
-  GError           *err = NULL;
-  GList            *file_list;
-  GList            *lp;
-  gint              uid;
-  gint              gid;
+  ThunarIOPermissions permissions;
+  ThunarJobResponse   response;
+  const gchar        *message;
+  GFileInfo          *info;
+  gboolean            recursive;
+  GError             *err = NULL;
+  GList              *file_list;
+  GList              *lp;
+  guint               n_processed;
+  gint                uid;
+  gint                gid;
 
   _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
   _thunar_return_val_if_fail (param_values != NULL, FALSE);
@@ -898,11 +1084,14 @@ _thunar_io_jobs_chown (ThunarJob  *job,
 
   _thunar_assert ((uid >= 0 || gid >= 0) && !(uid >= 0 && gid >= 0));
 
-  /* collect the files for the chown operation */
-  if (recursive)
-    file_list = _tij_collect_nofollow (job, file_list, FALSE, &err);
-  else
-    file_list = thunar_g_file_list_copy (file_list);
+  permissions.uid = uid;
+  permissions.gid = gid;
+  permissions.dir_mask = permissions.dir_mode = 0;
+  permissions.file_mask = permissions.file_mode = 0;
+  permissions.recursive = recursive;
+
+  /* change the local files, collecting the ones left to the loop below */
+  file_list = _tij_change_permissions (job, file_list, &permissions, &err);
 
   if (err != NULL)
     {
@@ -911,13 +1100,13 @@ _thunar_io_jobs_chown (ThunarJob  *job,
     }
 
   /* we know the total list of files to process */
-  thunar_job_set_total_files (THUNAR_JOB (job), file_list);
+  thunar_job_set_total_files (THUNAR_JOB (job), g_list_length (file_list));
 
   /* change the ownership of all files */
-  for (lp = file_list; lp != NULL && err == NULL; lp = lp->next)
+  for (lp = file_list, n_processed = 0; lp != NULL && err == NULL; lp = lp->next, n_processed++)
     {
       /* update progress information */
-      thunar_job_processing_file (THUNAR_JOB (job), lp);
+      thunar_job_processing_file (THUNAR_JOB (job), lp->data, n_processed);
 
       /* try to query information about the file */
       info = g_file_query_info (lp->data, 
@@ -1013,20 +1202,22 @@ _thunar_io_jobs_chmod (ThunarJob  *job,
                        GArray     *param_values,
                        GError    **error)
 {
-  ThunarJobResponse response;
-  GFileInfo        *info;
-  gboolean          recursive;
-  GError           *err = NULL;
-  GList            *file_list;
-  GList            *lp;
-  ThunarFileMode    dir_mask;
-  ThunarFileMode    dir_mode;
-  ThunarFileMode    file_mask;
-  ThunarFileMode    file_mode;
-  ThunarFileMode    mask;
-  ThunarFileMode    mode;
-  ThunarFileMode    old_mode;
-  ThunarFileMode    new_mode;
+  ThunarIOPermissions permissions;
+  ThunarJobResponse   response;
+  GFileInfo          *info;
+  gboolean            recursive;
+  GError             *err = NULL;
+  GList              *file_list;
+  GList              *lp;
+  guint               n_processed;
+  ThunarFileMode      dir_mask;
+  ThunarFileMode      dir_mode;
+  ThunarFileMode      file_mask;
+  ThunarFileMode      file_mode;
+  ThunarFileMode      mask;
+  ThunarFileMode      mode;
+  ThunarFileMode      old_mode;
+  ThunarFileMode      new_mode;
 
   _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
   _thunar_return_val_if_fail (param_values != NULL, FALSE);
@@ -1040,11 +1231,15 @@ _thunar_io_jobs_chmod (ThunarJob  *job,
   file_mode = g_value_get_flags (&g_array_index (param_values, GValue, 4));
   recursive = g_value_get_boolean (&g_array_index (param_values, GValue, 5));
 
-  /* collect the files for the chown operation */
-  if (recursive)
-    file_list = _tij_collect_nofollow (job, file_list, FALSE, &err);
-  else
-    file_list = thunar_g_file_list_copy (file_list);
+  permissions.uid = permissions.gid = -1;
+  permissions.dir_mask = dir_mask;
+  permissions.dir_mode = dir_mode;
+  permissions.file_mask = file_mask;
+  permissions.file_mode = file_mode;
+  permissions.recursive = recursive;
+
+  /* change the local files, collecting the ones left to the loop below */
+  file_list = _tij_change_permissions (job, file_list, &permissions, &err);
 
   if (err != NULL)
     {
@@ -1053,13 +1248,13 @@ _thunar_io_jobs_chmod (ThunarJob  *job,
     }
 
   /* we know the total list of files to process */
-  thunar_job_set_total_files (THUNAR_JOB (job), file_list);
+  thunar_job_set_total_files (THUNAR_JOB (job), g_list_length (file_list));
 
   /* change the ownership of all files */
-  for (lp = file_list; lp != NULL && err == NULL; lp = lp->next)
+  for (lp = file_list, n_processed = 0; lp != NULL && err == NULL; lp = lp->next, n_processed++)
     {
       /* update progress information */
-      thunar_job_processing_file (THUNAR_JOB (job), lp);
+      thunar_job_processing_file (THUNAR_JOB (job), lp->data, n_processed);
 
       /* try to query information about the file */
       info = g_file_query_info (lp->data, 
@@ -1093,7 +1288,7 @@ retry_chown:
        * information) into account */
       new_mode = ((old_mode & ~mask) | mode) & 07777;
 
-      if (old_mode != new_mode)
+      if ((old_mode & 07777) != new_mode)
         {
           /* try to change the file mode */
           g_file_set_attribute_uint32 (lp->data,
@@ -1170,9 +1365,17 @@ _thunar_io_jobs_ls (ThunarJob  *job,
                     GArray     *param_values,
                     GError    **error)
 {
-  GError *err = NULL;
-  GFile  *directory;
-  GList  *file_list = NULL;
+  GFileEnumerator *enumerator;
+  GCancellable    *cancellable;
+  ThunarFile      *file;
+  GFileInfo       *info;
+  GError          *err = NULL;
+  GFile           *directory;
+  GFile           *child;
+  GList           *file_list = NULL;
+  GPtrArray       *refresh = NULL;
+  guint            n_files = 0;
+  guint            batch_size = THUNAR_IO_JOBS_LS_FIRST_BATCH;
 
   _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
   _thunar_return_val_if_fail (param_values != NULL, FALSE);
@@ -1184,48 +1387,212 @@ _thunar_io_jobs_ls (ThunarJob  *job,
 
   /* determine the directory to list */
   directory = g_value_get_object (&g_array_index (param_values, GValue, 0));
+  cancellable = exo_job_get_cancellable (EXO_JOB (job));
 
   /* make sure the object is valid */
   _thunar_assert (G_IS_FILE (directory));
 
-  /* collect directory contents (non-recursively) */
-  file_list = thunar_io_scan_directory (job, directory,
-                                        G_FILE_QUERY_INFO_NONE, 
-                                        FALSE, FALSE, TRUE, &err);
+  /* read the directory contents (non-recursively) */
+  enumerator = g_file_enumerate_children (directory, THUNARX_FILE_INFO_NAMESPACE,
+                                          G_FILE_QUERY_INFO_NONE, cancellable, &err);
+  if (G_UNLIKELY (enumerator == NULL))
+    {
+      /* a folder that vanished is just empty */
+      if (g_error_matches (err, G_IO_ERROR, G_IO_ERROR_NOT_FOUND)
+          || g_error_matches (err, G_IO_ERROR, G_IO_ERROR_NOT_DIRECTORY))
+        {
+          g_error_free (err);
+          return TRUE;
+        }
+
+      g_propagate_error (error, err);
+      return FALSE;
+    }
+
+  while (!exo_job_is_cancelled (EXO_JOB (job)))
+    {
+      info = g_file_enumerator_next_file (enumerator, cancellable, &err);
+      if (G_UNLIKELY (info == NULL))
+        break;
+
+      child = g_file_get_child (directory, g_file_info_get_name (info));
+      file = thunar_file_cache_lookup (child);
+      if (G_UNLIKELY (file != NULL))
+        {
+          /* files of a folder reopened from the cache were not monitored
+           * in the meantime, refresh them from the info we already have
+           * in the main loop, instead of querying every file again */
+          if (refresh == NULL)
+            refresh = g_ptr_array_new_with_free_func (g_object_unref);
+          g_ptr_array_add (refresh, g_object_ref (G_OBJECT (file)));
+          g_ptr_array_add (refresh, g_object_ref (G_OBJECT (info)));
+        }
+      else
+        {
+          file = thunar_file_get_with_info (child, info, FALSE);
+        }
+      file_list = thunar_g_file_list_prepend (file_list, file);
+      g_object_unref (G_OBJECT (file));
+      g_object_unref (child);
+      g_object_unref (info);
+
+      /* hand out the first files early, so they can be shown while
+       * the rest of the folder is read in growing batches */
+      if (++n_files == batch_size)
+        {
+          if (!thunar_job_files_ready (THUNAR_JOB (job), file_list))
+            thunar_g_file_list_free (file_list);
+
+          file_list = NULL;
+          n_files = 0;
+          batch_size = MIN (batch_size * 2, THUNAR_IO_JOBS_LS_MAX_BATCH);
+        }
+    }
+
+  g_object_unref (enumerator);
+
+  if (refresh != NULL)
+    g_idle_add (_thunar_io_jobs_ls_refresh_idle, refresh);
 
   /* abort on errors or cancellation */
   if (err != NULL)
     {
       g_propagate_error (error, err);
+      thunar_g_file_list_free (file_list);
       return FALSE;
     }
-  else if (exo_job_set_error_if_cancelled (EXO_JOB (job), &err))
+  else if (exo_job_set_error_if_cancelled (EXO_JOB (job), error))
     {
-      g_propagate_error (error, err);
+      thunar_g_file_list_free (file_list);
       return FALSE;
     }
 
-  /* check if we have any files to report */
-  if (G_LIKELY (file_list != NULL))
+  /* emit the "files-ready" signal for the remaining files */
+  if (G_LIKELY (file_list != NULL)
+      && !thunar_job_files_ready (THUNAR_JOB (job), file_list))
+    {
+      /* none of the handlers took over the file list, so it's up to us
+       * to destroy it */
+      thunar_g_file_list_free (file_list);
+    }
+
+  return TRUE;
+}
+
+
+
+ThunarJob *
+thunar_io_jobs_list_directory (GFile *directory)
+{
+  _thunar_return_val_if_fail (G_IS_FILE (directory), NULL);
+  
+  return thunar_simple_job_launch (_thunar_io_jobs_ls, 1, G_TYPE_FILE, directory);
+}
+
+
+
+static gboolean
+_thunar_io_jobs_ls_directories (ThunarJob  *job,
+                                GArray     *param_values,
+                                GError    **error)
+{
+  GFileEnumerator *enumerator;
+  GCancellable    *cancellable;
+  ThunarFile      *file;
+  GFileInfo       *info;
+  GFileInfo       *child_info;
+  GPtrArray       *refresh = NULL;
+  GError          *err = NULL;
+  GFile           *directory;
+  GFile           *child;
+  GList           *file_list = NULL;
+
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
+  _thunar_return_val_if_fail (param_values != NULL, FALSE);
+  _thunar_return_val_if_fail (param_values->len == 1, FALSE);
+  _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  if (exo_job_set_error_if_cancelled (EXO_JOB (job), error))
+    return FALSE;
+
+  /* determine the directory to list */
+  directory = g_value_get_object (&g_array_index (param_values, GValue, 0));
+  cancellable = exo_job_get_cancellable (EXO_JOB (job));
+
+  /* only ask for the name and type, which the local backend can
+   * usually answer from the directory entry without a stat() */
+  enumerator = g_file_enumerate_children (directory,
+                                          G_FILE_ATTRIBUTE_STANDARD_TYPE ","
+                                          G_FILE_ATTRIBUTE_STANDARD_NAME,
+                                          G_FILE_QUERY_INFO_NONE,
+                                          cancellable, error);
+  if (G_UNLIKELY (enumerator == NULL))
+    return FALSE;
+
+  while (!exo_job_is_cancelled (EXO_JOB (job)))
     {
-      /* emit the "files-ready" signal */
-      if (!thunar_job_files_ready (THUNAR_JOB (job), file_list))
+      info = g_file_enumerator_next_file (enumerator, cancellable, &err);
+      if (G_UNLIKELY (info == NULL))
+        break;
+
+      /* only the directories get the full info and a ThunarFile */
+      if (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY)
         {
-          /* none of the handlers took over the file list, so it's up to us
-           * to destroy it */
-          thunar_g_file_list_free (file_list);
+          child = g_file_get_child (directory, g_file_info_get_name (info));
+          child_info = g_file_query_info (child, THUNARX_FILE_INFO_NAMESPACE,
+                                          G_FILE_QUERY_INFO_NONE, cancellable, NULL);
+          if (G_LIKELY (child_info != NULL))
+            {
+              file = thunar_file_cache_lookup (child);
+              if (file != NULL)
+                {
+                  /* refresh folders we already know of on the main thread */
+                  if (refresh == NULL)
+                    refresh = g_ptr_array_new_with_free_func (g_object_unref);
+                  g_ptr_array_add (refresh, g_object_ref (G_OBJECT (file)));
+                  g_ptr_array_add (refresh, g_object_ref (G_OBJECT (child_info)));
+                }
+              else
+                {
+                  file = thunar_file_get_with_info (child, child_info, FALSE);
+                }
+
+              file_list = thunar_g_file_list_prepend (file_list, file);
+              g_object_unref (G_OBJECT (file));
+              g_object_unref (child_info);
+            }
+          g_object_unref (child);
         }
+
+      g_object_unref (info);
     }
-  
-  /* there should be no errors here */
-  _thunar_assert (err == NULL);
 
-  /* propagate cancellation error */
-  if (exo_job_set_error_if_cancelled (EXO_JOB (job), &err))
+  g_object_unref (enumerator);
+
+  if (refresh != NULL)
+    g_idle_add (_thunar_io_jobs_ls_refresh_idle, refresh);
+
+  /* abort on errors or cancellation */
+  if (err != NULL)
     {
       g_propagate_error (error, err);
+      thunar_g_file_list_free (file_list);
       return FALSE;
     }
+  else if (exo_job_set_error_if_cancelled (EXO_JOB (job), error))
+    {
+      thunar_g_file_list_free (file_list);
+      return FALSE;
+    }
+
+  /* emit the "files-ready" signal */
+  if (G_LIKELY (file_list != NULL)
+      && !thunar_job_files_ready (THUNAR_JOB (job), file_list))
+    {
+      /* none of the handlers took over the file list, so it's up to us
+       * to destroy it */
+      thunar_g_file_list_free (file_list);
+    }
 
   return TRUE;
 }
@@ -1233,11 +1600,11 @@ _thunar_io_jobs_ls (ThunarJob  *job,
 
 
 ThunarJob *
-thunar_io_jobs_list_directory (GFile *directory)
+thunar_io_jobs_list_directories (GFile *directory)
 {
   _thunar_return_val_if_fail (G_IS_FILE (directory), NULL);
-  
-  return thunar_simple_job_launch (_thunar_io_jobs_ls, 1, G_TYPE_FILE, directory);
+
+  return thunar_simple_job_launch (_thunar_io_jobs_ls_directories, 1, G_TYPE_FILE, directory);
 }
 
 
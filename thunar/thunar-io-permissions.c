@@ -0,0 +1,536 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Xfce development team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_SYS_TYPES_H
+#include <sys/types.h>
+#endif
+#ifdef HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+
+#ifdef HAVE_DIRENT_H
+#include <dirent.h>
+#endif
+#ifdef HAVE_ERRNO_H
+#include <errno.h>
+#endif
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#include <gio/gio.h>
+
+#include <exo/exo.h>
+
+#include <thunar/thunar-gio-extensions.h>
+#include <thunar/thunar-io-permissions.h>
+#include <thunar/thunar-private.h>
+
+#if defined (HAVE_FCHMODAT) && defined (HAVE_FCHOWNAT) && defined (HAVE_FDOPENDIR) \
+ && defined (HAVE_FSTATAT) && defined (HAVE_OPENAT)
+#define THUNAR_IO_PERMISSIONS_AT 1
+#endif
+
+#ifndef O_CLOEXEC
+#define O_CLOEXEC 0
+#endif
+
+
+
+/* number of threads changing sub folders concurrently */
+#define THUNAR_IO_PERMISSIONS_THREADS (4)
+
+/* minimum time between two progress updates */
+#define THUNAR_IO_PERMISSIONS_UPDATE_INTERVAL (500 * 1000) /* 500 ms */
+
+
+
+#ifdef THUNAR_IO_PERMISSIONS_AT
+typedef struct
+{
+  ThunarJob                 *job;
+  const ThunarIOPermissions *permissions;
+
+  /* the selected folder, its sub folders are handled by the pool */
+  gint                       fd;
+  gchar                     *path;
+
+  volatile gint              n_pending;
+  volatile gint              n_processed;
+
+  /* GFiles that could not be changed */
+  GAsyncQueue               *failed;
+
+  /* GFiles of folders whose contents could not be read */
+  GAsyncQueue               *failed_folders;
+
+  gint64                     last_update_time;
+} ThunarIOChange;
+
+
+
+static void
+thunar_io_permissions_fail (ThunarIOChange *change,
+                            const gchar    *dir_path,
+                            const gchar    *name)
+{
+  gchar *path;
+
+  path = g_build_filename (dir_path, name, NULL);
+  g_async_queue_push (change->failed, g_file_new_for_path (path));
+  g_free (path);
+}
+
+
+
+static void
+thunar_io_permissions_fail_folder (ThunarIOChange *change,
+                                   const gchar    *path)
+{
+  g_async_queue_push (change->failed_folders, g_file_new_for_path (path));
+}
+
+
+
+static void
+thunar_io_permissions_progress (ThunarIOChange *change)
+{
+  gint64 current_time;
+  guint  n_processed;
+
+  /* notify callers not more then every 500ms */
+  current_time = g_get_monotonic_time ();
+  if (current_time - change->last_update_time < THUNAR_IO_PERMISSIONS_UPDATE_INTERVAL)
+    return;
+  change->last_update_time = current_time;
+
+  n_processed = g_atomic_int_get (&change->n_processed);
+  exo_job_info_message (EXO_JOB (change->job),
+                        ngettext ("Processed %u file", "Processed %u files", n_processed),
+                        n_processed);
+}
+
+
+
+static guint
+thunar_io_permissions_new_mode (ThunarIOChange    *change,
+                                const struct stat *statb)
+{
+  const ThunarIOPermissions *permissions = change->permissions;
+
+  /* generate the new mode, the file type bits are not part of it */
+  if (S_ISDIR (statb->st_mode))
+    return ((statb->st_mode & ~permissions->dir_mask) | permissions->dir_mode) & 07777;
+  else
+    return ((statb->st_mode & ~permissions->file_mask) | permissions->file_mode) & 07777;
+}
+
+
+
+static void
+thunar_io_permissions_apply (ThunarIOChange    *change,
+                             gint               dir_fd,
+                             const gchar       *dir_path,
+                             const gchar       *name,
+                             const struct stat *statb)
+{
+  const ThunarIOPermissions *permissions = change->permissions;
+  guint                      new_mode;
+  uid_t                      uid;
+  gid_t                      gid;
+
+  g_atomic_int_inc (&change->n_processed);
+
+  /* change the owner or group, unless the file already has them */
+  uid = (permissions->uid >= 0) ? (uid_t) permissions->uid : statb->st_uid;
+  gid = (permissions->gid >= 0) ? (gid_t) permissions->gid : statb->st_gid;
+  if ((uid != statb->st_uid || gid != statb->st_gid)
+      && fchownat (dir_fd, name, uid, gid, AT_SYMLINK_NOFOLLOW) < 0
+      && errno != ENOENT)
+    {
+      thunar_io_permissions_fail (change, dir_path, name);
+      return;
+    }
+
+  /* the mode of symlinks cannot be changed */
+  if (S_ISLNK (statb->st_mode))
+    return;
+
+  /* change the mode, unless the file already has it */
+  new_mode = thunar_io_permissions_new_mode (change, statb);
+  if (new_mode != (statb->st_mode & 07777)
+      && fchmodat (dir_fd, name, new_mode, 0) < 0
+      && errno != ENOENT)
+    {
+      thunar_io_permissions_fail (change, dir_path, name);
+    }
+}
+
+
+
+static gboolean thunar_io_permissions_contents (ThunarIOChange *change,
+                                                gint            fd,
+                                                const gchar    *path);
+
+
+
+static void
+thunar_io_permissions_entry (ThunarIOChange *change,
+                             gint            dir_fd,
+                             const gchar    *dir_path,
+                             const gchar    *name)
+{
+  struct stat statb;
+  gboolean    readable;
+  gchar      *path;
+  gint        fd;
+
+  if (fstatat (dir_fd, name, &statb, AT_SYMLINK_NOFOLLOW) < 0)
+    {
+      if (errno != ENOENT)
+        thunar_io_permissions_fail (change, dir_path, name);
+      return;
+    }
+
+  if (!S_ISDIR (statb.st_mode) || !change->permissions->recursive)
+    {
+      thunar_io_permissions_apply (change, dir_fd, dir_path, name, &statb);
+      return;
+    }
+
+  /* change the folder first if it stays readable, otherwise only
+   * after its contents were changed */
+  readable = ((thunar_io_permissions_new_mode (change, &statb) & (S_IRUSR | S_IXUSR)) == (S_IRUSR | S_IXUSR));
+  if (readable)
+    thunar_io_permissions_apply (change, dir_fd, dir_path, name, &statb);
+
+  /* the contents of a folder that cannot be read are changed
+   * through GIO, which walks the folder again */
+  path = g_build_filename (dir_path, name, NULL);
+  fd = openat (dir_fd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+  if (G_UNLIKELY (fd < 0))
+    {
+      if (errno != ENOENT)
+        thunar_io_permissions_fail_folder (change, path);
+    }
+  else if (!thunar_io_permissions_contents (change, fd, path))
+    {
+      thunar_io_permissions_fail_folder (change, path);
+    }
+  g_free (path);
+
+  if (!readable)
+    thunar_io_permissions_apply (change, dir_fd, dir_path, name, &statb);
+}
+
+
+
+static gboolean
+thunar_io_permissions_contents (ThunarIOChange *change,
+                                gint            fd,
+                                const gchar    *path)
+{
+  struct dirent *dp;
+  gboolean       succeed = TRUE;
+  DIR           *dir;
+
+  /* the DIR owns the file descriptor from now on */
+  dir = fdopendir (fd);
+  if (G_UNLIKELY (dir == NULL))
+    {
+      close (fd);
+      return FALSE;
+    }
+
+  while (!exo_job_is_cancelled (EXO_JOB (change->job)))
+    {
+      /* readdir() only sets errno on errors */
+      errno = 0;
+      dp = readdir (dir);
+      if (dp == NULL)
+        {
+          succeed = (errno == 0);
+          break;
+        }
+
+      /* skip "." and ".." */
+      if (dp->d_name[0] == '.'
+          && (dp->d_name[1] == '\0' || (dp->d_name[1] == '.' && dp->d_name[2] == '\0')))
+        continue;
+
+      thunar_io_permissions_entry (change, dirfd (dir), path, dp->d_name);
+    }
+
+  closedir (dir);
+
+  return succeed;
+}
+
+
+
+static void
+thunar_io_permissions_sub_folder (gpointer data,
+                                  gpointer user_data)
+{
+  ThunarIOChange *change = user_data;
+  gchar          *name = data;
+
+  if (!exo_job_is_cancelled (EXO_JOB (change->job)))
+    thunar_io_permissions_entry (change, change->fd, change->path, name);
+
+  g_free (name);
+
+  g_atomic_int_add (&change->n_pending, -1);
+}
+
+
+
+static void
+thunar_io_permissions_folder (ThunarIOChange *change)
+{
+  struct dirent *dp;
+  GThreadPool   *pool;
+  DIR           *dir;
+  gint           fd;
+
+  /* the DIR needs its own file descriptor, change->fd is shared with the pool */
+  fd = dup (change->fd);
+  dir = (fd < 0) ? NULL : fdopendir (fd);
+  if (G_UNLIKELY (dir == NULL))
+    {
+      if (fd >= 0)
+        close (fd);
+      thunar_io_permissions_fail_folder (change, change->path);
+      return;
+    }
+
+  pool = g_thread_pool_new (thunar_io_permissions_sub_folder, change,
+                            THUNAR_IO_PERMISSIONS_THREADS, FALSE, NULL);
+
+  /* change the files right away and hand the sub folders to the pool */
+  while (!exo_job_is_cancelled (EXO_JOB (change->job)))
+    {
+      /* readdir() only sets errno on errors */
+      errno = 0;
+      dp = readdir (dir);
+      if (dp == NULL)
+        {
+          if (G_UNLIKELY (errno != 0))
+            thunar_io_permissions_fail_folder (change, change->path);
+          break;
+        }
+
+      /* skip "." and ".." */
+      if (dp->d_name[0] == '.'
+          && (dp->d_name[1] == '\0' || (dp->d_name[1] == '.' && dp->d_name[2] == '\0')))
+        continue;
+
+#ifdef _DIRENT_HAVE_D_TYPE
+      if (dp->d_type == DT_DIR)
+        {
+          g_atomic_int_inc (&change->n_pending);
+          g_thread_pool_push (pool, g_strdup (dp->d_name), NULL);
+        }
+      else
+#endif
+        {
+          thunar_io_permissions_entry (change, change->fd, change->path, dp->d_name);
+        }
+
+      thunar_io_permissions_progress (change);
+    }
+
+  closedir (dir);
+
+  /* report the progress until the pool is done */
+  while (g_atomic_int_get (&change->n_pending) > 0)
+    {
+      g_usleep (G_USEC_PER_SEC / 20);
+      thunar_io_permissions_progress (change);
+    }
+
+  g_thread_pool_free (pool, FALSE, TRUE);
+}
+#endif
+
+
+
+/**
+ * thunar_io_permissions_change:
+ * @job            : a #ThunarJob.
+ * @file           : the #GFile to change.
+ * @permissions    : the changes to apply.
+ * @n_processed    : the number of files processed so far, updated.
+ * @failed_files   : return location for the #GFile<!---->s that could
+ *                   not be changed.
+ * @failed_folders : return location for the folders whose contents
+ *                   could not be read.
+ * @error          : return location for errors or %NULL.
+ *
+ * Changes the owner, group and mode of the local @file according to
+ * @permissions, and of all its contents if @file is a folder and the
+ * change is recursive. Symlinks are not followed and files which
+ * already match @permissions are left alone.
+ *
+ * The folder is traversed relative to open directory file descriptors,
+ * the sub folders of @file are changed in parallel. Files that could
+ * not be changed do not stop the operation, they are prepended to
+ * @failed_files instead. Folders that could not be opened or read are
+ * prepended to @failed_folders, their contents need to be walked and
+ * changed through GIO.
+ *
+ * %G_IO_ERROR_NOT_SUPPORTED is returned for non-local files, which
+ * need to be changed through GIO.
+ *
+ * Return value: %TRUE if @file was processed, %FALSE otherwise.
+ **/
+gboolean
+thunar_io_permissions_change (ThunarJob                 *job,
+                              GFile                     *file,
+                              const ThunarIOPermissions *permissions,
+                              guint                     *n_processed,
+                              GList                    **failed_files,
+                              GList                    **failed_folders,
+                              GError                   **error)
+{
+#ifdef THUNAR_IO_PERMISSIONS_AT
+  ThunarIOChange change;
+  struct stat    statb;
+  gboolean       readable;
+  GFile         *failed;
+  GList         *folders = NULL;
+  GList         *lp;
+  gchar         *path;
+  gchar         *parent_path;
+  gchar         *name;
+  gint           parent_fd;
+
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
+  _thunar_return_val_if_fail (G_IS_FILE (file), FALSE);
+  _thunar_return_val_if_fail (permissions != NULL, FALSE);
+  _thunar_return_val_if_fail (n_processed != NULL, FALSE);
+  _thunar_return_val_if_fail (failed_files != NULL, FALSE);
+  _thunar_return_val_if_fail (failed_folders != NULL, FALSE);
+  _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  if (exo_job_set_error_if_cancelled (EXO_JOB (job), error))
+    return FALSE;
+
+  path = g_file_is_native (file) ? g_file_get_path (file) : NULL;
+  if (G_UNLIKELY (path == NULL))
+    {
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                           "Not a local file");
+      return FALSE;
+    }
+
+  parent_path = g_path_get_dirname (path);
+  name = g_path_get_basename (path);
+
+  change.job = job;
+  change.permissions = permissions;
+  change.fd = -1;
+  change.path = path;
+  change.n_pending = 0;
+  change.n_processed = *n_processed;
+  change.failed = g_async_queue_new ();
+  change.failed_folders = g_async_queue_new ();
+  change.last_update_time = 0;
+
+  parent_fd = open (parent_path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (G_UNLIKELY (parent_fd < 0 || fstatat (parent_fd, name, &statb, AT_SYMLINK_NOFOLLOW) < 0))
+    {
+      thunar_io_permissions_fail (&change, parent_path, name);
+    }
+  else if (!S_ISDIR (statb.st_mode) || !permissions->recursive)
+    {
+      thunar_io_permissions_apply (&change, parent_fd, parent_path, name, &statb);
+    }
+  else
+    {
+      /* same order as for the sub folders */
+      readable = ((thunar_io_permissions_new_mode (&change, &statb) & (S_IRUSR | S_IXUSR)) == (S_IRUSR | S_IXUSR));
+      if (readable)
+        thunar_io_permissions_apply (&change, parent_fd, parent_path, name, &statb);
+
+      change.fd = openat (parent_fd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+      if (G_UNLIKELY (change.fd < 0))
+        {
+          thunar_io_permissions_fail_folder (&change, path);
+        }
+      else
+        {
+          thunar_io_permissions_folder (&change);
+          close (change.fd);
+        }
+
+      if (!readable)
+        thunar_io_permissions_apply (&change, parent_fd, parent_path, name, &statb);
+    }
+
+  if (parent_fd >= 0)
+    close (parent_fd);
+
+  /* hand over the folders that could not be read. They are walked again
+   * through GIO, so their failed contents don't need to be handed over */
+  while ((failed = g_async_queue_try_pop (change.failed_folders)) != NULL)
+    {
+      folders = g_list_prepend (folders, failed);
+      *failed_folders = g_list_prepend (*failed_folders, g_object_ref (failed));
+    }
+  g_async_queue_unref (change.failed_folders);
+
+  /* hand over the files that could not be changed */
+  while ((failed = g_async_queue_try_pop (change.failed)) != NULL)
+    {
+      for (lp = folders; lp != NULL; lp = lp->next)
+        if (g_file_equal (failed, lp->data) || g_file_has_prefix (failed, lp->data))
+          break;
+
+      if (lp == NULL)
+        *failed_files = g_list_prepend (*failed_files, failed);
+      else
+        g_object_unref (failed);
+    }
+  g_async_queue_unref (change.failed);
+
+  thunar_g_file_list_free (folders);
+
+  *n_processed = change.n_processed;
+
+  g_free (parent_path);
+  g_free (name);
+  g_free (path);
+
+  return !exo_job_set_error_if_cancelled (EXO_JOB (job), error);
+#else
+  g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                       "Not supported");
+  return FALSE;
+#endif
+}
@@ -0,0 +1,55 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Xfce development team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __THUNAR_IO_PERMISSIONS_H__
+#define __THUNAR_IO_PERMISSIONS_H__
+
+#include <thunar/thunar-job.h>
+
+G_BEGIN_DECLS
+
+typedef struct _ThunarIOPermissions ThunarIOPermissions;
+
+struct _ThunarIOPermissions
+{
+  /* the new owner and group, -1 to leave them unchanged */
+  gint     uid;
+  gint     gid;
+
+  /* the permission bits to change for folders and other files */
+  guint    dir_mask;
+  guint    dir_mode;
+  guint    file_mask;
+  guint    file_mode;
+
+  gboolean recursive;
+};
+
+gboolean thunar_io_permissions_change (ThunarJob                 *job,
+                                       GFile                     *file,
+                                       const ThunarIOPermissions *permissions,
+                                       guint                     *n_processed,
+                                       GList                    **failed_files,
+                                       GList                    **failed_folders,
+                                       GError                   **error);
+
+G_END_DECLS
+
+#endif /* !__THUNAR_IO_PERMISSIONS_H__ */
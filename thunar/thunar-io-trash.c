@@ -0,0 +1,465 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Xfce development team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_SYS_TYPES_H
+#include <sys/types.h>
+#endif
+#ifdef HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+
+#ifdef HAVE_DIRENT_H
+#include <dirent.h>
+#endif
+#ifdef HAVE_ERRNO_H
+#include <errno.h>
+#endif
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#include <gio/gio.h>
+#include <glib/gstdio.h>
+
+#include <exo/exo.h>
+
+#include <thunar/thunar-io-delete.h>
+#include <thunar/thunar-io-trash.h>
+#include <thunar/thunar-private.h>
+
+#ifndef O_CLOEXEC
+#define O_CLOEXEC 0
+#endif
+
+
+
+/* number of .trashinfo files written before the info folder is synced */
+#define THUNAR_IO_TRASH_BATCH_SIZE (100)
+
+
+
+struct _ThunarIOTrash
+{
+  /* the home trash, see the freedesktop.org trash specification */
+  gchar    *files_path;
+  gchar    *info_path;
+  dev_t     device;
+  gboolean  prepared;
+
+  /* the info folder, synced after every batch of .trashinfo files */
+  gint      info_fd;
+  guint     n_unsynced;
+};
+
+
+
+static void
+thunar_io_trash_set_error (GError     **error,
+                           const gchar *path,
+                           gint         errsv)
+{
+  gchar *display_name;
+
+  display_name = g_filename_display_name (path);
+  g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errsv),
+               "%s: %s", display_name, g_strerror (errsv));
+  g_free (display_name);
+}
+
+
+
+static gboolean
+thunar_io_trash_prepare (ThunarIOTrash *trash,
+                         GError       **error)
+{
+  struct stat statb;
+  gchar      *trash_path;
+
+  if (G_LIKELY (trash->prepared))
+    {
+      if (trash->info_fd >= 0)
+        return TRUE;
+
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                           "The home trash is not available");
+      return FALSE;
+    }
+
+  trash->prepared = TRUE;
+
+  trash_path = g_build_filename (g_get_user_data_dir (), "Trash", NULL);
+  trash->files_path = g_build_filename (trash_path, "files", NULL);
+  trash->info_path = g_build_filename (trash_path, "info", NULL);
+  g_free (trash_path);
+
+  /* make sure the home trash exists */
+  if (g_mkdir_with_parents (trash->files_path, 0700) < 0
+      || g_mkdir_with_parents (trash->info_path, 0700) < 0)
+    {
+      thunar_io_trash_set_error (error, trash->info_path, errno);
+      return FALSE;
+    }
+
+  trash->info_fd = open (trash->info_path, O_RDONLY | O_CLOEXEC);
+  if (G_UNLIKELY (trash->info_fd < 0))
+    {
+      thunar_io_trash_set_error (error, trash->info_path, errno);
+      return FALSE;
+    }
+
+  /* files can only be renamed into the trash on the same device */
+  if (fstat (trash->info_fd, &statb) < 0)
+    {
+      thunar_io_trash_set_error (error, trash->info_path, errno);
+      close (trash->info_fd);
+      trash->info_fd = -1;
+      return FALSE;
+    }
+  trash->device = statb.st_dev;
+
+  return TRUE;
+}
+
+
+
+static gboolean
+thunar_io_trash_path_is_within (const gchar *path,
+                                const gchar *folder)
+{
+  gsize length = strlen (folder);
+
+  /* compare whole path components, "Trash-old" is not in "Trash" */
+  return (strncmp (path, folder, length) == 0
+          && (path[length] == '\0' || path[length] == G_DIR_SEPARATOR
+              || (length > 0 && folder[length - 1] == G_DIR_SEPARATOR)));
+}
+
+
+
+static gboolean
+thunar_io_trash_write (gint         fd,
+                       const gchar *data,
+                       gsize        length)
+{
+  gssize n;
+
+  while (length > 0)
+    {
+      n = write (fd, data, length);
+      if (n < 0)
+        {
+          if (errno == EINTR)
+            continue;
+          return FALSE;
+        }
+
+      data += n;
+      length -= n;
+    }
+
+  return TRUE;
+}
+
+
+
+/**
+ * thunar_io_trash_new:
+ *
+ * Allocates a new #ThunarIOTrash, which moves files into the trash of
+ * the user without going through the trash backend of GIO. The
+ * .trashinfo files are written in batches, the info folder is only
+ * synced every now and then and when the #ThunarIOTrash is freed.
+ *
+ * Return value: the newly allocated #ThunarIOTrash.
+ **/
+ThunarIOTrash *
+thunar_io_trash_new (void)
+{
+  ThunarIOTrash *trash;
+
+  trash = g_slice_new0 (ThunarIOTrash);
+  trash->info_fd = -1;
+
+  return trash;
+}
+
+
+
+/**
+ * thunar_io_trash_free:
+ * @trash : a #ThunarIOTrash.
+ *
+ * Syncs the .trashinfo files written by @trash and frees it.
+ **/
+void
+thunar_io_trash_free (ThunarIOTrash *trash)
+{
+  if (trash->info_fd >= 0)
+    {
+      if (trash->n_unsynced > 0)
+        fsync (trash->info_fd);
+      close (trash->info_fd);
+    }
+
+  g_free (trash->files_path);
+  g_free (trash->info_path);
+  g_slice_free (ThunarIOTrash, trash);
+}
+
+
+
+/**
+ * thunar_io_trash_file:
+ * @trash : a #ThunarIOTrash.
+ * @file  : the #GFile to move into the trash.
+ * @error : return location for errors or %NULL.
+ *
+ * Moves the local @file, including all its contents if it is a folder,
+ * into the home trash with a single rename.
+ *
+ * %G_IO_ERROR_NOT_SUPPORTED is returned if @file is not local or on
+ * another device than the home trash, in which case g_file_trash()
+ * has to be used instead.
+ *
+ * Return value: %TRUE if @file was moved into the trash.
+ **/
+gboolean
+thunar_io_trash_file (ThunarIOTrash *trash,
+                      GFile         *file,
+                      GError       **error)
+{
+  struct stat statb;
+  GDateTime  *now;
+  gboolean    succeed = FALSE;
+  gchar      *path;
+  gchar      *base_name;
+  gchar      *trash_name;
+  gchar      *info_name;
+  gchar      *info_file;
+  gchar      *target_path;
+  gchar      *escaped_path;
+  gchar      *date;
+  gchar      *data;
+  guint       n;
+  gint        fd;
+
+  _thunar_return_val_if_fail (trash != NULL, FALSE);
+  _thunar_return_val_if_fail (G_IS_FILE (file), FALSE);
+  _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  if (!thunar_io_trash_prepare (trash, error))
+    return FALSE;
+
+  path = g_file_is_native (file) ? g_file_get_path (file) : NULL;
+  if (G_UNLIKELY (path == NULL))
+    {
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                           "Not a local file");
+      return FALSE;
+    }
+
+  /* only handle files that can be renamed into the home trash and
+   * leave everything else, like the trash itself, to GIO */
+  if (g_lstat (path, &statb) < 0)
+    {
+      thunar_io_trash_set_error (error, path, errno);
+      g_free (path);
+      return FALSE;
+    }
+
+  if (statb.st_dev != trash->device
+      || thunar_io_trash_path_is_within (trash->files_path, path)
+      || thunar_io_trash_path_is_within (path, trash->files_path)
+      || thunar_io_trash_path_is_within (path, trash->info_path))
+    {
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                           "Not on the device of the home trash");
+      g_free (path);
+      return FALSE;
+    }
+
+  /* reserve a unique name in the trash by creating the .trashinfo file */
+  base_name = g_path_get_basename (path);
+  for (n = 1, fd = -1; fd < 0; n++)
+    {
+      if (n == 1)
+        trash_name = g_strdup (base_name);
+      else
+        trash_name = g_strdup_printf ("%s.%u", base_name, n);
+
+      info_name = g_strconcat (trash_name, ".trashinfo", NULL);
+      info_file = g_build_filename (trash->info_path, info_name, NULL);
+      g_free (info_name);
+
+      fd = open (info_file, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+      if (fd < 0)
+        {
+          if (errno != EEXIST)
+            {
+              thunar_io_trash_set_error (error, info_file, errno);
+              g_free (info_file);
+              g_free (trash_name);
+              g_free (base_name);
+              g_free (path);
+              return FALSE;
+            }
+
+          g_free (info_file);
+          g_free (trash_name);
+        }
+    }
+  g_free (base_name);
+
+  /* write the .trashinfo file, without syncing it right away */
+  now = g_date_time_new_now_local ();
+  date = g_date_time_format (now, "%Y-%m-%dT%H:%M:%S");
+  g_date_time_unref (now);
+
+  escaped_path = g_uri_escape_string (path, "/", FALSE);
+  data = g_strdup_printf ("[Trash Info]\nPath=%s\nDeletionDate=%s\n", escaped_path, date);
+  g_free (escaped_path);
+  g_free (date);
+
+  if (!thunar_io_trash_write (fd, data, strlen (data)))
+    {
+      thunar_io_trash_set_error (error, info_file, errno);
+      close (fd);
+    }
+  else if (close (fd) < 0)
+    {
+      thunar_io_trash_set_error (error, info_file, errno);
+    }
+  else
+    {
+      /* move the file or the whole folder into the trash */
+      target_path = g_build_filename (trash->files_path, trash_name, NULL);
+      if (g_rename (path, target_path) < 0)
+        thunar_io_trash_set_error (error, path, errno);
+      else
+        succeed = TRUE;
+      g_free (target_path);
+    }
+  g_free (data);
+
+  if (G_UNLIKELY (!succeed))
+    {
+      /* release the reserved name again */
+      g_unlink (info_file);
+    }
+  else if (++trash->n_unsynced >= THUNAR_IO_TRASH_BATCH_SIZE)
+    {
+      /* make the batch of .trashinfo files persistent */
+      fsync (trash->info_fd);
+      trash->n_unsynced = 0;
+    }
+
+  g_free (info_file);
+  g_free (trash_name);
+  g_free (path);
+
+  return succeed;
+}
+
+
+
+/**
+ * thunar_io_trash_empty:
+ * @job             : a #ThunarJob.
+ * @thumbnail_cache : the #ThunarThumbnailCache to notify.
+ * @n_deleted       : the number of files deleted so far, updated.
+ * @error           : return location for errors or %NULL.
+ *
+ * Deletes the contents of the home trash directly, instead of
+ * collecting them through the trash backend of GIO first. The trash
+ * folders on other devices are not touched.
+ *
+ * Return value: %TRUE if the home trash is empty, %FALSE otherwise.
+ **/
+gboolean
+thunar_io_trash_empty (ThunarJob            *job,
+                       ThunarThumbnailCache *thumbnail_cache,
+                       guint                *n_deleted,
+                       GError              **error)
+{
+  struct dirent *dp;
+  gboolean       succeed = TRUE;
+  GFile         *file;
+  gchar         *trash_path;
+  gchar         *child_path;
+  gchar         *path;
+  DIR           *dir;
+  guint          n;
+
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
+  _thunar_return_val_if_fail (n_deleted != NULL, FALSE);
+  _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  trash_path = g_build_filename (g_get_user_data_dir (), "Trash", NULL);
+
+  /* delete the files first and the .trashinfo files afterwards, so
+   * the trash view never shows entries without information */
+  for (n = 0; succeed && n < 2; n++)
+    {
+      path = g_build_filename (trash_path, (n == 0) ? "files" : "info", NULL);
+      dir = opendir (path);
+      if (dir == NULL)
+        {
+          /* nothing to delete */
+          if (errno != ENOENT)
+            {
+              thunar_io_trash_set_error (error, path, errno);
+              succeed = FALSE;
+            }
+          g_free (path);
+          continue;
+        }
+
+      while (succeed && (dp = readdir (dir)) != NULL)
+        {
+          if (strcmp (dp->d_name, ".") == 0 || strcmp (dp->d_name, "..") == 0)
+            continue;
+
+          child_path = g_build_filename (path, dp->d_name, NULL);
+          file = g_file_new_for_path (child_path);
+          g_free (child_path);
+
+          succeed = thunar_io_delete_tree (job, file, thumbnail_cache, n_deleted, error);
+          g_object_unref (file);
+        }
+
+      closedir (dir);
+      g_free (path);
+    }
+
+  g_free (trash_path);
+
+  return succeed;
+}
@@ -0,0 +1,338 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Xfce development team
+ *
+ * This program is free software; you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of 
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the 
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public 
+ * License along with this program; if not, write to the Free 
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <exo/exo.h>
+
+#include <thunar/thunar-job-scheduler.h>
+#include <thunar/thunar-private.h>
+
+
+
+/* number of jobs that may use the same device at once */
+#define THUNAR_JOB_SCHEDULER_MAX_PER_DEVICE (1)
+
+
+
+typedef struct
+{
+  ThunarJob *job;
+  GPtrArray *devices;
+
+  /* device lookups that did not return yet */
+  guint      n_pending;
+
+  /* last queue position shown to the user */
+  guint      position;
+
+  gulong     cancelled_id;
+  gulong     finished_id;
+  guint      launched : 1;
+
+  /* moves within a single device are renames, which don't
+   * wait for other jobs and don't hold the device */
+  guint      moving : 1;
+  guint      unqueued : 1;
+} ThunarJobSchedulerEntry;
+
+
+
+static void thunar_job_scheduler_dispatch (void);
+
+
+
+/* jobs waiting for or using their devices, in the order they were
+ * scheduled. Only accessed from the main thread, so jobs that wait
+ * for a device don't occupy a thread of the shared job pool */
+static GList *scheduler_entries = NULL;
+
+
+
+static gboolean
+thunar_job_scheduler_shares_device (ThunarJobSchedulerEntry *entry,
+                                    ThunarJobSchedulerEntry *other)
+{
+  guint n;
+  guint m;
+
+  for (n = 0; n < entry->devices->len; ++n)
+    for (m = 0; m < other->devices->len; ++m)
+      if (strcmp (g_ptr_array_index (entry->devices, n), g_ptr_array_index (other->devices, m)) == 0)
+        return TRUE;
+
+  return FALSE;
+}
+
+
+
+static guint
+thunar_job_scheduler_position (GList *entry_link)
+{
+  ThunarJobSchedulerEntry *other;
+  gboolean                 earlier = TRUE;
+  GList                   *lp;
+  guint                    position = 0;
+
+  /* count the running jobs and the earlier waiting jobs that use one
+   * of the devices of this one. Jobs that are still looking up their
+   * devices don't hold anything yet */
+  for (lp = scheduler_entries; lp != NULL; lp = lp->next)
+    {
+      other = lp->data;
+      if (lp == entry_link)
+        earlier = FALSE;
+      else if (other->unqueued)
+        continue;
+      else if ((other->launched || (earlier && other->n_pending == 0))
+               && thunar_job_scheduler_shares_device (entry_link->data, other))
+        position++;
+    }
+
+  return position;
+}
+
+
+
+static void
+thunar_job_scheduler_finished (ExoJob                  *job,
+                               ThunarJobSchedulerEntry *entry)
+{
+  _thunar_return_if_fail (EXO_IS_JOB (job));
+  _thunar_return_if_fail (entry->job == THUNAR_JOB (job));
+
+  /* let the jobs waiting for the devices run */
+  scheduler_entries = g_list_remove (scheduler_entries, entry);
+  g_signal_handler_disconnect (G_OBJECT (job), entry->finished_id);
+  g_ptr_array_free (entry->devices, TRUE);
+  g_slice_free (ThunarJobSchedulerEntry, entry);
+  thunar_job_scheduler_dispatch ();
+
+  g_object_unref (G_OBJECT (job));
+}
+
+
+
+static gboolean
+thunar_job_scheduler_dispatch_idle (gpointer user_data)
+{
+  thunar_job_scheduler_dispatch ();
+  return FALSE;
+}
+
+
+
+static void
+thunar_job_scheduler_cancelled (GCancellable *cancellable,
+                                gpointer      user_data)
+{
+  /* may be emitted from any thread, a cancelled job is launched
+   * right away from the main loop so it can finish */
+  g_idle_add (thunar_job_scheduler_dispatch_idle, NULL);
+}
+
+
+
+static void
+thunar_job_scheduler_dispatch (void)
+{
+  ThunarJobSchedulerEntry *entry;
+  GCancellable            *cancellable;
+  GList                   *lp;
+  gchar                   *message;
+  guint                    position;
+
+  for (lp = scheduler_entries; lp != NULL; lp = lp->next)
+    {
+      entry = lp->data;
+      if (entry->launched || entry->n_pending > 0)
+        continue;
+
+      /* a move on a single device does not transfer any data */
+      if (entry->moving && entry->devices->len <= 1)
+        entry->unqueued = TRUE;
+
+      cancellable = exo_job_get_cancellable (EXO_JOB (entry->job));
+      position = entry->unqueued ? 0 : thunar_job_scheduler_position (lp);
+      if (position < THUNAR_JOB_SCHEDULER_MAX_PER_DEVICE
+          || g_cancellable_is_cancelled (cancellable))
+        {
+          /* the devices are free, start the job in the job pool */
+          g_cancellable_disconnect (cancellable, entry->cancelled_id);
+          entry->cancelled_id = 0;
+          entry->launched = TRUE;
+          exo_job_launch (EXO_JOB (entry->job));
+        }
+      else if (position != entry->position)
+        {
+          /* the job is not running yet, so tell the progress
+           * dialog directly instead of using exo_job_info_message() */
+          entry->position = position;
+          message = g_strdup_printf (ngettext ("Waiting for %u other operation on the same device...",
+                                               "Waiting for %u other operations on the same device...",
+                                               position), position);
+          g_signal_emit_by_name (G_OBJECT (entry->job), "info-message", message);
+          g_free (message);
+        }
+    }
+}
+
+
+
+static void
+thunar_job_scheduler_query_ready (GObject      *object,
+                                  GAsyncResult *result,
+                                  gpointer      user_data)
+{
+  ThunarJobSchedulerEntry *entry = user_data;
+  const gchar             *device;
+  GFileInfo               *info;
+  guint                    n;
+
+  /* a file that cannot be queried does not block anyone */
+  info = g_file_query_info_finish (G_FILE (object), result, NULL);
+  if (G_LIKELY (info != NULL))
+    {
+      device = g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_ID_FILESYSTEM);
+      if (G_LIKELY (device != NULL))
+        {
+          for (n = 0; n < entry->devices->len; ++n)
+            if (strcmp (g_ptr_array_index (entry->devices, n), device) == 0)
+              break;
+
+          if (n == entry->devices->len)
+            g_ptr_array_add (entry->devices, g_strdup (device));
+        }
+
+      g_object_unref (info);
+    }
+
+  /* the job can be queued once all its devices are known */
+  if (--entry->n_pending == 0)
+    thunar_job_scheduler_dispatch ();
+}
+
+
+
+static void
+thunar_job_scheduler_query (ThunarJobSchedulerEntry *entry,
+                            GFile                   *file)
+{
+  entry->n_pending++;
+  g_file_query_info_async (file, G_FILE_ATTRIBUTE_ID_FILESYSTEM,
+                           G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, G_PRIORITY_DEFAULT,
+                           exo_job_get_cancellable (EXO_JOB (entry->job)),
+                           thunar_job_scheduler_query_ready, entry);
+}
+
+
+
+/**
+ * thunar_job_scheduler_launch:
+ * @job          : a #ThunarJob that was not launched yet.
+ * @source_files : the #GFile<!---->s the @job reads.
+ * @target_files : the #GFile<!---->s the @job creates or %NULL.
+ * @moving       : %TRUE if the @job moves @source_files to @target_files.
+ *
+ * Launches the data transfer @job once no earlier transfer uses the
+ * devices of @source_files and @target_files anymore, so transfers on
+ * the same device run one after another while transfers on other
+ * devices run in parallel. Until then the @job waits in a queue in
+ * the main loop and shows its position as info message. A @job
+ * @moving files within a single device only renames them and is
+ * launched right away. Jobs that don't transfer data, like deleting
+ * or changing permissions, should not use the scheduler at all.
+ * Must be called from the main thread.
+ *
+ * Return value: the @job.
+ **/
+ThunarJob*
+thunar_job_scheduler_launch (ThunarJob *job,
+                             GList     *source_files,
+                             GList     *target_files,
+                             gboolean   moving)
+{
+  ThunarJobSchedulerEntry *entry;
+  GFile                   *last_parent = NULL;
+  GFile                   *parent;
+  GList                   *lp;
+
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), NULL);
+
+  entry = g_slice_new0 (ThunarJobSchedulerEntry);
+  entry->job = g_object_ref (G_OBJECT (job));
+  entry->devices = g_ptr_array_new_with_free_func (g_free);
+  entry->n_pending = 1;
+  entry->moving = moving;
+  scheduler_entries = g_list_append (scheduler_entries, entry);
+
+  /* release the devices once the job is done */
+  entry->finished_id = g_signal_connect (G_OBJECT (job), "finished",
+                                         G_CALLBACK (thunar_job_scheduler_finished), entry);
+
+  /* don't keep a cancelled job waiting */
+  entry->cancelled_id = g_cancellable_connect (exo_job_get_cancellable (EXO_JOB (job)),
+                                               G_CALLBACK (thunar_job_scheduler_cancelled),
+                                               NULL, NULL);
+
+  /* files in the same folder are on the same device, unless they are
+   * mount points, so only query one file per folder */
+  for (lp = source_files; lp != NULL; lp = lp->next)
+    {
+      parent = g_file_get_parent (lp->data);
+      if (parent == NULL || last_parent == NULL || !g_file_equal (parent, last_parent))
+        thunar_job_scheduler_query (entry, lp->data);
+
+      if (last_parent != NULL)
+        g_object_unref (last_parent);
+      last_parent = parent;
+    }
+
+  if (last_parent != NULL)
+    g_object_unref (last_parent);
+  last_parent = NULL;
+
+  /* targets usually do not exist yet, so use their parents */
+  for (lp = target_files; lp != NULL; lp = lp->next)
+    {
+      parent = g_file_get_parent (lp->data);
+      if (parent != NULL && (last_parent == NULL || !g_file_equal (parent, last_parent)))
+        thunar_job_scheduler_query (entry, parent);
+
+      if (last_parent != NULL)
+        g_object_unref (last_parent);
+      last_parent = parent;
+    }
+
+  if (last_parent != NULL)
+    g_object_unref (last_parent);
+
+  /* drop the guard, the job is launched once its devices are known */
+  if (--entry->n_pending == 0)
+    thunar_job_scheduler_dispatch ();
+
+  return job;
+}
@@ -34,12 +34,31 @@
 #include <thunar/thunar-enum-types.h>
 #include <thunar/thunar-job.h>
 #include <thunar/thunar-marshal.h>
+#include <thunar/thunar-preferences.h>
 #include <thunar/thunar-private.h>
 
 
 
 #define THUNAR_JOB_GET_PRIVATE(obj) (G_TYPE_INSTANCE_GET_PRIVATE ((obj), THUNAR_TYPE_JOB, ThunarJobPrivate))
 
+/* minimum time between two progress updates */
+#define PROGRESS_UPDATE_INTERVAL (500 * 1000) /* 500 ms */
+
+/* time before we show the rate + remaining time */
+#define MINIMUM_PROGRESS_TIME    (10 * G_USEC_PER_SEC) /* 10 seconds */
+
+#if GLIB_CHECK_VERSION (2, 32, 0)
+#define _thunar_job_pause_lock(job)   g_mutex_lock (&((job)->priv->pause_lock))
+#define _thunar_job_pause_unlock(job) g_mutex_unlock (&((job)->priv->pause_lock))
+#define _thunar_job_pause_wait(job)   g_cond_wait (&((job)->priv->pause_cond), &((job)->priv->pause_lock))
+#define _thunar_job_pause_wake(job)   g_cond_broadcast (&((job)->priv->pause_cond))
+#else
+#define _thunar_job_pause_lock(job)   g_mutex_lock ((job)->priv->pause_lock)
+#define _thunar_job_pause_unlock(job) g_mutex_unlock ((job)->priv->pause_lock)
+#define _thunar_job_pause_wait(job)   g_cond_wait ((job)->priv->pause_cond, (job)->priv->pause_lock)
+#define _thunar_job_pause_wake(job)   g_cond_broadcast ((job)->priv->pause_cond)
+#endif
+
 
 
 /* Signal identifiers */
@@ -69,7 +88,27 @@ struct _ThunarJobPrivate
   ThunarJobResponse earlier_ask_create_response;
   ThunarJobResponse earlier_ask_overwrite_response;
   ThunarJobResponse earlier_ask_skip_response;
-  GList            *total_files;
+
+  /* progress in files or bytes */
+  guint64           total;
+  guint64           progress;
+  guint             progress_in_bytes : 1;
+
+  /* rate limiting and rate estimation */
+  gint64            start_time;
+  gint64            last_update_time;
+  guint64           last_progress;
+  guint64           rate;
+
+  /* set from the main loop, checked by the job */
+  volatile gint     paused;
+#if GLIB_CHECK_VERSION (2, 32, 0)
+  GMutex            pause_lock;
+  GCond             pause_cond;
+#else
+  GMutex           *pause_lock;
+  GCond            *pause_cond;
+#endif
 };
 
 
@@ -213,6 +252,15 @@ thunar_job_init (ThunarJob *job)
   job->priv->earlier_ask_create_response = 0;
   job->priv->earlier_ask_overwrite_response = 0;
   job->priv->earlier_ask_skip_response = 0;
+
+  /* a paused job sleeps until it is resumed or cancelled */
+#if GLIB_CHECK_VERSION (2, 32, 0)
+  g_mutex_init (&job->priv->pause_lock);
+  g_cond_init (&job->priv->pause_cond);
+#else
+  job->priv->pause_lock = g_mutex_new ();
+  job->priv->pause_cond = g_cond_new ();
+#endif
 }
 
 
@@ -220,6 +268,16 @@ thunar_job_init (ThunarJob *job)
 static void
 thunar_job_finalize (GObject *object)
 {
+  ThunarJob *job = THUNAR_JOB (object);
+
+#if GLIB_CHECK_VERSION (2, 32, 0)
+  g_mutex_clear (&job->priv->pause_lock);
+  g_cond_clear (&job->priv->pause_cond);
+#else
+  g_mutex_free (job->priv->pause_lock);
+  g_cond_free (job->priv->pause_cond);
+#endif
+
   (*G_OBJECT_CLASS (thunar_job_parent_class)->finalize) (object);
 }
 
@@ -465,6 +523,35 @@ thunar_job_ask_replace (ThunarJob *job,
 
 
 
+ThunarJobResponse
+thunar_job_ask_restore (ThunarJob   *job,
+                        const gchar *format,
+                        ...)
+{
+  ThunarJobResponse response;
+  va_list           var_args;
+
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), THUNAR_JOB_RESPONSE_CANCEL);
+  _thunar_return_val_if_fail (format != NULL, THUNAR_JOB_RESPONSE_CANCEL);
+
+  /* check if the user already cancelled the job */
+  if (G_UNLIKELY (exo_job_is_cancelled (EXO_JOB (job))))
+    return THUNAR_JOB_RESPONSE_CANCEL;
+
+  /* ask the user what he wants to do */
+  va_start (var_args, format);
+  response = _thunar_job_ask_valist (job, format, var_args,
+                                     _("Do you want to restore the old names?"),
+                                     THUNAR_JOB_RESPONSE_YES
+                                     | THUNAR_JOB_RESPONSE_NO
+                                     | THUNAR_JOB_RESPONSE_CANCEL);
+  va_end (var_args);
+
+  return response;
+}
+
+
+
 ThunarJobResponse 
 thunar_job_ask_skip (ThunarJob   *job,
                      const gchar *format,
@@ -590,54 +677,335 @@ thunar_job_new_files (ThunarJob   *job,
 
 
 
+static void
+thunar_job_pause_cancelled (GCancellable *cancellable,
+                            ThunarJob    *job)
+{
+  /* wake up the paused job, so it notices the cancellation */
+  _thunar_job_pause_lock (job);
+  _thunar_job_pause_wake (job);
+  _thunar_job_pause_unlock (job);
+}
+
+
+
+static void
+thunar_job_wait_if_paused (ThunarJob *job)
+{
+  GCancellable *cancellable;
+  gint64        pause_time;
+  gulong        cancelled_id;
+
+  if (G_LIKELY (!g_atomic_int_get (&job->priv->paused)))
+    return;
+
+  exo_job_info_message (EXO_JOB (job), _("Paused"));
+
+  /* connect before taking the lock, the handler runs right
+   * away if the job is already cancelled */
+  cancellable = exo_job_get_cancellable (EXO_JOB (job));
+  cancelled_id = g_cancellable_connect (cancellable, G_CALLBACK (thunar_job_pause_cancelled), job, NULL);
+
+  pause_time = g_get_monotonic_time ();
+  _thunar_job_pause_lock (job);
+  while (g_atomic_int_get (&job->priv->paused)
+         && !g_cancellable_is_cancelled (cancellable))
+    _thunar_job_pause_wait (job);
+  _thunar_job_pause_unlock (job);
+
+  g_cancellable_disconnect (cancellable, cancelled_id);
+
+  /* the pause does not count for the transfer rate */
+  if (job->priv->start_time != 0)
+    job->priv->start_time += g_get_monotonic_time () - pause_time;
+}
+
+
+
+static gboolean
+thunar_job_update_progress (ThunarJob *job)
+{
+  ThunarJobPrivate *priv = job->priv;
+  gint64            current_time;
+  gint64            expired_time;
+  guint64           rate;
+
+  current_time = g_get_monotonic_time ();
+
+  if (G_UNLIKELY (priv->start_time == 0))
+    {
+      /* always report the start of the job */
+      priv->start_time = current_time;
+    }
+  else
+    {
+      /* notify callers not more then every 500ms */
+      expired_time = current_time - priv->last_update_time;
+      if (expired_time < PROGRESS_UPDATE_INTERVAL)
+        return FALSE;
+
+      /* calculate the rate in the last expired time */
+      rate = (priv->progress - priv->last_progress) / ((gdouble) expired_time / G_USEC_PER_SEC);
+
+      /* take the average of the last 10 rates (5 sec), so the output is less jumpy */
+      if (priv->rate > 0)
+        priv->rate = ((priv->rate * 10) + rate) / 11;
+      else
+        priv->rate = rate;
+    }
+
+  priv->last_update_time = current_time;
+  priv->last_progress = priv->progress;
+
+  if (G_LIKELY (priv->total > 0))
+    exo_job_percent (EXO_JOB (job), MIN ((priv->progress * 100.0) / priv->total, 100.0));
+
+  return TRUE;
+}
+
+
+
+/**
+ * thunar_job_set_total_files:
+ * @job           : a #ThunarJob.
+ * @n_total_files : the number of files the @job processes.
+ *
+ * Sets the number of files the @job processes, the progress is
+ * reported with thunar_job_processing_file() afterwards.
+ **/
 void
 thunar_job_set_total_files (ThunarJob *job,
-                            GList     *total_files)
+                            guint      n_total_files)
 {
   _thunar_return_if_fail (THUNAR_IS_JOB (job));
-  _thunar_return_if_fail (job->priv->total_files == NULL);
-  _thunar_return_if_fail (total_files != NULL);
 
-  job->priv->total_files = total_files;
+  job->priv->total = n_total_files;
+  job->priv->progress_in_bytes = FALSE;
 }
 
 
 
+/**
+ * thunar_job_set_total_size:
+ * @job        : a #ThunarJob.
+ * @total_size : the number of bytes the @job processes.
+ *
+ * Sets the number of bytes the @job processes, the progress is
+ * reported with thunar_job_add_progress() afterwards.
+ **/
+void
+thunar_job_set_total_size (ThunarJob *job,
+                           guint64    total_size)
+{
+  _thunar_return_if_fail (THUNAR_IS_JOB (job));
+
+  job->priv->total = total_size;
+  job->priv->progress_in_bytes = TRUE;
+}
+
+
+
+/**
+ * thunar_job_processing_file:
+ * @job         : a #ThunarJob.
+ * @file        : the #GFile that is processed now.
+ * @n_processed : the number of files processed before @file.
+ *
+ * Updates the progress of @job. The percentage and the name of
+ * @file are only reported every now and then, so this is cheap
+ * to call for every file.
+ **/
 void
 thunar_job_processing_file (ThunarJob *job,
-                            GList     *current_file)
+                            GFile     *file,
+                            guint      n_processed)
 {
-  GList *lp;
   gchar *base_name;
   gchar *display_name;
-  guint  n_processed;
-  guint  n_total;
 
   _thunar_return_if_fail (THUNAR_IS_JOB (job));
-  _thunar_return_if_fail (current_file != NULL);
+  _thunar_return_if_fail (G_IS_FILE (file));
 
-  base_name = g_file_get_basename (current_file->data);
-  display_name = g_filename_display_name (base_name);
-  g_free (base_name);
+  thunar_job_wait_if_paused (job);
 
-  exo_job_info_message (EXO_JOB (job), "%s", display_name);
-  g_free (display_name);
+  job->priv->progress = n_processed;
 
-  /* verify that we have total files set */
-  if (G_LIKELY (job->priv->total_files != NULL))
+  if (thunar_job_update_progress (job))
     {
-      /* determine the number of files processed so far */
-      for (lp = job->priv->total_files, n_processed = 0;
-           lp != current_file;
-           lp = lp->next);
+      base_name = g_file_get_basename (file);
+      display_name = g_filename_display_name (base_name);
+      g_free (base_name);
+
+      exo_job_info_message (EXO_JOB (job), "%s", display_name);
+      g_free (display_name);
+    }
+}
+
+
+
+/**
+ * thunar_job_add_progress:
+ * @job     : a #ThunarJob.
+ * @n_bytes : the number of bytes processed since the last call.
+ *
+ * Advances the progress of a @job that counts bytes, see
+ * thunar_job_set_total_size().
+ **/
+void
+thunar_job_add_progress (ThunarJob *job,
+                         guint64    n_bytes)
+{
+  _thunar_return_if_fail (THUNAR_IS_JOB (job));
+
+  thunar_job_wait_if_paused (job);
+
+  job->priv->progress += n_bytes;
+  thunar_job_update_progress (job);
+}
+
+
+
+/**
+ * thunar_job_set_paused:
+ * @job    : a #ThunarJob.
+ * @paused : whether to pause the @job.
+ *
+ * Pauses or resumes the @job. A paused job stops the next time it
+ * reports progress and continues once it is resumed or cancelled.
+ **/
+void
+thunar_job_set_paused (ThunarJob *job,
+                       gboolean   paused)
+{
+  _thunar_return_if_fail (THUNAR_IS_JOB (job));
+
+  _thunar_job_pause_lock (job);
+  g_atomic_int_set (&job->priv->paused, paused ? 1 : 0);
+  _thunar_job_pause_wake (job);
+  _thunar_job_pause_unlock (job);
+}
+
+
 
-      /* emit only if n_processed is a multiple of 8 */
-      if ((n_processed % 8) == 0)
+/**
+ * thunar_job_is_paused:
+ * @job : a #ThunarJob.
+ *
+ * Return value: %TRUE if @job is paused.
+ **/
+gboolean
+thunar_job_is_paused (ThunarJob *job)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
+
+  return g_atomic_int_get (&job->priv->paused);
+}
+
+
+
+/**
+ * thunar_job_get_status:
+ * @job : a #ThunarJob.
+ *
+ * Returns a description of the progress of @job like
+ * "22.6MB of 134.1MB" or "200 of 1000 files", followed by
+ * the remaining time once it can be estimated.
+ *
+ * The caller is responsible to free the returned string
+ * using g_free() when no longer needed.
+ *
+ * Return value: the status of @job or %NULL if the
+ *               @job does not report its progress.
+ **/
+gchar *
+thunar_job_get_status (ThunarJob *job)
+{
+  ThunarJobPrivate  *priv;
+  ThunarPreferences *preferences;
+  GFormatSizeFlags   size_flags = G_FORMAT_SIZE_DEFAULT;
+  gboolean           file_size_binary;
+  gchar             *total_str;
+  gchar             *progress_str;
+  gchar             *rate_str;
+  GString           *status;
+  gulong             remaining_time;
+
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), NULL);
+
+  priv = job->priv;
+  if (priv->total == 0)
+    return NULL;
+
+  status = g_string_sized_new (100);
+
+  if (priv->progress_in_bytes)
+    {
+      preferences = thunar_preferences_get ();
+      g_object_get (G_OBJECT (preferences), "misc-file-size-binary", &file_size_binary, NULL);
+      g_object_unref (G_OBJECT (preferences));
+
+      if (file_size_binary)
+        size_flags = G_FORMAT_SIZE_IEC_UNITS;
+
+      /* transfer status like "22.6MB of 134.1MB" */
+      total_str = g_format_size_full (priv->total, size_flags);
+      progress_str = g_format_size_full (priv->last_progress, size_flags);
+      g_string_append_printf (status, _("%s of %s"), progress_str, total_str);
+      g_free (total_str);
+      g_free (progress_str);
+    }
+  else
+    {
+      /* status like "200 of 1000 files" */
+      g_string_append_printf (status, ngettext ("%u of %u file", "%u of %u files", (gulong) priv->total),
+                              (guint) priv->last_progress, (guint) priv->total);
+    }
+
+  /* show time and rate after 10 seconds */
+  if (priv->rate > 0
+      && priv->total > priv->last_progress
+      && (priv->last_update_time - priv->start_time) > MINIMUM_PROGRESS_TIME)
+    {
+      /* remaining time based on the speed */
+      remaining_time = (priv->total - priv->last_progress) / priv->rate;
+
+      if (priv->progress_in_bytes)
+        rate_str = g_format_size_full (priv->rate, size_flags);
+      else
+        rate_str = g_strdup_printf (ngettext ("%u file", "%u files", (gulong) priv->rate), (guint) priv->rate);
+
+      if (remaining_time > 0)
         {
-          /* determine the total_number of files */
-          n_total = g_list_length (job->priv->total_files);
+          /* insert long dash */
+          g_string_append (status, " \xE2\x80\x94 ");
 
-          exo_job_percent (EXO_JOB (job), (n_processed * 100.0) / n_total);
+          if (remaining_time > 60 * 60)
+            {
+              remaining_time = (gulong) (remaining_time / (60 * 60));
+              g_string_append_printf (status, ngettext ("%lu hour remaining (%s/sec)",
+                                                        "%lu hours remaining (%s/sec)",
+                                                        remaining_time),
+                                                        remaining_time, rate_str);
+            }
+          else if (remaining_time > 60)
+            {
+              remaining_time = (gulong) (remaining_time / 60);
+              g_string_append_printf (status, ngettext ("%lu minute remaining (%s/sec)",
+                                                        "%lu minutes remaining (%s/sec)",
+                                                        remaining_time),
+                                                        remaining_time, rate_str);
+            }
+          else
+            {
+              g_string_append_printf (status, ngettext ("%lu second remaining (%s/sec)",
+                                                        "%lu seconds remaining (%s/sec)",
+                                                        remaining_time),
+                                                        remaining_time, rate_str);
+            }
         }
+
+      g_free (rate_str);
     }
+
+  return g_string_free (status, FALSE);
 }
@@ -67,9 +67,18 @@ struct _ThunarJob
 
 GType             thunar_job_get_type               (void) G_GNUC_CONST;
 void              thunar_job_set_total_files        (ThunarJob       *job,
-                                                     GList           *total_files);
+                                                     guint            n_total_files);
+void              thunar_job_set_total_size         (ThunarJob       *job,
+                                                     guint64          total_size);
 void              thunar_job_processing_file        (ThunarJob       *job,
-                                                     GList           *current_file);
+                                                     GFile           *file,
+                                                     guint            n_processed);
+void              thunar_job_add_progress           (ThunarJob       *job,
+                                                     guint64          n_bytes);
+gchar            *thunar_job_get_status             (ThunarJob       *job) G_GNUC_MALLOC;
+void              thunar_job_set_paused             (ThunarJob       *job,
+                                                     gboolean         paused);
+gboolean          thunar_job_is_paused              (ThunarJob       *job);
 
 ThunarJobResponse thunar_job_ask_create             (ThunarJob       *job,
                                                      const gchar     *format,
@@ -81,6 +90,9 @@ ThunarJobResponse thunar_job_ask_replace            (ThunarJob       *job,
                                                      GFile           *source_path,
                                                      GFile           *target_path,
                                                      GError         **error);
+ThunarJobResponse thunar_job_ask_restore            (ThunarJob       *job,
+                                                     const gchar     *format,
+                                                     ...);
 ThunarJobResponse thunar_job_ask_skip               (ThunarJob       *job,
                                                      const gchar     *format,
                                                      ...);
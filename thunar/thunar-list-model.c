@@ -29,11 +29,15 @@
 #ifdef HAVE_STRING_H
 #include <string.h>
 #endif
+#ifdef HAVE_TIME_H
+#include <time.h>
+#endif
 
 #include <thunar/thunar-application.h>
 #include <thunar/thunar-file-monitor.h>
 #include <thunar/thunar-gobject-extensions.h>
 #include <thunar/thunar-list-model.h>
+#include <thunar/thunar-name-index.h>
 #include <thunar/thunar-preferences.h>
 #include <thunar/thunar-private.h>
 #include <thunar/thunar-user.h>
@@ -46,6 +50,7 @@ enum
   PROP_0,
   PROP_CASE_SENSITIVE,
   PROP_DATE_STYLE,
+  PROP_FILTER,
   PROP_FOLDER,
   PROP_FOLDERS_FIRST,
   PROP_NUM_FILES,
@@ -133,10 +138,24 @@ static void               thunar_list_model_set_sort_func         (GtkTreeSortab
                                                                    gpointer                data,
                                                                    GDestroyNotify          destroy);
 static gboolean           thunar_list_model_has_default_sort_func (GtkTreeSortable        *sortable);
+static void               thunar_list_model_render_cache_free     (gpointer                data);
+static gchar             *thunar_list_model_format_column         (ThunarListModel        *store,
+                                                                   ThunarFile             *file,
+                                                                   gint                    column);
+static const gchar       *thunar_list_model_get_column_string     (ThunarListModel        *store,
+                                                                   ThunarFile             *file,
+                                                                   gint                    column);
 static gint               thunar_list_model_cmp_func              (gconstpointer           a,
                                                                    gconstpointer           b,
                                                                    gpointer                user_data);
+static gint               thunar_list_model_cmp_array_func        (gconstpointer           a,
+                                                                   gconstpointer           b,
+                                                                   gpointer                user_data);
 static void               thunar_list_model_sort                  (ThunarListModel        *store);
+static gboolean           thunar_list_model_file_visible          (ThunarListModel        *store,
+                                                                   ThunarFile             *file,
+                                                                   GHashTable             *matches);
+static void               thunar_list_model_refilter              (ThunarListModel        *store);
 static void               thunar_list_model_file_changed          (ThunarFileMonitor      *file_monitor,
                                                                    ThunarFile             *file,
                                                                    ThunarListModel        *store);
@@ -209,7 +228,32 @@ struct _ThunarListModel
 #endif
 
   GSequence      *rows;
-  GSList         *hidden;
+
+  /* set of the files which are not in the rows, because they
+   * are hidden while "show-hidden" is %FALSE or don't match
+   * the filter. Owns a reference on every file.
+   */
+  GHashTable     *hidden;
+
+  /* the filter text and the index of the display names in
+   * the folder, which is used to look up the matching files.
+   * The index only exists while a filter is set.
+   */
+  gchar          *filter;
+  ThunarNameIndex *name_index;
+
+  /* lookup table from a ThunarFile to its GSequenceIter, so we
+   * don't need to scan the rows to find the row for a file.
+   */
+  GHashTable     *file_rows;
+
+  /* formatted strings of the visible columns, per file, which
+   * are built on-demand, as GtkTreeView requests the same cell
+   * values over and over again while scrolling and sizing.
+   */
+  GHashTable     *render_cache;
+  time_t          render_cache_expires;
+
   ThunarFolder   *folder;
   gboolean        show_hidden : 1;
   gboolean        file_size_binary : 1;
@@ -283,6 +327,20 @@ thunar_list_model_class_init (ThunarListModelClass *klass)
                          THUNAR_DATE_STYLE_SIMPLE,
                          EXO_PARAM_READWRITE);
 
+  /**
+   * ThunarListModel:filter:
+   *
+   * Only files whose display name contains this text are
+   * presented by this #ThunarListModel, or all files if
+   * %NULL. The filter is reset when the folder changes.
+   **/
+  list_model_props[PROP_FILTER] =
+      g_param_spec_string ("filter",
+                           "filter",
+                           "filter",
+                           NULL,
+                           EXO_PARAM_READWRITE);
+
   /**
    * ThunarListModel:folder:
    *
@@ -422,6 +480,9 @@ thunar_list_model_init (ThunarListModel *store)
   store->sort_sign = 1;
   store->sort_func = thunar_file_compare_by_name;
   store->rows = g_sequence_new (g_object_unref);
+  store->hidden = g_hash_table_new_full (g_direct_hash, g_direct_equal, g_object_unref, NULL);
+  store->file_rows = g_hash_table_new (g_direct_hash, g_direct_equal);
+  store->render_cache = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, thunar_list_model_render_cache_free);
 
   /* connect to the shared ThunarFileMonitor, so we don't need to
    * connect "changed" to every single ThunarFile we own.
@@ -450,6 +511,13 @@ thunar_list_model_finalize (GObject *object)
   ThunarListModel *store = THUNAR_LIST_MODEL (object);
 
   g_sequence_free (store->rows);
+  g_hash_table_destroy (store->hidden);
+  g_hash_table_destroy (store->file_rows);
+  g_hash_table_destroy (store->render_cache);
+
+  if (store->name_index != NULL)
+    g_object_unref (G_OBJECT (store->name_index));
+  g_free (store->filter);
 
   /* disconnect from the file monitor */
   g_signal_handlers_disconnect_by_func (G_OBJECT (store->file_monitor), thunar_list_model_file_changed, store);
@@ -478,6 +546,10 @@ thunar_list_model_get_property (GObject    *object,
       g_value_set_enum (value, thunar_list_model_get_date_style (store));
       break;
 
+    case PROP_FILTER:
+      g_value_set_string (value, thunar_list_model_get_filter (store));
+      break;
+
     case PROP_FOLDER:
       g_value_set_object (value, thunar_list_model_get_folder (store));
       break;
@@ -524,6 +596,10 @@ thunar_list_model_set_property (GObject      *object,
       thunar_list_model_set_date_style (store, g_value_get_enum (value));
       break;
 
+    case PROP_FILTER:
+      thunar_list_model_set_filter (store, g_value_get_string (value));
+      break;
+
     case PROP_FOLDER:
       thunar_list_model_set_folder (store, g_value_get_object (value));
       break;
@@ -657,65 +733,54 @@ thunar_list_model_get_path (GtkTreeModel *model,
 
 
 static void
-thunar_list_model_get_value (GtkTreeModel *model,
-                             GtkTreeIter  *iter,
-                             gint          column,
-                             GValue       *value)
+thunar_list_model_render_cache_free (gpointer data)
+{
+  gchar **strings = data;
+  gint    n;
+
+  for (n = 0; n < THUNAR_N_VISIBLE_COLUMNS; ++n)
+    g_free (strings[n]);
+  g_free (strings);
+}
+
+
+
+static gchar*
+thunar_list_model_format_column (ThunarListModel *store,
+                                 ThunarFile      *file,
+                                 gint             column)
 {
   ThunarGroup *group;
   const gchar *content_type;
   const gchar *name;
   const gchar *real_name;
   ThunarUser  *user;
-  ThunarFile  *file;
-  gchar       *str;
-
-  _thunar_return_if_fail (THUNAR_IS_LIST_MODEL (model));
-  _thunar_return_if_fail (iter->stamp == (THUNAR_LIST_MODEL (model))->stamp);
-
-  file = g_sequence_get (iter->user_data);
-  _thunar_assert (THUNAR_IS_FILE (file));
+  gchar       *str = NULL;
 
   switch (column)
     {
     case THUNAR_COLUMN_DATE_ACCESSED:
-      g_value_init (value, G_TYPE_STRING);
-      str = thunar_file_get_date_string (file, THUNAR_FILE_DATE_ACCESSED, THUNAR_LIST_MODEL (model)->date_style);
-      g_value_take_string (value, str);
+      str = thunar_file_get_date_string (file, THUNAR_FILE_DATE_ACCESSED, store->date_style);
       break;
 
     case THUNAR_COLUMN_DATE_MODIFIED:
-      g_value_init (value, G_TYPE_STRING);
-      str = thunar_file_get_date_string (file, THUNAR_FILE_DATE_MODIFIED, THUNAR_LIST_MODEL (model)->date_style);
-      g_value_take_string (value, str);
+      str = thunar_file_get_date_string (file, THUNAR_FILE_DATE_MODIFIED, store->date_style);
       break;
 
     case THUNAR_COLUMN_GROUP:
-      g_value_init (value, G_TYPE_STRING);
       group = thunar_file_get_group (file);
       if (G_LIKELY (group != NULL))
         {
-          g_value_set_string (value, thunar_group_get_name (group));
+          str = g_strdup (thunar_group_get_name (group));
           g_object_unref (G_OBJECT (group));
         }
       else
         {
-          g_value_set_static_string (value, _("Unknown"));
+          str = g_strdup (_("Unknown"));
         }
       break;
 
-    case THUNAR_COLUMN_MIME_TYPE:
-      g_value_init (value, G_TYPE_STRING);
-      g_value_set_static_string (value, thunar_file_get_content_type (file));
-      break;
-
-    case THUNAR_COLUMN_NAME:
-      g_value_init (value, G_TYPE_STRING);
-      g_value_set_static_string (value, thunar_file_get_display_name (file));
-      break;
-
     case THUNAR_COLUMN_OWNER:
-      g_value_init (value, G_TYPE_STRING);
       user = thunar_file_get_user (file);
       if (G_LIKELY (user != NULL))
         {
@@ -723,37 +788,125 @@ thunar_list_model_get_value (GtkTreeModel *model,
           name = thunar_user_get_name (user);
           real_name = thunar_user_get_real_name (user);
           str = G_LIKELY (real_name != NULL) ? g_strdup_printf ("%s (%s)", real_name, name) : g_strdup (name);
-          g_value_take_string (value, str);
           g_object_unref (G_OBJECT (user));
         }
       else
         {
-          g_value_set_static_string (value, _("Unknown"));
+          str = g_strdup (_("Unknown"));
         }
       break;
 
     case THUNAR_COLUMN_PERMISSIONS:
-      g_value_init (value, G_TYPE_STRING);
-      g_value_take_string (value, thunar_file_get_mode_string (file));
+      str = thunar_file_get_mode_string (file);
       break;
 
     case THUNAR_COLUMN_SIZE:
-      g_value_init (value, G_TYPE_STRING);
-      g_value_take_string (value, thunar_file_get_size_string_formatted (file, THUNAR_LIST_MODEL (model)->file_size_binary));
+      str = thunar_file_get_size_string_formatted (file, store->file_size_binary);
       break;
 
     case THUNAR_COLUMN_TYPE:
-      g_value_init (value, G_TYPE_STRING);
       if (G_UNLIKELY (thunar_file_is_symlink (file)))
-        g_value_take_string (value, g_strdup_printf (_("link to %s"), thunar_file_get_symlink_target (file)));
+        {
+          str = g_strdup_printf (_("link to %s"), thunar_file_get_symlink_target (file));
+        }
       else
         {
           content_type = thunar_file_get_content_type (file);
           if (content_type != NULL)
-            g_value_take_string (value, g_content_type_get_description (content_type));
+            str = g_content_type_get_description (content_type);
         }
       break;
 
+    default:
+      _thunar_assert_not_reached ();
+      break;
+    }
+
+  return str;
+}
+
+
+
+static const gchar*
+thunar_list_model_get_column_string (ThunarListModel *store,
+                                     ThunarFile      *file,
+                                     gint             column)
+{
+  struct tm  tm;
+  time_t     now;
+  gchar    **strings;
+
+  _thunar_return_val_if_fail (column >= 0 && column < THUNAR_N_VISIBLE_COLUMNS, NULL);
+
+  /* relative dates like "Today" must be reformatted on the next day */
+  now = time (NULL);
+  if (G_UNLIKELY (now >= store->render_cache_expires))
+    {
+      g_hash_table_remove_all (store->render_cache);
+
+      /* determine the next local midnight */
+      tm = *localtime (&now);
+      tm.tm_sec = tm.tm_min = tm.tm_hour = 0;
+      tm.tm_mday += 1;
+      tm.tm_isdst = -1;
+      store->render_cache_expires = mktime (&tm);
+    }
+
+  /* lookup the cached strings of the file */
+  strings = g_hash_table_lookup (store->render_cache, file);
+  if (G_UNLIKELY (strings == NULL))
+    {
+      strings = g_new0 (gchar *, THUNAR_N_VISIBLE_COLUMNS);
+      g_hash_table_insert (store->render_cache, file, strings);
+    }
+
+  /* format the column on-demand */
+  if (strings[column] == NULL)
+    strings[column] = thunar_list_model_format_column (store, file, column);
+
+  return strings[column];
+}
+
+
+
+static void
+thunar_list_model_get_value (GtkTreeModel *model,
+                             GtkTreeIter  *iter,
+                             gint          column,
+                             GValue       *value)
+{
+  ThunarListModel *store = THUNAR_LIST_MODEL (model);
+  ThunarFile      *file;
+
+  _thunar_return_if_fail (THUNAR_IS_LIST_MODEL (model));
+  _thunar_return_if_fail (iter->stamp == store->stamp);
+
+  file = g_sequence_get (iter->user_data);
+  _thunar_assert (THUNAR_IS_FILE (file));
+
+  switch (column)
+    {
+    case THUNAR_COLUMN_DATE_ACCESSED:
+    case THUNAR_COLUMN_DATE_MODIFIED:
+    case THUNAR_COLUMN_GROUP:
+    case THUNAR_COLUMN_OWNER:
+    case THUNAR_COLUMN_PERMISSIONS:
+    case THUNAR_COLUMN_SIZE:
+    case THUNAR_COLUMN_TYPE:
+      g_value_init (value, G_TYPE_STRING);
+      g_value_set_string (value, thunar_list_model_get_column_string (store, file, column));
+      break;
+
+    case THUNAR_COLUMN_MIME_TYPE:
+      g_value_init (value, G_TYPE_STRING);
+      g_value_set_static_string (value, thunar_file_get_content_type (file));
+      break;
+
+    case THUNAR_COLUMN_NAME:
+      g_value_init (value, G_TYPE_STRING);
+      g_value_set_static_string (value, thunar_file_get_display_name (file));
+      break;
+
     case THUNAR_COLUMN_FILE:
       g_value_init (value, THUNAR_TYPE_FILE);
       g_value_set_object (value, file);
@@ -1047,6 +1200,16 @@ thunar_list_model_cmp_func (gconstpointer a,
 
 
 
+static gint
+thunar_list_model_cmp_array_func (gconstpointer a,
+                                  gconstpointer b,
+                                  gpointer      user_data)
+{
+  return thunar_list_model_cmp_func (*((ThunarFile **) a), *((ThunarFile **) b), user_data);
+}
+
+
+
 static void
 thunar_list_model_sort (ThunarListModel *store)
 {
@@ -1105,15 +1268,168 @@ thunar_list_model_sort (ThunarListModel *store)
 
 
 
+static gboolean
+thunar_list_model_file_visible (ThunarListModel *store,
+                                ThunarFile      *file,
+                                GHashTable      *matches)
+{
+  if (!store->show_hidden && thunar_file_is_hidden (file))
+    return FALSE;
+
+  /* use the result of the index lookup if we have one */
+  if (matches != NULL)
+    return (g_hash_table_lookup (matches, file) != NULL);
+
+  if (store->filter != NULL)
+    return thunar_name_index_matches (store->name_index, file, store->filter);
+
+  return TRUE;
+}
+
+
+
+static void
+thunar_list_model_refilter (ThunarListModel *store)
+{
+  GtkTreePath    *path;
+  GtkTreeIter     iter;
+  GHashTableIter  hash_iter;
+  GHashTable     *matches = NULL;
+  GPtrArray      *files;
+  ThunarFile     *file;
+  GSequenceIter  *row;
+  GSequenceIter  *next;
+  GSequenceIter  *end;
+  gboolean        has_inserted_handler;
+  gboolean        has_deleted_handler;
+  gint           *indices;
+  guint           n;
+
+  _thunar_return_if_fail (THUNAR_IS_LIST_MODEL (store));
+
+  /* views detach from the model for large changes, so the rows
+   * are rebuilt in a single batch when they attach again, see
+   * thunar_standard_view_set_show_hidden() */
+  has_inserted_handler = g_signal_has_handler_pending (G_OBJECT (store), store->row_inserted_id, 0, FALSE);
+  has_deleted_handler = g_signal_has_handler_pending (G_OBJECT (store), store->row_deleted_id, 0, FALSE);
+
+  /* the index only visits the files sharing the rarest trigram of
+   * the filter, instead of all files, once it is built completely */
+  if (store->filter != NULL)
+    matches = thunar_name_index_lookup (store->name_index, store->filter);
+
+  /* we modify the first index of a single path in place
+   * below, instead of allocating a path for every row */
+  path = gtk_tree_path_new_first ();
+  indices = gtk_tree_path_get_indices (path);
+
+  /* remove all rows that are no longer visible in a single pass */
+  row = g_sequence_get_begin_iter (store->rows);
+  end = g_sequence_get_end_iter (store->rows);
+  indices[0] = 0;
+
+  while (row != end)
+    {
+      next = g_sequence_iter_next (row);
+
+      file = g_sequence_get (row);
+      if (!thunar_list_model_file_visible (store, file, matches))
+        {
+          /* store file in the set */
+          g_hash_table_insert (store->hidden, g_object_ref (file), file);
+
+          /* remove file from the model */
+          g_hash_table_remove (store->file_rows, file);
+          g_sequence_remove (row);
+
+          /* notify the view(s), the next row takes over the index */
+          if (G_LIKELY (has_deleted_handler))
+            gtk_tree_model_row_deleted (GTK_TREE_MODEL (store), path);
+        }
+      else
+        {
+          indices[0]++;
+        }
+
+      row = next;
+      _thunar_assert (end == g_sequence_get_end_iter (store->rows));
+    }
+
+  /* take the files that became visible out of the set, we
+   * inherit the reference of the set on those files */
+  files = g_ptr_array_new ();
+  if (matches != NULL)
+    {
+      /* only matching files can become visible */
+      g_hash_table_iter_init (&hash_iter, matches);
+      while (g_hash_table_iter_next (&hash_iter, (gpointer *) &file, NULL))
+        if (g_hash_table_lookup (store->hidden, file) != NULL
+            && thunar_list_model_file_visible (store, file, matches))
+          g_ptr_array_add (files, file);
+
+      for (n = 0; n < files->len; ++n)
+        g_hash_table_steal (store->hidden, g_ptr_array_index (files, n));
+    }
+  else
+    {
+      g_hash_table_iter_init (&hash_iter, store->hidden);
+      while (g_hash_table_iter_next (&hash_iter, (gpointer *) &file, NULL))
+        if (thunar_list_model_file_visible (store, file, NULL))
+          {
+            g_ptr_array_add (files, file);
+            g_hash_table_iter_steal (&hash_iter);
+          }
+    }
+
+  /* sort them once, so they can be merged into the rows in a
+   * single pass, instead of a sorted insert and a position
+   * lookup for every file */
+  g_ptr_array_sort_with_data (files, thunar_list_model_cmp_array_func, store);
+
+  row = g_sequence_get_begin_iter (store->rows);
+  indices[0] = 0;
+  for (n = 0; n < files->len; ++n)
+    {
+      file = g_ptr_array_index (files, n);
+
+      /* skip all rows that sort before the file */
+      while (!g_sequence_iter_is_end (row)
+             && thunar_list_model_cmp_func (g_sequence_get (row), file, store) <= 0)
+        {
+          row = g_sequence_iter_next (row);
+          indices[0]++;
+        }
+
+      /* insert the file (the sequence takes over the reference) */
+      next = g_sequence_insert_before (row, file);
+      g_hash_table_insert (store->file_rows, file, next);
+
+      /* tell the view about the new row */
+      if (G_LIKELY (has_inserted_handler))
+        {
+          GTK_TREE_ITER_INIT (iter, store->stamp, next);
+          gtk_tree_model_row_inserted (GTK_TREE_MODEL (store), path, &iter);
+        }
+      indices[0]++;
+    }
+
+  g_ptr_array_free (files, TRUE);
+  gtk_tree_path_free (path);
+
+  if (matches != NULL)
+    g_hash_table_destroy (matches);
+}
+
+
+
 static void
 thunar_list_model_file_changed (ThunarFileMonitor *file_monitor,
                                 ThunarFile        *file,
                                 ThunarListModel   *store)
 {
   GSequenceIter *row;
-  GSequenceIter *end;
   gint           pos_after;
-  gint           pos_before = 0;
+  gint           pos_before;
   gint          *new_order;
   gint           length;
   gint           i, j;
@@ -1124,64 +1440,95 @@ thunar_list_model_file_changed (ThunarFileMonitor *file_monitor,
   _thunar_return_if_fail (THUNAR_IS_LIST_MODEL (store));
   _thunar_return_if_fail (THUNAR_IS_FILE (file));
 
-  row = g_sequence_get_begin_iter (store->rows);
-  end = g_sequence_get_end_iter (store->rows);
+  /* the formatted strings are outdated now */
+  g_hash_table_remove (store->render_cache, file);
 
-  while (row != end)
+  /* check if the file is a visible row in the store */
+  row = g_hash_table_lookup (store->file_rows, file);
+  if (G_LIKELY (row == NULL))
     {
-      if (G_UNLIKELY (g_sequence_get (row) == file))
+      /* a filtered file may match the filter after being renamed */
+      if (G_UNLIKELY (store->filter != NULL)
+          && g_hash_table_lookup (store->hidden, file) != NULL
+          && thunar_list_model_file_visible (store, file, NULL))
         {
-          /* generate the iterator for this row */
-          GTK_TREE_ITER_INIT (iter, store->stamp, row);
+          /* move the file from the set to the rows */
+          g_hash_table_steal (store->hidden, file);
+          row = g_sequence_insert_sorted (store->rows, file, thunar_list_model_cmp_func, store);
+          g_hash_table_insert (store->file_rows, file, row);
 
-          /* notify the view that it has to redraw the file */
-          _thunar_assert (pos_before == g_sequence_iter_get_position (row));
-          path = gtk_tree_path_new_from_indices (pos_before, -1);
-          gtk_tree_model_row_changed (GTK_TREE_MODEL (store), path, &iter);
+          GTK_TREE_ITER_INIT (iter, store->stamp, row);
+          path = gtk_tree_path_new_from_indices (g_sequence_iter_get_position (row), -1);
+          gtk_tree_model_row_inserted (GTK_TREE_MODEL (store), path, &iter);
           gtk_tree_path_free (path);
 
-          /* check if the sorting changed */
-          g_sequence_sort_changed (row, thunar_list_model_cmp_func, store);
-          pos_after = g_sequence_iter_get_position (row);
-          if (pos_after != pos_before)
-            {
-              /* do swap sorting here since its much faster than a complete sort */
-              length = g_sequence_get_length (store->rows);
-              if (G_LIKELY (length < 2000))
-                new_order = g_newa (gint, length);
-              else
-                new_order = g_new (gint, length);
-
-              /* new_order[newpos] = oldpos */
-              for (i = 0, j = 0; i < length; ++i)
-                {
-                  if (G_UNLIKELY (i == pos_after))
-                    {
-                      new_order[i] = pos_before;
-                    }
-                  else
-                    {
-                      if (G_UNLIKELY (j == pos_before))
-                        j++;
-                      new_order[i] = j++;
-                    }
-                }
+          g_object_notify_by_pspec (G_OBJECT (store), list_model_props[PROP_NUM_FILES]);
+        }
 
-              /* tell the view about the new item order */
-              path = gtk_tree_path_new_root ();
-              gtk_tree_model_rows_reordered (GTK_TREE_MODEL (store), path, NULL, new_order);
-              gtk_tree_path_free (path);
+      return;
+    }
 
-              /* clean up if we used the heap */
-              if (G_UNLIKELY (length >= 2000))
-                g_free (new_order);
-            }
+  /* generate the iterator for this row */
+  GTK_TREE_ITER_INIT (iter, store->stamp, row);
+
+  pos_before = g_sequence_iter_get_position (row);
+  path = gtk_tree_path_new_from_indices (pos_before, -1);
+
+  /* a renamed file may no longer match the filter */
+  if (G_UNLIKELY (store->filter != NULL)
+      && !thunar_list_model_file_visible (store, file, NULL))
+    {
+      /* move the file from the rows to the set */
+      g_hash_table_insert (store->hidden, g_object_ref (file), file);
+      g_hash_table_remove (store->file_rows, file);
+      g_sequence_remove (row);
+
+      gtk_tree_model_row_deleted (GTK_TREE_MODEL (store), path);
+      gtk_tree_path_free (path);
+
+      g_object_notify_by_pspec (G_OBJECT (store), list_model_props[PROP_NUM_FILES]);
+      return;
+    }
+
+  /* notify the view that it has to redraw the file */
+  gtk_tree_model_row_changed (GTK_TREE_MODEL (store), path, &iter);
+  gtk_tree_path_free (path);
+
+  /* check if the sorting changed */
+  g_sequence_sort_changed (row, thunar_list_model_cmp_func, store);
+  pos_after = g_sequence_iter_get_position (row);
+  if (pos_after != pos_before)
+    {
+      /* do swap sorting here since its much faster than a complete sort */
+      length = g_sequence_get_length (store->rows);
+      if (G_LIKELY (length < 2000))
+        new_order = g_newa (gint, length);
+      else
+        new_order = g_new (gint, length);
 
-          break;
+      /* new_order[newpos] = oldpos */
+      for (i = 0, j = 0; i < length; ++i)
+        {
+          if (G_UNLIKELY (i == pos_after))
+            {
+              new_order[i] = pos_before;
+            }
+          else
+            {
+              if (G_UNLIKELY (j == pos_before))
+                j++;
+              new_order[i] = j++;
+            }
         }
 
-      row = g_sequence_iter_next (row);
-      pos_before++;
+      /* tell the view about the new item order */
+      path = gtk_tree_path_new_root ();
+      gtk_tree_model_rows_reordered (GTK_TREE_MODEL (store), path, NULL, new_order);
+      gtk_tree_path_free (path);
+
+      /* clean up if we used the heap */
+      if (G_UNLIKELY (length >= 2000))
+        g_free (new_order);
     }
 }
 
@@ -1250,16 +1597,17 @@ thunar_list_model_files_added (ThunarFolder    *folder,
       file = g_object_ref (G_OBJECT (lp->data));
       _thunar_return_if_fail (THUNAR_IS_FILE (file));
 
-      /* check if the file should be hidden */
-      if (!store->show_hidden && thunar_file_is_hidden (file))
+      /* check if the file should be hidden or is filtered */
+      if (!thunar_list_model_file_visible (store, file, NULL))
         {
-          store->hidden = g_slist_prepend (store->hidden, file);
+          g_hash_table_insert (store->hidden, file, file);
         }
       else
         {
           /* insert the file */
           row = g_sequence_insert_sorted (store->rows, file,
                                           thunar_list_model_cmp_func, store);
+          g_hash_table_insert (store->file_rows, file, row);
 
           if (has_handler)
             {
@@ -1288,51 +1636,32 @@ thunar_list_model_files_removed (ThunarFolder    *folder,
 {
   GList         *lp;
   GSequenceIter *row;
-  GSequenceIter *end;
-  GSequenceIter *next;
   GtkTreePath   *path;
-  gboolean       found;
 
   /* drop all the referenced files from the model */
   for (lp = files; lp != NULL; lp = lp->next)
     {
-      row = g_sequence_get_begin_iter (store->rows);
-      end = g_sequence_get_end_iter (store->rows);
-
-      found = FALSE;
+      g_hash_table_remove (store->render_cache, lp->data);
 
-      while (row != end)
+      row = g_hash_table_lookup (store->file_rows, lp->data);
+      if (G_LIKELY (row != NULL))
         {
-          next = g_sequence_iter_next (row);
-
-          if (g_sequence_get (row) == lp->data)
-            {
-              /* setup path for "row-deleted" */
-              path = gtk_tree_path_new_from_indices (g_sequence_iter_get_position (row), -1);
-
-              /* remove file from the model */
-              g_sequence_remove (row);
-
-              /* notify the view(s) */
-              gtk_tree_model_row_deleted (GTK_TREE_MODEL (store), path);
-              gtk_tree_path_free (path);
-
-              /* no need to look in the hidden files */
-              found = TRUE;
+          /* setup path for "row-deleted" */
+          path = gtk_tree_path_new_from_indices (g_sequence_iter_get_position (row), -1);
 
-              break;
-            }
+          /* remove file from the model */
+          g_hash_table_remove (store->file_rows, lp->data);
+          g_sequence_remove (row);
 
-          row = next;
+          /* notify the view(s) */
+          gtk_tree_model_row_deleted (GTK_TREE_MODEL (store), path);
+          gtk_tree_path_free (path);
         }
-
-      /* check if the file was found */
-      if (!found)
+      else
         {
           /* file is hidden */
-          _thunar_assert (g_slist_find (store->hidden, lp->data) != NULL);
-          store->hidden = g_slist_remove (store->hidden, lp->data);
-          g_object_unref (G_OBJECT (lp->data));
+          _thunar_assert (g_hash_table_lookup (store->hidden, lp->data) != NULL);
+          g_hash_table_remove (store->hidden, lp->data);
         }
     }
 
@@ -1725,6 +2054,9 @@ thunar_list_model_set_date_style (ThunarListModel *store,
       /* apply the new setting */
       store->date_style = date_style;
 
+      /* drop the dates formatted in the old style */
+      g_hash_table_remove_all (store->render_cache);
+
       /* notify listeners */
       g_object_notify_by_pspec (G_OBJECT (store), list_model_props[PROP_DATE_STYLE]);
 
@@ -1784,6 +2116,8 @@ thunar_list_model_set_folder (ThunarListModel *store,
       end = g_sequence_get_end_iter (store->rows);
 
       /* remove existing entries */
+      g_hash_table_remove_all (store->file_rows);
+      g_hash_table_remove_all (store->render_cache);
       path = gtk_tree_path_new_first ();
       while (row != end)
         {
@@ -1801,8 +2135,7 @@ thunar_list_model_set_folder (ThunarListModel *store,
       gtk_tree_path_free (path);
 
       /* remove hidden entries */
-      g_slist_free_full (store->hidden, g_object_unref);
-      store->hidden = NULL;
+      g_hash_table_remove_all (store->hidden);
 
       /* unregister signals and drop the reference */
       g_signal_handlers_disconnect_matched (G_OBJECT (store->folder), G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, store);
@@ -1823,6 +2156,16 @@ thunar_list_model_set_folder (ThunarListModel *store,
   /* freeze */
   g_object_freeze_notify (G_OBJECT (store));
 
+  /* the filter only applies to the previous folder */
+  if (G_UNLIKELY (store->filter != NULL))
+    {
+      g_free (store->filter);
+      store->filter = NULL;
+      g_object_unref (G_OBJECT (store->name_index));
+      store->name_index = NULL;
+      g_object_notify_by_pspec (G_OBJECT (store), list_model_props[PROP_FILTER]);
+    }
+
   /* connect to the new folder (if any) */
   if (folder != NULL)
     {
@@ -1921,14 +2264,6 @@ void
 thunar_list_model_set_show_hidden (ThunarListModel *store,
                                    gboolean         show_hidden)
 {
-  GtkTreePath   *path;
-  GtkTreeIter    iter;
-  ThunarFile    *file;
-  GSList        *lp;
-  GSequenceIter *row;
-  GSequenceIter *next;
-  GSequenceIter *end;
-
   _thunar_return_if_fail (THUNAR_IS_LIST_MODEL (store));
 
   /* check if the settings differ */
@@ -1937,64 +2272,80 @@ thunar_list_model_set_show_hidden (ThunarListModel *store,
 
   store->show_hidden = show_hidden;
 
-  if (store->show_hidden)
-    {
-      for (lp = store->hidden; lp != NULL; lp = lp->next)
-        {
-          file = THUNAR_FILE (lp->data);
+  /* add or remove the hidden files */
+  thunar_list_model_refilter (store);
 
-          /* insert file in the sorted position */
-          row = g_sequence_insert_sorted (store->rows, file,
-                                          thunar_list_model_cmp_func, store);
+  /* notify listeners about the new setting */
+  g_object_freeze_notify (G_OBJECT (store));
+  g_object_notify_by_pspec (G_OBJECT (store), list_model_props[PROP_NUM_FILES]);
+  g_object_notify_by_pspec (G_OBJECT (store), list_model_props[PROP_SHOW_HIDDEN]);
+  g_object_thaw_notify (G_OBJECT (store));
+}
 
-          GTK_TREE_ITER_INIT (iter, store->stamp, row);
 
-          /* tell the view about the new row */
-          path = gtk_tree_path_new_from_indices (g_sequence_iter_get_position (row), -1);
-          gtk_tree_model_row_inserted (GTK_TREE_MODEL (store), path, &iter);
-          gtk_tree_path_free (path);
-        }
-      g_slist_free (store->hidden);
-      store->hidden = NULL;
-    }
-  else
-    {
-      _thunar_assert (store->hidden == NULL);
 
-      /* remove all hidden files */
-      row = g_sequence_get_begin_iter (store->rows);
-      end = g_sequence_get_end_iter (store->rows);
+/**
+ * thunar_list_model_get_filter:
+ * @store : a #ThunarListModel.
+ *
+ * Return value: the text the display names of the files in
+ *               @store are filtered by, or %NULL.
+ **/
+const gchar*
+thunar_list_model_get_filter (ThunarListModel *store)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_LIST_MODEL (store), NULL);
+  return store->filter;
+}
 
-      while (row != end)
-        {
-          next = g_sequence_iter_next (row);
 
-          file = g_sequence_get (row);
-          if (thunar_file_is_hidden (file))
-            {
-              /* store file in the list */
-              store->hidden = g_slist_prepend (store->hidden, g_object_ref (file));
 
-              /* setup path for "row-deleted" */
-              path = gtk_tree_path_new_from_indices (g_sequence_iter_get_position (row), -1);
+/**
+ * thunar_list_model_set_filter:
+ * @store  : a #ThunarListModel.
+ * @filter : the text to filter by or %NULL.
+ *
+ * Only presents the files whose display name contains @filter,
+ * ignoring case. The matching files are looked up in an index of
+ * the display names, and only the rows that changed are inserted
+ * into or removed from @store, so this is cheap to call while the
+ * user types the @filter. An empty @filter presents all files.
+ **/
+void
+thunar_list_model_set_filter (ThunarListModel *store,
+                              const gchar     *filter)
+{
+  _thunar_return_if_fail (THUNAR_IS_LIST_MODEL (store));
+
+  if (filter != NULL && *filter == '\0')
+    filter = NULL;
 
-              /* remove file from the model */
-              g_sequence_remove (row);
+  /* check if the filter differs */
+  if (g_strcmp0 (store->filter, filter) == 0)
+    return;
 
-              /* notify the view(s) */
-              gtk_tree_model_row_deleted (GTK_TREE_MODEL (store), path);
-              gtk_tree_path_free (path);
-            }
+  g_free (store->filter);
+  store->filter = g_strdup (filter);
 
-          row = next;
-          _thunar_assert (end == g_sequence_get_end_iter (store->rows));
-        }
+  /* only index the names while the user filters the folder */
+  if (filter != NULL && store->name_index == NULL)
+    {
+      store->name_index = thunar_name_index_new ();
+      thunar_name_index_set_folder (store->name_index, store->folder);
     }
+  else if (filter == NULL && store->name_index != NULL)
+    {
+      g_object_unref (G_OBJECT (store->name_index));
+      store->name_index = NULL;
+    }
+
+  /* add or remove the (no longer) matching files */
+  thunar_list_model_refilter (store);
 
   /* notify listeners about the new setting */
   g_object_freeze_notify (G_OBJECT (store));
   g_object_notify_by_pspec (G_OBJECT (store), list_model_props[PROP_NUM_FILES]);
-  g_object_notify_by_pspec (G_OBJECT (store), list_model_props[PROP_SHOW_HIDDEN]);
+  g_object_notify_by_pspec (G_OBJECT (store), list_model_props[PROP_FILTER]);
   g_object_thaw_notify (G_OBJECT (store));
 }
 
@@ -2041,6 +2392,9 @@ thunar_list_model_set_file_size_binary (ThunarListModel *store,
       /* apply the new setting */
       store->file_size_binary = file_size_binary;
 
+      /* drop the sizes formatted with the old setting */
+      g_hash_table_remove_all (store->render_cache);
+
       /* resort the model with the new setting */
       thunar_list_model_sort (store);
 
@@ -2121,26 +2475,17 @@ thunar_list_model_get_paths_for_files (ThunarListModel *store,
                                        GList           *files)
 {
   GList         *paths = NULL;
+  GList         *lp;
   GSequenceIter *row;
-  GSequenceIter *end;
-  gint           i = 0;
 
   _thunar_return_val_if_fail (THUNAR_IS_LIST_MODEL (store), NULL);
 
-  row = g_sequence_get_begin_iter (store->rows);
-  end = g_sequence_get_end_iter (store->rows);
-
   /* find the rows for the given files */
-  while (row != end)
+  for (lp = files; lp != NULL; lp = lp->next)
     {
-      if (g_list_find (files, g_sequence_get (row)) != NULL)
-        {
-          _thunar_assert (i == g_sequence_iter_get_position (row));
-          paths = g_list_prepend (paths, gtk_tree_path_new_from_indices (i, -1));
-        }
-
-      row = g_sequence_iter_next (row);
-      i++;
+      row = g_hash_table_lookup (store->file_rows, lp->data);
+      if (G_LIKELY (row != NULL))
+        paths = g_list_prepend (paths, gtk_tree_path_new_from_indices (g_sequence_iter_get_position (row), -1));
     }
 
   return paths;
@@ -34,13 +34,22 @@ G_DEFINE_TYPE (ThunarLocationDialog, thunar_location_dialog, THUNAR_TYPE_ABSTRAC
 
 
 
-static gboolean
-transform_object_to_boolean (const GValue *src_value,
-                             GValue       *dst_value,
-                             gpointer      user_data)
+static void
+thunar_location_dialog_entry_notify (GtkWidget  *path_entry,
+                                     GParamSpec *pspec,
+                                     GtkWidget  *open_button)
 {
-  g_value_set_boolean (dst_value, (g_value_get_object (src_value) != NULL));
-  return TRUE;
+  ThunarFile *current_file;
+  gboolean    resolving;
+
+  /* the "Open" button is only sensitive if a valid file is entered,
+   * or while the entered text is still being looked up, in which case
+   * the file is resolved right away when the dialog is accepted */
+  g_object_get (G_OBJECT (path_entry), "current-file", &current_file, "resolving", &resolving, NULL);
+  gtk_widget_set_sensitive (open_button, current_file != NULL || resolving);
+
+  if (current_file != NULL)
+    g_object_unref (G_OBJECT (current_file));
 }
 
 
@@ -88,9 +97,11 @@ thunar_location_dialog_init (ThunarLocationDialog *location_dialog)
   gtk_widget_show (location_dialog->entry);
 
   /* the "Open" button is only sensitive if a valid file is entered */
-  exo_binding_new_full (G_OBJECT (location_dialog->entry), "current-file",
-                        G_OBJECT (open_button), "sensitive",
-                        transform_object_to_boolean, NULL, NULL);
+  g_signal_connect (G_OBJECT (location_dialog->entry), "notify::current-file",
+                    G_CALLBACK (thunar_location_dialog_entry_notify), open_button);
+  g_signal_connect (G_OBJECT (location_dialog->entry), "notify::resolving",
+                    G_CALLBACK (thunar_location_dialog_entry_notify), open_button);
+  thunar_location_dialog_entry_notify (location_dialog->entry, NULL, open_button);
 }
 
 
@@ -0,0 +1,752 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Xfce development team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_SYS_TYPES_H
+#include <sys/types.h>
+#endif
+#ifdef HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <glib/gstdio.h>
+
+#include <thunar/thunar-monitor-registry.h>
+#include <thunar/thunar-preferences.h>
+#include <thunar/thunar-private.h>
+
+
+
+/* interval in seconds to check demoted locations for changes */
+#define THUNAR_MONITOR_POLL_INTERVAL  (5)
+
+/* budget if the inotify limits of the user are unknown */
+#define THUNAR_MONITOR_DEFAULT_BUDGET (4096)
+
+
+
+typedef enum
+{
+  THUNAR_MONITOR_KIND_FILE,
+  THUNAR_MONITOR_KIND_DIRECTORY,
+} ThunarMonitorKind;
+
+typedef struct
+{
+  gchar            *key;
+  GFile            *file;
+  ThunarMonitorKind kind;
+
+  /* the union of the flags of all subscriptions */
+  GFileMonitorFlags flags;
+
+  /* the subscriptions, one for each set of flags */
+  GSList           *subscriptions;
+  guint             n_users;
+
+  /* the backend monitor, NULL while the location is polled */
+  GFileMonitor     *monitor;
+
+  /* local path, only local locations count against the budget */
+  gchar            *path;
+  GList            *link;
+
+  /* last known state of a polled location */
+  gboolean          exists;
+  struct stat       statb;
+} ThunarMonitorEntry;
+
+typedef struct
+{
+  ThunarMonitorEntry *entry;
+  GFileMonitorFlags   flags;
+
+  /* the monitor shared by all users with these flags */
+  GFileMonitor       *proxy;
+  guint               n_users;
+} ThunarMonitorSubscription;
+
+typedef struct
+{
+  GFileMonitor      *proxy;
+  GFileMonitorFlags  flags;
+  GFile             *file;
+  GFile             *other_file;
+  GFileMonitorEvent  event;
+} ThunarMonitorEvent;
+
+
+
+typedef GFileMonitor      ThunarMonitorProxy;
+typedef GFileMonitorClass ThunarMonitorProxyClass;
+
+#define THUNAR_TYPE_MONITOR_PROXY (thunar_monitor_proxy_get_type ())
+
+static GType    thunar_monitor_proxy_get_type      (void) G_GNUC_CONST;
+static gboolean thunar_monitor_proxy_cancel        (GFileMonitor       *monitor);
+static void     thunar_monitor_registry_changed    (GFileMonitor       *monitor,
+                                                    GFile              *file,
+                                                    GFile              *other_file,
+                                                    GFileMonitorEvent   event_type,
+                                                    ThunarMonitorEntry *entry);
+static void     thunar_monitor_registry_set_budget (void);
+
+
+
+G_DEFINE_TYPE (ThunarMonitorProxy, thunar_monitor_proxy, G_TYPE_FILE_MONITOR)
+
+
+
+/* all entries by key, and subscriptions by proxy monitor */
+static GHashTable        *registry_entries = NULL;
+static GHashTable        *registry_proxies = NULL;
+
+/* local entries with a backend monitor, most recently used first */
+static GQueue             registry_watches = G_QUEUE_INIT;
+
+/* local entries demoted to polling */
+static GQueue             registry_polling = G_QUEUE_INIT;
+static guint              registry_poll_id = 0;
+
+static ThunarPreferences *registry_preferences = NULL;
+static guint              registry_budget = 0;
+static guint              registry_n_demotions = 0;
+
+
+
+static void
+thunar_monitor_proxy_class_init (ThunarMonitorProxyClass *klass)
+{
+  klass->cancel = thunar_monitor_proxy_cancel;
+}
+
+
+
+static void
+thunar_monitor_proxy_init (ThunarMonitorProxy *proxy)
+{
+}
+
+
+
+static gboolean
+thunar_monitor_proxy_cancel (GFileMonitor *monitor)
+{
+  /* the backend monitor is released by the registry */
+  return TRUE;
+}
+
+
+
+static void
+thunar_monitor_registry_init (void)
+{
+  if (G_LIKELY (registry_entries != NULL))
+    return;
+
+  registry_entries = g_hash_table_new (g_str_hash, g_str_equal);
+  registry_proxies = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+  /* follow changes of the budget */
+  registry_preferences = thunar_preferences_get ();
+  g_signal_connect_swapped (G_OBJECT (registry_preferences), "notify::misc-max-file-watches",
+                            G_CALLBACK (thunar_monitor_registry_set_budget), NULL);
+  thunar_monitor_registry_set_budget ();
+}
+
+
+
+static void
+thunar_monitor_registry_touch (ThunarMonitorEntry *entry)
+{
+  /* move local watches to the front of the lru queue */
+  if (entry->monitor != NULL
+      && entry->link != NULL
+      && entry->link != registry_watches.head)
+    {
+      g_queue_unlink (&registry_watches, entry->link);
+      g_queue_push_head_link (&registry_watches, entry->link);
+    }
+}
+
+
+
+static gboolean
+thunar_monitor_registry_watch (ThunarMonitorEntry *entry)
+{
+  _thunar_return_val_if_fail (entry->monitor == NULL, FALSE);
+
+  if (entry->kind == THUNAR_MONITOR_KIND_DIRECTORY)
+    entry->monitor = g_file_monitor_directory (entry->file, entry->flags, NULL, NULL);
+  else
+    entry->monitor = g_file_monitor (entry->file, entry->flags, NULL, NULL);
+
+  if (G_UNLIKELY (entry->monitor == NULL))
+    return FALSE;
+
+  g_signal_connect (G_OBJECT (entry->monitor), "changed",
+                    G_CALLBACK (thunar_monitor_registry_changed), entry);
+
+  return TRUE;
+}
+
+
+
+static void
+thunar_monitor_registry_unwatch (ThunarMonitorEntry *entry)
+{
+  if (G_LIKELY (entry->monitor != NULL))
+    {
+      g_signal_handlers_disconnect_matched (G_OBJECT (entry->monitor),
+                                            G_SIGNAL_MATCH_DATA, 0, 0,
+                                            NULL, NULL, entry);
+      g_file_monitor_cancel (entry->monitor);
+      g_object_unref (G_OBJECT (entry->monitor));
+      entry->monitor = NULL;
+    }
+}
+
+
+
+static void
+thunar_monitor_registry_stat (ThunarMonitorEntry *entry,
+                              struct stat        *statb,
+                              gboolean           *exists)
+{
+  *exists = (g_stat (entry->path, statb) == 0);
+  if (!*exists)
+    memset (statb, 0, sizeof (*statb));
+}
+
+
+
+static void
+thunar_monitor_registry_queue_event (GArray             *events,
+                                     ThunarMonitorEntry *entry,
+                                     GFile              *file,
+                                     GFile              *other_file,
+                                     GFileMonitorEvent   event_type)
+{
+  ThunarMonitorSubscription *subscription;
+  ThunarMonitorEvent         event;
+  GSList                    *lp;
+
+  /* queue the event for every subscription of the entry */
+  for (lp = entry->subscriptions; lp != NULL; lp = lp->next)
+    {
+      subscription = lp->data;
+
+      event.proxy = g_object_ref (G_OBJECT (subscription->proxy));
+      event.flags = subscription->flags;
+      event.file = g_object_ref (G_OBJECT (file));
+      event.other_file = (other_file != NULL) ? g_object_ref (G_OBJECT (other_file)) : NULL;
+      event.event = event_type;
+      g_array_append_val (events, event);
+    }
+}
+
+
+
+static void
+thunar_monitor_registry_emit_events (GArray *events)
+{
+  ThunarMonitorEvent *event;
+  guint               n;
+
+  for (n = 0; n < events->len; n++)
+    {
+      event = &g_array_index (events, ThunarMonitorEvent, n);
+
+      /* skip monitors released by an earlier handler */
+      if (g_file_monitor_is_cancelled (event->proxy))
+        ;
+      else if (event->event == G_FILE_MONITOR_EVENT_MOVED
+               && (event->flags & G_FILE_MONITOR_SEND_MOVED) == 0)
+        {
+          /* report a move like the backend does without SEND_MOVED */
+          g_file_monitor_emit_event (event->proxy, event->file, NULL, G_FILE_MONITOR_EVENT_DELETED);
+          if (event->other_file != NULL && !g_file_monitor_is_cancelled (event->proxy))
+            g_file_monitor_emit_event (event->proxy, event->other_file, NULL, G_FILE_MONITOR_EVENT_CREATED);
+        }
+      else if ((event->event == G_FILE_MONITOR_EVENT_PRE_UNMOUNT
+                || event->event == G_FILE_MONITOR_EVENT_UNMOUNTED)
+               && (event->flags & G_FILE_MONITOR_WATCH_MOUNTS) == 0)
+        {
+          /* mount events are only sent with WATCH_MOUNTS */
+        }
+      else
+        {
+          g_file_monitor_emit_event (event->proxy, event->file, event->other_file, event->event);
+        }
+
+      g_object_unref (G_OBJECT (event->proxy));
+      g_object_unref (G_OBJECT (event->file));
+      if (event->other_file != NULL)
+        g_object_unref (G_OBJECT (event->other_file));
+    }
+
+  g_array_free (events, TRUE);
+}
+
+
+
+static gboolean
+thunar_monitor_registry_poll (gpointer user_data)
+{
+  ThunarMonitorEntry *entry;
+  GFileMonitorEvent   event_type;
+  struct stat         statb;
+  gboolean            exists;
+  GArray             *events;
+  GList              *lp;
+
+  events = g_array_new (FALSE, FALSE, sizeof (ThunarMonitorEvent));
+
+  for (lp = registry_polling.head; lp != NULL; lp = lp->next)
+    {
+      entry = lp->data;
+      thunar_monitor_registry_stat (entry, &statb, &exists);
+
+      if (entry->exists && !exists)
+        event_type = G_FILE_MONITOR_EVENT_DELETED;
+      else if (!entry->exists && exists)
+        event_type = G_FILE_MONITOR_EVENT_CREATED;
+      else if (exists
+               && (statb.st_mtime != entry->statb.st_mtime
+                   || statb.st_ctime != entry->statb.st_ctime
+                   || statb.st_size != entry->statb.st_size
+                   || statb.st_ino != entry->statb.st_ino))
+        event_type = G_FILE_MONITOR_EVENT_CHANGED;
+      else
+        continue;
+
+      entry->exists = exists;
+      entry->statb = statb;
+
+      /* emit after the loop, handlers might release their monitors */
+      thunar_monitor_registry_queue_event (events, entry, entry->file, NULL, event_type);
+    }
+
+  thunar_monitor_registry_emit_events (events);
+
+  return TRUE;
+}
+
+
+
+static void
+thunar_monitor_registry_start_polling (ThunarMonitorEntry *entry)
+{
+  /* remember the current state to compare against */
+  thunar_monitor_registry_stat (entry, &entry->statb, &entry->exists);
+
+  g_queue_push_tail_link (&registry_polling, entry->link);
+
+  if (registry_poll_id == 0)
+    {
+      registry_poll_id = g_timeout_add_seconds (THUNAR_MONITOR_POLL_INTERVAL,
+                                                thunar_monitor_registry_poll, NULL);
+    }
+}
+
+
+
+static void
+thunar_monitor_registry_demote (ThunarMonitorEntry *entry)
+{
+  _thunar_return_if_fail (entry->link != NULL);
+  _thunar_return_if_fail (entry->monitor != NULL);
+
+  thunar_monitor_registry_unwatch (entry);
+
+  g_queue_unlink (&registry_watches, entry->link);
+  thunar_monitor_registry_start_polling (entry);
+
+  if (registry_n_demotions++ == 0)
+    {
+      g_message ("Reached the limit of %u file watches, "
+                 "changes in the least recently used folders are now polled",
+                 registry_budget);
+    }
+}
+
+
+
+static void
+thunar_monitor_registry_promote (void)
+{
+  ThunarMonitorEntry *entry;
+  GList              *link;
+
+  while (registry_polling.length > 0
+         && registry_watches.length < registry_budget)
+    {
+      link = registry_polling.head;
+      entry = link->data;
+
+      if (!thunar_monitor_registry_watch (entry))
+        break;
+
+      g_queue_unlink (&registry_polling, link);
+      g_queue_push_head_link (&registry_watches, link);
+    }
+
+  if (registry_polling.length == 0
+      && registry_poll_id != 0)
+    {
+      g_source_remove (registry_poll_id);
+      registry_poll_id = 0;
+    }
+}
+
+
+
+static void
+thunar_monitor_registry_set_budget (void)
+{
+  gchar   *contents;
+  guint64  max_watches;
+  guint    budget;
+
+  g_object_get (G_OBJECT (registry_preferences), "misc-max-file-watches", &budget, NULL);
+
+  if (budget == 0)
+    {
+      budget = THUNAR_MONITOR_DEFAULT_BUDGET;
+
+      /* leave half of the user's inotify watches for other applications */
+      if (g_file_get_contents ("/proc/sys/fs/inotify/max_user_watches", &contents, NULL, NULL))
+        {
+          max_watches = g_ascii_strtoull (contents, NULL, 10);
+          if (G_LIKELY (max_watches >= 2))
+            budget = MIN (max_watches / 2, G_MAXUINT);
+          g_free (contents);
+        }
+    }
+
+  registry_budget = budget;
+
+  /* demote the least recently used watches over the budget */
+  while (registry_watches.length > registry_budget)
+    thunar_monitor_registry_demote (registry_watches.tail->data);
+
+  /* or use the room for polled locations */
+  thunar_monitor_registry_promote ();
+}
+
+
+
+static void
+thunar_monitor_registry_changed (GFileMonitor       *monitor,
+                                 GFile              *file,
+                                 GFile              *other_file,
+                                 GFileMonitorEvent   event_type,
+                                 ThunarMonitorEntry *entry)
+{
+  GArray *events;
+
+  _thunar_return_if_fail (entry->monitor == monitor);
+
+  thunar_monitor_registry_touch (entry);
+
+  /* forward to the users, entry might be released in the handlers */
+  events = g_array_new (FALSE, FALSE, sizeof (ThunarMonitorEvent));
+  thunar_monitor_registry_queue_event (events, entry, file, other_file, event_type);
+  thunar_monitor_registry_emit_events (events);
+}
+
+
+
+static void
+thunar_monitor_registry_add_flags (ThunarMonitorEntry *entry,
+                                   GFileMonitorFlags   flags)
+{
+  /* nothing to do if the backend already watches for these flags */
+  if ((entry->flags | flags) == entry->flags)
+    return;
+
+  entry->flags |= flags;
+
+  /* polled locations pick up the flags when promoted */
+  if (entry->monitor == NULL)
+    return;
+
+  /* replace the backend monitor, keeping its place in the lru queue */
+  thunar_monitor_registry_unwatch (entry);
+  if (!thunar_monitor_registry_watch (entry) && entry->link != NULL)
+    {
+      g_queue_unlink (&registry_watches, entry->link);
+      thunar_monitor_registry_start_polling (entry);
+    }
+}
+
+
+
+static GFileMonitor *
+thunar_monitor_registry_subscribe (ThunarMonitorEntry *entry,
+                                   GFileMonitorFlags   flags)
+{
+  ThunarMonitorSubscription *subscription;
+  GSList                    *lp;
+
+  entry->n_users++;
+
+  /* users with the same flags share a subscription */
+  for (lp = entry->subscriptions; lp != NULL; lp = lp->next)
+    {
+      subscription = lp->data;
+      if (subscription->flags == flags)
+        {
+          subscription->n_users++;
+          return g_object_ref (G_OBJECT (subscription->proxy));
+        }
+    }
+
+  subscription = g_slice_new0 (ThunarMonitorSubscription);
+  subscription->entry = entry;
+  subscription->flags = flags;
+  subscription->proxy = g_object_new (THUNAR_TYPE_MONITOR_PROXY, NULL);
+  subscription->n_users = 1;
+
+  entry->subscriptions = g_slist_prepend (entry->subscriptions, subscription);
+  g_hash_table_insert (registry_proxies, subscription->proxy, subscription);
+
+  return g_object_ref (G_OBJECT (subscription->proxy));
+}
+
+
+
+static GFileMonitor *
+thunar_monitor_registry_acquire (GFile             *file,
+                                 GFileMonitorFlags  flags,
+                                 ThunarMonitorKind  kind)
+{
+  ThunarMonitorEntry *entry;
+  gchar              *uri;
+  gchar              *key;
+
+  thunar_monitor_registry_init ();
+
+  /* all users of a location share the backend monitor, whatever
+   * flags they ask for, so the key only holds the kind and location */
+  uri = g_file_get_uri (file);
+  key = g_strdup_printf ("%d:%s", kind, uri);
+  g_free (uri);
+
+  entry = g_hash_table_lookup (registry_entries, key);
+  if (entry != NULL)
+    {
+      g_free (key);
+
+      thunar_monitor_registry_add_flags (entry, flags);
+      thunar_monitor_registry_touch (entry);
+
+      return thunar_monitor_registry_subscribe (entry, flags);
+    }
+
+  entry = g_slice_new0 (ThunarMonitorEntry);
+  entry->key = key;
+  entry->file = g_object_ref (G_OBJECT (file));
+  entry->flags = flags;
+  entry->kind = kind;
+
+  if (g_file_is_native (file))
+    entry->path = g_file_get_path (file);
+
+  if (entry->path != NULL)
+    {
+      /* make room by demoting the least recently used watch */
+      if (registry_watches.length >= registry_budget
+          && registry_watches.tail != NULL)
+        thunar_monitor_registry_demote (registry_watches.tail->data);
+
+      if (registry_watches.length < registry_budget
+          && thunar_monitor_registry_watch (entry))
+        {
+          g_queue_push_head (&registry_watches, entry);
+          entry->link = registry_watches.head;
+        }
+      else
+        {
+          /* fall back to polling if no watch is available */
+          entry->link = g_list_prepend (NULL, entry);
+          thunar_monitor_registry_start_polling (entry);
+        }
+    }
+  else if (!thunar_monitor_registry_watch (entry))
+    {
+      g_object_unref (G_OBJECT (entry->file));
+      g_free (entry->key);
+      g_slice_free (ThunarMonitorEntry, entry);
+      return NULL;
+    }
+
+  g_hash_table_insert (registry_entries, entry->key, entry);
+
+  return thunar_monitor_registry_subscribe (entry, flags);
+}
+
+
+
+/**
+ * thunar_monitor_registry_get:
+ * @file  : a #GFile.
+ * @flags : the #GFileMonitorFlags.
+ *
+ * Like g_file_monitor(), but the backend monitor is shared with all
+ * other users of @file, watching for the union of their @flags. The
+ * events are reported as if @file was monitored with @flags alone.
+ * Local locations over the watch budget are checked for changes
+ * periodically instead.
+ *
+ * The returned monitor must not be cancelled, release it using
+ * thunar_monitor_registry_release() after disconnecting your
+ * signal handlers.
+ *
+ * Return value: the shared #GFileMonitor or %NULL.
+ **/
+GFileMonitor *
+thunar_monitor_registry_get (GFile             *file,
+                             GFileMonitorFlags  flags)
+{
+  _thunar_return_val_if_fail (G_IS_FILE (file), NULL);
+  return thunar_monitor_registry_acquire (file, flags, THUNAR_MONITOR_KIND_FILE);
+}
+
+
+
+/**
+ * thunar_monitor_registry_get_directory:
+ * @file  : a #GFile.
+ * @flags : the #GFileMonitorFlags.
+ *
+ * Like thunar_monitor_registry_get(), but for g_file_monitor_directory().
+ *
+ * Return value: the shared #GFileMonitor or %NULL.
+ **/
+GFileMonitor *
+thunar_monitor_registry_get_directory (GFile             *file,
+                                       GFileMonitorFlags  flags)
+{
+  _thunar_return_val_if_fail (G_IS_FILE (file), NULL);
+  return thunar_monitor_registry_acquire (file, flags, THUNAR_MONITOR_KIND_DIRECTORY);
+}
+
+
+
+/**
+ * thunar_monitor_registry_release:
+ * @monitor : a #GFileMonitor returned by the registry.
+ *
+ * Releases a monitor returned by thunar_monitor_registry_get() or
+ * thunar_monitor_registry_get_directory(). The location is no
+ * longer watched when the last user released its monitor.
+ **/
+void
+thunar_monitor_registry_release (GFileMonitor *monitor)
+{
+  ThunarMonitorSubscription *subscription;
+  ThunarMonitorEntry        *entry;
+  gboolean                   had_watch = FALSE;
+
+  _thunar_return_if_fail (G_IS_FILE_MONITOR (monitor));
+
+  subscription = g_hash_table_lookup (registry_proxies, monitor);
+  _thunar_return_if_fail (subscription != NULL);
+
+  entry = subscription->entry;
+  entry->n_users--;
+
+  /* the backend keeps watching for the flags of a released
+   * subscription, the events are still translated per user */
+  if (--subscription->n_users == 0)
+    {
+      g_hash_table_remove (registry_proxies, subscription->proxy);
+      entry->subscriptions = g_slist_remove (entry->subscriptions, subscription);
+
+      g_file_monitor_cancel (subscription->proxy);
+      g_object_unref (G_OBJECT (subscription->proxy));
+      g_slice_free (ThunarMonitorSubscription, subscription);
+    }
+
+  if (entry->n_users == 0)
+    {
+      g_hash_table_remove (registry_entries, entry->key);
+
+      if (entry->link != NULL)
+        {
+          had_watch = (entry->monitor != NULL);
+          if (had_watch)
+            g_queue_delete_link (&registry_watches, entry->link);
+          else
+            g_queue_delete_link (&registry_polling, entry->link);
+        }
+
+      thunar_monitor_registry_unwatch (entry);
+
+      /* a watch became available for a polled location */
+      if (had_watch)
+        thunar_monitor_registry_promote ();
+
+      g_object_unref (G_OBJECT (entry->file));
+      g_free (entry->path);
+      g_free (entry->key);
+      g_slice_free (ThunarMonitorEntry, entry);
+    }
+
+  g_object_unref (G_OBJECT (monitor));
+}
+
+
+
+/**
+ * thunar_monitor_registry_get_stats:
+ * @stats : return location for the #ThunarMonitorStats.
+ *
+ * Fills @stats with the current usage of the registry.
+ **/
+void
+thunar_monitor_registry_get_stats (ThunarMonitorStats *stats)
+{
+  GHashTableIter      iter;
+  gpointer            entry;
+
+  _thunar_return_if_fail (stats != NULL);
+
+  thunar_monitor_registry_init ();
+
+  stats->n_locations = g_hash_table_size (registry_entries);
+  stats->n_watches = registry_watches.length;
+  stats->n_polling = registry_polling.length;
+  stats->n_demotions = registry_n_demotions;
+  stats->budget = registry_budget;
+  stats->n_users = 0;
+
+  g_hash_table_iter_init (&iter, registry_entries);
+  while (g_hash_table_iter_next (&iter, NULL, &entry))
+    stats->n_users += ((ThunarMonitorEntry *) entry)->n_users;
+}
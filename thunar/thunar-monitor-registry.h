@@ -0,0 +1,59 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Xfce development team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __THUNAR_MONITOR_REGISTRY_H__
+#define __THUNAR_MONITOR_REGISTRY_H__
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS;
+
+typedef struct _ThunarMonitorStats ThunarMonitorStats;
+
+/**
+ * ThunarMonitorStats:
+ * @n_locations : number of distinct monitored locations.
+ * @n_watches   : number of local locations using a kernel watch.
+ * @n_polling   : number of local locations demoted to polling.
+ * @n_users     : number of references handed out for all locations.
+ * @n_demotions : number of demotions to polling since startup.
+ * @budget      : the maximum number of kernel watches.
+ **/
+struct _ThunarMonitorStats
+{
+  guint n_locations;
+  guint n_watches;
+  guint n_polling;
+  guint n_users;
+  guint n_demotions;
+  guint budget;
+};
+
+GFileMonitor *thunar_monitor_registry_get           (GFile              *file,
+                                                     GFileMonitorFlags   flags);
+GFileMonitor *thunar_monitor_registry_get_directory (GFile              *file,
+                                                     GFileMonitorFlags   flags);
+void          thunar_monitor_registry_release       (GFileMonitor       *monitor);
+
+void          thunar_monitor_registry_get_stats     (ThunarMonitorStats *stats);
+
+G_END_DECLS;
+
+#endif /* !__THUNAR_MONITOR_REGISTRY_H__ */
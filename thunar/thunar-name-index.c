@@ -0,0 +1,683 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Xfce development team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <thunar/thunar-file-monitor.h>
+#include <thunar/thunar-name-index.h>
+#include <thunar/thunar-private.h>
+
+
+
+/* number of files indexed per idle iteration */
+#define THUNAR_NAME_INDEX_CHUNK_SIZE (1000)
+
+/* packs the three bytes starting at s into a hash table key */
+#define THUNAR_NAME_INDEX_TRIGRAM(s) (GUINT_TO_POINTER ((guint) (guchar) (s)[0]         \
+                                                        | ((guint) (guchar) (s)[1] << 8)  \
+                                                        | ((guint) (guchar) (s)[2] << 16)))
+
+
+
+typedef struct _ThunarNameEntry ThunarNameEntry;
+
+
+
+static void        thunar_name_index_finalize       (GObject           *object);
+static void        thunar_name_index_folder_destroy (ThunarFolder      *folder,
+                                                     ThunarNameIndex   *name_index);
+static void        thunar_name_index_files_added    (ThunarFolder      *folder,
+                                                     GList             *files,
+                                                     ThunarNameIndex   *name_index);
+static void        thunar_name_index_files_removed  (ThunarFolder      *folder,
+                                                     GList             *files,
+                                                     ThunarNameIndex   *name_index);
+static void        thunar_name_index_file_changed   (ThunarFileMonitor *file_monitor,
+                                                     ThunarFile        *file,
+                                                     ThunarNameIndex   *name_index);
+static void        thunar_name_index_add_file       (ThunarNameIndex   *name_index,
+                                                     ThunarFile        *file);
+static void        thunar_name_index_remove_entry   (ThunarNameIndex   *name_index,
+                                                     ThunarNameEntry   *entry);
+static void        thunar_name_index_clear          (ThunarNameIndex   *name_index);
+static ThunarFile *thunar_name_index_pop_pending    (ThunarNameIndex   *name_index);
+static gboolean    thunar_name_index_build_idle     (gpointer          user_data);
+static void        thunar_name_index_build_destroy  (gpointer          user_data);
+
+
+
+struct _ThunarNameIndexClass
+{
+  GObjectClass __parent__;
+};
+
+struct _ThunarNameIndex
+{
+  GObject __parent__;
+
+  ThunarFolder      *folder;
+  ThunarFileMonitor *file_monitor;
+
+  /* all entries, the id of an entry is its position in the
+   * array. Removed entries stay in the array until more than
+   * half of the entries are removed, to keep the ids stable.
+   */
+  GPtrArray         *entries;
+  GHashTable        *file_entries;
+  guint              n_removed;
+
+  /* maps every trigram of the normalized names to the
+   * ascending array of the ids of the entries containing it
+   */
+  GHashTable        *trigrams;
+
+  /* files of the folder that are not indexed yet, the
+   * index is built in chunks from an idle source. The
+   * links of the queue are looked up by file, to drop
+   * removed files without walking the queue */
+  GQueue            *pending;
+  GHashTable        *pending_links;
+  guint              build_idle_id;
+
+  /* normalized version of the last text passed to
+   * thunar_name_index_matches() */
+  gchar             *match_text;
+  gchar             *match_key;
+};
+
+struct _ThunarNameEntry
+{
+  ThunarFile *file;
+  gchar      *name;
+  gchar      *key;
+  guint32     id;
+};
+
+
+
+G_DEFINE_TYPE (ThunarNameIndex, thunar_name_index, G_TYPE_OBJECT)
+
+
+
+static void
+thunar_name_index_class_init (ThunarNameIndexClass *klass)
+{
+  GObjectClass *gobject_class;
+
+  gobject_class = G_OBJECT_CLASS (klass);
+  gobject_class->finalize = thunar_name_index_finalize;
+}
+
+
+
+static void
+thunar_name_index_posting_free (gpointer data)
+{
+  g_array_free (data, TRUE);
+}
+
+
+
+static void
+thunar_name_index_init (ThunarNameIndex *name_index)
+{
+  name_index->entries = g_ptr_array_new ();
+  name_index->file_entries = g_hash_table_new (g_direct_hash, g_direct_equal);
+  name_index->trigrams = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, thunar_name_index_posting_free);
+  name_index->pending = g_queue_new ();
+  name_index->pending_links = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+  /* watch for renamed files */
+  name_index->file_monitor = thunar_file_monitor_get_default ();
+  g_signal_connect (G_OBJECT (name_index->file_monitor), "file-changed",
+                    G_CALLBACK (thunar_name_index_file_changed), name_index);
+}
+
+
+
+static void
+thunar_name_index_finalize (GObject *object)
+{
+  ThunarNameIndex *name_index = THUNAR_NAME_INDEX (object);
+
+  /* disconnect from the folder */
+  thunar_name_index_set_folder (name_index, NULL);
+
+  /* disconnect from the file monitor */
+  g_signal_handlers_disconnect_by_func (G_OBJECT (name_index->file_monitor), thunar_name_index_file_changed, name_index);
+  g_object_unref (G_OBJECT (name_index->file_monitor));
+
+  g_ptr_array_free (name_index->entries, TRUE);
+  g_hash_table_destroy (name_index->file_entries);
+  g_hash_table_destroy (name_index->trigrams);
+  g_queue_free (name_index->pending);
+  g_hash_table_destroy (name_index->pending_links);
+
+  g_free (name_index->match_text);
+  g_free (name_index->match_key);
+
+  (*G_OBJECT_CLASS (thunar_name_index_parent_class)->finalize) (object);
+}
+
+
+
+static gchar*
+thunar_name_index_normalize (const gchar *text)
+{
+  gchar *normalized;
+  gchar *key;
+
+  /* compare names independent of their unicode
+   * representation and case */
+  normalized = g_utf8_normalize (text, -1, G_NORMALIZE_ALL);
+  if (G_UNLIKELY (normalized == NULL))
+    return g_strdup (text);
+
+  key = g_utf8_casefold (normalized, -1);
+  g_free (normalized);
+
+  return key;
+}
+
+
+
+static void
+thunar_name_entry_free (ThunarNameEntry *entry)
+{
+  g_free (entry->name);
+  g_free (entry->key);
+  g_slice_free (ThunarNameEntry, entry);
+}
+
+
+
+static void
+thunar_name_index_folder_destroy (ThunarFolder    *folder,
+                                  ThunarNameIndex *name_index)
+{
+  _thunar_return_if_fail (THUNAR_IS_FOLDER (folder));
+  _thunar_return_if_fail (name_index->folder == folder);
+
+  thunar_name_index_set_folder (name_index, NULL);
+}
+
+
+
+static void
+thunar_name_index_files_added (ThunarFolder    *folder,
+                               GList           *files,
+                               ThunarNameIndex *name_index)
+{
+  GList *lp;
+
+  _thunar_return_if_fail (THUNAR_IS_NAME_INDEX (name_index));
+  _thunar_return_if_fail (name_index->folder == folder);
+
+  /* queue the files, the file references are owned by the folder,
+   * which emits "files-removed" before dropping them */
+  for (lp = files; lp != NULL; lp = lp->next)
+    {
+      if (g_hash_table_lookup (name_index->pending_links, lp->data) != NULL)
+        continue;
+
+      g_queue_push_tail (name_index->pending, lp->data);
+      g_hash_table_insert (name_index->pending_links, lp->data, g_queue_peek_tail_link (name_index->pending));
+    }
+
+  /* index them in the background */
+  if (name_index->build_idle_id == 0 && !g_queue_is_empty (name_index->pending))
+    {
+      name_index->build_idle_id = g_idle_add_full (G_PRIORITY_LOW, thunar_name_index_build_idle,
+                                                   name_index, thunar_name_index_build_destroy);
+    }
+}
+
+
+
+static void
+thunar_name_index_files_removed (ThunarFolder    *folder,
+                                 GList           *files,
+                                 ThunarNameIndex *name_index)
+{
+  ThunarNameEntry *entry;
+  GList           *link;
+  GList           *lp;
+
+  _thunar_return_if_fail (THUNAR_IS_NAME_INDEX (name_index));
+  _thunar_return_if_fail (name_index->folder == folder);
+
+  for (lp = files; lp != NULL; lp = lp->next)
+    {
+      /* files that are still queued are simply not indexed */
+      link = g_hash_table_lookup (name_index->pending_links, lp->data);
+      if (link != NULL)
+        {
+          g_hash_table_remove (name_index->pending_links, lp->data);
+          g_queue_delete_link (name_index->pending, link);
+          continue;
+        }
+
+      entry = g_hash_table_lookup (name_index->file_entries, lp->data);
+      if (G_LIKELY (entry != NULL))
+        thunar_name_index_remove_entry (name_index, entry);
+    }
+}
+
+
+
+static void
+thunar_name_index_file_changed (ThunarFileMonitor *file_monitor,
+                                ThunarFile        *file,
+                                ThunarNameIndex   *name_index)
+{
+  ThunarNameEntry *entry;
+
+  _thunar_return_if_fail (THUNAR_IS_FILE_MONITOR (file_monitor));
+  _thunar_return_if_fail (THUNAR_IS_NAME_INDEX (name_index));
+
+  entry = g_hash_table_lookup (name_index->file_entries, file);
+  if (G_LIKELY (entry == NULL))
+    return;
+
+  /* reindex the file if it was renamed */
+  if (G_UNLIKELY (strcmp (entry->name, thunar_file_get_display_name (file)) != 0))
+    {
+      thunar_name_index_remove_entry (name_index, entry);
+      thunar_name_index_add_file (name_index, file);
+    }
+}
+
+
+
+static void
+thunar_name_index_add_entry (ThunarNameIndex *name_index,
+                             ThunarNameEntry *entry)
+{
+  const gchar *s;
+  GArray      *posting;
+  gpointer     trigram;
+
+  /* add the entry to the posting list of each of its trigrams,
+   * ids are added in ascending order, so a trigram occurring
+   * more than once in the same name is the last item */
+  for (s = entry->key; s[0] != '\0' && s[1] != '\0' && s[2] != '\0'; ++s)
+    {
+      trigram = THUNAR_NAME_INDEX_TRIGRAM (s);
+      posting = g_hash_table_lookup (name_index->trigrams, trigram);
+      if (G_UNLIKELY (posting == NULL))
+        {
+          posting = g_array_new (FALSE, FALSE, sizeof (guint32));
+          g_hash_table_insert (name_index->trigrams, trigram, posting);
+        }
+      else if (g_array_index (posting, guint32, posting->len - 1) == entry->id)
+        {
+          continue;
+        }
+
+      g_array_append_val (posting, entry->id);
+    }
+}
+
+
+
+static void
+thunar_name_index_add_file (ThunarNameIndex *name_index,
+                            ThunarFile      *file)
+{
+  ThunarNameEntry *entry;
+
+  /* skip files we already know about */
+  if (g_hash_table_lookup (name_index->file_entries, file) != NULL)
+    return;
+
+  entry = g_slice_new (ThunarNameEntry);
+  entry->file = file;
+  entry->name = g_strdup (thunar_file_get_display_name (file));
+  entry->key = thunar_name_index_normalize (entry->name);
+  entry->id = name_index->entries->len;
+
+  g_ptr_array_add (name_index->entries, entry);
+  g_hash_table_insert (name_index->file_entries, file, entry);
+
+  thunar_name_index_add_entry (name_index, entry);
+}
+
+
+
+static void
+thunar_name_index_remove_entry (ThunarNameIndex *name_index,
+                                ThunarNameEntry *entry)
+{
+  ThunarNameEntry *live;
+  guint            n;
+  guint            m;
+
+  _thunar_return_if_fail (entry->file != NULL);
+
+  /* mark the entry as removed, the posting lists are not
+   * touched, lookups skip the entry instead */
+  g_hash_table_remove (name_index->file_entries, entry->file);
+  entry->file = NULL;
+  name_index->n_removed += 1;
+
+  /* rebuild the index once most entries are stale */
+  if (G_UNLIKELY (name_index->n_removed > THUNAR_NAME_INDEX_CHUNK_SIZE
+                  && name_index->n_removed > name_index->entries->len / 2))
+    {
+      g_hash_table_remove_all (name_index->trigrams);
+
+      /* move the live entries to the front, keeping their order */
+      for (n = 0, m = 0; n < name_index->entries->len; ++n)
+        {
+          live = g_ptr_array_index (name_index->entries, n);
+          if (live->file == NULL)
+            {
+              thunar_name_entry_free (live);
+            }
+          else
+            {
+              live->id = m;
+              g_ptr_array_index (name_index->entries, m++) = live;
+              thunar_name_index_add_entry (name_index, live);
+            }
+        }
+
+      g_ptr_array_set_size (name_index->entries, m);
+      name_index->n_removed = 0;
+    }
+}
+
+
+
+static void
+thunar_name_index_clear (ThunarNameIndex *name_index)
+{
+  guint n;
+
+  /* stop building the index */
+  if (G_UNLIKELY (name_index->build_idle_id != 0))
+    g_source_remove (name_index->build_idle_id);
+  g_queue_clear (name_index->pending);
+  g_hash_table_remove_all (name_index->pending_links);
+
+  for (n = 0; n < name_index->entries->len; ++n)
+    thunar_name_entry_free (g_ptr_array_index (name_index->entries, n));
+  g_ptr_array_set_size (name_index->entries, 0);
+  g_hash_table_remove_all (name_index->file_entries);
+  g_hash_table_remove_all (name_index->trigrams);
+
+  name_index->n_removed = 0;
+}
+
+
+
+static ThunarFile*
+thunar_name_index_pop_pending (ThunarNameIndex *name_index)
+{
+  ThunarFile *file;
+
+  file = g_queue_pop_head (name_index->pending);
+  g_hash_table_remove (name_index->pending_links, file);
+
+  return file;
+}
+
+
+
+static gboolean
+thunar_name_index_build_idle (gpointer user_data)
+{
+  ThunarNameIndex *name_index = THUNAR_NAME_INDEX (user_data);
+  guint            n;
+
+  /* index the next chunk of queued files */
+  for (n = 0; n < THUNAR_NAME_INDEX_CHUNK_SIZE && !g_queue_is_empty (name_index->pending); ++n)
+    thunar_name_index_add_file (name_index, thunar_name_index_pop_pending (name_index));
+
+  return !g_queue_is_empty (name_index->pending);
+}
+
+
+
+static void
+thunar_name_index_build_destroy (gpointer user_data)
+{
+  THUNAR_NAME_INDEX (user_data)->build_idle_id = 0;
+}
+
+
+
+/**
+ * thunar_name_index_new:
+ *
+ * Allocates a new #ThunarNameIndex, which is not
+ * connected to any folder.
+ *
+ * Return value: the newly allocated #ThunarNameIndex.
+ **/
+ThunarNameIndex*
+thunar_name_index_new (void)
+{
+  return g_object_new (THUNAR_TYPE_NAME_INDEX, NULL);
+}
+
+
+
+/**
+ * thunar_name_index_get_folder:
+ * @name_index : a #ThunarNameIndex.
+ *
+ * Return value: the #ThunarFolder indexed by @name_index or %NULL.
+ **/
+ThunarFolder*
+thunar_name_index_get_folder (ThunarNameIndex *name_index)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_NAME_INDEX (name_index), NULL);
+  return name_index->folder;
+}
+
+
+
+/**
+ * thunar_name_index_set_folder:
+ * @name_index : a #ThunarNameIndex.
+ * @folder     : a #ThunarFolder or %NULL.
+ *
+ * Indexes the display names of the files in @folder. The index
+ * is built in the background and kept up to date whenever files
+ * are added to, removed from or renamed in @folder.
+ **/
+void
+thunar_name_index_set_folder (ThunarNameIndex *name_index,
+                              ThunarFolder    *folder)
+{
+  _thunar_return_if_fail (THUNAR_IS_NAME_INDEX (name_index));
+  _thunar_return_if_fail (folder == NULL || THUNAR_IS_FOLDER (folder));
+
+  if (G_UNLIKELY (name_index->folder == folder))
+    return;
+
+  /* disconnect from the previous folder */
+  if (G_LIKELY (name_index->folder != NULL))
+    {
+      g_signal_handlers_disconnect_matched (G_OBJECT (name_index->folder), G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, name_index);
+      g_object_unref (G_OBJECT (name_index->folder));
+    }
+
+  thunar_name_index_clear (name_index);
+
+  name_index->folder = folder;
+
+  if (G_LIKELY (folder != NULL))
+    {
+      g_object_ref (G_OBJECT (folder));
+
+      /* queue the files the folder already knows about */
+      thunar_name_index_files_added (folder, thunar_folder_get_files (folder), name_index);
+
+      g_signal_connect (G_OBJECT (folder), "destroy", G_CALLBACK (thunar_name_index_folder_destroy), name_index);
+      g_signal_connect (G_OBJECT (folder), "files-added", G_CALLBACK (thunar_name_index_files_added), name_index);
+      g_signal_connect (G_OBJECT (folder), "files-removed", G_CALLBACK (thunar_name_index_files_removed), name_index);
+    }
+}
+
+
+
+/**
+ * thunar_name_index_lookup:
+ * @name_index : a #ThunarNameIndex.
+ * @text       : the text to look for.
+ *
+ * Looks up all files whose display name contains @text, ignoring
+ * case. Only the entries sharing the rarest trigram of @text are
+ * compared, so the lookup does not need to visit every file for
+ * texts of three bytes or more.
+ *
+ * While the index is still being built in the background, %NULL
+ * is returned instead of building the rest of the index at once,
+ * and the files have to be checked with thunar_name_index_matches().
+ *
+ * The caller is responsible to free the returned set using
+ * g_hash_table_destroy(), it does not hold references on the
+ * files.
+ *
+ * Return value: a #GHashTable with the matching #ThunarFile<!---->s
+ *               as keys, or %NULL if the index is not built yet.
+ **/
+GHashTable*
+thunar_name_index_lookup (ThunarNameIndex *name_index,
+                          const gchar     *text)
+{
+  ThunarNameEntry *entry;
+  const gchar     *s;
+  GHashTable      *files;
+  GArray          *posting;
+  GArray          *rarest = NULL;
+  gchar           *key;
+  guint            n;
+
+  _thunar_return_val_if_fail (THUNAR_IS_NAME_INDEX (name_index), NULL);
+  _thunar_return_val_if_fail (text != NULL, NULL);
+
+  /* don't block the user while the index is built */
+  if (!g_queue_is_empty (name_index->pending))
+    return NULL;
+
+  files = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+  key = thunar_name_index_normalize (text);
+
+  if (key[0] == '\0' || key[1] == '\0' || key[2] == '\0')
+    {
+      /* too short for the trigrams, check all entries */
+      for (n = 0; n < name_index->entries->len; ++n)
+        {
+          entry = g_ptr_array_index (name_index->entries, n);
+          if (entry->file != NULL && strstr (entry->key, key) != NULL)
+            g_hash_table_insert (files, entry->file, entry->file);
+        }
+    }
+  else
+    {
+      /* every match contains all trigrams of the key, so only
+       * the entries of the shortest posting list are candidates */
+      for (s = key; s[2] != '\0'; ++s)
+        {
+          posting = g_hash_table_lookup (name_index->trigrams, THUNAR_NAME_INDEX_TRIGRAM (s));
+          if (posting == NULL)
+            {
+              /* no name contains this trigram */
+              rarest = NULL;
+              break;
+            }
+
+          if (rarest == NULL || posting->len < rarest->len)
+            rarest = posting;
+        }
+
+      for (n = 0; rarest != NULL && n < rarest->len; ++n)
+        {
+          entry = g_ptr_array_index (name_index->entries, g_array_index (rarest, guint32, n));
+          if (entry->file != NULL && strstr (entry->key, key) != NULL)
+            g_hash_table_insert (files, entry->file, entry->file);
+        }
+    }
+
+  g_free (key);
+
+  return files;
+}
+
+
+
+/**
+ * thunar_name_index_matches:
+ * @name_index : a #ThunarNameIndex.
+ * @file       : a #ThunarFile in the indexed folder.
+ * @text       : the text to look for.
+ *
+ * Checks whether the display name of @file contains @text, ignoring
+ * case. The normalized forms of @text and the indexed names are
+ * cached, so this is cheap to call for single files as they are
+ * added to the folder.
+ *
+ * Return value: %TRUE if @file matches @text.
+ **/
+gboolean
+thunar_name_index_matches (ThunarNameIndex *name_index,
+                           ThunarFile      *file,
+                           const gchar     *text)
+{
+  ThunarNameEntry *entry;
+  gboolean         matches;
+  gchar           *key;
+
+  _thunar_return_val_if_fail (THUNAR_IS_NAME_INDEX (name_index), FALSE);
+  _thunar_return_val_if_fail (THUNAR_IS_FILE (file), FALSE);
+  _thunar_return_val_if_fail (text != NULL, FALSE);
+
+  /* normalize the text only once per key */
+  if (name_index->match_text == NULL || strcmp (name_index->match_text, text) != 0)
+    {
+      g_free (name_index->match_text);
+      g_free (name_index->match_key);
+      name_index->match_text = g_strdup (text);
+      name_index->match_key = thunar_name_index_normalize (text);
+    }
+
+  /* the entry of a renamed file may not be updated yet, if the
+   * caller saw the "file-changed" signal before the index */
+  entry = g_hash_table_lookup (name_index->file_entries, file);
+  if (G_LIKELY (entry != NULL && strcmp (entry->name, thunar_file_get_display_name (file)) == 0))
+    return (strstr (entry->key, name_index->match_key) != NULL);
+
+  /* the file is not indexed yet */
+  key = thunar_name_index_normalize (thunar_file_get_display_name (file));
+  matches = (strstr (key, name_index->match_key) != NULL);
+  g_free (key);
+
+  return matches;
+}
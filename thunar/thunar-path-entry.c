@@ -38,6 +38,7 @@
 
 #include <gdk/gdkkeysyms.h>
 
+#include <thunar/thunar-completion-index.h>
 #include <thunar/thunar-gobject-extensions.h>
 #include <thunar/thunar-icon-factory.h>
 #include <thunar/thunar-icon-renderer.h>
@@ -57,10 +58,15 @@ enum
 {
   PROP_0,
   PROP_CURRENT_FILE,
+  PROP_RESOLVING,
 };
 
 
 
+typedef struct _ThunarPathEntryLoad ThunarPathEntryLoad;
+
+
+
 static void     thunar_path_entry_editable_init                 (GtkEditableClass     *iface);
 static void     thunar_path_entry_finalize                      (GObject              *object);
 static void     thunar_path_entry_get_property                  (GObject              *object,  
@@ -88,6 +94,20 @@ static void     thunar_path_entry_drag_data_get                 (GtkWidget
                                                                  guint                 timestamp);
 static void     thunar_path_entry_activate                      (GtkEntry             *entry);
 static void     thunar_path_entry_changed                       (GtkEditable          *editable);
+static void     thunar_path_entry_load_cancel                   (ThunarPathEntry      *path_entry);
+static void     thunar_path_entry_load_finish                   (ThunarPathEntry      *path_entry);
+static void     thunar_path_entry_load_unref                    (ThunarPathEntryLoad  *load);
+static void     thunar_path_entry_load_folder_ready             (GFile                *location,
+                                                                 ThunarFile           *file,
+                                                                 GError               *error,
+                                                                 gpointer              user_data);
+static void     thunar_path_entry_load_file_ready               (GFile                *location,
+                                                                 ThunarFile           *file,
+                                                                 GError               *error,
+                                                                 gpointer              user_data);
+static void     thunar_path_entry_set_resolved                  (ThunarPathEntry      *path_entry,
+                                                                 ThunarFile           *current_folder,
+                                                                 ThunarFile           *current_file);
 static void     thunar_path_entry_update_icon                   (ThunarPathEntry      *path_entry);
 static void     thunar_path_entry_do_insert_text                (GtkEditable          *editable,
                                                                  const gchar          *new_text,
@@ -126,19 +146,39 @@ struct _ThunarPathEntry
 {
   GtkEntry __parent__;
 
-  ThunarIconFactory *icon_factory;
-  ThunarFile        *current_folder;
-  ThunarFile        *current_file;
-  GFile             *working_directory;
+  ThunarIconFactory     *icon_factory;
+  ThunarFile            *current_folder;
+  ThunarFile            *current_file;
+  GFile                 *working_directory;
 
-  guint              drag_button;
-  gint               drag_x;
-  gint               drag_y;
+  guint                  drag_button;
+  gint                   drag_x;
+  gint                   drag_y;
+
+  /* pending asynchronous lookup of the entered folder/file */
+  ThunarPathEntryLoad   *load;
 
   /* auto completion support */
-  guint              in_change : 1;
-  guint              has_completion : 1;
-  guint              check_completion_idle_id;
+  ThunarCompletionIndex *completion_index;
+  guint                  in_change : 1;
+  guint                  has_completion : 1;
+  guint                  check_completion_pending : 1;
+  guint                  check_completion_idle_id;
+};
+
+struct _ThunarPathEntryLoad
+{
+  /* %NULL once the load was cancelled */
+  ThunarPathEntry *path_entry;
+  GCancellable    *cancellable;
+
+  GFile           *folder_path;
+  GFile           *file_path;
+  ThunarFile      *folder;
+  ThunarFile      *file;
+
+  /* lookups still running, plus one while they are started */
+  guint            n_pending;
 };
 
 
@@ -194,6 +234,21 @@ thunar_path_entry_class_init (ThunarPathEntryClass *klass)
                                                         THUNAR_TYPE_FILE,
                                                         EXO_PARAM_READWRITE));
 
+  /**
+   * ThunarPathEntry:resolving:
+   *
+   * Whether the entered text is still being looked up. The
+   * current file is resolved right away when it is requested
+   * with thunar_path_entry_get_current_file() in the meantime.
+   **/
+  g_object_class_install_property (gobject_class,
+                                   PROP_RESOLVING,
+                                   g_param_spec_boolean ("resolving",
+                                                         "resolving",
+                                                         "resolving",
+                                                         FALSE,
+                                                         EXO_PARAM_READABLE));
+
   /**
    * ThunarPathEntry:icon-size:
    *
@@ -229,6 +284,9 @@ thunar_path_entry_init (ThunarPathEntry *path_entry)
   path_entry->check_completion_idle_id = 0;
   path_entry->working_directory = NULL;
 
+  /* sorted index of the folder contents for the prefix lookups */
+  path_entry->completion_index = thunar_completion_index_new ();
+
   /* allocate a new entry completion for the given model */
   completion = gtk_entry_completion_new ();
   gtk_entry_completion_set_popup_single_match (completion, FALSE);
@@ -280,6 +338,12 @@ thunar_path_entry_finalize (GObject *object)
   if (path_entry->icon_factory != NULL)
     g_object_unref (path_entry->icon_factory);
 
+  /* abort the pending lookup (if any) */
+  thunar_path_entry_load_cancel (path_entry);
+
+  /* release the completion index */
+  g_object_unref (G_OBJECT (path_entry->completion_index));
+
   /* release the current-folder reference */
   if (G_LIKELY (path_entry->current_folder != NULL))
     g_object_unref (G_OBJECT (path_entry->current_folder));
@@ -315,7 +379,12 @@ thunar_path_entry_get_property (GObject    *object,
   switch (prop_id)
     {
     case PROP_CURRENT_FILE:
-      g_value_set_object (value, thunar_path_entry_get_current_file (path_entry));
+      /* don't block on a pending lookup, it notifies once done */
+      g_value_set_object (value, path_entry->current_file);
+      break;
+
+    case PROP_RESOLVING:
+      g_value_set_boolean (value, path_entry->load != NULL);
       break;
 
     default:
@@ -520,6 +589,9 @@ thunar_path_entry_activate (GtkEntry *entry)
 {
   ThunarPathEntry *path_entry = THUNAR_PATH_ENTRY (entry);
 
+  /* the activate handlers need the file for the text entered right now */
+  thunar_path_entry_load_finish (path_entry);
+
   if (G_LIKELY (path_entry->has_completion))
     {
       /* place cursor at the end of the text if we have completion set */
@@ -535,19 +607,14 @@ thunar_path_entry_activate (GtkEntry *entry)
 static void
 thunar_path_entry_changed (GtkEditable *editable)
 {
-  GtkEntryCompletion *completion;
-  ThunarPathEntry    *path_entry = THUNAR_PATH_ENTRY (editable);
-  ThunarFolder       *folder;
-  GtkTreeModel       *model;
-  const gchar        *text;
-  gchar              *escaped_text;
-  ThunarFile         *current_folder;
-  ThunarFile         *current_file;
-  GFile              *folder_path = NULL;
-  GFile              *file_path = NULL;
-  gchar              *folder_part = NULL;
-  gchar              *file_part = NULL;
-  gboolean            update_icon = FALSE;
+  ThunarPathEntryLoad *load;
+  ThunarPathEntry     *path_entry = THUNAR_PATH_ENTRY (editable);
+  const gchar         *text;
+  gchar               *escaped_text;
+  GFile               *folder_path = NULL;
+  GFile               *file_path = NULL;
+  gchar               *folder_part = NULL;
+  gchar               *file_part = NULL;
 
   /* check if we should ignore this event */
   if (G_UNLIKELY (path_entry->in_change))
@@ -584,9 +651,175 @@ thunar_path_entry_changed (GtkEditable *editable)
       g_free (file_part);
     }
 
-  /* determine new current file/folder from the paths */
-  current_folder = (folder_path != NULL) ? thunar_file_get (folder_path, NULL) : NULL;
-  current_file = (file_path != NULL) ? thunar_file_get (file_path, NULL) : NULL;
+  /* the user kept typing, so any pending lookup is stale now */
+  thunar_path_entry_load_cancel (path_entry);
+
+  /* determine new current file/folder from the paths in the background, so
+   * slow or dead mounts don't block the entry. Files in the cache are
+   * resolved right away.
+   */
+  load = g_slice_new0 (ThunarPathEntryLoad);
+  load->path_entry = path_entry;
+  load->cancellable = g_cancellable_new ();
+  load->folder_path = folder_path;
+  load->file_path = file_path;
+  load->n_pending = 1;
+  path_entry->load = load;
+
+  /* look up the folder and the file in parallel, the file is often the folder itself */
+  if (G_LIKELY (folder_path != NULL))
+    {
+      load->n_pending++;
+      thunar_file_get_async (folder_path, load->cancellable,
+                             thunar_path_entry_load_folder_ready, load);
+    }
+  if (file_path != NULL && (folder_path == NULL || !g_file_equal (file_path, folder_path)))
+    {
+      load->n_pending++;
+      thunar_file_get_async (file_path, load->cancellable,
+                             thunar_path_entry_load_file_ready, load);
+    }
+
+  /* the lookups may have completed from the cache already */
+  if (path_entry->load == load)
+    g_object_notify (G_OBJECT (path_entry), "resolving");
+  thunar_path_entry_load_unref (load);
+}
+
+
+
+static void
+thunar_path_entry_load_cancel (ThunarPathEntry *path_entry)
+{
+  if (G_UNLIKELY (path_entry->load != NULL))
+    {
+      /* detach the load from the entry, it's released once the
+       * cancelled queries returned to thunar_path_entry_load_unref() */
+      path_entry->load->path_entry = NULL;
+      g_cancellable_cancel (path_entry->load->cancellable);
+      path_entry->load = NULL;
+    }
+}
+
+
+
+static void
+thunar_path_entry_load_finish (ThunarPathEntry *path_entry)
+{
+  ThunarPathEntryLoad *load = path_entry->load;
+  ThunarFile          *folder = NULL;
+  ThunarFile          *file = NULL;
+
+  if (G_LIKELY (load == NULL))
+    return;
+
+  /* the result is needed now, so resolve whatever is still missing
+   * synchronously, which is usually served from the file cache */
+  if (load->folder != NULL)
+    folder = g_object_ref (G_OBJECT (load->folder));
+  else if (load->folder_path != NULL)
+    folder = thunar_file_get (load->folder_path, NULL);
+
+  if (load->file != NULL)
+    file = g_object_ref (G_OBJECT (load->file));
+  else if (load->file_path != NULL && load->folder_path != NULL && g_file_equal (load->file_path, load->folder_path))
+    file = (folder != NULL) ? g_object_ref (G_OBJECT (folder)) : NULL;
+  else if (load->file_path != NULL)
+    file = thunar_file_get (load->file_path, NULL);
+
+  /* the running lookups are no longer needed */
+  thunar_path_entry_load_cancel (path_entry);
+
+  thunar_path_entry_set_resolved (path_entry, folder, file);
+  g_object_notify (G_OBJECT (path_entry), "resolving");
+
+  if (G_LIKELY (folder != NULL))
+    g_object_unref (G_OBJECT (folder));
+  if (G_LIKELY (file != NULL))
+    g_object_unref (G_OBJECT (file));
+}
+
+
+
+static void
+thunar_path_entry_load_unref (ThunarPathEntryLoad *load)
+{
+  ThunarPathEntry *path_entry = load->path_entry;
+
+  if (--load->n_pending > 0)
+    return;
+
+  if (G_LIKELY (path_entry != NULL))
+    {
+      /* the file is often the folder itself */
+      if (load->file == NULL && load->folder != NULL && load->file_path != NULL
+          && g_file_equal (load->file_path, load->folder_path))
+        load->file = g_object_ref (G_OBJECT (load->folder));
+
+      /* everything is resolved, apply the result */
+      path_entry->load = NULL;
+      thunar_path_entry_set_resolved (path_entry, load->folder, load->file);
+      g_object_notify (G_OBJECT (path_entry), "resolving");
+    }
+
+  /* release the load */
+  if (G_LIKELY (load->folder != NULL))
+    g_object_unref (G_OBJECT (load->folder));
+  if (G_LIKELY (load->file != NULL))
+    g_object_unref (G_OBJECT (load->file));
+  if (G_LIKELY (load->folder_path != NULL))
+    g_object_unref (load->folder_path);
+  if (G_LIKELY (load->file_path != NULL))
+    g_object_unref (load->file_path);
+  g_object_unref (load->cancellable);
+  g_slice_free (ThunarPathEntryLoad, load);
+}
+
+
+
+static void
+thunar_path_entry_load_folder_ready (GFile      *location,
+                                     ThunarFile *file,
+                                     GError     *error,
+                                     gpointer    user_data)
+{
+  ThunarPathEntryLoad *load = user_data;
+
+  /* remember the folder, unless the lookup failed or was cancelled */
+  if (error == NULL && load->path_entry != NULL)
+    load->folder = g_object_ref (G_OBJECT (file));
+
+  thunar_path_entry_load_unref (load);
+}
+
+
+
+static void
+thunar_path_entry_load_file_ready (GFile      *location,
+                                   ThunarFile *file,
+                                   GError     *error,
+                                   gpointer    user_data)
+{
+  ThunarPathEntryLoad *load = user_data;
+
+  /* remember the file, unless the lookup failed or was cancelled */
+  if (error == NULL && load->path_entry != NULL)
+    load->file = g_object_ref (G_OBJECT (file));
+
+  thunar_path_entry_load_unref (load);
+}
+
+
+
+static void
+thunar_path_entry_set_resolved (ThunarPathEntry *path_entry,
+                                ThunarFile      *current_folder,
+                                ThunarFile      *current_file)
+{
+  GtkEntryCompletion *completion;
+  ThunarFolder       *folder;
+  GtkTreeModel       *model;
+  gboolean            update_icon = FALSE;
 
   /* determine the entry completion */
   completion = gtk_entry_get_completion (GTK_ENTRY (path_entry));
@@ -618,6 +851,9 @@ thunar_path_entry_changed (GtkEditable *editable)
       gtk_entry_completion_set_model (completion, model);
       g_object_unref (G_OBJECT (model));
 
+      /* index the new folder for the prefix lookups */
+      thunar_completion_index_set_folder (path_entry->completion_index, folder);
+
       /* cleanup */
       if (G_LIKELY (folder != NULL))
         g_object_unref (G_OBJECT (folder));
@@ -649,15 +885,12 @@ thunar_path_entry_changed (GtkEditable *editable)
   if (update_icon)
     thunar_path_entry_update_icon (path_entry);
 
-  /* cleanup */
-  if (G_LIKELY (current_folder != NULL))
-    g_object_unref (G_OBJECT (current_folder));
-  if (G_LIKELY (current_file != NULL))
-    g_object_unref (G_OBJECT (current_file));
-  if (G_LIKELY (folder_path != NULL))
-    g_object_unref (folder_path);
-  if (G_LIKELY (file_path != NULL))
-    g_object_unref (file_path);
+  /* run the completion check that was skipped during the lookup */
+  if (G_UNLIKELY (path_entry->check_completion_pending))
+    {
+      path_entry->check_completion_pending = FALSE;
+      thunar_path_entry_queue_check_completion (path_entry);
+    }
 }
 
 
@@ -859,12 +1092,8 @@ thunar_path_entry_common_prefix_lookup (ThunarPathEntry *path_entry,
                                         gchar          **prefix_return,
                                         ThunarFile     **file_return)
 {
-  GtkTreeModel *model;
-  GtkTreeIter   iter;
-  const gchar  *text;
-  const gchar  *s;
-  gchar        *name;
-  gchar        *t;
+  const gchar *text;
+  const gchar *s;
 
   *prefix_return = NULL;
   *file_return = NULL;
@@ -877,48 +1106,8 @@ thunar_path_entry_common_prefix_lookup (ThunarPathEntry *path_entry,
   else if (G_LIKELY (s != NULL))
     text = s + 1;
 
-  /* check all items in the model */
-  model = gtk_entry_completion_get_model (gtk_entry_get_completion (GTK_ENTRY (path_entry)));
-  if (gtk_tree_model_get_iter_first (model, &iter))
-    {
-      do 
-        {
-          /* determine the real file name for the iter */
-          gtk_tree_model_get (model, &iter, THUNAR_COLUMN_FILE_NAME, &name, -1);
-
-          /* check if we have a valid prefix here */
-          if (g_str_has_prefix (name, text))
-            {
-              /* check if we're the first to match */
-              if (*prefix_return == NULL)
-                {
-                  /* remember the prefix */
-                  *prefix_return = g_strdup (name);
-                  
-                  /* determine the file for the iter */
-                  gtk_tree_model_get (model, &iter, THUNAR_COLUMN_FILE, file_return, -1);
-                }
-              else
-                {
-                  /* we already have another prefix, so determine the common part */
-                  for (s = name, t = *prefix_return; *s != '\0' && *s == *t; ++s, ++t)
-                    ;
-                  *t = '\0';
-
-                  /* release the file, since it's not a unique match */
-                  if (G_LIKELY (*file_return != NULL))
-                    {
-                      g_object_unref (G_OBJECT (*file_return));
-                      *file_return = NULL;
-                    }
-                }
-            }
-
-          /* cleanup */
-          g_free (name);
-        }
-      while (gtk_tree_model_iter_next (model, &iter));
-    }
+  /* binary search the sorted folder index */
+  thunar_completion_index_lookup_prefix (path_entry->completion_index, text, prefix_return, file_return);
 }
 
 
@@ -929,61 +1118,24 @@ thunar_path_entry_match_func (GtkEntryCompletion *completion,
                               GtkTreeIter        *iter,
                               gpointer            user_data)
 {
-  GtkTreeModel *model;
-  const gchar  *last_slash;
-  ThunarFile   *file;
-  gboolean      matched;
-  gchar        *text_normalized;
-  gchar        *name_normalized;
-  gchar        *name;
+  ThunarPathEntry *path_entry = THUNAR_PATH_ENTRY (user_data);
+  GtkTreeModel    *model;
+  ThunarFile      *file;
+  gboolean         matched;
 
   /* determine the model from the completion */
   model = gtk_entry_completion_get_model (completion);
 
-  /* leave if the model is null, we do this in thunar_path_entry_changed() to speed
+  /* leave if the model is null, we do this in thunar_path_entry_set_resolved() to speed
    * things up, but that causes http://bugzilla.xfce.org/show_bug.cgi?id=4847. */
   if (G_UNLIKELY (model == NULL))
     return FALSE;
 
-  /* determine the current text (UTF-8 normalized) */
-  text_normalized = g_utf8_normalize (gtk_entry_get_text (GTK_ENTRY (user_data)), -1, G_NORMALIZE_ALL);
-
-  /* lookup the last slash character in the key */
-  last_slash = strrchr (text_normalized, G_DIR_SEPARATOR);
-  if (G_UNLIKELY (last_slash != NULL && last_slash[1] == '\0'))
-    {
-      /* check if the file is hidden */
-      gtk_tree_model_get (model, iter, THUNAR_COLUMN_FILE, &file, -1);
-      matched = !thunar_file_is_hidden (file);
-      g_object_unref (G_OBJECT (file));
-    }
-  else
-    {
-      if (G_UNLIKELY (last_slash == NULL))
-        last_slash = text_normalized;
-      else
-        last_slash += 1;
-
-      /* determine the real file name for the iter */
-      gtk_tree_model_get (model, iter, THUNAR_COLUMN_FILE_NAME, &name, -1);
-      name_normalized = g_utf8_normalize (name, -1, G_NORMALIZE_ALL);
-      if (G_LIKELY (name_normalized != NULL))
-        g_free (name);
-      else
-        name_normalized = name;
-
-      /* check if we have a match here */
-      if (name_normalized != NULL)
-        matched = g_str_has_prefix (name_normalized, last_slash);
-      else
-        matched = FALSE;
-
-      /* cleanup */
-      g_free (name_normalized);
-    }
-
-  /* cleanup */
-  g_free (text_normalized);
+  /* the index caches the normalized key and file names */
+  gtk_tree_model_get (model, iter, THUNAR_COLUMN_FILE, &file, -1);
+  matched = thunar_completion_index_matches (path_entry->completion_index, file,
+                                             gtk_entry_get_text (GTK_ENTRY (path_entry)));
+  g_object_unref (G_OBJECT (file));
 
   return matched;
 }
@@ -1136,7 +1288,12 @@ thunar_path_entry_check_completion_idle (gpointer user_data)
 
   /* check if the user entered at least part of a filename */
   text = gtk_entry_get_text (GTK_ENTRY (path_entry));
-  if (*text != '\0' && text[strlen (text) - 1] != '/')
+  if (G_UNLIKELY (path_entry->load != NULL))
+    {
+      /* the folder index is stale until the lookup finishes */
+      path_entry->check_completion_pending = TRUE;
+    }
+  else if (*text != '\0' && text[strlen (text) - 1] != '/')
     {
       /* automatically insert the common prefix */
       thunar_path_entry_common_prefix_append (path_entry, TRUE);
@@ -1178,7 +1335,8 @@ thunar_path_entry_new (void)
  *
  * Returns the #ThunarFile currently being displayed by
  * @path_entry or %NULL if @path_entry doesn't contain
- * a valid #ThunarFile.
+ * a valid #ThunarFile. If the entered text is still
+ * being looked up, it is resolved synchronously.
  *
  * Return value: the #ThunarFile for @path_entry or %NULL.
  **/
@@ -1186,6 +1344,9 @@ ThunarFile*
 thunar_path_entry_get_current_file (ThunarPathEntry *path_entry)
 {
   _thunar_return_val_if_fail (THUNAR_IS_PATH_ENTRY (path_entry), NULL);
+
+  thunar_path_entry_load_finish (path_entry);
+
   return path_entry->current_file;
 }
 
@@ -80,6 +80,7 @@ enum
   PROP_MISC_FULL_PATH_IN_TITLE,
   PROP_MISC_HORIZONTAL_WHEEL_NAVIGATES,
   PROP_MISC_IMAGE_SIZE_IN_STATUSBAR,
+  PROP_MISC_MAX_FILE_WATCHES,
   PROP_MISC_MIDDLE_CLICK_IN_TAB,
   PROP_MISC_RECURSIVE_PERMISSIONS,
   PROP_MISC_REMEMBER_GEOMETRY,
@@ -90,6 +91,8 @@ enum
   PROP_MISC_TAB_CLOSE_MIDDLE_CLICK,
   PROP_MISC_TEXT_BESIDE_ICONS,
   PROP_MISC_THUMBNAIL_MODE,
+  PROP_MISC_TRANSFER_BANDWIDTH_LIMIT,
+  PROP_MISC_TRANSFER_VERIFY,
   PROP_MISC_FILE_SIZE_BINARY,
   PROP_SHORTCUTS_ICON_EMBLEMS,
   PROP_SHORTCUTS_ICON_SIZE,
@@ -560,6 +563,21 @@ thunar_preferences_class_init (ThunarPreferencesClass *klass)
                             FALSE,
                             EXO_PARAM_READWRITE);
 
+  /**
+   * ThunarPreferences:misc-max-file-watches:
+   *
+   * The maximum number of local files and folders watched with
+   * kernel notifications. Further locations are checked for changes
+   * periodically. A value of %0 picks a limit based on the
+   * inotify watches available to the user.
+   **/
+  preferences_props[PROP_MISC_MAX_FILE_WATCHES] =
+      g_param_spec_uint ("misc-max-file-watches",
+                         NULL,
+                         NULL,
+                         0u, G_MAXUINT, 0u,
+                         EXO_PARAM_READWRITE);
+
   /**
    * ThunarPreferences:misc-middle-click-in-tab:
    *
@@ -693,6 +711,32 @@ thunar_preferences_class_init (ThunarPreferencesClass *klass)
                          THUNAR_THUMBNAIL_MODE_ONLY_LOCAL,
                          EXO_PARAM_READWRITE);
 
+  /**
+   * ThunarPreferences:misc-transfer-bandwidth-limit:
+   *
+   * The maximum rate in KiB per second at which a copy or move
+   * transfers data, or %0 for no limit.
+   **/
+  preferences_props[PROP_MISC_TRANSFER_BANDWIDTH_LIMIT] =
+      g_param_spec_uint ("misc-transfer-bandwidth-limit",
+                         NULL,
+                         NULL,
+                         0u, G_MAXUINT, 0u,
+                         EXO_PARAM_READWRITE);
+
+  /**
+   * ThunarPreferences:misc-transfer-verify:
+   *
+   * Whether copied files are read back and compared with the
+   * originals, writing a checksum manifest of the copy.
+   **/
+  preferences_props[PROP_MISC_TRANSFER_VERIFY] =
+      g_param_spec_boolean ("misc-transfer-verify",
+                            NULL,
+                            NULL,
+                            FALSE,
+                            EXO_PARAM_READWRITE);
+
   /**
    * ThunarPreferences:misc-file-size-binary:
    *
@@ -30,7 +30,6 @@
 #include <thunar/thunar-pango-extensions.h>
 #include <thunar/thunar-private.h>
 #include <thunar/thunar-util.h>
-#include <thunar/thunar-transfer-job.h>
 #include <thunar/thunar-progress-view.h>
 
 
@@ -56,6 +55,8 @@ static void              thunar_progress_view_set_property (GObject            *
                                                             const GValue       *value,
                                                             GParamSpec         *pspec);
 static void              thunar_progress_view_cancel_job   (ThunarProgressView *view);
+static void              thunar_progress_view_toggle_pause (ThunarProgressView *view,
+                                                            GtkToggleButton    *button);
 static ThunarJobResponse thunar_progress_view_ask          (ThunarProgressView *view,
                                                             const gchar        *message,
                                                             ThunarJobResponse   choices,
@@ -225,6 +226,17 @@ thunar_progress_view_init (ThunarProgressView *view)
   gtk_box_pack_start (GTK_BOX (vbox3), view->progress_label, FALSE, TRUE, 0);
   gtk_widget_show (view->progress_label);
 
+  button = gtk_toggle_button_new ();
+  g_signal_connect_swapped (button, "toggled", G_CALLBACK (thunar_progress_view_toggle_pause), view);
+  gtk_widget_set_tooltip_text (button, _("Pause or resume the operation"));
+  gtk_box_pack_start (GTK_BOX (hbox), button, FALSE, TRUE, 0);
+  gtk_widget_set_can_focus (button, FALSE);
+  gtk_widget_show (button);
+
+  image = gtk_image_new_from_stock (GTK_STOCK_MEDIA_PAUSE, GTK_ICON_SIZE_BUTTON);
+  gtk_container_add (GTK_CONTAINER (button), image);
+  gtk_widget_show (image);
+
   button = gtk_button_new ();
   g_signal_connect_swapped (button, "clicked", G_CALLBACK (thunar_progress_view_cancel_job), view);
   gtk_box_pack_start (GTK_BOX (hbox), button, FALSE, TRUE, 0);
@@ -357,6 +369,28 @@ thunar_progress_view_cancel_job (ThunarProgressView *view)
 
 
 
+static void
+thunar_progress_view_toggle_pause (ThunarProgressView *view,
+                                   GtkToggleButton    *button)
+{
+  gboolean paused;
+
+  _thunar_return_if_fail (THUNAR_IS_PROGRESS_VIEW (view));
+  _thunar_return_if_fail (GTK_IS_TOGGLE_BUTTON (button));
+
+  if (view->job != NULL)
+    {
+      paused = gtk_toggle_button_get_active (button);
+      thunar_job_set_paused (view->job, paused);
+
+      /* the job stops reporting progress while it is paused */
+      if (paused)
+        gtk_label_set_text (GTK_LABEL (view->progress_label), _("Paused"));
+    }
+}
+
+
+
 static ThunarJobResponse
 thunar_progress_view_ask (ThunarProgressView *view,
                           const gchar        *message,
@@ -479,9 +513,9 @@ thunar_progress_view_percent (ThunarProgressView *view,
   gtk_progress_bar_set_fraction (GTK_PROGRESS_BAR (view->progress_bar), percent / 100.0);
 
   /* set progress text */
-  if (THUNAR_IS_TRANSFER_JOB (job))
+  text = thunar_job_get_status (THUNAR_JOB (job));
+  if (G_LIKELY (text != NULL))
     {
-      text = thunar_transfer_job_get_status (THUNAR_TRANSFER_JOB (job));
       gtk_label_set_text (GTK_LABEL (view->progress_label), text);
       g_free (text);
     }
@@ -0,0 +1,1050 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Xfce development team
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_SYS_TYPES_H
+#include <sys/types.h>
+#endif
+
+#ifdef HAVE_ERRNO_H
+#include <errno.h>
+#endif
+#ifdef HAVE_SIGNAL_H
+#include <signal.h>
+#endif
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#include <glib/gstdio.h>
+#include <libxfce4util/libxfce4util.h>
+
+#include <thunarx/thunarx.h>
+
+#include <thunar/thunar-marshal.h>
+#include <thunar/thunar-private.h>
+#include <thunar/thunar-rename-job.h>
+#include <thunar/thunar-simple-job.h>
+
+
+
+/* the directory (relative to the user's cache directory) holding the journals */
+#define THUNAR_RENAME_JOB_JOURNAL_DIR "Thunar/renamer/"
+
+/* minimum interval between two "progress" emissions */
+#define THUNAR_RENAME_JOB_PROGRESS_INTERVAL (G_USEC_PER_SEC / 10)
+
+
+
+/* Signal identifiers */
+enum
+{
+  PROGRESS,
+  RENAME_FAILED,
+  LAST_SIGNAL,
+};
+
+
+
+/* States of a pair while the renames are ordered */
+enum
+{
+  NODE_UNVISITED,
+  NODE_VISITING,
+  NODE_PLANNED,
+};
+
+
+
+typedef struct _ThunarRenameJobNode   ThunarRenameJobNode;
+typedef struct _ThunarRenameJobStep   ThunarRenameJobStep;
+typedef struct _ThunarRenameJobRevert ThunarRenameJobRevert;
+
+
+
+static void     thunar_rename_job_finalize (GObject  *object);
+static gboolean thunar_rename_job_execute  (ExoJob   *job,
+                                            GError  **error);
+
+
+
+struct _ThunarRenameJobClass
+{
+  ThunarJobClass __parent__;
+
+  /* signals */
+  void              (*progress)      (ThunarRenameJob  *job,
+                                      guint             n_done,
+                                      guint             n_total);
+  ThunarJobResponse (*rename_failed) (ThunarRenameJob  *job,
+                                      const gchar      *old_name,
+                                      const gchar      *new_name,
+                                      const gchar      *message,
+                                      ThunarJobResponse choices);
+};
+
+struct _ThunarRenameJob
+{
+  ThunarJob __parent__;
+
+  GList    *pairs;
+  GArray   *steps;
+
+  /* the pairs renamed (or reverted) so far */
+  guint     n_done;
+  guint     n_total;
+
+  /* files renamed since the last "progress" emission */
+  GList    *renamed;
+  gint64    last_time;
+
+  /* the undo journal, -1 if not available */
+  gchar    *journal_path;
+  gint      journal_fd;
+};
+
+/* A pair while the renames are ordered, the blocker being
+ * the pair currently occupying the target of this pair.
+ */
+struct _ThunarRenameJobNode
+{
+  ThunarRenamerPair *pair;
+  GFile             *target;
+  gint               blocker;
+  guint              state;
+};
+
+/* A single rename operation of the job. A pair whose target is
+ * occupied by another file of a rename cycle is split into two
+ * steps, the first one moving it away to a temporary name.
+ */
+struct _ThunarRenameJobStep
+{
+  ThunarFile *file;
+  gchar      *old_name;
+  gchar      *new_name;
+
+  /* the locations for the journal, NULL if the file is not moved */
+  GFile      *source;
+  GFile      *target;
+
+  /* index of the other step of a split pair, -1 if none */
+  gint        partner;
+
+  guint       temporary : 1;
+  guint       skipped : 1;
+  guint       done : 1;
+};
+
+/* A completed step of a crashed instance, read back from its
+ * journal. The inode tells whether the file at @target is still
+ * the one that was renamed, 0 if unknown.
+ */
+struct _ThunarRenameJobRevert
+{
+  GFile   *source;
+  GFile   *target;
+  guint64  inode;
+};
+
+
+
+static guint rename_job_signals[LAST_SIGNAL];
+
+/* serializes the recovery at startup and the rename jobs */
+G_LOCK_DEFINE_STATIC (rename_job_recover);
+
+
+
+G_DEFINE_TYPE (ThunarRenameJob, thunar_rename_job, THUNAR_TYPE_JOB)
+
+
+
+static void
+thunar_rename_job_class_init (ThunarRenameJobClass *klass)
+{
+  ExoJobClass  *job_class;
+  GObjectClass *gobject_class;
+
+  gobject_class = G_OBJECT_CLASS (klass);
+  gobject_class->finalize = thunar_rename_job_finalize;
+
+  job_class = EXO_JOB_CLASS (klass);
+  job_class->execute = thunar_rename_job_execute;
+
+  /**
+   * ThunarRenameJob::progress:
+   * @job     : a #ThunarRenameJob.
+   * @n_done  : the number of files renamed so far.
+   * @n_total : the number of files to rename.
+   *
+   * Emitted by the @job, at most ten times per second, to inform
+   * listeners about the progress of the operation. While reverting
+   * previous changes, the counters refer to the files reverted.
+   **/
+  rename_job_signals[PROGRESS] =
+    g_signal_new (I_("progress"),
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_NO_HOOKS,
+                  G_STRUCT_OFFSET (ThunarRenameJobClass, progress),
+                  NULL, NULL,
+                  _thunar_marshal_VOID__UINT_UINT,
+                  G_TYPE_NONE, 2,
+                  G_TYPE_UINT,
+                  G_TYPE_UINT);
+
+  /**
+   * ThunarRenameJob::rename-failed:
+   * @job      : a #ThunarRenameJob.
+   * @old_name : the name of the file that could not be renamed.
+   * @new_name : the name the file should have been renamed to.
+   * @message  : the error message.
+   * @choices  : a combination of #ThunarJobResponse<!---->s.
+   *
+   * Emitted when a file could not be renamed. The handler returns
+   * %THUNAR_JOB_RESPONSE_YES to skip the file, %THUNAR_JOB_RESPONSE_NO
+   * to revert the previous changes or %THUNAR_JOB_RESPONSE_CANCEL to
+   * stop without reverting.
+   *
+   * Return value: the selected choice.
+   **/
+  rename_job_signals[RENAME_FAILED] =
+    g_signal_new (I_("rename-failed"),
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_NO_HOOKS | G_SIGNAL_RUN_LAST,
+                  G_STRUCT_OFFSET (ThunarRenameJobClass, rename_failed),
+                  NULL, NULL,
+                  _thunar_marshal_FLAGS__STRING_STRING_STRING_FLAGS,
+                  THUNAR_TYPE_JOB_RESPONSE, 4,
+                  G_TYPE_STRING,
+                  G_TYPE_STRING,
+                  G_TYPE_STRING,
+                  THUNAR_TYPE_JOB_RESPONSE);
+}
+
+
+
+static void
+thunar_rename_job_init (ThunarRenameJob *job)
+{
+  job->steps = g_array_new (FALSE, TRUE, sizeof (ThunarRenameJobStep));
+  job->journal_fd = -1;
+}
+
+
+
+static void
+thunar_rename_job_finalize (GObject *object)
+{
+  ThunarRenameJob     *job = THUNAR_RENAME_JOB (object);
+  ThunarRenameJobStep *step;
+  guint                n;
+
+  /* release the steps */
+  for (n = 0; n < job->steps->len; ++n)
+    {
+      step = &g_array_index (job->steps, ThunarRenameJobStep, n);
+      g_free (step->old_name);
+      g_free (step->new_name);
+      if (step->source != NULL)
+        g_object_unref (step->source);
+      if (step->target != NULL)
+        g_object_unref (step->target);
+    }
+  g_array_free (job->steps, TRUE);
+
+  /* release the pairs and any pending notifications */
+  thunar_renamer_pair_list_free (job->pairs);
+  g_list_free_full (job->renamed, g_object_unref);
+
+  g_free (job->journal_path);
+
+  (*G_OBJECT_CLASS (thunar_rename_job_parent_class)->finalize) (object);
+}
+
+
+
+static gboolean
+thunar_rename_job_journal_write (ThunarRenameJob *job,
+                                 const gchar     *format,
+                                 ...)
+{
+  va_list  var_args;
+  gssize   n;
+  gsize    length;
+  gchar   *line;
+  gchar   *p;
+
+  if (job->journal_fd < 0)
+    return FALSE;
+
+  va_start (var_args, format);
+  line = g_strdup_vprintf (format, var_args);
+  va_end (var_args);
+
+  /* write the complete line, the journal is only
+   * flushed to disk explicitly after the plan */
+  for (p = line, length = strlen (line); length > 0; p += n, length -= n)
+    {
+      n = write (job->journal_fd, p, length);
+      if (G_UNLIKELY (n < 0))
+        {
+          if (errno == EINTR)
+            {
+              n = 0;
+              continue;
+            }
+
+          /* stop journaling, the renames are still performed */
+          g_warning ("Failed to write rename journal \"%s\": %s", job->journal_path, g_strerror (errno));
+          close (job->journal_fd);
+          job->journal_fd = -1;
+          break;
+        }
+    }
+
+  g_free (line);
+
+  return (job->journal_fd >= 0);
+}
+
+
+
+static void
+thunar_rename_job_journal_sync (ThunarRenameJob *job)
+{
+  if (job->journal_fd >= 0 && fsync (job->journal_fd) < 0)
+    g_warning ("Failed to sync rename journal \"%s\": %s", job->journal_path, g_strerror (errno));
+}
+
+
+
+static void
+thunar_rename_job_journal_open (ThunarRenameJob *job)
+{
+  ThunarRenameJobStep *step;
+  GFileInfo           *info;
+  guint64              inode;
+  gchar               *source_uri;
+  gchar               *target_uri;
+  gchar               *directory;
+  guint                n;
+
+  /* determine the journal directory, creating it if necessary */
+  directory = xfce_resource_save_location (XFCE_RESOURCE_CACHE, THUNAR_RENAME_JOB_JOURNAL_DIR, TRUE);
+  if (G_UNLIKELY (directory == NULL))
+    return;
+
+  /* the journal name contains our pid, so other instances leave it alone */
+  job->journal_path = g_strdup_printf ("%s/journal-%d-XXXXXX", directory, (gint) getpid ());
+  job->journal_fd = g_mkstemp (job->journal_path);
+  g_free (directory);
+
+  if (G_UNLIKELY (job->journal_fd < 0))
+    {
+      g_warning ("Failed to create rename journal \"%s\": %s", job->journal_path, g_strerror (errno));
+      return;
+    }
+
+  /* write the plan, one line per step, in the order of execution */
+  for (n = 0; n < job->steps->len; ++n)
+    {
+      step = &g_array_index (job->steps, ThunarRenameJobStep, n);
+      if (step->source != NULL && step->target != NULL)
+        {
+          /* remember the inode of the file, both steps of a split
+           * pair move the same file, which is still in place */
+          info = g_file_query_info (thunar_file_get_file (step->file), G_FILE_ATTRIBUTE_UNIX_INODE,
+                                    G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, NULL, NULL);
+          inode = (info != NULL) ? g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_UNIX_INODE) : 0;
+          if (info != NULL)
+            g_object_unref (info);
+
+          source_uri = g_file_get_uri (step->source);
+          target_uri = g_file_get_uri (step->target);
+          thunar_rename_job_journal_write (job, "R\t%s\t%s\t%" G_GUINT64_FORMAT "\n",
+                                           source_uri, target_uri, inode);
+          g_free (source_uri);
+          g_free (target_uri);
+        }
+      else
+        {
+          /* desktop files are renamed in place */
+          thunar_rename_job_journal_write (job, "N\n");
+        }
+    }
+
+  /* make sure the plan is on disk before touching any file */
+  thunar_rename_job_journal_sync (job);
+}
+
+
+
+static void
+thunar_rename_job_journal_close (ThunarRenameJob *job)
+{
+  /* the operation is complete, the journal is no longer needed */
+  if (job->journal_fd >= 0)
+    close (job->journal_fd);
+  if (job->journal_path != NULL)
+    g_unlink (job->journal_path);
+
+  job->journal_fd = -1;
+}
+
+
+
+static gboolean
+thunar_rename_job_revert_check (ThunarRenameJobRevert *revert)
+{
+  GFileInfo *info;
+  gboolean   matches;
+
+  /* the file must still have its new name... */
+  info = g_file_query_info (revert->target, G_FILE_ATTRIBUTE_UNIX_INODE,
+                            G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, NULL, NULL);
+  if (info == NULL)
+    return FALSE;
+
+  /* ...and be the file that was renamed */
+  matches = (revert->inode == 0
+             || !g_file_info_has_attribute (info, G_FILE_ATTRIBUTE_UNIX_INODE)
+             || g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_UNIX_INODE) == revert->inode);
+  g_object_unref (info);
+
+  /* and nothing may have taken its old place */
+  return (matches && !g_file_query_exists (revert->source, NULL));
+}
+
+
+
+static void
+thunar_rename_job_revert_free (ThunarRenameJobRevert *revert)
+{
+  g_object_unref (revert->source);
+  g_object_unref (revert->target);
+  g_slice_free (ThunarRenameJobRevert, revert);
+}
+
+
+
+static GList *
+thunar_rename_job_journal_read (const gchar *path)
+{
+  ThunarRenameJobRevert *revert;
+  GPtrArray             *steps;
+  gboolean              *done;
+  GList                 *reverts = NULL;
+  gchar                 *contents;
+  gchar                **fields;
+  gchar                **lines;
+  guint                  index;
+  guint                  n;
+
+  if (!g_file_get_contents (path, &contents, NULL, NULL))
+    return NULL;
+
+  /* collect the planned steps, in the order of execution */
+  lines = g_strsplit (contents, "\n", -1);
+  steps = g_ptr_array_new ();
+  for (n = 0; lines[n] != NULL; ++n)
+    if (lines[n][0] == 'R' || lines[n][0] == 'N')
+      g_ptr_array_add (steps, lines[n]);
+
+  /* replay the done (D) and undone (U) markers */
+  done = g_new0 (gboolean, steps->len);
+  for (n = 0; lines[n] != NULL; ++n)
+    if ((lines[n][0] == 'D' || lines[n][0] == 'U') && lines[n][1] == '\t')
+      {
+        index = strtoul (lines[n] + 2, NULL, 10);
+        if (G_LIKELY (index < steps->len))
+          done[index] = (lines[n][0] == 'D');
+      }
+
+  /* the completed steps, to be undone in reverse order */
+  for (index = 0; index < steps->len; ++index)
+    {
+      fields = g_strsplit (g_ptr_array_index (steps, index), "\t", 4);
+      if (done[index] && g_strv_length (fields) >= 3)
+        {
+          revert = g_slice_new0 (ThunarRenameJobRevert);
+          revert->source = g_file_new_for_uri (fields[1]);
+          revert->target = g_file_new_for_uri (fields[2]);
+          if (fields[3] != NULL)
+            revert->inode = g_ascii_strtoull (fields[3], NULL, 10);
+          reverts = g_list_prepend (reverts, revert);
+        }
+      g_strfreev (fields);
+    }
+
+  g_ptr_array_free (steps, TRUE);
+  g_strfreev (lines);
+  g_free (contents);
+  g_free (done);
+
+  return reverts;
+}
+
+
+
+static GList *
+thunar_rename_job_journal_list (void)
+{
+  const gchar *name;
+  gchar       *directory;
+  GList       *journals = NULL;
+  GDir        *dir;
+  pid_t        pid;
+
+  directory = xfce_resource_save_location (XFCE_RESOURCE_CACHE, THUNAR_RENAME_JOB_JOURNAL_DIR, FALSE);
+  if (G_LIKELY (directory == NULL))
+    return NULL;
+
+  dir = g_dir_open (directory, 0, NULL);
+  if (G_LIKELY (dir != NULL))
+    {
+      while ((name = g_dir_read_name (dir)) != NULL)
+        {
+          if (!g_str_has_prefix (name, "journal-"))
+            continue;
+
+          /* skip journals of running instances (including ourselves) */
+          pid = strtol (name + 8, NULL, 10);
+          if (pid <= 0 || pid == getpid () || kill (pid, 0) == 0 || errno == EPERM)
+            continue;
+
+          /* the instance crashed in the middle of a bulk rename */
+          journals = g_list_prepend (journals, g_build_filename (directory, name, NULL));
+        }
+
+      g_dir_close (dir);
+    }
+
+  g_free (directory);
+
+  return journals;
+}
+
+
+
+static gboolean
+thunar_rename_job_recover_func (ThunarJob  *job,
+                                GArray     *param_values,
+                                GError    **error)
+{
+  GFileCopyFlags         flags = G_FILE_COPY_NOFOLLOW_SYMLINKS | G_FILE_COPY_NO_FALLBACK_FOR_MOVE;
+  ThunarJobResponse      response = THUNAR_JOB_RESPONSE_NO;
+  ThunarRenameJobRevert *revert;
+  GError                *err = NULL;
+  GList                 *journals;
+  GList                 *reverts = NULL;
+  GList                 *lp;
+  gchar                 *display_name;
+  guint                  n_reverts;
+  guint                  n = 0;
+
+  G_LOCK (rename_job_recover);
+
+  /* collect what is left to undo of all crashed bulk renames */
+  journals = thunar_rename_job_journal_list ();
+  for (lp = journals; lp != NULL; lp = lp->next)
+    reverts = g_list_concat (reverts, thunar_rename_job_journal_read (lp->data));
+
+  /* let the user decide, the files might have been used since */
+  n_reverts = g_list_length (reverts);
+  if (n_reverts > 0)
+    {
+      response = thunar_job_ask_restore (job, ngettext ("A bulk rename was interrupted, %u rename can be undone",
+                                                        "A bulk rename was interrupted, %u renames can be undone",
+                                                        n_reverts), n_reverts);
+    }
+
+  if (response == THUNAR_JOB_RESPONSE_YES)
+    {
+      for (lp = reverts; lp != NULL && !exo_job_is_cancelled (EXO_JOB (job)); lp = lp->next, ++n)
+        {
+          revert = lp->data;
+
+          /* show the file in the progress dialog */
+          display_name = g_file_get_parse_name (revert->target);
+          exo_job_info_message (EXO_JOB (job), _("Restoring the old name of \"%s\""), display_name);
+          exo_job_percent (EXO_JOB (job), (n * 100.0) / n_reverts);
+
+          /* skip files renamed or replaced since the crash, the check
+           * is done here, an earlier revert may free the old name */
+          if (thunar_rename_job_revert_check (revert)
+              && !g_file_move (revert->target, revert->source, flags, NULL, NULL, NULL, &err))
+            {
+              g_warning ("Failed to revert \"%s\": %s", display_name, err->message);
+              g_clear_error (&err);
+            }
+
+          g_free (display_name);
+        }
+    }
+
+  /* keep the journals if the user cancelled, to ask again next time */
+  if (!exo_job_is_cancelled (EXO_JOB (job)))
+    for (lp = journals; lp != NULL; lp = lp->next)
+      g_unlink (lp->data);
+
+  G_UNLOCK (rename_job_recover);
+
+  g_list_free_full (reverts, (GDestroyNotify) thunar_rename_job_revert_free);
+  g_list_free_full (journals, g_free);
+
+  return !exo_job_set_error_if_cancelled (EXO_JOB (job), error);
+}
+
+
+
+static void
+thunar_rename_job_add_step (ThunarRenameJob *job,
+                            ThunarFile      *file,
+                            const gchar     *old_name,
+                            const gchar     *new_name,
+                            GFile           *source,
+                            GFile           *target,
+                            gboolean         temporary)
+{
+  ThunarRenameJobStep step = { NULL, };
+
+  step.file = file;
+  step.old_name = g_strdup (old_name);
+  step.new_name = g_strdup (new_name);
+  step.partner = -1;
+  step.temporary = temporary;
+
+  /* the journal can only revert moved files */
+  if (source != NULL && target != NULL)
+    {
+      step.source = g_object_ref (G_OBJECT (source));
+      step.target = g_object_ref (G_OBJECT (target));
+    }
+
+  g_array_append_val (job->steps, step);
+}
+
+
+
+static void
+thunar_rename_job_plan (ThunarRenameJob *job)
+{
+  ThunarRenameJobNode *nodes;
+  ThunarRenameJobStep *step;
+  GHashTable          *sources;
+  gboolean             is_secure;
+  GArray              *path;
+  GFile               *parent;
+  GFile               *source;
+  GFile               *temp = NULL;
+  GList               *lp;
+  gchar               *temp_name = NULL;
+  guint                n_nodes;
+  guint                first = 0;
+  guint                k;
+  guint                i;
+  gint                 n;
+  gint                 m;
+
+  n_nodes = g_list_length (job->pairs);
+  nodes = g_new0 (ThunarRenameJobNode, n_nodes);
+  sources = g_hash_table_new (g_file_hash, (GEqualFunc) g_file_equal);
+
+  /* determine the location every file will be moved to */
+  for (lp = job->pairs, n = 0; lp != NULL; lp = lp->next, ++n)
+    {
+      nodes[n].pair = lp->data;
+      nodes[n].blocker = -1;
+
+      /* desktop files only change their name key, they stay where they are */
+      if (thunar_file_is_desktop_file (nodes[n].pair->file, &is_secure) && is_secure)
+        continue;
+
+      source = thunar_file_get_file (nodes[n].pair->file);
+      parent = g_file_get_parent (source);
+      if (G_LIKELY (parent != NULL))
+        {
+          nodes[n].target = g_file_get_child_for_display_name (parent, nodes[n].pair->name, NULL);
+          g_object_unref (parent);
+        }
+
+      g_hash_table_insert (sources, source, GINT_TO_POINTER (n + 1));
+    }
+
+  /* find the pair (if any) currently occupying the target of each pair */
+  for (n = 0; n < (gint) n_nodes; ++n)
+    if (nodes[n].target != NULL)
+      {
+        m = GPOINTER_TO_INT (g_hash_table_lookup (sources, nodes[n].target)) - 1;
+        if (m != n)
+          nodes[n].blocker = m;
+      }
+
+  path = g_array_new (FALSE, FALSE, sizeof (gint));
+  for (n = 0; n < (gint) n_nodes; ++n)
+    {
+      /* follow the chain of pairs waiting for each other */
+      g_array_set_size (path, 0);
+      for (m = n; m >= 0 && nodes[m].state == NODE_UNVISITED; m = nodes[m].blocker)
+        {
+          nodes[m].state = NODE_VISITING;
+          g_array_append_val (path, m);
+        }
+
+      /* a chain leading back into itself is a cycle (a->b, b->a), which
+       * is broken by moving the pair it was entered at to a temporary name */
+      k = path->len;
+      if (m >= 0 && nodes[m].state == NODE_VISITING)
+        {
+          for (k = 0; g_array_index (path, gint, k) != m; ++k)
+            ;
+
+          parent = g_file_get_parent (nodes[m].target);
+          temp_name = g_strdup_printf (".thunar-rename-%08x", g_random_int ());
+          temp = g_file_get_child (parent, temp_name);
+          g_object_unref (parent);
+
+          first = job->steps->len;
+          thunar_rename_job_add_step (job, nodes[m].pair->file,
+                                      thunar_file_get_display_name (nodes[m].pair->file), temp_name,
+                                      thunar_file_get_file (nodes[m].pair->file), temp, TRUE);
+        }
+
+      /* rename the chain from its end, every pair freeing the target of the previous one */
+      for (i = path->len; i-- > 0; )
+        {
+          m = g_array_index (path, gint, i);
+          if (G_UNLIKELY (i == k))
+            {
+              /* move the cycle's first pair from the temporary name to its target */
+              thunar_rename_job_add_step (job, nodes[m].pair->file, temp_name, nodes[m].pair->name,
+                                          temp, nodes[m].target, FALSE);
+
+              /* link the two steps of the pair */
+              step = &g_array_index (job->steps, ThunarRenameJobStep, first);
+              step->partner = job->steps->len - 1;
+              step = &g_array_index (job->steps, ThunarRenameJobStep, job->steps->len - 1);
+              step->partner = first;
+
+              g_object_unref (temp);
+              g_free (temp_name);
+            }
+          else
+            {
+              thunar_rename_job_add_step (job, nodes[m].pair->file,
+                                          thunar_file_get_display_name (nodes[m].pair->file), nodes[m].pair->name,
+                                          thunar_file_get_file (nodes[m].pair->file), nodes[m].target, FALSE);
+            }
+
+          nodes[m].state = NODE_PLANNED;
+        }
+    }
+  g_array_free (path, TRUE);
+
+  /* cleanup */
+  for (n = 0; n < (gint) n_nodes; ++n)
+    if (nodes[n].target != NULL)
+      g_object_unref (nodes[n].target);
+  g_hash_table_destroy (sources);
+  g_free (nodes);
+}
+
+
+
+static gboolean
+thunar_rename_job_progress_idle (gpointer user_data)
+{
+  ThunarRenameJob *job = THUNAR_RENAME_JOB (user_data);
+  GList           *lp;
+
+  /* tell the associated folders that the files were renamed */
+  for (lp = job->renamed; lp != NULL; lp = lp->next)
+    {
+      thunarx_file_info_renamed (THUNARX_FILE_INFO (lp->data));
+      thunar_file_changed (lp->data);
+    }
+
+  g_list_free_full (job->renamed, g_object_unref);
+  job->renamed = NULL;
+
+  g_signal_emit (job, rename_job_signals[PROGRESS], 0, job->n_done, job->n_total);
+
+  return FALSE;
+}
+
+
+
+static void
+thunar_rename_job_progress (ThunarRenameJob *job,
+                            gboolean         force)
+{
+  gint64 real_time;
+
+  /* don't flood the main loop with notifications */
+  real_time = g_get_real_time ();
+  if (!force && real_time < job->last_time)
+    return;
+  job->last_time = real_time + THUNAR_RENAME_JOB_PROGRESS_INTERVAL;
+
+  /* blocks until the main loop has handled the renamed files */
+  exo_job_send_to_mainloop (EXO_JOB (job), thunar_rename_job_progress_idle,
+                            g_object_ref (job), g_object_unref);
+}
+
+
+
+static ThunarJobResponse
+thunar_rename_job_rename (ThunarRenameJob *job,
+                          guint            index,
+                          gboolean         revert)
+{
+  ThunarRenameJobStep *step;
+  ThunarJobResponse    response = 0;
+  ThunarJobResponse    choices;
+  const gchar         *old_name;
+  const gchar         *new_name;
+  GError              *error = NULL;
+
+  step = &g_array_index (job->steps, ThunarRenameJobStep, index);
+  old_name = revert ? step->new_name : step->old_name;
+  new_name = revert ? step->old_name : step->new_name;
+
+  /* try to rename the file */
+  if (thunar_file_rename (step->file, new_name, exo_job_get_cancellable (EXO_JOB (job)), TRUE, &error))
+    {
+      step->done = !revert;
+      thunar_rename_job_journal_write (job, "%c\t%u\n", revert ? 'U' : 'D', index);
+
+      /* a lost done marker would leave the file renamed after a crash,
+       * a lost undone marker is harmless, the file is no longer there */
+      if (!revert)
+        thunar_rename_job_journal_sync (job);
+
+      /* temporary names are not announced */
+      if (!step->temporary)
+        {
+          job->renamed = g_list_prepend (job->renamed, g_object_ref (G_OBJECT (step->file)));
+          job->n_done++;
+        }
+
+      thunar_rename_job_progress (job, FALSE);
+      return THUNAR_JOB_RESPONSE_YES;
+    }
+
+  /* don't ask if the user cancelled the job */
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    {
+      g_error_free (error);
+      return THUNAR_JOB_RESPONSE_CANCEL;
+    }
+
+  /* determine the possible choices */
+  if (!revert && job->n_done > 0)
+    choices = THUNAR_JOB_RESPONSE_YES | THUNAR_JOB_RESPONSE_NO | THUNAR_JOB_RESPONSE_CANCEL;
+  else if (job->n_done + 1 < job->n_total)
+    choices = THUNAR_JOB_RESPONSE_YES | THUNAR_JOB_RESPONSE_CANCEL;
+  else
+    choices = THUNAR_JOB_RESPONSE_CANCEL;
+
+  /* make sure the user sees the current state before asking */
+  thunar_rename_job_progress (job, TRUE);
+
+  exo_job_emit (EXO_JOB (job), rename_job_signals[RENAME_FAILED], 0,
+                old_name, new_name, error->message, choices, &response);
+  g_error_free (error);
+
+  /* anything not offered cancels the job */
+  if ((response & choices) == 0)
+    response = THUNAR_JOB_RESPONSE_CANCEL;
+
+  if (response == THUNAR_JOB_RESPONSE_YES)
+    {
+      /* the pair is skipped as a whole */
+      job->n_total--;
+      if (!revert && step->temporary)
+        g_array_index (job->steps, ThunarRenameJobStep, step->partner).skipped = TRUE;
+    }
+
+  return response;
+}
+
+
+
+static void
+thunar_rename_job_restore_temporary (ThunarRenameJob *job)
+{
+  ThunarRenameJobStep *partner;
+  ThunarRenameJobStep *step;
+  guint                n;
+
+  /* move files whose final rename never happened back to their
+   * old name, as long as no other file took that name meanwhile */
+  for (n = 0; n < job->steps->len; ++n)
+    {
+      step = &g_array_index (job->steps, ThunarRenameJobStep, n);
+      if (!step->temporary || !step->done)
+        continue;
+
+      partner = &g_array_index (job->steps, ThunarRenameJobStep, step->partner);
+      if (!partner->done && thunar_file_rename (step->file, step->old_name, NULL, TRUE, NULL))
+        {
+          step->done = FALSE;
+          thunar_rename_job_journal_write (job, "U\t%u\n", n);
+          job->renamed = g_list_prepend (job->renamed, g_object_ref (G_OBJECT (step->file)));
+        }
+    }
+}
+
+
+
+static void
+thunar_rename_job_revert (ThunarRenameJob *job)
+{
+  ThunarJobResponse response = THUNAR_JOB_RESPONSE_YES;
+  guint             n;
+
+  /* the counters now refer to the files to revert */
+  job->n_total = job->n_done;
+  job->n_done = 0;
+
+  /* undo the completed steps in reverse order */
+  for (n = job->steps->len; n > 0 && response == THUNAR_JOB_RESPONSE_YES; --n)
+    {
+      if (exo_job_is_cancelled (EXO_JOB (job)))
+        break;
+
+      if (g_array_index (job->steps, ThunarRenameJobStep, n - 1).done)
+        response = thunar_rename_job_rename (job, n - 1, TRUE);
+    }
+}
+
+
+
+static gboolean
+thunar_rename_job_execute (ExoJob  *job,
+                           GError **error)
+{
+  ThunarRenameJob   *rename_job = THUNAR_RENAME_JOB (job);
+  ThunarJobResponse  response = THUNAR_JOB_RESPONSE_YES;
+  guint              n;
+
+  _thunar_return_val_if_fail (THUNAR_IS_RENAME_JOB (job), FALSE);
+  _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  if (exo_job_set_error_if_cancelled (job, error))
+    return FALSE;
+
+  /* wait until the user decided about bulk renames interrupted
+   * by a crash, the recovery job is launched at startup */
+  G_LOCK (rename_job_recover);
+  G_UNLOCK (rename_job_recover);
+
+  /* order the renames and journal them before touching any file */
+  thunar_rename_job_plan (rename_job);
+  thunar_rename_job_journal_open (rename_job);
+
+  rename_job->n_total = g_list_length (rename_job->pairs);
+
+  for (n = 0; n < rename_job->steps->len && response == THUNAR_JOB_RESPONSE_YES; ++n)
+    {
+      if (exo_job_is_cancelled (job))
+        break;
+
+      if (!g_array_index (rename_job->steps, ThunarRenameJobStep, n).skipped)
+        response = thunar_rename_job_rename (rename_job, n, FALSE);
+    }
+
+  if (response == THUNAR_JOB_RESPONSE_NO)
+    thunar_rename_job_revert (rename_job);
+
+  /* never leave files behind under a temporary name */
+  thunar_rename_job_restore_temporary (rename_job);
+
+  /* announce the last changes, the journal is no longer needed */
+  thunar_rename_job_progress (rename_job, TRUE);
+  thunar_rename_job_journal_close (rename_job);
+
+  return !exo_job_set_error_if_cancelled (job, error);
+}
+
+
+
+/**
+ * thunar_rename_job_new:
+ * @pairs : a #GList of #ThunarRenamerPair<!---->s.
+ *
+ * Allocates a new #ThunarJob, which renames all files in
+ * @pairs when launched. Renames whose target is occupied by
+ * another file in @pairs are ordered so that the other file
+ * is renamed first, moving cycles out of the way through a
+ * temporary name.
+ *
+ * Return value: the newly allocated #ThunarRenameJob.
+ **/
+ThunarJob *
+thunar_rename_job_new (GList *pairs)
+{
+  ThunarRenameJob *job;
+
+  job = g_object_new (THUNAR_TYPE_RENAME_JOB, NULL);
+  job->pairs = thunar_renamer_pair_list_copy (pairs);
+
+  return THUNAR_JOB (job);
+}
+
+
+
+/**
+ * thunar_rename_job_recover:
+ *
+ * Launches a #ThunarJob, which asks the user whether to roll back
+ * the bulk renames of Thunar instances that crashed in the middle
+ * of renaming, using the journals they left behind. Files renamed
+ * or replaced since are left alone. Called once at startup, rename
+ * jobs launched in the meantime wait for it to finish.
+ *
+ * The caller is responsible to release the returned object using
+ * g_object_unref() when no longer needed.
+ *
+ * Return value: the launched #ThunarJob or %NULL if there are no
+ *               journals to recover.
+ **/
+ThunarJob *
+thunar_rename_job_recover (void)
+{
+  GList *journals;
+
+  /* usually there is nothing to recover */
+  journals = thunar_rename_job_journal_list ();
+  if (G_LIKELY (journals == NULL))
+    return NULL;
+  g_list_free_full (journals, g_free);
+
+  return thunar_simple_job_launch (thunar_rename_job_recover_func, 0);
+}
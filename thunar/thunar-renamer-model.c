@@ -39,6 +39,10 @@
 
 #define THUNAR_RENAMER_MODEL_ITEM(item) ((ThunarRenamerModelItem *) (item))
 
+/* time in microseconds the update idle source may spend
+ * per iteration, before returning to the main loop */
+#define THUNAR_RENAMER_MODEL_UPDATE_TIME (20 * 1000)
+
 
 
 /* Property identifiers */
@@ -112,8 +116,15 @@ static void                    thunar_renamer_model_file_destroyed      (ThunarR
 static void                    thunar_renamer_model_invalidate_all      (ThunarRenamerModel      *renamer_model);
 static void                    thunar_renamer_model_invalidate_item     (ThunarRenamerModel      *renamer_model,
                                                                          ThunarRenamerModelItem  *item);
-static gboolean                thunar_renamer_model_conflict_item       (ThunarRenamerModel      *renamer_model,
+static void                    thunar_renamer_model_item_changed        (ThunarRenamerModel      *renamer_model,
+                                                                         ThunarRenamerModelItem  *item);
+static void                    thunar_renamer_model_target_add          (ThunarRenamerModel      *renamer_model,
+                                                                         ThunarRenamerModelItem  *item,
+                                                                         const gchar             *target);
+static void                    thunar_renamer_model_target_remove       (ThunarRenamerModel      *renamer_model,
                                                                          ThunarRenamerModelItem  *item);
+static void                    thunar_renamer_model_unlink_item         (ThunarRenamerModel      *renamer_model,
+                                                                         GList                   *lp);
 static gchar                  *thunar_renamer_model_process_item        (ThunarRenamerModel      *renamer_model,
                                                                          ThunarRenamerModelItem  *item,
                                                                          guint                    idx);
@@ -154,6 +165,23 @@ struct _ThunarRenamerModel
   ThunarFileMonitor *file_monitor;
   ThunarxRenamer    *renamer;
   GList             *items;
+  GList             *items_tail;
+  gint               n_items;
+
+  /* lookup table from a ThunarFile to its link in the items */
+  GHashTable        *file_items;
+
+  /* the target names of the items per parent directory, which
+   * maps a GFile to a table from the name to the GPtrArray of the
+   * items with that target name, used to detect conflicts.
+   */
+  GHashTable        *targets;
+
+  /* number of items waiting for a "row-changed" */
+  guint              n_changed;
+
+  /* TRUE if items were added since the renamer was last prepared */
+  gboolean           prepare;
 
   /* TRUE if the model is currently frozen */
   gboolean           frozen;
@@ -164,12 +192,16 @@ struct _ThunarRenamerModel
 
 struct _ThunarRenamerModelItem
 {
-  ThunarFile *file;
-  gchar      *name;
-  guint64     date_changed;
-  guint       changed : 1;  /* if the file changed */
-  guint       conflict : 1; /* if the item conflicts with another item */
-  guint       dirty : 1;    /* if the item must be updated */
+  ThunarFile  *file;
+  GFile       *parent;
+  gchar       *name;
+  const gchar *target;          /* key in the targets table or NULL */
+  guint64      date_changed;
+  guint        changed : 1;     /* if the file changed */
+  guint        conflict : 1;    /* if the item conflicts with another item */
+  guint        dirty : 1;       /* if the item must be updated */
+  guint        row_changed : 1; /* if "row-changed" must be emitted */
+  guint        prepared : 1;    /* if the renamer knows about the file */
 };
 
 
@@ -276,6 +308,10 @@ thunar_renamer_model_init (ThunarRenamerModel *renamer_model)
   renamer_model->stamp = g_random_int ();
 #endif
 
+  renamer_model->file_items = g_hash_table_new (g_direct_hash, g_direct_equal);
+  renamer_model->targets = g_hash_table_new_full (g_file_hash, (GEqualFunc) g_file_equal,
+                                                  g_object_unref, (GDestroyNotify) g_hash_table_destroy);
+
   /* connect to the file monitor */
   renamer_model->file_monitor = thunar_file_monitor_get_default ();
   g_signal_connect_swapped (G_OBJECT (renamer_model->file_monitor), "file-changed",
@@ -295,6 +331,8 @@ thunar_renamer_model_finalize (GObject *object)
   thunar_renamer_model_set_renamer (renamer_model, NULL);
 
   /* release all items */
+  g_hash_table_destroy (renamer_model->targets);
+  g_hash_table_destroy (renamer_model->file_items);
   g_list_free_full (renamer_model->items, thunar_renamer_model_item_free);
 
   /* disconnect from the file monitor */
@@ -562,7 +600,7 @@ static gint
 thunar_renamer_model_iter_n_children (GtkTreeModel *tree_model,
                                       GtkTreeIter  *iter)
 {
-  return (iter == NULL) ? g_list_length (THUNAR_RENAMER_MODEL (tree_model)->items) : 0;
+  return (iter == NULL) ? THUNAR_RENAMER_MODEL (tree_model)->n_items : 0;
 }
 
 
@@ -615,41 +653,40 @@ thunar_renamer_model_file_changed (ThunarRenamerModel *renamer_model,
   _thunar_return_if_fail (renamer_model->file_monitor == file_monitor);
 
   /* check if we have that file */
-  for (lp = renamer_model->items; lp != NULL; lp = lp->next)
-    if (THUNAR_RENAMER_MODEL_ITEM (lp->data)->file == file)
-      {
-        item = THUNAR_RENAMER_MODEL_ITEM (lp->data);
-
-        /* check if the file changed on disk, this is done to prevent
-         * excessive looping when some renamers are used
-         * (thunar-media-tags-plugin is an example) */
-        date_changed = thunar_file_get_date (file, THUNAR_FILE_DATE_CHANGED);
-        if (item->date_changed == date_changed)
-          break;
+  lp = g_hash_table_lookup (renamer_model->file_items, file);
+  if (G_LIKELY (lp == NULL))
+    return;
+
+  item = THUNAR_RENAMER_MODEL_ITEM (lp->data);
 
-        /* check if we're frozen */
-        if (G_LIKELY (!renamer_model->frozen))
-          {
-            /* the file changed */
-            item->changed = TRUE;
+  /* check if the file changed on disk, this is done to prevent
+   * excessive looping when some renamers are used
+   * (thunar-media-tags-plugin is an example) */
+  date_changed = thunar_file_get_date (file, THUNAR_FILE_DATE_CHANGED);
+  if (item->date_changed == date_changed)
+    return;
 
-            /* set the new mtime */
-            item->date_changed = date_changed;
+  /* check if we're frozen */
+  if (G_LIKELY (!renamer_model->frozen))
+    {
+      /* the file changed */
+      item->changed = TRUE;
 
-            /* invalidate the item */
-            thunar_renamer_model_invalidate_item (renamer_model, item);
-            break;
-          }
+      /* set the new mtime */
+      item->date_changed = date_changed;
 
-        /* determine the iter for the item */
-        GTK_TREE_ITER_INIT (iter, renamer_model->stamp, lp);
+      /* invalidate the item */
+      thunar_renamer_model_invalidate_item (renamer_model, item);
+      return;
+    }
+
+  /* determine the iter for the item */
+  GTK_TREE_ITER_INIT (iter, renamer_model->stamp, lp);
 
-        /* emit "row-changed" to display up2date file name */
-        path = gtk_tree_model_get_path (GTK_TREE_MODEL (renamer_model), &iter);
-        gtk_tree_model_row_changed (GTK_TREE_MODEL (renamer_model), path, &iter);
-        gtk_tree_path_free (path);
-        break;
-      }
+  /* emit "row-changed" to display up2date file name */
+  path = gtk_tree_model_get_path (GTK_TREE_MODEL (renamer_model), &iter);
+  gtk_tree_model_row_changed (GTK_TREE_MODEL (renamer_model), path, &iter);
+  gtk_tree_path_free (path);
 }
 
 
@@ -669,27 +706,23 @@ thunar_renamer_model_file_destroyed (ThunarRenamerModel *renamer_model,
   _thunar_return_if_fail (THUNAR_IS_FILE (file));
 
   /* check if we have that file */
-  for (lp = renamer_model->items; lp != NULL; lp = lp->next)
-    if (THUNAR_RENAMER_MODEL_ITEM (lp->data)->file == file)
-      {
-        /* determine the idx of the item */
-        idx = g_list_position (renamer_model->items, lp);
-
-        /* free the item data */
-        thunar_renamer_model_item_free (lp->data);
-
-        /* drop the item from the list */
-        renamer_model->items = g_list_delete_link (renamer_model->items, lp);
-
-        /* tell the view that the item is gone */
-        path = gtk_tree_path_new_from_indices (idx, -1);
-        gtk_tree_model_row_deleted (GTK_TREE_MODEL (renamer_model), path);
-        gtk_tree_path_free (path);
-
-        /* invalidate all other items */
-        thunar_renamer_model_invalidate_all (renamer_model);
-        break;
-      }
+  lp = g_hash_table_lookup (renamer_model->file_items, file);
+  if (G_LIKELY (lp == NULL))
+    return;
+
+  /* determine the idx of the item */
+  idx = g_list_position (renamer_model->items, lp);
+
+  /* drop the item from the list */
+  thunar_renamer_model_unlink_item (renamer_model, lp);
+
+  /* tell the view that the item is gone */
+  path = gtk_tree_path_new_from_indices (idx, -1);
+  gtk_tree_model_row_deleted (GTK_TREE_MODEL (renamer_model), path);
+  gtk_tree_path_free (path);
+
+  /* invalidate all other items */
+  thunar_renamer_model_invalidate_all (renamer_model);
 }
 
 
@@ -727,75 +760,126 @@ thunar_renamer_model_invalidate_item (ThunarRenamerModel     *renamer_model,
 
 
 
-static gboolean
-trm_same_directory (ThunarFile *a,
-                    ThunarFile *b)
+static void
+thunar_renamer_model_item_changed (ThunarRenamerModel     *renamer_model,
+                                   ThunarRenamerModelItem *item)
 {
-  GFile    *parent_a;
-  GFile    *parent_b;
-  gboolean  result;
+  /* "row-changed" is emitted for all marked items at
+   * once, by the next iteration of the update idle */
+  if (!item->row_changed)
+    {
+      item->row_changed = TRUE;
+      renamer_model->n_changed += 1;
+    }
+}
 
-  /* determine the parent paths for both files */
-  parent_a = g_file_get_parent (thunar_file_get_file (a));
-  parent_b = g_file_get_parent (thunar_file_get_file (b));
 
-  /* check if both files have the same parent */
-  result = (parent_a != NULL && parent_b != NULL && g_file_equal (parent_a, parent_b));
 
-  if (parent_a != NULL)
-    g_object_unref (parent_a);
-  if (parent_b != NULL)
-    g_object_unref (parent_b);
+static void
+thunar_renamer_model_target_add (ThunarRenamerModel     *renamer_model,
+                                 ThunarRenamerModelItem *item,
+                                 const gchar            *target)
+{
+  ThunarRenamerModelItem *oitem;
+  GHashTable             *names;
+  GPtrArray              *items;
+  gpointer                key;
 
-  return result;
+  _thunar_return_if_fail (item->target == NULL);
+
+  /* items in the root directory can't conflict */
+  if (G_UNLIKELY (item->parent == NULL))
+    return;
+
+  /* lookup the names in the parent directory */
+  names = g_hash_table_lookup (renamer_model->targets, item->parent);
+  if (G_UNLIKELY (names == NULL))
+    {
+      names = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_ptr_array_unref);
+      g_hash_table_insert (renamer_model->targets, g_object_ref (G_OBJECT (item->parent)), names);
+    }
+
+  /* lookup the items with the same target name */
+  if (!g_hash_table_lookup_extended (names, target, &key, (gpointer *) &items))
+    {
+      key = g_strdup (target);
+      items = g_ptr_array_new ();
+      g_hash_table_insert (names, key, items);
+    }
+
+  g_ptr_array_add (items, item);
+  item->target = key;
+
+  /* the items conflict if they have the same target name */
+  if (items->len == 2)
+    {
+      /* the other item is now in conflict too */
+      oitem = g_ptr_array_index (items, 0);
+      oitem->conflict = TRUE;
+      thunar_renamer_model_item_changed (renamer_model, oitem);
+    }
+
+  item->conflict = (items->len > 1);
 }
 
 
 
-static gboolean
-thunar_renamer_model_conflict_item (ThunarRenamerModel     *renamer_model,
+static void
+thunar_renamer_model_target_remove (ThunarRenamerModel     *renamer_model,
                                     ThunarRenamerModelItem *item)
 {
   ThunarRenamerModelItem *oitem;
-  GtkTreePath            *path;
-  GtkTreeIter             iter;
-  gboolean                conflict = FALSE;
-  GList                  *lp;
+  GHashTable             *names;
+  GPtrArray              *items;
 
-  for (lp = renamer_model->items; lp != NULL; lp = lp->next)
+  if (item->target == NULL)
+    return;
+
+  names = g_hash_table_lookup (renamer_model->targets, item->parent);
+  items = g_hash_table_lookup (names, item->target);
+  g_ptr_array_remove_fast (items, item);
+
+  if (items->len == 0)
     {
-      /* check if this item is dirty or the item we're about to check */
-      oitem = THUNAR_RENAMER_MODEL_ITEM (lp->data);
-      if (G_UNLIKELY (oitem == item || oitem->dirty))
-        continue;
-
-      /* check if this other item conflicts with the item in question (can only conflict if in same directory) */
-      if (trm_same_directory (item->file, oitem->file)
-          && ((item->name != NULL && oitem->name == NULL && strcmp (item->name, thunar_file_get_display_name (oitem->file)) == 0)
-           || (item->name == NULL && oitem->name != NULL && strcmp (thunar_file_get_display_name (item->file), oitem->name) == 0)
-           || (item->name != NULL && oitem->name != NULL && strcmp (item->name, oitem->name) == 0)))
-        {
-          /* check if the other item is already in conflict state */
-          if (G_LIKELY (!oitem->conflict))
-            {
-              /* set to conflict state */
-              oitem->conflict = TRUE;
+      /* drop the name, and the directory if it was the last name */
+      g_hash_table_remove (names, item->target);
+      if (g_hash_table_size (names) == 0)
+        g_hash_table_remove (renamer_model->targets, item->parent);
+    }
+  else if (items->len == 1)
+    {
+      /* the remaining item no longer conflicts */
+      oitem = g_ptr_array_index (items, 0);
+      oitem->conflict = FALSE;
+      thunar_renamer_model_item_changed (renamer_model, oitem);
+    }
 
-              /* determine iter for other item */
-              GTK_TREE_ITER_INIT (iter, renamer_model->stamp, lp);
+  item->target = NULL;
+  item->conflict = FALSE;
+}
 
-              /* emit "row-changed" for the other item */
-              path = gtk_tree_model_get_path (GTK_TREE_MODEL (renamer_model), &iter);
-              gtk_tree_model_row_changed (GTK_TREE_MODEL (renamer_model), path, &iter);
-              gtk_tree_path_free (path);
-            }
 
-          /* this item conflicts */
-          conflict = TRUE;
-        }
-    }
 
-  return conflict;
+static void
+thunar_renamer_model_unlink_item (ThunarRenamerModel *renamer_model,
+                                  GList              *lp)
+{
+  ThunarRenamerModelItem *item = THUNAR_RENAMER_MODEL_ITEM (lp->data);
+
+  /* forget about the item */
+  thunar_renamer_model_target_remove (renamer_model, item);
+  g_hash_table_remove (renamer_model->file_items, item->file);
+  if (G_UNLIKELY (item->row_changed))
+    renamer_model->n_changed -= 1;
+
+  /* free the item data */
+  thunar_renamer_model_item_free (item);
+
+  /* drop the item from the list */
+  if (renamer_model->items_tail == lp)
+    renamer_model->items_tail = lp->prev;
+  renamer_model->items = g_list_delete_link (renamer_model->items, lp);
+  renamer_model->n_items -= 1;
 }
 
 
@@ -891,12 +975,17 @@ thunar_renamer_model_update_idle (gpointer user_data)
 {
   ThunarRenamerModelItem *item;
   ThunarRenamerModel     *renamer_model = THUNAR_RENAMER_MODEL (user_data);
+  const gchar            *target;
   GtkTreePath            *path;
   GtkTreeIter             iter;
-  gboolean                changed = FALSE;
+  gboolean                changed;
   gboolean                conflict;
+  gboolean                processed = FALSE;
+  gint64                  deadline;
+  gint                   *indices;
   guint                   idx;
   gchar                  *name;
+  GList                  *files;
   GList                  *lp;
 
   GDK_THREADS_ENTER ();
@@ -904,14 +993,44 @@ thunar_renamer_model_update_idle (gpointer user_data)
   /* don't do anything if the model is frozen */
   if (G_LIKELY (!renamer_model->frozen))
     {
-      /* process the first dirty item */
-      for (idx = 0, lp = renamer_model->items; !changed && lp != NULL; ++idx, lp = lp->next)
+      /* let the renamer prepare the new files in a single call */
+      if (renamer_model->prepare && renamer_model->renamer != NULL)
+        {
+          for (files = NULL, lp = renamer_model->items; lp != NULL; lp = lp->next)
+            {
+              item = THUNAR_RENAMER_MODEL_ITEM (lp->data);
+              if (!item->prepared)
+                {
+                  files = g_list_prepend (files, item->file);
+                  item->prepared = TRUE;
+                }
+            }
+
+          if (G_LIKELY (files != NULL))
+            {
+              files = g_list_reverse (files);
+              thunarx_renamer_prepare (renamer_model->renamer, files);
+              g_list_free (files);
+            }
+        }
+      renamer_model->prepare = FALSE;
+
+      /* process the dirty items in batches, as long
+       * as the time slice of this iteration permits */
+      deadline = g_get_monotonic_time () + THUNAR_RENAMER_MODEL_UPDATE_TIME;
+      for (idx = 0, lp = renamer_model->items; lp != NULL; ++idx, lp = lp->next)
         {
           /* check if this item is dirty */
           item = THUNAR_RENAMER_MODEL_ITEM (lp->data);
           if (G_LIKELY (!item->dirty))
             continue;
 
+          /* continue in the next iteration if we're out of time */
+          if (processed && g_get_monotonic_time () > deadline)
+            break;
+
+          processed = TRUE;
+
           /* check if the file changed */
           changed = item->changed;
 
@@ -936,35 +1055,52 @@ thunar_renamer_model_update_idle (gpointer user_data)
               g_free (name);
             }
 
-          /* check if this item conflicts with any other item */
-          conflict = thunar_renamer_model_conflict_item (renamer_model, item);
-          if (item->conflict != conflict)
+          /* move the item to its new target name, which
+           * updates the conflict state of the other items */
+          conflict = item->conflict;
+          target = (item->name != NULL) ? item->name : thunar_file_get_display_name (item->file);
+          if (item->target == NULL || strcmp (item->target, target) != 0)
             {
-              /* apply the new state */
-              item->conflict = conflict;
-
-              /* the item changed */
-              changed = TRUE;
+              thunar_renamer_model_target_remove (renamer_model, item);
+              thunar_renamer_model_target_add (renamer_model, item, target);
             }
 
           /* check if the item changed */
-          if (G_LIKELY (changed))
+          if (G_LIKELY (changed || item->conflict != conflict))
+            thunar_renamer_model_item_changed (renamer_model, item);
+        }
+
+      /* emit "row-changed" for all changed items in a single pass */
+      if (renamer_model->n_changed > 0)
+        {
+          path = gtk_tree_path_new_first ();
+          indices = gtk_tree_path_get_indices (path);
+
+          for (idx = 0, lp = renamer_model->items; lp != NULL && renamer_model->n_changed > 0; ++idx, lp = lp->next)
             {
+              item = THUNAR_RENAMER_MODEL_ITEM (lp->data);
+              if (!item->row_changed)
+                continue;
+
+              item->row_changed = FALSE;
+              renamer_model->n_changed -= 1;
+
               /* generate the iter for the item */
               GTK_TREE_ITER_INIT (iter, renamer_model->stamp, lp);
 
               /* emit "row-changed" for this item */
-              path = gtk_tree_path_new_from_indices (idx, -1);
+              indices[0] = idx;
               gtk_tree_model_row_changed (GTK_TREE_MODEL (renamer_model), path, &iter);
-              gtk_tree_path_free (path);
             }
+
+          gtk_tree_path_free (path);
         }
     }
 
   GDK_THREADS_LEAVE ();
 
-  /* keep the idle source as long as any item changed */
-  return changed;
+  /* keep the idle source as long as any item was processed */
+  return processed;
 }
 
 
@@ -988,6 +1124,7 @@ thunar_renamer_model_item_new (ThunarFile *file)
 
   item = g_slice_new0 (ThunarRenamerModelItem);
   item->file = g_object_ref (G_OBJECT (file));
+  item->parent = g_file_get_parent (thunar_file_get_file (file));
   item->date_changed = thunar_file_get_date (file, THUNAR_FILE_DATE_CHANGED);
   item->dirty = TRUE;
 
@@ -1002,6 +1139,8 @@ thunar_renamer_model_item_free (gpointer data)
   ThunarRenamerModelItem *item = data;
 
   g_object_unref (G_OBJECT (item->file));
+  if (G_LIKELY (item->parent != NULL))
+    g_object_unref (G_OBJECT (item->parent));
   g_free (item->name);
   g_slice_free (ThunarRenamerModelItem, item);
 }
@@ -1248,6 +1387,8 @@ void
 thunar_renamer_model_set_renamer (ThunarRenamerModel *renamer_model,
                                   ThunarxRenamer     *renamer)
 {
+  GList *lp;
+
   _thunar_return_if_fail (THUNAR_IS_RENAMER_MODEL (renamer_model));
   _thunar_return_if_fail (renamer == NULL || THUNARX_IS_RENAMER (renamer));
 
@@ -1272,6 +1413,11 @@ thunar_renamer_model_set_renamer (ThunarRenamerModel *renamer_model,
       g_object_ref (G_OBJECT (renamer));
     }
 
+  /* the new renamer must prepare all files */
+  for (lp = renamer_model->items; lp != NULL; lp = lp->next)
+    THUNAR_RENAMER_MODEL_ITEM (lp->data)->prepared = FALSE;
+  renamer_model->prepare = TRUE;
+
   /* invalidate all items */
   thunar_renamer_model_invalidate_all (renamer_model);
 
@@ -1303,25 +1449,45 @@ thunar_renamer_model_insert (ThunarRenamerModel *renamer_model,
   _thunar_return_if_fail (THUNAR_IS_FILE (file));
 
   /* check if we already have that file */
-  for (lp = renamer_model->items; lp != NULL; lp = lp->next)
-    if (THUNAR_RENAMER_MODEL_ITEM (lp->data)->file == file)
-      return;
+  if (g_hash_table_lookup (renamer_model->file_items, file) != NULL)
+    return;
 
   /* allocate a new item for the file */
   item = thunar_renamer_model_item_new (file);
 
-  /* append the item to the model */
-  renamer_model->items = g_list_insert (renamer_model->items, item, position);
+  if (position < 0 || position >= renamer_model->n_items)
+    {
+      /* append the item to the model, without walking the list */
+      position = renamer_model->n_items;
+      lp = g_list_alloc ();
+      lp->data = item;
+      lp->prev = renamer_model->items_tail;
+      if (G_LIKELY (renamer_model->items_tail != NULL))
+        renamer_model->items_tail->next = lp;
+      else
+        renamer_model->items = lp;
+      renamer_model->items_tail = lp;
+    }
+  else
+    {
+      /* insert the item into the model */
+      renamer_model->items = g_list_insert (renamer_model->items, item, position);
+      lp = g_list_nth (renamer_model->items, position);
+    }
+
+  g_hash_table_insert (renamer_model->file_items, file, lp);
+  renamer_model->n_items += 1;
 
   /* determine the iterator for the new item */
-  GTK_TREE_ITER_INIT (iter, renamer_model->stamp, g_list_find (renamer_model->items, item));
+  GTK_TREE_ITER_INIT (iter, renamer_model->stamp, lp);
 
   /* emit the "row-inserted" signal */
-  path = gtk_tree_model_get_path (GTK_TREE_MODEL (renamer_model), &iter);
+  path = gtk_tree_path_new_from_indices (position, -1);
   gtk_tree_model_row_inserted (GTK_TREE_MODEL (renamer_model), path, &iter);
   gtk_tree_path_free (path);
 
   /* invalidate the newly added item */
+  renamer_model->prepare = TRUE;
   thunar_renamer_model_invalidate_item (renamer_model, item);
 }
 
@@ -1352,7 +1518,7 @@ thunar_renamer_model_reorder (ThunarRenamerModel *renamer_model,
   _thunar_return_if_fail (THUNAR_IS_RENAMER_MODEL (renamer_model));
 
   /* leave when there is nothing to sort */
-  n_items = g_list_length (renamer_model->items);
+  n_items = renamer_model->n_items;
   if (G_UNLIKELY (n_items <= 1))
     return;
 
@@ -1365,9 +1531,15 @@ thunar_renamer_model_reorder (ThunarRenamerModel *renamer_model,
 
   /* be sure to not overuse the stack */
   if (G_LIKELY (n_items < 500))
-    sort_array = g_newa (SortTuple, n_items);
+    {
+      sort_array = g_newa (SortTuple, n_items);
+      new_order = g_newa (gint, n_items);
+    }
   else
-    sort_array = g_new (SortTuple, n_items);
+    {
+      sort_array = g_new (SortTuple, n_items);
+      new_order = g_new (gint, n_items);
+    }
 
   /* generate the sort array of tuples */
   for (lp = renamer_model->items, m = 0, n = 0; lp != NULL; lp = lp->next, ++n, ++m)
@@ -1396,7 +1568,6 @@ thunar_renamer_model_reorder (ThunarRenamerModel *renamer_model,
     g_qsort_with_data (sort_array, n_items, sizeof (SortTuple), thunar_renamer_model_cmp_name, GINT_TO_POINTER (position));
 
   /* update our internals and generate the new order */
-  new_order = g_newa (gint, n_items);
   for (n = 0, lprev = NULL; n < n_items; ++n)
     {
       /* set the new order in the sort list */
@@ -1416,6 +1587,7 @@ thunar_renamer_model_reorder (ThunarRenamerModel *renamer_model,
       /* advance the offset */
       lprev = lp;
     }
+  renamer_model->items_tail = lprev;
 
   /* tell the view about the new item order */
   path = gtk_tree_path_new ();
@@ -1427,7 +1599,10 @@ thunar_renamer_model_reorder (ThunarRenamerModel *renamer_model,
   
   /* cleanup if we used the heap */
   if (G_UNLIKELY (n_items >= 500))
-    g_free (sort_array);
+    {
+      g_free (sort_array);
+      g_free (new_order);
+    }
 }
 
 
@@ -1461,6 +1636,8 @@ thunar_renamer_model_sort (ThunarRenamerModel *renamer_model,
 void
 thunar_renamer_model_clear (ThunarRenamerModel *renamer_model)
 {
+  GtkTreePath *path;
+
   _thunar_return_if_fail (THUNAR_IS_RENAMER_MODEL (renamer_model));
 
   /* grab an additional reference on the model */
@@ -1469,13 +1646,20 @@ thunar_renamer_model_clear (ThunarRenamerModel *renamer_model)
   /* freeze notifications */
   g_object_freeze_notify (G_OBJECT (renamer_model));
 
-  /* delete all items from the model */
+  /* no need to track conflicts of the items we drop */
+  g_hash_table_remove_all (renamer_model->targets);
+
+  /* delete all items from the model, without invalidating the
+   * remaining items after every item, like the "file-destroyed"
+   * handler does */
+  path = gtk_tree_path_new_first ();
   while (renamer_model->items != NULL)
     {
-      /* just use the "file-destroyed" handler here to drop the first item */
-      thunar_renamer_model_file_destroyed (renamer_model, THUNAR_RENAMER_MODEL_ITEM (renamer_model->items->data)->file,
-                                           renamer_model->file_monitor);
+      THUNAR_RENAMER_MODEL_ITEM (renamer_model->items->data)->target = NULL;
+      thunar_renamer_model_unlink_item (renamer_model, renamer_model->items);
+      gtk_tree_model_row_deleted (GTK_TREE_MODEL (renamer_model), path);
     }
+  gtk_tree_path_free (path);
 
   /* thaw notifications */
   g_object_thaw_notify (G_OBJECT (renamer_model));
@@ -1508,11 +1692,8 @@ thunar_renamer_model_remove (ThunarRenamerModel *renamer_model,
   if (G_UNLIKELY (lp == NULL))
     return;
 
-  /* free the item data */
-  thunar_renamer_model_item_free (lp->data);
-
   /* drop the item from the list */
-  renamer_model->items = g_list_delete_link (renamer_model->items, lp);
+  thunar_renamer_model_unlink_item (renamer_model, lp);
 
   /* tell the view that the item is gone */
   gtk_tree_model_row_deleted (GTK_TREE_MODEL (renamer_model), path);
@@ -22,23 +22,25 @@
 #endif
 
 #include <thunar/thunar-private.h>
+#include <thunar/thunar-rename-job.h>
 #include <thunar/thunar-renamer-progress.h>
 
 
 
-/* Signal identifiers */
-enum
-{
-  FINISHED,
-  LAST_SIGNAL,
-};
-
-
-
-static void     thunar_renamer_progress_finalize          (GObject                    *object);
-static void     thunar_renamer_progress_destroy           (GtkObject                  *object);
-static gboolean thunar_renamer_progress_next_idle         (gpointer                    user_data);
-static void     thunar_renamer_progress_next_idle_destroy (gpointer                    user_data);
+static void              thunar_renamer_progress_finalize      (GObject                    *object);
+static void              thunar_renamer_progress_destroy       (GtkObject                  *object);
+static void              thunar_renamer_progress_progress      (ThunarRenameJob            *job,
+                                                                guint                       n_done,
+                                                                guint                       n_total,
+                                                                ThunarRenamerProgress      *renamer_progress);
+static ThunarJobResponse thunar_renamer_progress_rename_failed (ThunarRenameJob            *job,
+                                                                const gchar                *old_name,
+                                                                const gchar                *new_name,
+                                                                const gchar                *message,
+                                                                ThunarJobResponse           choices,
+                                                                ThunarRenamerProgress      *renamer_progress);
+static void              thunar_renamer_progress_finished      (ThunarRenameJob            *job,
+                                                                ThunarRenamerProgress      *renamer_progress);
 
 
 
@@ -52,15 +54,11 @@ struct _ThunarRenamerProgress
   GtkAlignment __parent__;
   GtkWidget   *bar;
 
-  GList       *pairs_done;
-  guint        n_pairs_done;
-  GList       *pairs_todo;
-  guint        n_pairs_todo;
-  gboolean     pairs_undo;  /* whether we're undoing previous changes */
+  /* the job renaming the files in a separate thread */
+  ThunarJob   *job;
 
   /* internal main loop for the _rename() method */
-  guint        next_idle_id;
-  GMainLoop   *next_idle_loop;
+  GMainLoop   *job_loop;
 };
 
 
@@ -102,12 +100,8 @@ thunar_renamer_progress_finalize (GObject *object)
   ThunarRenamerProgress *renamer_progress = THUNAR_RENAMER_PROGRESS (object);
 
   /* make sure we're not finalized while the main loop is active */
-  _thunar_assert (renamer_progress->next_idle_id == 0);
-  _thunar_assert (renamer_progress->next_idle_loop == NULL);
-
-  /* release the pairs */
-  thunar_renamer_pair_list_free (renamer_progress->pairs_done);
-  thunar_renamer_pair_list_free (renamer_progress->pairs_todo);
+  _thunar_assert (renamer_progress->job == NULL);
+  _thunar_assert (renamer_progress->job_loop == NULL);
 
   (*G_OBJECT_CLASS (thunar_renamer_progress_parent_class)->finalize) (object);
 }
@@ -127,156 +121,107 @@ thunar_renamer_progress_destroy (GtkObject *object)
 
 
 
-static gboolean
-thunar_renamer_progress_next_idle (gpointer user_data)
+static void
+thunar_renamer_progress_progress (ThunarRenameJob       *job,
+                                  guint                  n_done,
+                                  guint                  n_total,
+                                  ThunarRenamerProgress *renamer_progress)
 {
-  ThunarRenamerProgress *renamer_progress = THUNAR_RENAMER_PROGRESS (user_data);
-  ThunarRenamerPair     *pair;
-  GtkWindow             *toplevel;
-  GtkWidget             *message;
-  GError                *error = NULL;
-  gchar                 *oldname;
-  gchar                  text[128];
-  gint                   response;
-  guint                  n_done;
-  guint                  n_total;
-  GList                 *first;
-
-  GDK_THREADS_ENTER ();
-
-  /* check if we have still pairs to go */
-  if (G_LIKELY (renamer_progress->pairs_todo != NULL))
-    {
-      /* pop the first pair from the todo list */
-      first = g_list_first (renamer_progress->pairs_todo);
-      pair = first->data;
-      renamer_progress->pairs_todo = g_list_delete_link (renamer_progress->pairs_todo, first);
-
-      /* update item count */
-      renamer_progress->n_pairs_todo--;
-      _thunar_assert (g_list_length (renamer_progress->pairs_todo) == renamer_progress->n_pairs_todo);
-
-      /* determine the done/todo items */
-      n_done = renamer_progress->n_pairs_done + 1;
-      n_total = n_done + renamer_progress->n_pairs_todo;
-
-      /* update the progress bar text */
-      g_snprintf (text, sizeof (text), "%d/%d", n_done, n_total);
-      gtk_progress_bar_set_text (GTK_PROGRESS_BAR (renamer_progress->bar), text);
-
-      /* update the progress bar fraction */
-      gtk_progress_bar_set_fraction (GTK_PROGRESS_BAR (renamer_progress->bar), CLAMP ((gdouble) n_done / MAX (n_total, 1), 0.0, 1.0));
-
-      /* remember the old file name (for undo) */
-      oldname = g_strdup (thunar_file_get_display_name (pair->file));
-
-      /* try to rename the file */
-      if (!thunar_file_rename (pair->file, pair->name, NULL, FALSE, &error))
-        {
-          /* determine the toplevel widget */
-          toplevel = (GtkWindow *) gtk_widget_get_toplevel (GTK_WIDGET (renamer_progress));
-
-          /* tell the user that we failed */
-          message = gtk_message_dialog_new (toplevel,
-                                            GTK_DIALOG_DESTROY_WITH_PARENT
-                                            | GTK_DIALOG_MODAL,
-                                            GTK_MESSAGE_ERROR,
-                                            GTK_BUTTONS_NONE,
-                                            _("Failed to rename \"%s\" to \"%s\"."),
-                                            oldname, pair->name);
-
-          /* check if we should provide undo */
-          if (!renamer_progress->pairs_undo && renamer_progress->pairs_done != NULL)
-            {
-              gtk_message_dialog_format_secondary_text (GTK_MESSAGE_DIALOG (message),
-                                                        _("You can either choose to skip this file and continue to rename the "
-                                                          "remaining files, or revert the previously renamed files to their "
-                                                          "previous names, or cancel the operation without reverting previous "
-                                                          "changes."));
-              gtk_dialog_add_button (GTK_DIALOG (message), GTK_STOCK_CANCEL, GTK_RESPONSE_CANCEL);
-              gtk_dialog_add_button (GTK_DIALOG (message), _("_Revert Changes"), GTK_RESPONSE_REJECT);
-              gtk_dialog_add_button (GTK_DIALOG (message), _("_Skip This File"), GTK_RESPONSE_ACCEPT);
-              gtk_dialog_set_default_response (GTK_DIALOG (message), GTK_RESPONSE_ACCEPT);
-            }
-          else if (renamer_progress->pairs_todo != NULL)
-            {
-              gtk_message_dialog_format_secondary_text (GTK_MESSAGE_DIALOG (message),
-                                                        _("Do you want to skip this file and continue to rename the "
-                                                          "remaining files?"));
-              gtk_dialog_add_button (GTK_DIALOG (message), GTK_STOCK_CANCEL, GTK_RESPONSE_CANCEL);
-              gtk_dialog_add_button (GTK_DIALOG (message), _("_Skip This File"), GTK_RESPONSE_ACCEPT);
-              gtk_dialog_set_default_response (GTK_DIALOG (message), GTK_RESPONSE_ACCEPT);
-            }
-          else
-            {
-              gtk_message_dialog_format_secondary_text (GTK_MESSAGE_DIALOG (message), "%s.", error->message);
-              gtk_dialog_add_button (GTK_DIALOG (message), GTK_STOCK_CLOSE, GTK_RESPONSE_CANCEL);
-            }
-
-          /* run the dialog */
-          response = gtk_dialog_run (GTK_DIALOG (message));
-          if (response == GTK_RESPONSE_REJECT)
-            {
-              /* undo previous changes */
-              renamer_progress->pairs_undo = TRUE;
-
-              /* release the todo pairs and use the done as todo */
-              thunar_renamer_pair_list_free (renamer_progress->pairs_todo);
-              renamer_progress->pairs_todo = renamer_progress->pairs_done;
-              renamer_progress->pairs_done = NULL;
-
-              renamer_progress->n_pairs_done = 0;
-              renamer_progress->n_pairs_todo = g_list_length (renamer_progress->pairs_todo);
-            }
-          else if (response != GTK_RESPONSE_ACCEPT)
-            {
-              /* canceled, just exit the main loop */
-              g_main_loop_quit (renamer_progress->next_idle_loop);
-            }
-
-          /* release the pair */
-          thunar_renamer_pair_free (pair);
-
-          /* destroy the dialog */
-          gtk_widget_destroy (message);
-
-          /* clear the error */
-          g_clear_error (&error);
-
-          /* release old name */
-          g_free (oldname);
-        }
-      else
-        {
-          /* replace the newname with the oldname for the pair (-> undo) */
-          g_free (pair->name);
-          pair->name = oldname;
-
-          /* move the pair to the list of completed pairs */
-          renamer_progress->pairs_done = g_list_prepend (renamer_progress->pairs_done, pair);
-
-          /* update counter */
-          renamer_progress->n_pairs_done++;
-          _thunar_assert (g_list_length (renamer_progress->pairs_done) == renamer_progress->n_pairs_done);
-        }
-    }
+  gchar text[128];
+
+  _thunar_return_if_fail (THUNAR_IS_RENAME_JOB (job));
+  _thunar_return_if_fail (THUNAR_IS_RENAMER_PROGRESS (renamer_progress));
+
+  /* update the progress bar text */
+  g_snprintf (text, sizeof (text), "%d/%d", n_done, n_total);
+  gtk_progress_bar_set_text (GTK_PROGRESS_BAR (renamer_progress->bar), text);
+
+  /* update the progress bar fraction */
+  gtk_progress_bar_set_fraction (GTK_PROGRESS_BAR (renamer_progress->bar), CLAMP ((gdouble) n_done / MAX (n_total, 1), 0.0, 1.0));
+}
+
 
-  /* be sure to cancel the internal loop once we're done */
-  if (G_UNLIKELY (renamer_progress->pairs_todo == NULL))
-    g_main_loop_quit (renamer_progress->next_idle_loop);
 
-  GDK_THREADS_LEAVE ();
+static ThunarJobResponse
+thunar_renamer_progress_rename_failed (ThunarRenameJob       *job,
+                                       const gchar           *old_name,
+                                       const gchar           *new_name,
+                                       const gchar           *message,
+                                       ThunarJobResponse      choices,
+                                       ThunarRenamerProgress *renamer_progress)
+{
+  GtkWindow *toplevel;
+  GtkWidget *dialog;
+  gint       response;
+
+  _thunar_return_val_if_fail (THUNAR_IS_RENAME_JOB (job), THUNAR_JOB_RESPONSE_CANCEL);
+  _thunar_return_val_if_fail (THUNAR_IS_RENAMER_PROGRESS (renamer_progress), THUNAR_JOB_RESPONSE_CANCEL);
+
+  /* determine the toplevel widget */
+  toplevel = (GtkWindow *) gtk_widget_get_toplevel (GTK_WIDGET (renamer_progress));
+
+  /* tell the user that we failed */
+  dialog = gtk_message_dialog_new (toplevel,
+                                   GTK_DIALOG_DESTROY_WITH_PARENT
+                                   | GTK_DIALOG_MODAL,
+                                   GTK_MESSAGE_ERROR,
+                                   GTK_BUTTONS_NONE,
+                                   _("Failed to rename \"%s\" to \"%s\"."),
+                                   old_name, new_name);
+
+  /* check if we should provide undo */
+  if ((choices & THUNAR_JOB_RESPONSE_NO) != 0)
+    {
+      gtk_message_dialog_format_secondary_text (GTK_MESSAGE_DIALOG (dialog),
+                                                _("You can either choose to skip this file and continue to rename the "
+                                                  "remaining files, or revert the previously renamed files to their "
+                                                  "previous names, or cancel the operation without reverting previous "
+                                                  "changes."));
+      gtk_dialog_add_button (GTK_DIALOG (dialog), GTK_STOCK_CANCEL, GTK_RESPONSE_CANCEL);
+      gtk_dialog_add_button (GTK_DIALOG (dialog), _("_Revert Changes"), GTK_RESPONSE_REJECT);
+      gtk_dialog_add_button (GTK_DIALOG (dialog), _("_Skip This File"), GTK_RESPONSE_ACCEPT);
+      gtk_dialog_set_default_response (GTK_DIALOG (dialog), GTK_RESPONSE_ACCEPT);
+    }
+  else if ((choices & THUNAR_JOB_RESPONSE_YES) != 0)
+    {
+      gtk_message_dialog_format_secondary_text (GTK_MESSAGE_DIALOG (dialog),
+                                                _("Do you want to skip this file and continue to rename the "
+                                                  "remaining files?"));
+      gtk_dialog_add_button (GTK_DIALOG (dialog), GTK_STOCK_CANCEL, GTK_RESPONSE_CANCEL);
+      gtk_dialog_add_button (GTK_DIALOG (dialog), _("_Skip This File"), GTK_RESPONSE_ACCEPT);
+      gtk_dialog_set_default_response (GTK_DIALOG (dialog), GTK_RESPONSE_ACCEPT);
+    }
+  else
+    {
+      gtk_message_dialog_format_secondary_text (GTK_MESSAGE_DIALOG (dialog), "%s.", message);
+      gtk_dialog_add_button (GTK_DIALOG (dialog), GTK_STOCK_CLOSE, GTK_RESPONSE_CANCEL);
+    }
 
-  /* keep the idle source alive as long as we have anything to do */
-  return (renamer_progress->pairs_todo != NULL);
+  /* run the dialog */
+  response = gtk_dialog_run (GTK_DIALOG (dialog));
+  gtk_widget_destroy (dialog);
+
+  /* translate the response */
+  if (response == GTK_RESPONSE_REJECT)
+    return THUNAR_JOB_RESPONSE_NO;
+  else if (response == GTK_RESPONSE_ACCEPT)
+    return THUNAR_JOB_RESPONSE_YES;
+  else
+    return THUNAR_JOB_RESPONSE_CANCEL;
 }
 
 
 
 static void
-thunar_renamer_progress_next_idle_destroy (gpointer user_data)
+thunar_renamer_progress_finished (ThunarRenameJob       *job,
+                                  ThunarRenamerProgress *renamer_progress)
 {
-  THUNAR_RENAMER_PROGRESS (user_data)->next_idle_id = 0;
+  _thunar_return_if_fail (THUNAR_IS_RENAME_JOB (job));
+  _thunar_return_if_fail (THUNAR_IS_RENAMER_PROGRESS (renamer_progress));
+
+  /* the job is done, exit the internal main loop */
+  if (G_LIKELY (renamer_progress->job_loop != NULL))
+    g_main_loop_quit (renamer_progress->job_loop);
 }
 
 
@@ -307,9 +252,9 @@ thunar_renamer_progress_cancel (ThunarRenamerProgress *renamer_progress)
 {
   _thunar_return_if_fail (THUNAR_IS_RENAMER_PROGRESS (renamer_progress));
 
-  /* exit the internal main loop (if any) */
-  if (G_UNLIKELY (renamer_progress->next_idle_loop != NULL))
-    g_main_loop_quit (renamer_progress->next_idle_loop);
+  /* cancel the job, the internal main loop exits once it finished */
+  if (G_UNLIKELY (renamer_progress->job != NULL))
+    exo_job_cancel (EXO_JOB (renamer_progress->job));
 }
 
 
@@ -326,7 +271,7 @@ gboolean
 thunar_renamer_progress_running (ThunarRenamerProgress *renamer_progress)
 {
   _thunar_return_val_if_fail (THUNAR_IS_RENAMER_PROGRESS (renamer_progress), FALSE);
-  return (renamer_progress->next_idle_loop != NULL);
+  return (renamer_progress->job_loop != NULL);
 }
 
 
@@ -349,46 +294,31 @@ thunar_renamer_progress_run (ThunarRenamerProgress *renamer_progress,
   _thunar_return_if_fail (THUNAR_IS_RENAMER_PROGRESS (renamer_progress));
 
   /* make sure we're not already renaming */
-  if (G_UNLIKELY (renamer_progress->next_idle_id != 0
-      || renamer_progress->next_idle_loop != NULL))
+  if (G_UNLIKELY (renamer_progress->job != NULL
+      || renamer_progress->job_loop != NULL))
     return;
 
   /* take an additional reference on the progress */
   g_object_ref (G_OBJECT (renamer_progress));
 
-  /* make sure to release the list of completed items first */
-  thunar_renamer_pair_list_free (renamer_progress->pairs_done);
-  renamer_progress->pairs_done = NULL;
-
-  /* set the pairs on the todo list */
-  thunar_renamer_pair_list_free (renamer_progress->pairs_todo);
-  renamer_progress->pairs_todo = thunar_renamer_pair_list_copy (pairs);
-  renamer_progress->n_pairs_todo = g_list_length (renamer_progress->pairs_todo);
-
-  /* schedule the idle source */
-  renamer_progress->next_idle_id = g_idle_add_full (G_PRIORITY_LOW, thunar_renamer_progress_next_idle,
-                                                    renamer_progress, thunar_renamer_progress_next_idle_destroy);
-
-  /* run the inner main loop */
-  renamer_progress->next_idle_loop = g_main_loop_new (NULL, FALSE);
-  g_main_loop_run (renamer_progress->next_idle_loop);
-  g_main_loop_unref (renamer_progress->next_idle_loop);
-  renamer_progress->next_idle_loop = NULL;
+  /* launch the job renaming the pairs */
+  renamer_progress->job = thunar_rename_job_new (pairs);
+  g_signal_connect (renamer_progress->job, "progress", G_CALLBACK (thunar_renamer_progress_progress), renamer_progress);
+  g_signal_connect (renamer_progress->job, "rename-failed", G_CALLBACK (thunar_renamer_progress_rename_failed), renamer_progress);
+  g_signal_connect (renamer_progress->job, "finished", G_CALLBACK (thunar_renamer_progress_finished), renamer_progress);
+  exo_job_launch (EXO_JOB (renamer_progress->job));
 
-  /* be sure to cancel any pending idle source */
-  if (G_UNLIKELY (renamer_progress->next_idle_id != 0))
-    g_source_remove (renamer_progress->next_idle_id);
+  /* run the inner main loop until the job is finished */
+  renamer_progress->job_loop = g_main_loop_new (NULL, FALSE);
+  g_main_loop_run (renamer_progress->job_loop);
+  g_main_loop_unref (renamer_progress->job_loop);
+  renamer_progress->job_loop = NULL;
 
-  /* release the list of completed items */
-  thunar_renamer_pair_list_free (renamer_progress->pairs_done);
-  renamer_progress->pairs_done = NULL;
-
-  /* release the list of todo items */
-  thunar_renamer_pair_list_free (renamer_progress->pairs_todo);
-  renamer_progress->pairs_todo = NULL;
+  /* release the job */
+  g_signal_handlers_disconnect_matched (renamer_progress->job, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, renamer_progress);
+  g_object_unref (renamer_progress->job);
+  renamer_progress->job = NULL;
 
   /* release the additional reference on the progress */
   g_object_unref (G_OBJECT (renamer_progress));
 }
-
-
@@ -49,6 +49,9 @@
 #define SPINNER_CYCLE_DURATION 1000
 #define SPINNER_NUM_STEPS      12
 
+/* seconds before we stop waiting for a bookmark to resolve */
+#define RESOLVE_TIMEOUT 10
+
 
 
 #define THUNAR_SHORTCUT(obj) ((ThunarShortcut *) (obj))
@@ -125,6 +128,10 @@ static void               thunar_shortcuts_model_add_shortcut       (ThunarShort
                                                                      ThunarShortcut            *shortcut);
 static void               thunar_shortcuts_model_remove_shortcut    (ThunarShortcutsModel      *model,
                                                                      ThunarShortcut            *shortcut);
+static void               thunar_shortcuts_model_watch_file         (ThunarShortcutsModel      *model,
+                                                                     ThunarShortcut            *shortcut);
+static void               thunar_shortcuts_model_resolve            (ThunarShortcutsModel      *model,
+                                                                     ThunarShortcut            *shortcut);
 static gboolean           thunar_shortcuts_model_load               (gpointer                   data);
 static void               thunar_shortcuts_model_save               (ThunarShortcutsModel      *model);
 static void               thunar_shortcuts_model_monitor            (GFileMonitor              *monitor,
@@ -148,6 +155,7 @@ static void               thunar_shortcuts_model_device_changed     (ThunarDevic
 
 static void               thunar_shortcut_free                      (ThunarShortcut            *shortcut,
                                                                      ThunarShortcutsModel      *model);
+static void               thunar_shortcut_stop_resolve              (ThunarShortcut            *shortcut);
 
 
 
@@ -200,6 +208,10 @@ struct _ThunarShortcut
   ThunarFile          *file;
   ThunarDevice        *device;
 
+  /* pending lookup of the file for a bookmark location */
+  GCancellable        *resolve_cancellable;
+  guint                resolve_timeout_id;
+
   guint                hidden : 1;
 };
 
@@ -1118,6 +1130,25 @@ thunar_shortcuts_model_sort_func (gconstpointer shortcut_a,
 
 
 
+static void
+thunar_shortcuts_model_watch_file (ThunarShortcutsModel *model,
+                                   ThunarShortcut       *shortcut)
+{
+  _thunar_return_if_fail (THUNAR_IS_SHORTCUTS_MODEL (model));
+  _thunar_return_if_fail (THUNAR_IS_FILE (shortcut->file));
+
+  /* watch the file for changes */
+  thunar_file_watch (shortcut->file);
+
+  /* connect appropriate signals */
+  g_signal_connect (G_OBJECT (shortcut->file), "changed",
+                    G_CALLBACK (thunar_shortcuts_model_file_changed), model);
+  g_signal_connect (G_OBJECT (shortcut->file), "destroy",
+                    G_CALLBACK (thunar_shortcuts_model_file_destroy), model);
+}
+
+
+
 static void
 thunar_shortcuts_model_add_shortcut_with_path (ThunarShortcutsModel *model,
                                                ThunarShortcut       *shortcut,
@@ -1131,16 +1162,7 @@ thunar_shortcuts_model_add_shortcut_with_path (ThunarShortcutsModel *model,
 
   /* we want to stay informed about changes to the file */
   if (G_LIKELY (shortcut->file != NULL))
-    {
-      /* watch the file for changes */
-      thunar_file_watch (shortcut->file);
-
-      /* connect appropriate signals */
-      g_signal_connect (G_OBJECT (shortcut->file), "changed",
-                        G_CALLBACK (thunar_shortcuts_model_file_changed), model);
-      g_signal_connect (G_OBJECT (shortcut->file), "destroy",
-                        G_CALLBACK (thunar_shortcuts_model_file_destroy), model);
-    }
+    thunar_shortcuts_model_watch_file (model, shortcut);
 
   if (path == NULL)
     {
@@ -1229,6 +1251,112 @@ thunar_shortcuts_model_local_file (GFile *gfile)
 
 
 
+static void
+thunar_shortcuts_model_resolve_finished (GFile      *location,
+                                         ThunarFile *file,
+                                         GError     *error,
+                                         gpointer    user_data)
+{
+  ThunarShortcutsModel *model;
+  ThunarShortcut       *shortcut = NULL;
+  GtkTreePath          *path;
+  GtkTreeIter           iter;
+  GList                *lp;
+  gint                  idx;
+
+  /* the shortcut was released or the lookup timed out, the
+   * model might be gone already, so don't touch anything */
+  if (error != NULL && g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    return;
+
+  model = THUNAR_SHORTCUTS_MODEL (user_data);
+
+  /* lookup the unresolved shortcut for the location */
+  for (idx = 0, lp = model->shortcuts; lp != NULL; ++idx, lp = lp->next)
+    {
+      shortcut = THUNAR_SHORTCUT (lp->data);
+      if (shortcut->resolve_cancellable != NULL
+          && shortcut->location != NULL
+          && g_file_equal (shortcut->location, location))
+        break;
+    }
+
+  if (G_UNLIKELY (lp == NULL))
+    return;
+
+  /* the lookup is done */
+  thunar_shortcut_stop_resolve (shortcut);
+
+  /* only directories are shown in the model */
+  if (G_UNLIKELY (error != NULL || !thunar_file_is_directory (file)))
+    {
+      /* drop the row, but unlike thunar_shortcuts_model_remove_shortcut()
+       * this doesn't rewrite the bookmarks file */
+      model->shortcuts = g_list_delete_link (model->shortcuts, lp);
+
+      path = gtk_tree_path_new_from_indices (idx, -1);
+      gtk_tree_model_row_deleted (GTK_TREE_MODEL (model), path);
+      gtk_tree_path_free (path);
+
+      thunar_shortcut_free (shortcut, model);
+
+      /* update header visibility */
+      thunar_shortcuts_model_header_visibility (model);
+      return;
+    }
+
+  /* the shortcut is now backed by the file, which
+   * provides the icon and the display name */
+  shortcut->file = g_object_ref (G_OBJECT (file));
+  thunar_shortcuts_model_watch_file (model, shortcut);
+  g_object_unref (shortcut->location);
+  shortcut->location = NULL;
+  g_object_unref (shortcut->gicon);
+  shortcut->gicon = NULL;
+
+  /* notify the views about the change */
+  GTK_TREE_ITER_INIT (iter, model->stamp, lp);
+  path = gtk_tree_path_new_from_indices (idx, -1);
+  gtk_tree_model_row_changed (GTK_TREE_MODEL (model), path, &iter);
+  gtk_tree_path_free (path);
+}
+
+
+
+static gboolean
+thunar_shortcuts_model_resolve_timeout (gpointer data)
+{
+  ThunarShortcut *shortcut = THUNAR_SHORTCUT (data);
+
+  /* give up on the lookup, the shortcut keeps its location
+   * and is resolved when the user opens it */
+  shortcut->resolve_timeout_id = 0;
+  thunar_shortcut_stop_resolve (shortcut);
+
+  return FALSE;
+}
+
+
+
+static void
+thunar_shortcuts_model_resolve (ThunarShortcutsModel *model,
+                                ThunarShortcut       *shortcut)
+{
+  _thunar_return_if_fail (THUNAR_IS_SHORTCUTS_MODEL (model));
+  _thunar_return_if_fail (G_IS_FILE (shortcut->location));
+  _thunar_return_if_fail (shortcut->resolve_cancellable == NULL);
+
+  shortcut->resolve_cancellable = g_cancellable_new ();
+  shortcut->resolve_timeout_id = g_timeout_add_seconds (RESOLVE_TIMEOUT, thunar_shortcuts_model_resolve_timeout, shortcut);
+
+  /* this may finish (and even release the shortcut) right away,
+   * if the file is already in the cache */
+  thunar_file_get_async (shortcut->location, shortcut->resolve_cancellable,
+                         thunar_shortcuts_model_resolve_finished, model);
+}
+
+
+
 static void
 thunar_shortcuts_model_load_line (GFile       *file_path,
                                   const gchar *name,
@@ -1237,7 +1365,6 @@ thunar_shortcuts_model_load_line (GFile       *file_path,
 {
   ThunarShortcutsModel *model = THUNAR_SHORTCUTS_MODEL (user_data);
   ThunarShortcut       *shortcut;
-  ThunarFile           *file;
 
   _thunar_return_if_fail (G_IS_FILE (file_path));
   _thunar_return_if_fail (THUNAR_IS_SHORTCUTS_MODEL (model));
@@ -1246,29 +1373,22 @@ thunar_shortcuts_model_load_line (GFile       *file_path,
   /* handle local and remove files differently */
   if (thunar_shortcuts_model_local_file (file_path))
     {
-      /* try to open the file corresponding to the uri */
-      file = thunar_file_get (file_path, NULL);
-      if (G_UNLIKELY (file == NULL))
-        return;
+      /* create the shortcut entry from the bookmark, so we don't
+       * have to wait for the file system (which might be an
+       * unresponsive mount) before the bookmark is shown */
+      shortcut = g_slice_new0 (ThunarShortcut);
+      shortcut->group = THUNAR_SHORTCUT_GROUP_PLACES_BOOKMARKS;
+      shortcut->gicon = g_themed_icon_new ("folder");
+      shortcut->location = g_object_ref (file_path);
+      shortcut->sort_id = row_num;
+      shortcut->hidden = thunar_shortcuts_model_get_hidden (model, shortcut);
+      shortcut->name = g_strdup (name);
 
-      /* make sure the file refers to a directory */
-      if (G_UNLIKELY (thunar_file_is_directory (file)))
-        {
-          /* create the shortcut entry */
-          shortcut = g_slice_new0 (ThunarShortcut);
-          shortcut->group = THUNAR_SHORTCUT_GROUP_PLACES_BOOKMARKS;
-          shortcut->file = file;
-          shortcut->sort_id = row_num;
-          shortcut->hidden = thunar_shortcuts_model_get_hidden (model, shortcut);
-          shortcut->name = g_strdup (name);
+      /* append the shortcut to the list */
+      thunar_shortcuts_model_add_shortcut (model, shortcut);
 
-          /* append the shortcut to the list */
-          thunar_shortcuts_model_add_shortcut (model, shortcut);
-        }
-      else
-        {
-          g_object_unref (file);
-        }
+      /* lookup the file in the background */
+      thunar_shortcuts_model_resolve (model, shortcut);
     }
   else
     {
@@ -1650,10 +1770,32 @@ thunar_shortcuts_model_device_changed (ThunarDeviceMonitor  *device_monitor,
 
 
 
+static void
+thunar_shortcut_stop_resolve (ThunarShortcut *shortcut)
+{
+  if (shortcut->resolve_timeout_id != 0)
+    {
+      g_source_remove (shortcut->resolve_timeout_id);
+      shortcut->resolve_timeout_id = 0;
+    }
+
+  if (shortcut->resolve_cancellable != NULL)
+    {
+      g_cancellable_cancel (shortcut->resolve_cancellable);
+      g_object_unref (shortcut->resolve_cancellable);
+      shortcut->resolve_cancellable = NULL;
+    }
+}
+
+
+
 static void
 thunar_shortcut_free (ThunarShortcut       *shortcut,
                       ThunarShortcutsModel *model)
 {
+  /* abort a pending lookup */
+  thunar_shortcut_stop_resolve (shortcut);
+
   if (G_LIKELY (shortcut->file != NULL))
     {
       /* drop the file watch */
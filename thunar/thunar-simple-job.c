@@ -142,6 +142,49 @@ thunar_simple_job_execute (ExoJob  *job,
 
 
 
+static ThunarJob *
+thunar_simple_job_new_valist (ThunarSimpleJobFunc func,
+                              guint               n_param_values,
+                              va_list             var_args)
+{
+  ThunarSimpleJob *simple_job;
+  GValue           value = { 0, };
+  gchar           *error_message;
+  guint            n;
+
+  /* allocate and initialize the simple job */
+  simple_job = g_object_new (THUNAR_TYPE_SIMPLE_JOB, NULL);
+  simple_job->func = func;
+  simple_job->param_values = g_array_sized_new (FALSE, TRUE, sizeof (GValue), n_param_values);
+
+  /* collect the parameters */
+  for (n = 0; n < n_param_values; ++n)
+    {
+      /* initialize the value to hold the next parameter */
+      g_value_init (&value, va_arg (var_args, GType));
+
+      /* collect the value from the stack */
+      G_VALUE_COLLECT (&value, var_args, 0, &error_message);
+
+      /* check if an error occurred */
+      if (G_UNLIKELY (error_message != NULL))
+        {
+          g_error ("%s: %s", G_STRLOC, error_message);
+          g_free (error_message);
+        }
+
+      g_array_insert_val (simple_job->param_values, n, value);
+
+      /* manually unset the value, g_value_unset doesn't work
+       * because we don't want to free the data */
+      memset (&value, 0, sizeof (GValue));
+    }
+
+  return THUNAR_JOB (simple_job);
+}
+
+
+
 /**
  * thunar_simple_job_launch:
  * @func           : the #ThunarSimpleJobFunc to execute the job.
@@ -171,44 +214,47 @@ thunar_simple_job_launch (ThunarSimpleJobFunc func,
                           guint               n_param_values,
                           ...)
 {
-  ThunarSimpleJob *simple_job;
-  va_list          var_args;
-  GValue           value = { 0, };
-  gchar           *error_message;
-  guint            n;
+  ThunarJob *job;
+  va_list    var_args;
 
-  /* allocate and initialize the simple job */
-  simple_job = g_object_new (THUNAR_TYPE_SIMPLE_JOB, NULL);
-  simple_job->func = func;
-  simple_job->param_values = g_array_sized_new (FALSE, TRUE, sizeof (GValue), n_param_values);
-
-  /* collect the parameters */
   va_start (var_args, n_param_values);
-  for (n = 0; n < n_param_values; ++n)
-    {
-      /* initialize the value to hold the next parameter */
-      g_value_init (&value, va_arg (var_args, GType));
+  job = thunar_simple_job_new_valist (func, n_param_values, var_args);
+  va_end (var_args);
 
-      /* collect the value from the stack */
-      G_VALUE_COLLECT (&value, var_args, 0, &error_message);
+  /* launch the job */
+  return THUNAR_JOB (exo_job_launch (EXO_JOB (job)));
+}
 
-      /* check if an error occurred */
-      if (G_UNLIKELY (error_message != NULL))
-        {
-          g_error ("%s: %s", G_STRLOC, error_message);
-          g_free (error_message);
-        }
 
-      g_array_insert_val (simple_job->param_values, n, value);
 
-      /* manually unset the value, g_value_unset doesn't work
-       * because we don't want to free the data */
-      memset (&value, 0, sizeof (GValue));
-    }
+/**
+ * thunar_simple_job_new:
+ * @func           : the #ThunarSimpleJobFunc to execute the job.
+ * @n_param_values : the number of parameters to pass to the @func.
+ * @...            : a list of #GType and parameter pairs (exactly
+ *                   @n_param_values pairs) that are passed to @func.
+ *
+ * Like thunar_simple_job_launch(), but leaves it up to the caller
+ * to launch the job, e.g. with thunar_job_scheduler_launch().
+ *
+ * The caller is responsible to release the returned object using
+ * g_object_unref() when no longer needed.
+ *
+ * Return value: the newly allocated #ThunarJob.
+ **/
+ThunarJob *
+thunar_simple_job_new (ThunarSimpleJobFunc func,
+                       guint               n_param_values,
+                       ...)
+{
+  ThunarJob *job;
+  va_list    var_args;
+
+  va_start (var_args, n_param_values);
+  job = thunar_simple_job_new_valist (func, n_param_values, var_args);
   va_end (var_args);
 
-  /* launch the job */
-  return THUNAR_JOB (exo_job_launch (EXO_JOB (simple_job)));
+  return job;
 }
 
 
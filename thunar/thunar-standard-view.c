@@ -72,6 +72,7 @@ enum
   PROP_CURRENT_DIRECTORY,
   PROP_LOADING,
   PROP_DISPLAY_NAME,
+  PROP_FILTER_TEXT,
   PROP_TOOLTIP_TEXT,
   PROP_SELECTED_FILES,
   PROP_SHOW_HIDDEN,
@@ -165,6 +166,7 @@ static ThunarFile          *thunar_standard_view_get_drop_file              (Thu
 static void                 thunar_standard_view_merge_custom_actions       (ThunarStandardView       *standard_view,
                                                                              GList                    *selected_items);
 static void                 thunar_standard_view_update_statusbar_text      (ThunarStandardView       *standard_view);
+static void                 thunar_standard_view_filter_changed             (ThunarStandardView       *standard_view);
 static void                 thunar_standard_view_current_directory_destroy  (ThunarFile               *current_directory,
                                                                              ThunarStandardView       *standard_view);
 static void                 thunar_standard_view_current_directory_changed  (ThunarFile               *current_directory,
@@ -518,6 +520,19 @@ thunar_standard_view_class_init (ThunarStandardViewClass *klass)
                            NULL,
                            EXO_PARAM_READABLE);
 
+  /**
+   * ThunarStandardView:filter-text:
+   *
+   * Only files whose name contains this text are displayed
+   * by the view, or all files if %NULL or empty.
+   **/
+  standard_view_props[PROP_FILTER_TEXT] =
+      g_param_spec_string ("filter-text",
+                           "filter-text",
+                           "filter-text",
+                           NULL,
+                           EXO_PARAM_READWRITE);
+
   /**
    * ThunarStandardView:parse-name:
    *
@@ -747,6 +762,9 @@ thunar_standard_view_init (ThunarStandardView *standard_view)
   /* be sure to update the statusbar text whenever the file-size-binary property changes */
   g_signal_connect_swapped (G_OBJECT (standard_view->model), "notify::file-size-binary", G_CALLBACK (thunar_standard_view_update_statusbar_text), standard_view);
 
+  /* the model resets the filter whenever the folder changes */
+  g_signal_connect_swapped (G_OBJECT (standard_view->model), "notify::filter", G_CALLBACK (thunar_standard_view_filter_changed), standard_view);
+
   /* connect to size allocation signals for generating thumbnail requests */
   g_signal_connect_after (G_OBJECT (standard_view), "size-allocate",
                           G_CALLBACK (thunar_standard_view_size_allocate), NULL);
@@ -957,7 +975,8 @@ thunar_standard_view_get_property (GObject    *object,
                                    GValue     *value,
                                    GParamSpec *pspec)
 {
-  ThunarFile *current_directory;
+  ThunarFile  *current_directory;
+  const gchar *filter_text;
 
   switch (prop_id)
     {
@@ -975,6 +994,12 @@ thunar_standard_view_get_property (GObject    *object,
         g_value_set_static_string (value, thunar_file_get_display_name (current_directory));
       break;
 
+    case PROP_FILTER_TEXT:
+      /* never NULL, so it can be bound to the text of an entry */
+      filter_text = thunar_list_model_get_filter (THUNAR_STANDARD_VIEW (object)->model);
+      g_value_set_string (value, (filter_text != NULL) ? filter_text : "");
+      break;
+
     case PROP_TOOLTIP_TEXT:
       current_directory = thunar_navigator_get_current_directory (THUNAR_NAVIGATOR (object));
       if (current_directory != NULL)
@@ -1027,6 +1052,10 @@ thunar_standard_view_set_property (GObject      *object,
       thunar_standard_view_set_loading (standard_view, g_value_get_boolean (value));
       break;
 
+    case PROP_FILTER_TEXT:
+      thunar_list_model_set_filter (standard_view->model, g_value_get_string (value));
+      break;
+
     case PROP_SELECTED_FILES:
       thunar_component_set_selected_files (THUNAR_COMPONENT (object), g_value_get_boxed (value));
       break;
@@ -1689,7 +1718,105 @@ static void
 thunar_standard_view_set_show_hidden (ThunarView *view,
                                       gboolean    show_hidden)
 {
-  thunar_list_model_set_show_hidden (THUNAR_STANDARD_VIEW (view)->model, show_hidden);
+  ThunarStandardView *standard_view = THUNAR_STANDARD_VIEW (view);
+  GtkAdjustment      *vadjustment;
+  GtkTreePath        *start_path;
+  GtkTreePath        *end_path;
+  GtkTreePath        *path;
+  GtkTreeIter         iter;
+  ThunarFile         *first_file = NULL;
+  ThunarFile         *cursor_file = NULL;
+  ThunarFile         *file;
+  gdouble             value;
+  GList              *selected_files;
+  GList              *paths;
+  GList               files;
+  GList              *lp;
+
+  if (thunar_list_model_get_show_hidden (standard_view->model) == show_hidden)
+    return;
+
+  /* remember the first visible file and the file with the cursor, that
+   * are still there afterwards, the paths change with the hidden files */
+  vadjustment = gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (standard_view));
+  value = gtk_adjustment_get_value (vadjustment);
+  if ((*THUNAR_STANDARD_VIEW_GET_CLASS (standard_view)->get_visible_range) (standard_view, &start_path, &end_path))
+    {
+      for (path = start_path; first_file == NULL && gtk_tree_path_compare (path, end_path) <= 0; gtk_tree_path_next (path))
+        {
+          if (!gtk_tree_model_get_iter (GTK_TREE_MODEL (standard_view->model), &iter, path))
+            break;
+
+          file = thunar_list_model_get_file (standard_view->model, &iter);
+          if (show_hidden || !thunar_file_is_hidden (file))
+            first_file = g_object_ref (G_OBJECT (file));
+          g_object_unref (G_OBJECT (file));
+        }
+
+      gtk_tree_path_free (start_path);
+      gtk_tree_path_free (end_path);
+    }
+
+  path = (*THUNAR_STANDARD_VIEW_GET_CLASS (standard_view)->get_cursor) (standard_view);
+  if (path != NULL)
+    {
+      if (gtk_tree_model_get_iter (GTK_TREE_MODEL (standard_view->model), &iter, path))
+        {
+          cursor_file = thunar_list_model_get_file (standard_view->model, &iter);
+          if (!show_hidden && thunar_file_is_hidden (cursor_file))
+            {
+              g_object_unref (G_OBJECT (cursor_file));
+              cursor_file = NULL;
+            }
+        }
+      gtk_tree_path_free (path);
+    }
+
+  /* toggling the hidden files can insert or remove thousands of rows, so
+   * we temporarily disconnect the model from the view, which rebuilds its
+   * rows in a single pass once reconnected, instead of handling a signal
+   * for every single row. Detaching clears the selection, so restore it.
+   */
+  selected_files = thunar_g_file_list_copy (standard_view->priv->selected_files);
+  g_object_set (G_OBJECT (GTK_BIN (standard_view)->child), "model", NULL, NULL);
+
+  thunar_list_model_set_show_hidden (standard_view->model, show_hidden);
+
+  g_object_set (G_OBJECT (GTK_BIN (standard_view)->child), "model", standard_view->model, NULL);
+
+  /* place the cursor first, moving it changes the selection of the details view */
+  if (cursor_file != NULL)
+    {
+      files.data = cursor_file;
+      files.next = NULL;
+      files.prev = NULL;
+
+      paths = thunar_list_model_get_paths_for_files (standard_view->model, &files);
+      if (G_LIKELY (paths != NULL))
+        (*THUNAR_STANDARD_VIEW_GET_CLASS (standard_view)->set_cursor) (standard_view, paths->data, FALSE);
+      g_list_free_full (paths, (GDestroyNotify) gtk_tree_path_free);
+
+      g_object_unref (G_OBJECT (cursor_file));
+    }
+
+  /* select the files again, without scrolling to them */
+  (*THUNAR_STANDARD_VIEW_GET_CLASS (standard_view)->unselect_all) (standard_view);
+  paths = thunar_list_model_get_paths_for_files (standard_view->model, selected_files);
+  for (lp = paths; lp != NULL; lp = lp->next)
+    (*THUNAR_STANDARD_VIEW_GET_CLASS (standard_view)->select_path) (standard_view, lp->data);
+  g_list_free_full (paths, (GDestroyNotify) gtk_tree_path_free);
+  thunar_g_file_list_free (selected_files);
+
+  /* scroll back to the first visible file, or the old position */
+  if (first_file != NULL)
+    {
+      thunar_view_scroll_to_file (view, first_file, FALSE, TRUE, 0.0f, 0.0f);
+      g_object_unref (G_OBJECT (first_file));
+    }
+  else
+    {
+      gtk_adjustment_set_value (vadjustment, value);
+    }
 }
 
 
@@ -2174,6 +2301,17 @@ thunar_standard_view_update_statusbar_text (ThunarStandardView *standard_view)
 
 
 
+static void
+thunar_standard_view_filter_changed (ThunarStandardView *standard_view)
+{
+  _thunar_return_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view));
+
+  /* tell everybody that the filter text changed */
+  g_object_notify_by_pspec (G_OBJECT (standard_view), standard_view_props[PROP_FILTER_TEXT]);
+}
+
+
+
 /*
  * Find a fallback directory we can navigate to if the directory gets
  * deleted. It first tries the parent folders, and finally if none can
@@ -4167,11 +4305,11 @@ thunar_standard_view_request_thumbnails_real (ThunarStandardView *standard_view,
 {
   GtkTreePath *start_path;
   GtkTreePath *end_path;
-  GtkTreePath *path;
   GtkTreeIter  iter;
   ThunarFile  *file;
   gboolean     valid_iter;
   GList       *visible_files = NULL;
+  gint         n_visible;
 
   _thunar_return_val_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view), FALSE);
   _thunar_return_val_if_fail (THUNAR_IS_ICON_FACTORY (standard_view->icon_factory), FALSE);
@@ -4190,32 +4328,23 @@ thunar_standard_view_request_thumbnails_real (ThunarStandardView *standard_view,
                                                                             &start_path,
                                                                             &end_path))
     {
+      /* the model is a flat list, so the number of visible items
+       * follows from the indices, which saves a path lookup per row */
+      n_visible = gtk_tree_path_get_indices (end_path)[0]
+                  - gtk_tree_path_get_indices (start_path)[0] + 1;
+
       /* iterate over the range to collect all files */
       valid_iter = gtk_tree_model_get_iter (GTK_TREE_MODEL (standard_view->model),
                                             &iter, start_path);
 
-      while (valid_iter)
+      while (valid_iter && n_visible-- > 0)
         {
           /* prepend the file to the visible items list */
           file = thunar_list_model_get_file (standard_view->model, &iter);
           visible_files = g_list_prepend (visible_files, file);
 
-          /* check if we've reached the end of the visible range */
-          path = gtk_tree_model_get_path (GTK_TREE_MODEL (standard_view->model), &iter);
-          if (gtk_tree_path_compare (path, end_path) != 0)
-            {
-              /* try to compute the next visible item */
-              valid_iter =
-                gtk_tree_model_iter_next (GTK_TREE_MODEL (standard_view->model), &iter);
-            }
-          else
-            {
-              /* we have reached the end, terminate the loop */
-              valid_iter = FALSE;
-            }
-
-          /* release the tree path */
-          gtk_tree_path_free (path);
+          /* try to compute the next visible item */
+          valid_iter = gtk_tree_model_iter_next (GTK_TREE_MODEL (standard_view->model), &iter);
         }
 
       /* queue a thumbnail request */
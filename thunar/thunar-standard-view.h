@@ -78,6 +78,11 @@ struct _ThunarStandardViewClass
                                          GtkTreePath        *path,
                                          gboolean            start_editing);
 
+  /* Returns the path of the item/row with the cursor or NULL if
+   * there's no cursor. The path is freed by the caller.
+   */
+  GtkTreePath *(*get_cursor)            (ThunarStandardView *standard_view);
+
   /* Called by the ThunarStandardView class to let derived class
    * scroll the view to the given path.
    */
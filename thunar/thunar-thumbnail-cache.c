@@ -31,6 +31,7 @@
 
 #include <glib.h>
 #include <glib-object.h>
+#include <glib/gstdio.h>
 #include <gio/gio.h>
 
 #include <thunar/thunar-private.h>
@@ -45,9 +46,51 @@
 #define _thumbnail_cache_unlock(cache) g_mutex_unlock ((cache)->lock)
 #endif
 
+/* time requests are collected before they are sent to the cache service */
+#define THUNAR_THUMBNAIL_CACHE_WINDOW (500) /* ms */
 
+/* number of queued requests that are sent right away */
+#define THUNAR_THUMBNAIL_CACHE_MAX_BATCH (1000)
 
-static void thunar_thumbnail_cache_finalize (GObject *object);
+
+
+static void thunar_thumbnail_cache_finalize    (GObject *object);
+static void thunar_thumbnail_cache_disk_update (GFile   *source_file,
+                                                GFile   *target_file);
+
+
+
+#ifdef HAVE_DBUS
+typedef enum
+{
+  THUNAR_THUMBNAIL_CACHE_MOVE = 1,
+  THUNAR_THUMBNAIL_CACHE_COPY,
+  THUNAR_THUMBNAIL_CACHE_DELETE,
+  THUNAR_THUMBNAIL_CACHE_CLEANUP,
+} ThunarThumbnailCacheKind;
+
+/* The requests collected during the batching window. A batch is sent
+ * as one request per kind, so a file may only appear in the queue of
+ * a single kind, otherwise the batch is closed and a new one started.
+ */
+typedef struct
+{
+  /* moves and copies use the same index in the source and target array */
+  GPtrArray  *move_sources;
+  GPtrArray  *move_targets;
+  GPtrArray  *copy_sources;
+  GPtrArray  *copy_targets;
+  GPtrArray  *delete_queue;
+  GPtrArray  *cleanup_queue;
+
+  /* the queued move targets and deleted files, to merge requests */
+  GHashTable *move_index;
+  GHashTable *delete_index;
+
+  /* the kind of the requests each queued file belongs to */
+  GHashTable *kind_index;
+} ThunarThumbnailCacheBatch;
+#endif
 
 
 
@@ -58,39 +101,68 @@ struct _ThunarThumbnailCacheClass
 
 struct _ThunarThumbnailCache
 {
-  GObject     __parent__;
+  GObject                    __parent__;
 
 #ifdef HAVE_DBUS
-  DBusGProxy *cache_proxy;
+  DBusGProxy                *cache_proxy;
 
-  GList      *move_source_queue;
-  GList      *move_target_queue;
-  guint       move_queue_idle_id;
+  /* set once the cache service turned out to be missing */
+  gint                       service_missing;
 
-  GList      *copy_source_queue;
-  GList      *copy_target_queue;
-  guint       copy_queue_idle_id;
+  /* the batch collecting requests, and the batches closed
+   * before it, which are sent first */
+  ThunarThumbnailCacheBatch *batch;
+  GQueue                     closed_batches;
 
-  GList      *delete_queue;
-  guint       delete_queue_idle_id;
-
-  GList      *cleanup_queue;
-  guint       cleanup_queue_idle_id;
+  guint                      n_queued;
+  guint                      flush_id;
+  guint                      flush_idle : 1;
 
 #if GLIB_CHECK_VERSION (2, 32, 0)
-  GMutex      lock;
+  GMutex                     lock;
 #else
-  GMutex     *lock;
+  GMutex                    *lock;
 #endif
 #endif
 };
 
+#ifdef HAVE_DBUS
+typedef struct
+{
+  ThunarThumbnailCache *cache;
+  GPtrArray            *target_files;
+} ThunarThumbnailCacheReply;
+#endif
+
 
 
 G_DEFINE_TYPE (ThunarThumbnailCache, thunar_thumbnail_cache, G_TYPE_OBJECT)
 
 
 
+#ifdef HAVE_DBUS
+static ThunarThumbnailCacheBatch *
+thunar_thumbnail_cache_batch_new (void)
+{
+  ThunarThumbnailCacheBatch *batch;
+
+  batch = g_slice_new (ThunarThumbnailCacheBatch);
+  batch->move_sources = g_ptr_array_new ();
+  batch->move_targets = g_ptr_array_new ();
+  batch->copy_sources = g_ptr_array_new ();
+  batch->copy_targets = g_ptr_array_new ();
+  batch->delete_queue = g_ptr_array_new ();
+  batch->cleanup_queue = g_ptr_array_new ();
+  batch->move_index = g_hash_table_new (g_file_hash, (GEqualFunc) g_file_equal);
+  batch->delete_index = g_hash_table_new (g_file_hash, (GEqualFunc) g_file_equal);
+  batch->kind_index = g_hash_table_new_full (g_file_hash, (GEqualFunc) g_file_equal, g_object_unref, NULL);
+
+  return batch;
+}
+#endif
+
+
+
 static void
 thunar_thumbnail_cache_class_init (ThunarThumbnailCacheClass *klass)
 {
@@ -126,6 +198,10 @@ thunar_thumbnail_cache_init (ThunarThumbnailCache *cache)
       dbus_g_connection_unref (connection);
     }
 
+  /* allocate the batch for the first requests */
+  cache->batch = thunar_thumbnail_cache_batch_new ();
+  g_queue_init (&cache->closed_batches);
+
 /* create a new mutex for accessing the cache from different threads */
 #if GLIB_CHECK_VERSION (2, 32, 0)
   g_mutex_init (&cache->lock);
@@ -137,6 +213,48 @@ thunar_thumbnail_cache_init (ThunarThumbnailCache *cache)
 
 
 
+#ifdef HAVE_DBUS
+static void
+thunar_thumbnail_cache_queue_free (GPtrArray *queue)
+{
+  guint n;
+
+  /* files of merged requests are NULL */
+  for (n = 0; n < queue->len; ++n)
+    if (g_ptr_array_index (queue, n) != NULL)
+      g_object_unref (g_ptr_array_index (queue, n));
+
+  g_ptr_array_free (queue, TRUE);
+}
+
+
+
+static void
+thunar_thumbnail_cache_batch_free_index (ThunarThumbnailCacheBatch *batch)
+{
+  g_hash_table_destroy (batch->move_index);
+  g_hash_table_destroy (batch->delete_index);
+  g_hash_table_destroy (batch->kind_index);
+  g_slice_free (ThunarThumbnailCacheBatch, batch);
+}
+
+
+
+static void
+thunar_thumbnail_cache_batch_free (ThunarThumbnailCacheBatch *batch)
+{
+  thunar_thumbnail_cache_queue_free (batch->move_sources);
+  thunar_thumbnail_cache_queue_free (batch->move_targets);
+  thunar_thumbnail_cache_queue_free (batch->copy_sources);
+  thunar_thumbnail_cache_queue_free (batch->copy_targets);
+  thunar_thumbnail_cache_queue_free (batch->delete_queue);
+  thunar_thumbnail_cache_queue_free (batch->cleanup_queue);
+  thunar_thumbnail_cache_batch_free_index (batch);
+}
+#endif
+
+
+
 static void
 thunar_thumbnail_cache_finalize (GObject *object)
 {
@@ -146,27 +264,14 @@ thunar_thumbnail_cache_finalize (GObject *object)
   /* acquire a cache lock */
   _thumbnail_cache_lock (cache);
 
-  /* drop the move queue idle and all queued files */
-  if (cache->move_queue_idle_id > 0)
-    g_source_remove (cache->move_queue_idle_id);
-  g_list_free_full (cache->move_source_queue, g_object_unref);
-  g_list_free_full (cache->move_target_queue, g_object_unref);
+  /* drop the pending flush */
+  if (cache->flush_id > 0)
+    g_source_remove (cache->flush_id);
 
-  /* drop the copy queue idle and all queued files */
-  if (cache->copy_queue_idle_id > 0)
-    g_source_remove (cache->copy_queue_idle_id);
-  g_list_free_full (cache->copy_source_queue, g_object_unref);
-  g_list_free_full (cache->copy_target_queue, g_object_unref);
-
-  /* drop the delete queue idle and all queued files */
-  if (cache->delete_queue_idle_id > 0)
-    g_source_remove (cache->delete_queue_idle_id);
-  g_list_free_full (cache->delete_queue, g_object_unref);
-
-  /* drop the cleanup queue idle and all queued files */
-  if (cache->cleanup_queue_idle_id > 0)
-    g_source_remove (cache->cleanup_queue_idle_id);
-  g_list_free_full (cache->cleanup_queue, g_object_unref);
+  /* drop all queued files */
+  g_queue_foreach (&cache->closed_batches, (GFunc) thunar_thumbnail_cache_batch_free, NULL);
+  g_queue_clear (&cache->closed_batches);
+  thunar_thumbnail_cache_batch_free (cache->batch);
 
   /* check if we have a valid cache proxy */
   if (cache->cache_proxy != NULL)
@@ -188,355 +293,417 @@ thunar_thumbnail_cache_finalize (GObject *object)
 
 
 
-#ifdef HAVE_DBUS
 static void
-thunar_thumbnail_cache_move_copy_async_reply (DBusGProxy *proxy,
-                                              GError     *error,
-                                              gpointer    user_data)
+thunar_thumbnail_cache_disk_update (GFile *source_file,
+                                    GFile *target_file)
 {
-  GList      *li;
-  ThunarFile *file;
-
-  _thunar_return_if_fail (DBUS_IS_G_PROXY (proxy));
-
-  for (li = user_data; li != NULL; li = li->next)
+  static const gchar *sizes[] = { "normal", "large" };
+  gchar              *source_name;
+  gchar              *target_name = NULL;
+  gchar              *source_path;
+  gchar              *target_path;
+  gchar              *dirs[2];
+  gchar              *uri;
+  guint               n;
+  guint               i;
+
+  /* the thumbnail names are the MD5 hashes of the URIs */
+  uri = g_file_get_uri (source_file);
+  source_name = g_compute_checksum_for_string (G_CHECKSUM_MD5, uri, -1);
+  g_free (uri);
+
+  if (target_file != NULL)
     {
-      file = thunar_file_cache_lookup (G_FILE (li->data));
-      g_object_unref (G_OBJECT (li->data));
-
-      if (G_LIKELY (file != NULL))
-        {
-          /* if visible, let the view know there might be a thumb */
-          thunar_file_changed (file);
-          g_object_unref (file);
-        }
+      uri = g_file_get_uri (target_file);
+      target_name = g_compute_checksum_for_string (G_CHECKSUM_MD5, uri, -1);
+      g_free (uri);
     }
 
-  g_list_free (user_data);
+  /* both the current and the old location of the thumbnails,
+   * see thunar_file_get_thumbnail_path() */
+  dirs[0] = g_build_filename (g_get_user_cache_dir (), "thumbnails", NULL);
+  dirs[1] = g_build_filename (g_get_home_dir (), ".thumbnails", NULL);
+
+  for (n = 0; n < G_N_ELEMENTS (dirs); ++n)
+    for (i = 0; i < G_N_ELEMENTS (sizes); ++i)
+      {
+        source_path = g_strdup_printf ("%s/%s/%s.png", dirs[n], sizes[i], source_name);
+
+        /* rename or delete the thumbnail, it is fine if there is none */
+        if (target_name != NULL)
+          {
+            target_path = g_strdup_printf ("%s/%s/%s.png", dirs[n], sizes[i], target_name);
+            g_rename (source_path, target_path);
+            g_free (target_path);
+          }
+        else
+          {
+            g_unlink (source_path);
+          }
+
+        g_free (source_path);
+      }
+
+  g_free (dirs[0]);
+  g_free (dirs[1]);
+  g_free (source_name);
+  g_free (target_name);
 }
 
 
 
-static void
-thunar_thumbnail_cache_move_async (ThunarThumbnailCache *cache,
-                                   const gchar         **source_uris,
-                                   const gchar         **target_uris,
-                                   gpointer              user_data)
+#ifdef HAVE_DBUS
+static gboolean
+thunar_thumbnail_cache_has_service (ThunarThumbnailCache *cache)
 {
-  _thunar_return_if_fail (THUNAR_IS_THUMBNAIL_CACHE (cache));
-  _thunar_return_if_fail (source_uris != NULL);
-  _thunar_return_if_fail (target_uris != NULL);
-
-  /* request a thumbnail cache update asynchronously */
-  thunar_thumbnail_cache_proxy_move_async (cache->cache_proxy,
-                                           source_uris, target_uris,
-                                           thunar_thumbnail_cache_move_copy_async_reply,
-                                           user_data);
+  return (cache->cache_proxy != NULL
+          && !g_atomic_int_get (&cache->service_missing));
 }
 
 
 
 static void
-thunar_thumbnail_cache_copy_async (ThunarThumbnailCache *cache,
-                                   const gchar         **source_uris,
-                                   const gchar         **target_uris,
-                                   gpointer              user_data)
+thunar_thumbnail_cache_check_reply (ThunarThumbnailCache *cache,
+                                    GError               *error)
 {
-  _thunar_return_if_fail (THUNAR_IS_THUMBNAIL_CACHE (cache));
-  _thunar_return_if_fail (source_uris != NULL);
-  _thunar_return_if_fail (target_uris != NULL);
-
-  /* request a thumbnail cache update asynchronously */
-  thunar_thumbnail_cache_proxy_copy_async (cache->cache_proxy,
-                                           source_uris, target_uris,
-                                           thunar_thumbnail_cache_move_copy_async_reply,
-                                           user_data);
+  /* handle the thumbnails ourselves if nobody provides the service */
+  if (error != NULL
+      && (g_error_matches (error, DBUS_GERROR, DBUS_GERROR_SERVICE_UNKNOWN)
+          || g_error_matches (error, DBUS_GERROR, DBUS_GERROR_NAME_HAS_NO_OWNER)))
+    g_atomic_int_set (&cache->service_missing, TRUE);
 }
 
 
 
 static void
-thunar_thumbnail_cache_delete_async_reply (DBusGProxy *proxy,
-                                           GError     *error,
-                                           gpointer    user_data)
+thunar_thumbnail_cache_move_copy_async_reply (DBusGProxy *proxy,
+                                              GError     *error,
+                                              gpointer    user_data)
 {
-  _thunar_return_if_fail (DBUS_IS_G_PROXY (proxy));
-}
+  ThunarThumbnailCacheReply *reply = user_data;
+  ThunarFile                *file;
+  guint                      n;
 
+  _thunar_return_if_fail (DBUS_IS_G_PROXY (proxy));
 
+  thunar_thumbnail_cache_check_reply (reply->cache, error);
 
-static void
-thunar_thumbnail_cache_delete_async (ThunarThumbnailCache *cache,
-                                     const gchar         **uris)
-{
-  _thunar_return_if_fail (THUNAR_IS_THUMBNAIL_CACHE (cache));
-  _thunar_return_if_fail (uris != NULL);
+  for (n = 0; n < reply->target_files->len; ++n)
+    {
+      file = thunar_file_cache_lookup (g_ptr_array_index (reply->target_files, n));
+      if (G_LIKELY (file != NULL))
+        {
+          /* if visible, let the view know there might be a thumb */
+          thunar_file_changed (file);
+          g_object_unref (file);
+        }
+    }
 
-  /* request a thumbnail cache update asynchronously */
-  thunar_thumbnail_cache_proxy_delete_async (cache->cache_proxy, uris,
-                                             thunar_thumbnail_cache_delete_async_reply,
-                                             NULL);
+  thunar_thumbnail_cache_queue_free (reply->target_files);
+  g_object_unref (reply->cache);
+  g_slice_free (ThunarThumbnailCacheReply, reply);
 }
 
 
 
 static void
-thunar_thumbnail_cache_cleanup_async_reply (DBusGProxy *proxy,
-                                            GError     *error,
-                                            gpointer    user_data)
+thunar_thumbnail_cache_async_reply (DBusGProxy *proxy,
+                                    GError     *error,
+                                    gpointer    user_data)
 {
   _thunar_return_if_fail (DBUS_IS_G_PROXY (proxy));
+
+  thunar_thumbnail_cache_check_reply (user_data, error);
+  g_object_unref (user_data);
 }
 
 
 
-static void
-thunar_thumbnail_cache_cleanup_async (ThunarThumbnailCache *cache,
-                                      const gchar *const    *base_uris)
+static gchar **
+thunar_thumbnail_cache_queue_to_uris (GPtrArray *queue,
+                                      GPtrArray *other_queue,
+                                      gchar   ***other_uris,
+                                      GPtrArray *other_files)
 {
-  _thunar_return_if_fail (THUNAR_IS_THUMBNAIL_CACHE (cache));
-  _thunar_return_if_fail (base_uris != NULL);
+  gchar **uris;
+  guint   n;
+  guint   i;
 
-  /* request a thumbnail cache update asynchronously */
-  thunar_thumbnail_cache_proxy_cleanup_async (cache->cache_proxy,
-                                              (const gchar **)base_uris, 0,
-                                              thunar_thumbnail_cache_cleanup_async_reply,
-                                              NULL);
-}
+  uris = g_new (gchar *, queue->len + 1);
+  if (other_queue != NULL)
+    *other_uris = g_new (gchar *, queue->len + 1);
 
+  /* skip the requests that were merged with later ones */
+  for (n = i = 0; n < queue->len; ++n)
+    {
+      if (g_ptr_array_index (queue, n) == NULL)
+        continue;
 
+      uris[i] = g_file_get_uri (g_ptr_array_index (queue, n));
+      g_object_unref (g_ptr_array_index (queue, n));
 
-static gboolean
-thunar_thumbnail_cache_process_queue (ThunarThumbnailCache *cache,
-                                      gboolean              copy_async)
-{
-  GList  *sp;
-  GList  *tp;
-  gchar **source_uris;
-  gchar **target_uris;
-  guint   n_uris;
-  guint   n;
-  GList  *source_queue;
-  GList  *target_queue;
+      if (other_queue != NULL)
+        {
+          (*other_uris)[i] = g_file_get_uri (g_ptr_array_index (other_queue, n));
+
+          /* the targets are needed again in the reply */
+          g_ptr_array_add (other_files, g_ptr_array_index (other_queue, n));
+        }
+
+      ++i;
+    }
+
+  uris[i] = NULL;
+  if (other_queue != NULL)
+    (*other_uris)[i] = NULL;
+
+  g_ptr_array_free (queue, TRUE);
+  if (other_queue != NULL)
+    g_ptr_array_free (other_queue, TRUE);
+
+  return uris;
+}
 
-  _thunar_return_val_if_fail (THUNAR_IS_THUMBNAIL_CACHE (cache), FALSE);
 
-  /* acquire a cache lock */
-  _thumbnail_cache_lock (cache);
 
-  /* steal the lists */
-  if (copy_async)
+static void
+thunar_thumbnail_cache_batch_send (ThunarThumbnailCache      *cache,
+                                   ThunarThumbnailCacheBatch *batch)
+{
+  ThunarThumbnailCacheReply *reply;
+  gchar                    **source_uris;
+  gchar                    **target_uris;
+
+  /* send one request per queue, no file is in more than one queue */
+  if (batch->move_sources->len > 0)
     {
-      source_queue = cache->copy_source_queue;
-      cache->copy_source_queue = NULL;
-      target_queue = cache->copy_target_queue;
-      cache->copy_target_queue = NULL;
+      reply = g_slice_new (ThunarThumbnailCacheReply);
+      reply->cache = g_object_ref (cache);
+      reply->target_files = g_ptr_array_sized_new (batch->move_targets->len);
+      source_uris = thunar_thumbnail_cache_queue_to_uris (batch->move_sources, batch->move_targets,
+                                                          &target_uris, reply->target_files);
+      thunar_thumbnail_cache_proxy_move_async (cache->cache_proxy,
+                                               (const gchar **) source_uris,
+                                               (const gchar **) target_uris,
+                                               thunar_thumbnail_cache_move_copy_async_reply,
+                                               reply);
+      g_strfreev (source_uris);
+      g_strfreev (target_uris);
     }
   else
     {
-      source_queue = cache->move_source_queue;
-      cache->move_source_queue = NULL;
-      target_queue = cache->move_target_queue;
-      cache->move_target_queue = NULL;
+      g_ptr_array_free (batch->move_sources, TRUE);
+      g_ptr_array_free (batch->move_targets, TRUE);
     }
 
-  /* compute how many URIs there are */
-  n_uris = g_list_length (source_queue);
-
-  /* allocate a string array for the URIs */
-  source_uris = g_new0 (gchar *, n_uris + 1);
-  target_uris = g_new0 (gchar *, n_uris + 1);
-
-  /* fill URI array with file URIs from the move queue */
-  for (n = 0,
-       sp = g_list_last (source_queue),
-       tp = g_list_last (target_queue);
-       sp != NULL && tp != NULL;
-       sp = sp->prev, tp = tp->prev, ++n)
+  if (batch->copy_sources->len > 0)
     {
-      source_uris[n] = g_file_get_uri (sp->data);
-      target_uris[n] = g_file_get_uri (tp->data);
-
-      /* release the source object */
-      g_object_unref (sp->data);
+      reply = g_slice_new (ThunarThumbnailCacheReply);
+      reply->cache = g_object_ref (cache);
+      reply->target_files = g_ptr_array_sized_new (batch->copy_targets->len);
+      source_uris = thunar_thumbnail_cache_queue_to_uris (batch->copy_sources, batch->copy_targets,
+                                                          &target_uris, reply->target_files);
+      thunar_thumbnail_cache_proxy_copy_async (cache->cache_proxy,
+                                               (const gchar **) source_uris,
+                                               (const gchar **) target_uris,
+                                               thunar_thumbnail_cache_move_copy_async_reply,
+                                               reply);
+      g_strfreev (source_uris);
+      g_strfreev (target_uris);
+    }
+  else
+    {
+      g_ptr_array_free (batch->copy_sources, TRUE);
+      g_ptr_array_free (batch->copy_targets, TRUE);
     }
 
-  /* NULL-terminate the URI arrays */
-  source_uris[n] = NULL;
-  target_uris[n] = NULL;
-
-  if (copy_async)
+  if (batch->delete_queue->len > 0)
     {
-      /* asynchronously copy the thumbnails */
-      thunar_thumbnail_cache_copy_async (cache,
-                                         (const gchar **)source_uris,
-                                         (const gchar **)target_uris,
-                                         target_queue);
+      source_uris = thunar_thumbnail_cache_queue_to_uris (batch->delete_queue, NULL, NULL, NULL);
+      thunar_thumbnail_cache_proxy_delete_async (cache->cache_proxy,
+                                                 (const gchar **) source_uris,
+                                                 thunar_thumbnail_cache_async_reply,
+                                                 g_object_ref (cache));
+      g_strfreev (source_uris);
     }
   else
     {
-      /* asynchronously move the thumbnails */
-      thunar_thumbnail_cache_move_async (cache,
-                                         (const gchar **)source_uris,
-                                         (const gchar **)target_uris,
-                                         target_queue);
+      g_ptr_array_free (batch->delete_queue, TRUE);
     }
 
-  /* free the URI arrays */
-  g_strfreev (source_uris);
-  g_strfreev (target_uris);
-
-  /* release the move queue lists */
-  g_list_free (source_queue);
-
-  /* release the cache lock */
-  _thumbnail_cache_unlock (cache);
+  if (batch->cleanup_queue->len > 0)
+    {
+      source_uris = thunar_thumbnail_cache_queue_to_uris (batch->cleanup_queue, NULL, NULL, NULL);
+      thunar_thumbnail_cache_proxy_cleanup_async (cache->cache_proxy,
+                                                  (const gchar **) source_uris, 0,
+                                                  thunar_thumbnail_cache_async_reply,
+                                                  g_object_ref (cache));
+      g_strfreev (source_uris);
+    }
+  else
+    {
+      g_ptr_array_free (batch->cleanup_queue, TRUE);
+    }
 
-  return FALSE;
+  /* the queues were released while converting them */
+  thunar_thumbnail_cache_batch_free_index (batch);
 }
 
 
 
 static gboolean
-thunar_thumbnail_cache_process_move_queue (gpointer user_data)
+thunar_thumbnail_cache_flush (gpointer user_data)
 {
-  return thunar_thumbnail_cache_process_queue (user_data, FALSE);
-}
+  ThunarThumbnailCache *cache = THUNAR_THUMBNAIL_CACHE (user_data);
+  GQueue                batches;
 
+  /* acquire a cache lock */
+  _thumbnail_cache_lock (cache);
 
+  /* steal the batches, the requests are sent without holding the lock */
+  batches = cache->closed_batches;
+  g_queue_init (&cache->closed_batches);
+  g_queue_push_tail (&batches, cache->batch);
+  cache->batch = thunar_thumbnail_cache_batch_new ();
 
-static void
-thunar_thumbnail_cache_process_move_queue_destroy (gpointer user_data)
-{
-  THUNAR_THUMBNAIL_CACHE (user_data)->move_queue_idle_id = 0;
-}
+  cache->n_queued = 0;
+  cache->flush_id = 0;
+  cache->flush_idle = FALSE;
 
+  /* release the cache lock */
+  _thumbnail_cache_unlock (cache);
 
+  /* D-Bus delivers the requests in order, so the batches are applied
+   * in the order the operations happened */
+  while (!g_queue_is_empty (&batches))
+    thunar_thumbnail_cache_batch_send (cache, g_queue_pop_head (&batches));
 
-static gboolean
-thunar_thumbnail_cache_process_copy_queue (gpointer user_data)
-{
-  return thunar_thumbnail_cache_process_queue (user_data, TRUE);
+  return FALSE;
 }
 
 
 
 static void
-thunar_thumbnail_cache_process_copy_queue_destroy (gpointer user_data)
-{
-  THUNAR_THUMBNAIL_CACHE (user_data)->copy_queue_idle_id = 0;
-}
-
-
-
-static gboolean
-thunar_thumbnail_cache_process_delete_queue (ThunarThumbnailCache *cache)
+thunar_thumbnail_cache_claim (ThunarThumbnailCache     *cache,
+                              GFile                    *file,
+                              ThunarThumbnailCacheKind  kind)
 {
-  GList  *lp;
-  gchar **uris;
-  guint   n_uris;
-  guint   n;
-
-  _thunar_return_val_if_fail (THUNAR_IS_THUMBNAIL_CACHE (cache), FALSE);
-
-  /* acquire a cache lock */
-  _thumbnail_cache_lock (cache);
-
-  /* compute how many URIs there are */
-  n_uris = g_list_length (cache->delete_queue);
+  ThunarThumbnailCacheBatch *batch = cache->batch;
+  ThunarThumbnailCacheKind   queued_kind;
 
-  /* allocate a string array for the URIs */
-  uris = g_new0 (gchar *, n_uris + 1);
+  /* the caller holds the cache lock */
+  queued_kind = GPOINTER_TO_UINT (g_hash_table_lookup (batch->kind_index, file));
+  if (queued_kind == kind)
+    return;
 
-  /* fill URI array with file URIs from the delete queue */
-  for (lp = g_list_last (cache->delete_queue), n = 0; lp != NULL; lp = lp->prev, ++n)
+  if (queued_kind != 0)
     {
-      uris[n] = g_file_get_uri (lp->data);
-
-      /* release the file object */
-      g_object_unref (lp->data);
+      /* the file is already queued for another kind of request, which
+       * is sent in a different order, so close the batch to keep the
+       * requests for the file in order */
+      g_queue_push_tail (&cache->closed_batches, batch);
+      batch = cache->batch = thunar_thumbnail_cache_batch_new ();
     }
 
-  /* NULL-terminate the URI array */
-  uris[n] = NULL;
-
-  /* asynchronously delete the thumbnails */
-  thunar_thumbnail_cache_delete_async (cache, (const gchar **)uris);
+  g_hash_table_insert (batch->kind_index, g_object_ref (file), GUINT_TO_POINTER (kind));
+}
 
-  /* free the URI array */
-  g_strfreev (uris);
 
-  /* release the delete queue list */
-  g_list_free (cache->delete_queue);
-  cache->delete_queue = NULL;
 
-  /* reset the delete queue idle ID */
-  cache->delete_queue_idle_id = 0;
+static void
+thunar_thumbnail_cache_schedule_flush (ThunarThumbnailCache *cache)
+{
+  /* the caller holds the cache lock */
+  cache->n_queued++;
 
-  /* release the cache lock */
-  _thumbnail_cache_unlock (cache);
+  if (cache->n_queued >= THUNAR_THUMBNAIL_CACHE_MAX_BATCH)
+    {
+      /* the batch is full, send it as soon as the main loop is idle */
+      if (!cache->flush_idle)
+        {
+          if (cache->flush_id > 0)
+            g_source_remove (cache->flush_id);
 
-  return FALSE;
+          cache->flush_id = g_idle_add_full (G_PRIORITY_DEFAULT_IDLE, thunar_thumbnail_cache_flush,
+                                             cache, NULL);
+          cache->flush_idle = TRUE;
+        }
+    }
+  else if (cache->flush_id == 0)
+    {
+      /* the window is not extended by later requests, so nothing
+       * waits longer than THUNAR_THUMBNAIL_CACHE_WINDOW */
+      cache->flush_id = g_timeout_add_full (G_PRIORITY_DEFAULT_IDLE, THUNAR_THUMBNAIL_CACHE_WINDOW,
+                                            thunar_thumbnail_cache_flush, cache, NULL);
+    }
 }
 
 
 
-static gboolean
-thunar_thumbnail_cache_process_cleanup_queue (ThunarThumbnailCache *cache)
+static GFile *
+thunar_thumbnail_cache_steal_move (ThunarThumbnailCache *cache,
+                                   GFile                *target_file)
 {
-  GList  *lp;
-  gchar **uris;
-  guint   n_uris;
-  guint   n;
+  ThunarThumbnailCacheBatch *batch = cache->batch;
+  gpointer                   index;
+  GFile                     *source_file;
+  guint                      n;
+
+  /* the caller holds the cache lock */
+  if (!g_hash_table_lookup_extended (batch->move_index, target_file, NULL, &index))
+    return NULL;
+
+  n = GPOINTER_TO_UINT (index);
+  g_hash_table_remove (batch->move_index, target_file);
+
+  /* take the queued move out of the batch, its files are
+   * queued again by the request it is merged into */
+  source_file = g_ptr_array_index (batch->move_sources, n);
+  g_hash_table_remove (batch->kind_index, source_file);
+  g_hash_table_remove (batch->kind_index, target_file);
+  g_object_unref (g_ptr_array_index (batch->move_targets, n));
+  g_ptr_array_index (batch->move_sources, n) = NULL;
+  g_ptr_array_index (batch->move_targets, n) = NULL;
+
+  return source_file;
+}
 
-  _thunar_return_val_if_fail (THUNAR_IS_THUMBNAIL_CACHE (cache), FALSE);
 
-  /* acquire a cache lock */
-  _thumbnail_cache_lock (cache);
 
-  /* compute how many URIs there are */
-  n_uris = g_list_length (cache->cleanup_queue);
+static void
+thunar_thumbnail_cache_queue_remove (ThunarThumbnailCache     *cache,
+                                     ThunarThumbnailCacheKind  kind,
+                                     GFile                    *file)
+{
+  GFile *source_file;
 
-  /* allocate a string array for the URIs */
-  uris = g_new0 (gchar *, n_uris + 1);
+  /* the caller holds the cache lock. if the file was moved in this
+   * batch, only the thumbnail of the source is left to handle */
+  source_file = thunar_thumbnail_cache_steal_move (cache, file);
+  if (source_file == NULL)
+    source_file = g_object_ref (file);
 
-#ifndef NDEBUG
-  g_debug ("cleanup:");
-#endif
+  /* this may start a new batch */
+  thunar_thumbnail_cache_claim (cache, source_file, kind);
 
-  /* fill URI array with file URIs from the cleanup queue */
-  for (lp = g_list_last (cache->cleanup_queue), n = 0; lp != NULL; lp = lp->prev, ++n)
+  /* the same file is only deleted once per batch */
+  if (kind == THUNAR_THUMBNAIL_CACHE_DELETE)
     {
-      uris[n] = g_file_get_uri (lp->data);
-
-#ifndef NDEBUG
-      g_debug ("  %s", uris[n]);
-#endif
+      if (g_hash_table_lookup (cache->batch->delete_index, source_file) != NULL)
+        {
+          g_object_unref (source_file);
+          return;
+        }
 
-      /* release the file object */
-      g_object_unref (lp->data);
+      g_hash_table_insert (cache->batch->delete_index, source_file, source_file);
+      g_ptr_array_add (cache->batch->delete_queue, source_file);
+    }
+  else
+    {
+      g_ptr_array_add (cache->batch->cleanup_queue, source_file);
     }
 
-  /* NULL-terminate the URI array */
-  uris[n] = NULL;
-
-  /* asynchronously cleanup the thumbnails */
-  thunar_thumbnail_cache_cleanup_async (cache, (const gchar *const *)uris);
-
-  /* free the URI array */
-  g_strfreev (uris);
-
-  /* release the cleanup queue list */
-  g_list_free (cache->cleanup_queue);
-  cache->cleanup_queue = NULL;
-
-  /* reset the cleanup queue idle ID */
-  cache->cleanup_queue_idle_id = 0;
-
-  /* release the cache lock */
-  _thumbnail_cache_unlock (cache);
-
-  return FALSE;
+  thunar_thumbnail_cache_schedule_flush (cache);
 }
 #endif /* HAVE_DBUS */
 
@@ -555,39 +722,53 @@ thunar_thumbnail_cache_move_file (ThunarThumbnailCache *cache,
                                   GFile                *source_file,
                                   GFile                *target_file)
 {
+#ifdef HAVE_DBUS
+  ThunarThumbnailCacheBatch *batch;
+  GFile                     *first_source;
+#endif
+
   _thunar_return_if_fail (THUNAR_IS_THUMBNAIL_CACHE (cache));
   _thunar_return_if_fail (G_IS_FILE (source_file));
   _thunar_return_if_fail (G_IS_FILE (target_file));
 
 #ifdef HAVE_DBUS
-  /* acquire a cache lock */
-  _thumbnail_cache_lock (cache);
-
   /* check if we have a valid proxy for the cache service */
-  if (cache->cache_proxy != NULL)
+  if (thunar_thumbnail_cache_has_service (cache))
     {
-      /* cancel any pending timeout to process the move queue */
-      if (cache->move_queue_idle_id > 0)
-        {
-          g_source_remove (cache->move_queue_idle_id);
-          cache->move_queue_idle_id = 0;
-        }
-
-      /* add the files to the move queue */
-      cache->move_source_queue = g_list_prepend (cache->move_source_queue,
-                                                 g_object_ref (source_file));
-      cache->move_target_queue = g_list_prepend (cache->move_target_queue,
-                                                 g_object_ref (target_file));
-
-      /* process the move queue in a 250ms timeout */
-      cache->move_queue_idle_id =
-        g_timeout_add_full (G_PRIORITY_DEFAULT_IDLE, 250, thunar_thumbnail_cache_process_move_queue,
-                            cache, thunar_thumbnail_cache_process_move_queue_destroy);
+      /* acquire a cache lock */
+      _thumbnail_cache_lock (cache);
+
+      /* start a new batch if the files are queued for other requests */
+      thunar_thumbnail_cache_claim (cache, source_file, THUNAR_THUMBNAIL_CACHE_MOVE);
+      thunar_thumbnail_cache_claim (cache, target_file, THUNAR_THUMBNAIL_CACHE_MOVE);
+
+      /* merge a chain of moves into one */
+      first_source = thunar_thumbnail_cache_steal_move (cache, source_file);
+      if (first_source == NULL)
+        first_source = g_object_ref (source_file);
+
+      /* add the files to the move queue, they are claimed again
+       * in case the merged move released them */
+      batch = cache->batch;
+      g_hash_table_insert (batch->kind_index, g_object_ref (first_source),
+                           GUINT_TO_POINTER (THUNAR_THUMBNAIL_CACHE_MOVE));
+      g_hash_table_insert (batch->kind_index, g_object_ref (target_file),
+                           GUINT_TO_POINTER (THUNAR_THUMBNAIL_CACHE_MOVE));
+      g_hash_table_insert (batch->move_index, target_file,
+                           GUINT_TO_POINTER (batch->move_targets->len));
+      g_ptr_array_add (batch->move_sources, first_source);
+      g_ptr_array_add (batch->move_targets, g_object_ref (target_file));
+
+      thunar_thumbnail_cache_schedule_flush (cache);
+
+      /* release the cache lock */
+      _thumbnail_cache_unlock (cache);
+
+      return;
     }
-
-  /* release the cache lock */
-  _thumbnail_cache_unlock (cache);
 #endif
+
+  thunar_thumbnail_cache_disk_update (source_file, target_file);
 }
 
 
@@ -602,33 +783,26 @@ thunar_thumbnail_cache_copy_file (ThunarThumbnailCache *cache,
   _thunar_return_if_fail (G_IS_FILE (target_file));
 
 #ifdef HAVE_DBUS
-  /* acquire a cache lock */
-  _thumbnail_cache_lock (cache);
-
-  /* check if we have a valid proxy for the cache service */
-  if (cache->cache_proxy != NULL)
+  /* check if we have a valid proxy for the cache service, copied
+   * thumbnails are generated again otherwise */
+  if (thunar_thumbnail_cache_has_service (cache))
     {
-      /* cancel any pending timeout to process the copy queue */
-      if (cache->copy_queue_idle_id > 0)
-        {
-          g_source_remove (cache->copy_queue_idle_id);
-          cache->copy_queue_idle_id = 0;
-        }
+      /* acquire a cache lock */
+      _thumbnail_cache_lock (cache);
+
+      /* start a new batch if the files are queued for other requests */
+      thunar_thumbnail_cache_claim (cache, source_file, THUNAR_THUMBNAIL_CACHE_COPY);
+      thunar_thumbnail_cache_claim (cache, target_file, THUNAR_THUMBNAIL_CACHE_COPY);
 
       /* add the files to the copy queues */
-      cache->copy_source_queue = g_list_prepend (cache->copy_source_queue,
-                                                 g_object_ref (source_file));
-      cache->copy_target_queue = g_list_prepend (cache->copy_target_queue,
-                                                 g_object_ref (target_file));
-
-      /* process the copy queue in a 250ms timeout */
-      cache->copy_queue_idle_id =
-        g_timeout_add_full (G_PRIORITY_DEFAULT_IDLE, 500, thunar_thumbnail_cache_process_copy_queue,
-                            cache, thunar_thumbnail_cache_process_copy_queue_destroy);
-    }
+      g_ptr_array_add (cache->batch->copy_sources, g_object_ref (source_file));
+      g_ptr_array_add (cache->batch->copy_targets, g_object_ref (target_file));
 
-  /* release the cache lock */
-  _thumbnail_cache_unlock (cache);
+      thunar_thumbnail_cache_schedule_flush (cache);
+
+      /* release the cache lock */
+      _thumbnail_cache_unlock (cache);
+    }
 #endif
 }
 
@@ -642,31 +816,23 @@ thunar_thumbnail_cache_delete_file (ThunarThumbnailCache *cache,
   _thunar_return_if_fail (G_IS_FILE (file));
 
 #ifdef HAVE_DBUS
-  /* acquire a cache lock */
-  _thumbnail_cache_lock (cache);
-
   /* check if we have a valid proxy for the cache service */
-  if (cache->cache_proxy)
+  if (thunar_thumbnail_cache_has_service (cache))
     {
-      /* cancel any pending timeout to process the delete queue */
-      if (cache->delete_queue_idle_id > 0)
-        {
-          g_source_remove (cache->delete_queue_idle_id);
-          cache->delete_queue_idle_id = 0;
-        }
+      /* acquire a cache lock */
+      _thumbnail_cache_lock (cache);
 
       /* add the file to the delete queue */
-      cache->delete_queue = g_list_prepend (cache->delete_queue, g_object_ref (file));
+      thunar_thumbnail_cache_queue_remove (cache, THUNAR_THUMBNAIL_CACHE_DELETE, file);
 
-      /* process the delete queue in a 250ms timeout */
-      cache->delete_queue_idle_id =
-        g_timeout_add (500, (GSourceFunc) thunar_thumbnail_cache_process_delete_queue,
-                       cache);
-    }
+      /* release the cache lock */
+      _thumbnail_cache_unlock (cache);
 
-  /* release the cache lock */
-  _thumbnail_cache_unlock (cache);
+      return;
+    }
 #endif
+
+  thunar_thumbnail_cache_disk_update (file, NULL);
 }
 
 
@@ -679,29 +845,23 @@ thunar_thumbnail_cache_cleanup_file (ThunarThumbnailCache *cache,
   _thunar_return_if_fail (G_IS_FILE (file));
 
 #ifdef HAVE_DBUS
-  /* acquire a cache lock */
-  _thumbnail_cache_lock (cache);
-
   /* check if we have a valid proxy for the cache service */
-  if (cache->cache_proxy)
+  if (thunar_thumbnail_cache_has_service (cache))
     {
-      /* cancel any pending timeout to process the cleanup queue */
-      if (cache->cleanup_queue_idle_id > 0)
-        {
-          g_source_remove (cache->cleanup_queue_idle_id);
-          cache->cleanup_queue_idle_id = 0;
-        }
+      /* acquire a cache lock */
+      _thumbnail_cache_lock (cache);
 
       /* add the file to the cleanup queue */
-      cache->cleanup_queue = g_list_prepend (cache->cleanup_queue, g_object_ref (file));
+      thunar_thumbnail_cache_queue_remove (cache, THUNAR_THUMBNAIL_CACHE_CLEANUP, file);
 
-      /* process the cleanup queue in a 250ms timeout */
-      cache->cleanup_queue_idle_id =
-        g_timeout_add (1000, (GSourceFunc) thunar_thumbnail_cache_process_cleanup_queue,
-                       cache);
-    }
+      /* release the cache lock */
+      _thumbnail_cache_unlock (cache);
 
-  /* release the cache lock */
-  _thumbnail_cache_unlock (cache);
+      return;
+    }
 #endif
+
+  /* without the service only the thumbnail of the file itself
+   * can be found, not those of the folder contents */
+  thunar_thumbnail_cache_disk_update (file, NULL);
 }
@@ -23,7 +23,32 @@
 #include <config.h>
 #endif
 
+#ifdef HAVE_SYS_TYPES_H
+#include <sys/types.h>
+#endif
+#ifdef HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+
+#ifdef HAVE_ERRNO_H
+#include <errno.h>
+#endif
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_TIME_H
+#include <time.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
 #include <gio/gio.h>
+#include <glib/gstdio.h>
+#include <libxfce4util/libxfce4util.h>
 
 #include <thunar/thunar-application.h>
 #include <thunar/thunar-gio-extensions.h>
@@ -37,21 +62,53 @@
 
 
 
-/* seconds before we show the transfer rate + remaining time */
-#define MINIMUM_TRANSFER_TIME (10 * G_USEC_PER_SEC) /* 10 seconds */
-
-
-
 /* Property identifiers */
 enum
 {
   PROP_0,
   PROP_FILE_SIZE_BINARY,
+  PROP_BANDWIDTH_LIMIT,
+  PROP_VERIFY,
 };
 
 
 
-typedef struct _ThunarTransferNode ThunarTransferNode;
+/* interval in which the telemetry is updated (in usec) */
+#define TELEMETRY_INTERVAL (G_USEC_PER_SEC / 2)
+
+/* maximum time to sleep at once for the bandwidth limit (in usec) */
+#define THROTTLE_MAX_SLEEP (G_USEC_PER_SEC / 4)
+
+/* the directory (relative to the user's cache directory) holding the journals */
+#define THUNAR_TRANSFER_JOB_JOURNAL_DIR "Thunar/transfers/"
+
+/* transfers smaller than this are not worth a journal */
+#define THUNAR_TRANSFER_JOB_JOURNAL_MIN_SIZE (64 * 1024 * 1024)
+
+/* journals of transfers that were not resumed within a week are dropped */
+#define THUNAR_TRANSFER_JOB_JOURNAL_MAX_AGE (7 * 24 * 60 * 60)
+
+/* files of at least this size are copied in chunks, with a checkpoint
+ * in the journal every time this many bytes are on the disk */
+#define THUNAR_TRANSFER_JOB_CHECKPOINT_SIZE (64 * 1024 * 1024)
+
+/* size of the chunks read and written at once */
+#define THUNAR_TRANSFER_JOB_CHUNK_SIZE (1024 * 1024)
+
+/* the directory (relative to the user's cache directory) holding the manifests */
+#define THUNAR_TRANSFER_JOB_MANIFEST_DIR "Thunar/manifests/"
+
+/* manifests are kept for a month, to check the copies later on */
+#define THUNAR_TRANSFER_JOB_MANIFEST_MAX_AGE (30 * 24 * 60 * 60)
+
+/* number of threads reading back copied files */
+#define THUNAR_TRANSFER_JOB_VERIFY_THREADS 4
+
+
+
+typedef struct _ThunarTransferNode         ThunarTransferNode;
+typedef struct _ThunarTransferJournalEntry ThunarTransferJournalEntry;
+typedef struct _ThunarTransferDigest       ThunarTransferDigest;
 
 
 
@@ -68,7 +125,10 @@ static void     thunar_transfer_job_set_property (GObject      *object,
 static void     thunar_transfer_job_finalize     (GObject                *object);
 static gboolean thunar_transfer_job_execute      (ExoJob                 *job,
                                                   GError                **error);
+static gboolean thunar_transfer_job_run          (ThunarTransferJob      *job,
+                                                  GError                **error);
 static void     thunar_transfer_node_free        (gpointer                data);
+static void     thunar_transfer_digest_free      (gpointer                data);
 
 
 
@@ -85,17 +145,45 @@ struct _ThunarTransferJob
   GList                *source_node_list;
   GList                *target_file_list;
 
-  gint64                start_time;
-  gint64                last_update_time;
-  guint64               last_total_progress;
-
   guint64               total_size;
-  guint64               total_progress;
   guint64               file_progress;
-  guint64               transfer_rate;
 
   ThunarPreferences    *preferences;
   gboolean              file_size_binary;
+  guint                 bandwidth_limit;
+
+  /* token bucket for the bandwidth limit */
+  gdouble               bucket_tokens;
+  gint64                bucket_time;
+
+  /* telemetry of the job thread */
+  ThunarTransferPhase   phase;
+  gint64                phase_start_time;
+  gint64                phase_time[THUNAR_TRANSFER_N_PHASES];
+  guint64               n_files;
+  guint64               bytes_done;
+  guint64               rate;
+  guint64               rate_bytes;
+  gint64                rate_time;
+  gint64                publish_time;
+
+  /* snapshot of the telemetry, protected by the transfer_jobs lock */
+  ThunarTransferStats   stats;
+
+  /* journal of the copied files, to resume an interrupted transfer */
+  gchar                *journal_path;
+  gint                  journal_fd;
+  GHashTable           *journal;
+
+  /* read back copied files and compare their checksums, the verified
+   * files go to the manifest right away and only the failed ones are
+   * kept, protected by the transfer_verify lock */
+  gboolean              verify;
+  GThreadPool          *verify_pool;
+  guint                 n_verify;
+  GList                *verify_failed;
+  gchar                *manifest_path;
+  gint                  manifest_fd;
 };
 
 struct _ThunarTransferNode
@@ -105,6 +193,44 @@ struct _ThunarTransferNode
   GFile              *source_file;
 };
 
+struct _ThunarTransferJournalEntry
+{
+  /* size and modification time of the source file */
+  guint64  size;
+  guint64  mtime;
+
+  /* the target file created by the transfer, entries are only
+   * trusted as long as the target is still this file */
+  guint64  inode;
+
+  /* bytes of the target file known to be on the disk */
+  guint64  offset;
+  gboolean done;
+};
+
+struct _ThunarTransferDigest
+{
+  GFile   *source_file;
+  GFile   *target_file;
+  guint64  size;
+  guint64  mtime;
+
+  /* SHA-256 digests, the source digest is computed while copying
+   * if possible, everything else in the verify threads */
+  gchar   *source_digest;
+  gchar   *target_digest;
+  GError  *error;
+};
+
+
+
+/* running transfer jobs, see thunar_transfer_job_get_stats() */
+static GList *transfer_jobs = NULL;
+G_LOCK_DEFINE_STATIC (transfer_jobs);
+
+/* the manifests are written from the verify threads */
+G_LOCK_DEFINE_STATIC (transfer_verify);
+
 
 
 G_DEFINE_TYPE (ThunarTransferJob, thunar_transfer_job, THUNAR_TYPE_JOB)
@@ -137,6 +263,34 @@ thunar_transfer_job_class_init (ThunarTransferJobClass *klass)
                                                          NULL,
                                                          FALSE,
                                                          EXO_PARAM_READWRITE));
+
+  /**
+   * ThunarTransferJob:bandwidth-limit:
+   *
+   * The maximum transfer rate in KiB per second, or %0
+   * for no limit.
+   **/
+  g_object_class_install_property (gobject_class,
+                                   PROP_BANDWIDTH_LIMIT,
+                                   g_param_spec_uint ("bandwidth-limit",
+                                                      "BandwidthLimit",
+                                                      NULL,
+                                                      0, G_MAXUINT, 0,
+                                                      EXO_PARAM_READWRITE));
+
+  /**
+   * ThunarTransferJob:verify:
+   *
+   * Whether copied files are read back and compared with
+   * the originals.
+   **/
+  g_object_class_install_property (gobject_class,
+                                   PROP_VERIFY,
+                                   g_param_spec_boolean ("verify",
+                                                         "Verify",
+                                                         NULL,
+                                                         FALSE,
+                                                         EXO_PARAM_READWRITE));
 }
 
 
@@ -147,17 +301,18 @@ thunar_transfer_job_init (ThunarTransferJob *job)
   job->preferences = thunar_preferences_get ();
   exo_binding_new (G_OBJECT (job->preferences), "misc-file-size-binary",
                    G_OBJECT (job), "file-size-binary");
+  exo_binding_new (G_OBJECT (job->preferences), "misc-transfer-bandwidth-limit",
+                   G_OBJECT (job), "bandwidth-limit");
+  exo_binding_new (G_OBJECT (job->preferences), "misc-transfer-verify",
+                   G_OBJECT (job), "verify");
 
   job->type = 0;
   job->source_node_list = NULL;
   job->target_file_list = NULL;
   job->total_size = 0;
-  job->total_progress = 0;
   job->file_progress = 0;
-  job->last_update_time = 0;
-  job->last_total_progress = 0;
-  job->transfer_rate = 0;
-  job->start_time = 0;
+  job->journal_fd = -1;
+  job->manifest_fd = -1;
 }
 
 
@@ -171,6 +326,18 @@ thunar_transfer_job_finalize (GObject *object)
 
   thunar_g_file_list_free (job->target_file_list);
 
+  /* keep the journal of an unfinished transfer for resuming */
+  if (job->journal_fd >= 0)
+    close (job->journal_fd);
+  if (job->journal != NULL)
+    g_hash_table_destroy (job->journal);
+  g_free (job->journal_path);
+
+  _thunar_assert (job->verify_pool == NULL);
+  _thunar_assert (job->manifest_fd < 0);
+  g_list_free_full (job->verify_failed, thunar_transfer_digest_free);
+  g_free (job->manifest_path);
+
   g_object_unref (job->preferences);
 
   (*G_OBJECT_CLASS (thunar_transfer_job_parent_class)->finalize) (object);
@@ -192,155 +359,1223 @@ thunar_transfer_job_get_property (GObject     *object,
       g_value_set_boolean (value, job->file_size_binary);
       break;
 
-    default:
-      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
-      break;
+    case PROP_BANDWIDTH_LIMIT:
+      g_value_set_uint (value, job->bandwidth_limit);
+      break;
+
+    case PROP_VERIFY:
+      g_value_set_boolean (value, job->verify);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+    }
+}
+
+
+
+static void
+thunar_transfer_job_set_property (GObject      *object,
+                                  guint         prop_id,
+                                  const GValue *value,
+                                  GParamSpec   *pspec)
+{
+  ThunarTransferJob *job = THUNAR_TRANSFER_JOB (object);
+
+  switch (prop_id)
+    {
+    case PROP_FILE_SIZE_BINARY:
+      job->file_size_binary = g_value_get_boolean (value);
+      break;
+
+    case PROP_BANDWIDTH_LIMIT:
+      job->bandwidth_limit = g_value_get_uint (value);
+      break;
+
+    case PROP_VERIFY:
+      job->verify = g_value_get_boolean (value);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+    }
+}
+
+
+
+static void
+thunar_transfer_job_publish (ThunarTransferJob *job,
+                             gboolean           force)
+{
+  ThunarTransferStats stats;
+  gint64              current_time;
+  guint               n;
+
+  current_time = g_get_monotonic_time ();
+
+  /* rate limit the snapshots */
+  if (!force && current_time - job->publish_time < TELEMETRY_INTERVAL)
+    return;
+  job->publish_time = current_time;
+
+  stats.n_jobs = 1;
+  stats.n_files = job->n_files;
+  stats.bytes_done = job->bytes_done;
+  stats.bytes_total = job->total_size;
+  stats.bytes_per_second = job->rate;
+  stats.files_per_second = 0.0;
+  stats.remaining_time = -1;
+
+  for (n = 0; n < THUNAR_TRANSFER_N_PHASES; ++n)
+    stats.phase_time[n] = job->phase_time[n];
+
+  /* include the running phase */
+  stats.phase_time[job->phase] += current_time - job->phase_start_time;
+
+  if (stats.phase_time[THUNAR_TRANSFER_PHASE_COPY] > 0)
+    {
+      stats.files_per_second = job->n_files / ((gdouble) stats.phase_time[THUNAR_TRANSFER_PHASE_COPY]
+                                               / G_USEC_PER_SEC);
+    }
+
+  if (job->rate > 0 && job->total_size > job->bytes_done)
+    stats.remaining_time = (job->total_size - job->bytes_done) / job->rate;
+
+  G_LOCK (transfer_jobs);
+  job->stats = stats;
+  G_UNLOCK (transfer_jobs);
+}
+
+
+
+static ThunarTransferPhase
+thunar_transfer_job_set_phase (ThunarTransferJob   *job,
+                               ThunarTransferPhase  phase)
+{
+  ThunarTransferPhase old_phase = job->phase;
+  gint64              current_time;
+
+  if (old_phase == phase)
+    return old_phase;
+
+  current_time = g_get_monotonic_time ();
+  job->phase_time[old_phase] += current_time - job->phase_start_time;
+  job->phase_start_time = current_time;
+  job->phase = phase;
+
+  /* thumbnail updates happen for every file, don't publish each of them */
+  thunar_transfer_job_publish (job, old_phase != THUNAR_TRANSFER_PHASE_THUMBNAILS
+                                    && phase != THUNAR_TRANSFER_PHASE_THUMBNAILS);
+
+  return old_phase;
+}
+
+
+
+static void
+thunar_transfer_job_update_rate (ThunarTransferJob *job)
+{
+  gint64  current_time;
+  gint64  expired_time;
+  guint64 rate;
+
+  current_time = g_get_monotonic_time ();
+
+  if (G_UNLIKELY (job->rate_time == 0))
+    {
+      job->rate_time = current_time;
+      job->rate_bytes = job->bytes_done;
+      return;
+    }
+
+  expired_time = current_time - job->rate_time;
+  if (expired_time < TELEMETRY_INTERVAL)
+    return;
+
+  /* calculate the rate in the last expired time */
+  rate = (job->bytes_done - job->rate_bytes) / ((gdouble) expired_time / G_USEC_PER_SEC);
+
+  /* moving average over the last 10 rates (5 sec), like the job status */
+  if (job->rate > 0)
+    job->rate = ((job->rate * 10) + rate) / 11;
+  else
+    job->rate = rate;
+
+  job->rate_time = current_time;
+  job->rate_bytes = job->bytes_done;
+}
+
+
+
+static void
+thunar_transfer_job_throttle (ThunarTransferJob *job,
+                              guint64            n_bytes)
+{
+  gdouble limit;
+  gint64  current_time;
+  gint64  sleep_time;
+
+  limit = (gdouble) job->bandwidth_limit * 1024;
+  if (G_LIKELY (limit <= 0))
+    {
+      /* start with a full bucket when a limit is set later on */
+      job->bucket_time = 0;
+      return;
+    }
+
+  /* refill the bucket, it holds at most one second of data */
+  current_time = g_get_monotonic_time ();
+  if (job->bucket_time == 0)
+    job->bucket_tokens = limit;
+  else
+    job->bucket_tokens = MIN (limit, job->bucket_tokens + limit * (current_time - job->bucket_time) / G_USEC_PER_SEC);
+  job->bucket_time = current_time;
+
+  /* take the transferred bytes from the bucket */
+  job->bucket_tokens -= n_bytes;
+
+  /* wait until the debt is paid, in short steps to stay responsive to cancellation */
+  while (job->bucket_tokens < 0 && !exo_job_is_cancelled (EXO_JOB (job)))
+    {
+      sleep_time = -job->bucket_tokens * G_USEC_PER_SEC / limit;
+      g_usleep (CLAMP (sleep_time, 1000, THROTTLE_MAX_SLEEP));
+
+      current_time = g_get_monotonic_time ();
+      job->bucket_tokens += limit * (current_time - job->bucket_time) / G_USEC_PER_SEC;
+      job->bucket_time = current_time;
+    }
+}
+
+
+
+static void
+thunar_transfer_job_progress (goffset  current_num_bytes,
+                              goffset  total_num_bytes,
+                              gpointer user_data)
+{
+  ThunarTransferJob *job = user_data;
+  guint64            n_bytes;
+
+  _thunar_return_if_fail (THUNAR_IS_TRANSFER_JOB (job));
+
+  if (G_LIKELY (job->total_size > 0))
+    {
+      n_bytes = current_num_bytes - job->file_progress;
+
+      /* update total progress */
+      thunar_job_add_progress (THUNAR_JOB (job), n_bytes);
+
+      /* update file progress */
+      job->file_progress = current_num_bytes;
+
+      /* update the telemetry */
+      job->bytes_done += n_bytes;
+      thunar_transfer_job_update_rate (job);
+      thunar_transfer_job_publish (job, FALSE);
+
+      /* respect the bandwidth limit */
+      thunar_transfer_job_throttle (job, n_bytes);
+    }
+}
+
+
+
+static gboolean
+thunar_transfer_job_collect_node (ThunarTransferJob  *job,
+                                  ThunarTransferNode *node,
+                                  GError            **error)
+{
+  ThunarTransferNode *child_node;
+  GFileInfo          *info;
+  GError             *err = NULL;
+  GList              *file_list;
+  GList              *lp;
+
+  _thunar_return_val_if_fail (THUNAR_IS_TRANSFER_JOB (job), FALSE);
+  _thunar_return_val_if_fail (node != NULL && G_IS_FILE (node->source_file), FALSE);
+  _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  if (exo_job_set_error_if_cancelled (EXO_JOB (job), error))
+    return FALSE;
+
+  info = g_file_query_info (node->source_file,
+                            G_FILE_ATTRIBUTE_STANDARD_SIZE ","
+                            G_FILE_ATTRIBUTE_STANDARD_TYPE,
+                            G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                            exo_job_get_cancellable (EXO_JOB (job)),
+                            &err);
+
+  if (G_UNLIKELY (info == NULL))
+    return FALSE;
+
+  job->total_size += g_file_info_get_size (info);
+
+  /* check if we have a directory here */
+  if (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY)
+    {
+      /* scan the directory for immediate children */
+      file_list = thunar_io_scan_directory (THUNAR_JOB (job), node->source_file,
+                                            G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                            FALSE, FALSE, FALSE, &err);
+
+      /* add children to the transfer node */
+      for (lp = file_list; err == NULL && lp != NULL; lp = lp->next)
+        {
+          /* allocate a new transfer node for the child */
+          child_node = g_slice_new0 (ThunarTransferNode);
+          child_node->source_file = g_object_ref (lp->data);
+
+          /* hook the child node into the child list */
+          child_node->next = node->children;
+          node->children = child_node;
+
+          /* collect the child node */
+          thunar_transfer_job_collect_node (job, child_node, &err);
+        }
+
+      /* release the child files */
+      thunar_g_file_list_free (file_list);
+    }
+
+  /* release file info */
+  g_object_unref (info);
+
+  if (G_UNLIKELY (err != NULL))
+    {
+      g_propagate_error (error, err);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+
+
+static void
+thunar_transfer_job_journal_write (ThunarTransferJob *job,
+                                   const gchar       *format,
+                                   ...)
+{
+  va_list  var_args;
+  gssize   n;
+  gsize    length;
+  gchar   *line;
+  gchar   *p;
+
+  if (job->journal_fd < 0)
+    return;
+
+  va_start (var_args, format);
+  line = g_strdup_vprintf (format, var_args);
+  va_end (var_args);
+
+  /* write the complete line, the journal is appended to but never
+   * synced, the checkpoints sync the target files they refer to */
+  for (p = line, length = strlen (line); length > 0; p += n, length -= n)
+    {
+      n = write (job->journal_fd, p, length);
+      if (G_UNLIKELY (n < 0))
+        {
+          if (errno == EINTR)
+            {
+              n = 0;
+              continue;
+            }
+
+          /* stop journaling, the transfer itself continues */
+          g_warning ("Failed to write transfer journal \"%s\": %s", job->journal_path, g_strerror (errno));
+          close (job->journal_fd);
+          job->journal_fd = -1;
+          break;
+        }
+    }
+
+  g_free (line);
+}
+
+
+
+static void
+thunar_transfer_job_expire (const gchar *directory,
+                            const gchar *suffix,
+                            time_t       max_age)
+{
+  struct stat  statb;
+  const gchar *name;
+  gchar       *path;
+  GDir        *dir;
+  time_t       now = time (NULL);
+
+  dir = g_dir_open (directory, 0, NULL);
+  if (G_UNLIKELY (dir == NULL))
+    return;
+
+  while ((name = g_dir_read_name (dir)) != NULL)
+    {
+      if (!g_str_has_suffix (name, suffix))
+        continue;
+
+      path = g_build_filename (directory, name, NULL);
+      if (g_stat (path, &statb) == 0 && now - statb.st_mtime > max_age)
+        g_unlink (path);
+      g_free (path);
+    }
+
+  g_dir_close (dir);
+}
+
+
+
+static void
+thunar_transfer_job_journal_load (ThunarTransferJob *job)
+{
+  ThunarTransferJournalEntry *entry;
+  GChecksum                  *checksum;
+  gchar                      *directory;
+  gchar                      *contents;
+  gchar                     **fields;
+  gchar                     **lines;
+  gchar                      *uri;
+  GList                      *lp;
+  guint                       n;
+
+  _thunar_return_if_fail (job->journal_path == NULL);
+
+  directory = xfce_resource_save_location (XFCE_RESOURCE_CACHE, THUNAR_TRANSFER_JOB_JOURNAL_DIR, TRUE);
+  if (G_UNLIKELY (directory == NULL))
+    return;
+
+  thunar_transfer_job_expire (directory, ".journal", THUNAR_TRANSFER_JOB_JOURNAL_MAX_AGE);
+
+  /* the journal is named after the transfer, so running the
+   * same transfer again picks up the journal of the last run */
+  checksum = g_checksum_new (G_CHECKSUM_MD5);
+  g_checksum_update (checksum, (const guchar *) (job->type == THUNAR_TRANSFER_JOB_MOVE ? "move" : "copy"), -1);
+  for (lp = job->source_node_list; lp != NULL; lp = lp->next)
+    {
+      uri = g_file_get_uri (((ThunarTransferNode *) lp->data)->source_file);
+      g_checksum_update (checksum, (const guchar *) "\n", 1);
+      g_checksum_update (checksum, (const guchar *) uri, -1);
+      g_free (uri);
+    }
+  for (lp = job->target_file_list; lp != NULL; lp = lp->next)
+    {
+      uri = g_file_get_uri (lp->data);
+      g_checksum_update (checksum, (const guchar *) "\n", 1);
+      g_checksum_update (checksum, (const guchar *) uri, -1);
+      g_free (uri);
+    }
+
+  job->journal_path = g_strdup_printf ("%s/%s.journal", directory, g_checksum_get_string (checksum));
+  g_checksum_free (checksum);
+  g_free (directory);
+
+  if (!g_file_get_contents (job->journal_path, &contents, NULL, NULL))
+    return;
+
+  /* replay the records of the earlier run, later records win */
+  job->journal = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+  lines = g_strsplit (contents, "\n", -1);
+  for (n = 0; lines[n] != NULL; ++n)
+    {
+      fields = g_strsplit (lines[n], "\t", -1);
+      if ((lines[n][0] == 'B' && g_strv_length (fields) == 6)
+          || (lines[n][0] == 'D' && g_strv_length (fields) == 5))
+        {
+          /* a file was started (B) or completed (D) */
+          entry = g_new0 (ThunarTransferJournalEntry, 1);
+          entry->size = g_ascii_strtoull (fields[2], NULL, 10);
+          entry->mtime = g_ascii_strtoull (fields[3], NULL, 10);
+          entry->inode = g_ascii_strtoull (fields[(lines[n][0] == 'B') ? 5 : 4], NULL, 10);
+          entry->offset = (lines[n][0] == 'B') ? g_ascii_strtoull (fields[4], NULL, 10) : entry->size;
+          entry->done = (lines[n][0] == 'D');
+          g_hash_table_replace (job->journal, g_strdup (fields[1]), entry);
+        }
+      else if (lines[n][0] == 'C' && g_strv_length (fields) == 3)
+        {
+          /* a checkpoint of a partial file */
+          entry = g_hash_table_lookup (job->journal, fields[1]);
+          if (G_LIKELY (entry != NULL))
+            entry->offset = g_ascii_strtoull (fields[2], NULL, 10);
+        }
+      g_strfreev (fields);
+    }
+  g_strfreev (lines);
+  g_free (contents);
+}
+
+
+
+static void
+thunar_transfer_job_journal_open (ThunarTransferJob *job)
+{
+  if (job->journal_path == NULL)
+    return;
+
+  /* small transfers are quickly repeated, unless we are resuming */
+  if (job->journal == NULL && job->total_size < THUNAR_TRANSFER_JOB_JOURNAL_MIN_SIZE)
+    return;
+
+  job->journal_fd = g_open (job->journal_path, O_WRONLY | O_CREAT | O_APPEND, 0600);
+  if (G_UNLIKELY (job->journal_fd < 0))
+    {
+      g_warning ("Failed to open transfer journal \"%s\": %s", job->journal_path, g_strerror (errno));
+      return;
+    }
+
+  if (job->journal == NULL)
+    job->journal = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+}
+
+
+
+static void
+thunar_transfer_job_journal_close (ThunarTransferJob *job)
+{
+  /* the transfer is complete, the journal is no longer needed */
+  if (job->journal_fd >= 0)
+    close (job->journal_fd);
+  if (job->journal_path != NULL)
+    g_unlink (job->journal_path);
+
+  job->journal_fd = -1;
+}
+
+
+
+static guint64
+ttj_query_inode (ThunarTransferJob *job,
+                 GFile             *file)
+{
+  GFileInfo *info;
+  guint64    inode = 0;
+
+  info = g_file_query_info (file, G_FILE_ATTRIBUTE_UNIX_INODE,
+                            G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                            exo_job_get_cancellable (EXO_JOB (job)), NULL);
+  if (G_LIKELY (info != NULL))
+    {
+      inode = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_UNIX_INODE);
+      g_object_unref (info);
+    }
+
+  return inode;
+}
+
+
+
+static void
+ttj_set_error_from_errno (GError     **error,
+                          const gchar *path,
+                          gint         errsv)
+{
+  gchar *display_name;
+
+  display_name = g_filename_display_name (path);
+  g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errsv),
+               "%s: %s", display_name, g_strerror (errsv));
+  g_free (display_name);
+}
+
+
+
+static gboolean
+ttj_copy_file_chunked (ThunarTransferJob *job,
+                       GFile             *source_file,
+                       GFile             *target_file,
+                       const gchar       *target_uri,
+                       GFileCopyFlags     copy_flags,
+                       guint64            size,
+                       guint64            mtime,
+                       guint64            offset,
+                       GChecksum         *checksum,
+                       GError           **error)
+{
+  const gchar *failed_path = NULL;
+  guint64      checkpoint = offset;
+  gssize       n_read;
+  gssize       n_written;
+  gssize       n;
+  GError      *err = NULL;
+  gchar       *source_path;
+  gchar       *target_path;
+  gchar       *buffer = NULL;
+  gint         source_fd = -1;
+  gint         target_fd = -1;
+  gint         errsv = 0;
+  gint         flags;
+  struct stat  statb;
+
+  source_path = g_file_get_path (source_file);
+  target_path = g_file_get_path (target_file);
+
+  source_fd = g_open (source_path, O_RDONLY, 0);
+  if (G_UNLIKELY (source_fd < 0))
+    {
+      errsv = errno;
+      failed_path = source_path;
+      goto out;
+    }
+
+  /* the permissions are copied once the data is complete */
+  flags = O_WRONLY | O_CREAT;
+  if ((copy_flags & G_FILE_COPY_OVERWRITE) == 0)
+    flags |= O_EXCL;
+  target_fd = g_open (target_path, flags, 0600);
+  if (G_UNLIKELY (target_fd < 0))
+    {
+      errsv = errno;
+      failed_path = target_path;
+      goto out;
+    }
+
+  if (fstat (target_fd, &statb) < 0)
+    {
+      errsv = errno;
+      failed_path = target_path;
+      goto out;
+    }
+
+  /* the target is ours now, either created here or replaced with
+   * the consent of the user, so a resumed run may continue it */
+  thunar_transfer_job_journal_write (job, "B\t%s\t%" G_GUINT64_FORMAT "\t%" G_GUINT64_FORMAT "\t%" G_GUINT64_FORMAT "\t%" G_GUINT64_FORMAT "\n",
+                                     target_uri, size, mtime, offset, (guint64) statb.st_ino);
+
+  /* drop whatever was written after the last checkpoint */
+  if (ftruncate (target_fd, offset) < 0
+      || lseek (target_fd, offset, SEEK_SET) < 0
+      || lseek (source_fd, offset, SEEK_SET) < 0)
+    {
+      errsv = errno;
+      failed_path = target_path;
+      goto out;
+    }
+
+  /* the resumed part counts as done */
+  thunar_job_add_progress (THUNAR_JOB (job), offset);
+  job->file_progress = offset;
+
+  buffer = g_malloc (THUNAR_TRANSFER_JOB_CHUNK_SIZE);
+  while (!exo_job_set_error_if_cancelled (EXO_JOB (job), &err))
+    {
+      n_read = read (source_fd, buffer, THUNAR_TRANSFER_JOB_CHUNK_SIZE);
+      if (G_UNLIKELY (n_read < 0))
+        {
+          if (errno == EINTR)
+            continue;
+
+          errsv = errno;
+          failed_path = source_path;
+          break;
+        }
+
+      if (n_read == 0)
+        break;
+
+      /* hash the data on its way to the target */
+      if (checksum != NULL)
+        g_checksum_update (checksum, (const guchar *) buffer, n_read);
+
+      for (n_written = 0; n_written < n_read; n_written += n)
+        {
+          n = write (target_fd, buffer + n_written, n_read - n_written);
+          if (G_UNLIKELY (n < 0))
+            {
+              if (errno == EINTR)
+                {
+                  n = 0;
+                  continue;
+                }
+
+              errsv = errno;
+              failed_path = target_path;
+              break;
+            }
+        }
+
+      if (G_UNLIKELY (failed_path != NULL))
+        break;
+
+      offset += n_read;
+      thunar_transfer_job_progress (offset, size, job);
+
+      /* make the data durable before recording the checkpoint */
+      if (job->journal_fd >= 0
+          && offset - checkpoint >= THUNAR_TRANSFER_JOB_CHECKPOINT_SIZE
+          && fsync (target_fd) == 0)
+        {
+          checkpoint = offset;
+          thunar_transfer_job_journal_write (job, "C\t%s\t%" G_GUINT64_FORMAT "\n",
+                                             target_uri, checkpoint);
+        }
+    }
+
+  if (err == NULL && failed_path == NULL)
+    {
+      if (close (target_fd) < 0)
+        {
+          errsv = errno;
+          failed_path = target_path;
+        }
+      target_fd = -1;
+    }
+
+out:
+  if (source_fd >= 0)
+    close (source_fd);
+  if (target_fd >= 0)
+    close (target_fd);
+
+  if (err == NULL && failed_path != NULL)
+    ttj_set_error_from_errno (&err, failed_path, errsv);
+
+  /* copy the permissions and times like g_file_copy() does, errors are not fatal */
+  if (err == NULL)
+    {
+      g_file_copy_attributes (source_file, target_file, G_FILE_COPY_NOFOLLOW_SYMLINKS,
+                              exo_job_get_cancellable (EXO_JOB (job)), NULL);
+    }
+
+  g_free (buffer);
+  g_free (source_path);
+  g_free (target_path);
+
+  if (G_UNLIKELY (err != NULL))
+    {
+      g_propagate_error (error, err);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+
+
+static void
+thunar_transfer_digest_free (gpointer data)
+{
+  ThunarTransferDigest *digest = data;
+
+  g_object_unref (digest->source_file);
+  g_object_unref (digest->target_file);
+  g_free (digest->source_digest);
+  g_free (digest->target_digest);
+  if (digest->error != NULL)
+    g_error_free (digest->error);
+
+  g_slice_free (ThunarTransferDigest, digest);
+}
+
+
+
+static gchar *
+thunar_transfer_job_checksum_file (ThunarTransferJob *job,
+                                   GFile             *file,
+                                   gboolean           drop_cache,
+                                   GError           **error)
+{
+  GFileInputStream *stream;
+  GChecksum        *checksum;
+  gssize            n_read;
+  gchar            *digest = NULL;
+  gchar            *buffer;
+  gchar            *path;
+  gint              fd;
+#ifdef HAVE_POSIX_FADVISE
+  off_t             offset = 0;
+#endif
+
+  checksum = g_checksum_new (G_CHECKSUM_SHA256);
+  buffer = g_malloc (THUNAR_TRANSFER_JOB_CHUNK_SIZE);
+
+  path = g_file_get_path (file);
+  if (G_LIKELY (path != NULL))
+    {
+      fd = g_open (path, O_RDONLY, 0);
+      if (G_UNLIKELY (fd < 0))
+        {
+          ttj_set_error_from_errno (error, path, errno);
+        }
+      else
+        {
+#ifdef HAVE_POSIX_FADVISE
+          /* read the data back from the disk, not from the page cache */
+          if (drop_cache && fsync (fd) == 0)
+            posix_fadvise (fd, 0, 0, POSIX_FADV_DONTNEED);
+#endif
+
+          while (!exo_job_set_error_if_cancelled (EXO_JOB (job), error))
+            {
+              n_read = read (fd, buffer, THUNAR_TRANSFER_JOB_CHUNK_SIZE);
+              if (G_UNLIKELY (n_read < 0))
+                {
+                  if (errno == EINTR)
+                    continue;
+
+                  ttj_set_error_from_errno (error, path, errno);
+                  break;
+                }
+
+              if (n_read == 0)
+                {
+                  digest = g_strdup (g_checksum_get_string (checksum));
+                  break;
+                }
+
+              g_checksum_update (checksum, (const guchar *) buffer, n_read);
+
+#ifdef HAVE_POSIX_FADVISE
+              /* don't push the files of the user out of the page cache */
+              if (drop_cache)
+                posix_fadvise (fd, offset, n_read, POSIX_FADV_DONTNEED);
+              offset += n_read;
+#endif
+            }
+
+          close (fd);
+        }
+    }
+  else
+    {
+      stream = g_file_read (file, exo_job_get_cancellable (EXO_JOB (job)), error);
+      if (G_LIKELY (stream != NULL))
+        {
+          do
+            {
+              n_read = g_input_stream_read (G_INPUT_STREAM (stream), buffer,
+                                            THUNAR_TRANSFER_JOB_CHUNK_SIZE,
+                                            exo_job_get_cancellable (EXO_JOB (job)),
+                                            error);
+              if (n_read > 0)
+                g_checksum_update (checksum, (const guchar *) buffer, n_read);
+            }
+          while (n_read > 0);
+
+          if (n_read == 0)
+            digest = g_strdup (g_checksum_get_string (checksum));
+
+          g_object_unref (stream);
+        }
+    }
+
+  g_checksum_free (checksum);
+  g_free (buffer);
+  g_free (path);
+
+  return digest;
+}
+
+
+
+static void
+thunar_transfer_job_checksum_digest (ThunarTransferJob    *job,
+                                     ThunarTransferDigest *digest)
+{
+  /* files copied with g_file_copy() need another pass over the source */
+  if (digest->source_digest == NULL)
+    {
+      digest->source_digest = thunar_transfer_job_checksum_file (job, digest->source_file,
+                                                                 FALSE, &digest->error);
+    }
+
+  if (G_LIKELY (digest->error == NULL))
+    {
+      digest->target_digest = thunar_transfer_job_checksum_file (job, digest->target_file,
+                                                                 TRUE, &digest->error);
+    }
+}
+
+
+
+static void
+thunar_transfer_job_manifest_write (ThunarTransferJob    *job,
+                                    ThunarTransferDigest *digest)
+{
+  GDateTime *date_time;
+  gssize     n;
+  gsize      length;
+  gchar     *directory;
+  gchar     *date;
+  gchar     *line;
+  gchar     *path;
+  gchar     *p;
+
+  /* create the manifest with the first verified file */
+  if (G_UNLIKELY (job->manifest_path == NULL))
+    {
+      directory = xfce_resource_save_location (XFCE_RESOURCE_CACHE, THUNAR_TRANSFER_JOB_MANIFEST_DIR, TRUE);
+      if (G_UNLIKELY (directory == NULL))
+        {
+          job->manifest_path = g_strdup ("");
+          return;
+        }
+
+      thunar_transfer_job_expire (directory, ".sha256", THUNAR_TRANSFER_JOB_MANIFEST_MAX_AGE);
+
+      date_time = g_date_time_new_now_local ();
+      date = g_date_time_format (date_time, "%Y%m%d-%H%M%S");
+      job->manifest_path = g_strdup_printf ("%s/transfer-%s-XXXXXX.sha256", directory, date);
+      g_date_time_unref (date_time);
+      g_free (directory);
+      g_free (date);
+
+      job->manifest_fd = g_mkstemp (job->manifest_path);
+      if (G_UNLIKELY (job->manifest_fd < 0))
+        g_warning ("Failed to write transfer manifest \"%s\": %s", job->manifest_path, g_strerror (errno));
+    }
+
+  if (job->manifest_fd < 0)
+    return;
+
+  /* add the file in the format of sha256sum(1) */
+  path = g_file_get_path (digest->target_file);
+  if (G_UNLIKELY (path == NULL))
+    path = g_file_get_uri (digest->target_file);
+  line = g_strdup_printf ("%s  %s\n", digest->target_digest, path);
+  g_free (path);
+
+  for (p = line, length = strlen (line); length > 0; p += n, length -= n)
+    {
+      n = write (job->manifest_fd, p, length);
+      if (G_UNLIKELY (n < 0))
+        {
+          if (errno == EINTR)
+            {
+              n = 0;
+              continue;
+            }
+
+          /* drop the incomplete manifest, the verification goes on */
+          g_warning ("Failed to write transfer manifest \"%s\": %s", job->manifest_path, g_strerror (errno));
+          close (job->manifest_fd);
+          g_unlink (job->manifest_path);
+          job->manifest_fd = -1;
+          break;
+        }
+    }
+
+  g_free (line);
+}
+
+
+
+static void
+thunar_transfer_job_verify_done (ThunarTransferJob    *job,
+                                 ThunarTransferDigest *digest)
+{
+  gboolean failed;
+
+  failed = (digest->error != NULL || strcmp (digest->source_digest, digest->target_digest) != 0);
+
+  G_LOCK (transfer_verify);
+  if (G_UNLIKELY (failed))
+    job->verify_failed = g_list_prepend (job->verify_failed, digest);
+  else
+    thunar_transfer_job_manifest_write (job, digest);
+  G_UNLOCK (transfer_verify);
+
+  /* the failed files are reset in the journal at the end */
+  if (G_LIKELY (!failed))
+    thunar_transfer_digest_free (digest);
+}
+
+
+
+static void
+thunar_transfer_job_verify_digest (gpointer data,
+                                   gpointer user_data)
+{
+  ThunarTransferDigest *digest = data;
+  ThunarTransferJob    *job = user_data;
+
+  thunar_transfer_job_checksum_digest (job, digest);
+  thunar_transfer_job_verify_done (job, digest);
+}
+
+
+
+static void
+thunar_transfer_job_journal_reset (ThunarTransferJob    *job,
+                                   ThunarTransferDigest *digest)
+{
+  gchar *target_uri;
+
+  /* copy the file again when the transfer is resumed */
+  target_uri = g_file_get_uri (digest->target_file);
+  thunar_transfer_job_journal_write (job, "B\t%s\t%" G_GUINT64_FORMAT "\t%" G_GUINT64_FORMAT "\t0\t%" G_GUINT64_FORMAT "\n",
+                                     target_uri, digest->size, digest->mtime,
+                                     ttj_query_inode (job, digest->target_file));
+  g_free (target_uri);
+}
+
+
+
+static gboolean
+thunar_transfer_job_verify (ThunarTransferJob *job,
+                            GFile             *source_file,
+                            GFile             *target_file,
+                            guint64            size,
+                            guint64            mtime,
+                            gchar             *source_digest,
+                            GError           **error)
+{
+  ThunarTransferDigest *digest;
+  gchar                *display_name;
+
+  digest = g_slice_new0 (ThunarTransferDigest);
+  digest->source_file = g_object_ref (source_file);
+  digest->target_file = g_object_ref (target_file);
+  digest->size = size;
+  digest->mtime = mtime;
+  digest->source_digest = source_digest;
+
+  job->n_verify++;
+
+  if (job->type == THUNAR_TRANSFER_JOB_MOVE)
+    {
+      /* the source is deleted right after this, so compare now */
+      thunar_transfer_job_checksum_digest (job, digest);
+
+      if (digest->error == NULL && strcmp (digest->source_digest, digest->target_digest) != 0)
+        {
+          display_name = g_file_get_parse_name (target_file);
+          g_set_error (&digest->error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                       _("The copy of \"%s\" differs from the original"),
+                       display_name);
+          g_free (display_name);
+        }
+
+      if (G_UNLIKELY (digest->error != NULL))
+        {
+          thunar_transfer_job_journal_reset (job, digest);
+          g_propagate_error (error, digest->error);
+          digest->error = NULL;
+          thunar_transfer_digest_free (digest);
+          return FALSE;
+        }
+
+      thunar_transfer_job_verify_done (job, digest);
+    }
+  else
+    {
+      /* read back the copies in parallel with the transfer */
+      if (job->verify_pool == NULL)
+        {
+          job->verify_pool = g_thread_pool_new (thunar_transfer_job_verify_digest, job,
+                                                THUNAR_TRANSFER_JOB_VERIFY_THREADS,
+                                                FALSE, NULL);
+        }
+
+      g_thread_pool_push (job->verify_pool, digest, NULL);
     }
+
+  return TRUE;
 }
 
 
 
 static void
-thunar_transfer_job_set_property (GObject      *object,
-                                  guint         prop_id,
-                                  const GValue *value,
-                                  GParamSpec   *pspec)
+thunar_transfer_job_manifest_close (ThunarTransferJob *job,
+                                    gboolean           keep)
 {
-  ThunarTransferJob *job = THUNAR_TRANSFER_JOB (object);
-
-  switch (prop_id)
+  if (job->manifest_fd >= 0)
     {
-    case PROP_FILE_SIZE_BINARY:
-      job->file_size_binary = g_value_get_boolean (value);
-      break;
+      close (job->manifest_fd);
+      job->manifest_fd = -1;
 
-    default:
-      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
-      break;
+      /* the manifest of an aborted transfer is of no use */
+      if (!keep)
+        g_unlink (job->manifest_path);
     }
+
+  g_free (job->manifest_path);
+  job->manifest_path = NULL;
 }
 
 
 
 static void
-thunar_transfer_job_progress (goffset  current_num_bytes,
-                              goffset  total_num_bytes,
-                              gpointer user_data)
+thunar_transfer_job_verify_abort (ThunarTransferJob *job)
 {
-  ThunarTransferJob *job = user_data;
-  guint64            new_percentage;
-  gint64             current_time;
-  gint64             expired_time;
-  guint64            transfer_rate;
+  /* drop the queued files and wait for the running threads */
+  if (job->verify_pool != NULL)
+    g_thread_pool_free (job->verify_pool, TRUE, TRUE);
+  job->verify_pool = NULL;
 
-  _thunar_return_if_fail (THUNAR_IS_TRANSFER_JOB (job));
+  thunar_transfer_job_manifest_close (job, FALSE);
+}
 
-  if (G_LIKELY (job->total_size > 0))
-    {
-      /* update total progress */
-      job->total_progress += (current_num_bytes - job->file_progress);
 
-      /* update file progress */
-      job->file_progress = current_num_bytes;
 
-      /* compute the new percentage after the progress we've made */
-      new_percentage = (job->total_progress * 100.0) / job->total_size;
+static gboolean
+thunar_transfer_job_verify_finish (ThunarTransferJob *job,
+                                   GError           **error)
+{
+  GList *lp;
+  guint  n_failed = 0;
+
+  /* wait for the remaining files */
+  if (job->verify_pool != NULL)
+    g_thread_pool_free (job->verify_pool, FALSE, TRUE);
+  job->verify_pool = NULL;
 
-      /* get current time */
-      current_time = g_get_real_time ();
-      expired_time = current_time - job->last_update_time;
+  if (job->n_verify == 0)
+    return TRUE;
 
-      /* notify callers not more then every 500ms */
-      if (expired_time > (500 * 1000))
-        {
-          /* calculate the transfer rate in the last expired time */
-          transfer_rate = (job->total_progress - job->last_total_progress) / ((gfloat) expired_time / G_USEC_PER_SEC);
+  if (exo_job_set_error_if_cancelled (EXO_JOB (job), error))
+    {
+      thunar_transfer_job_manifest_close (job, FALSE);
+      return FALSE;
+    }
 
-          /* take the average of the last 10 rates (5 sec), so the output is less jumpy */
-          if (job->transfer_rate > 0)
-            job->transfer_rate = ((job->transfer_rate * 10) + transfer_rate) / 11;
-          else
-            job->transfer_rate = transfer_rate;
+  thunar_transfer_job_manifest_close (job, TRUE);
 
-          /* emit the percent signal */
-          exo_job_percent (EXO_JOB (job), new_percentage);
+  /* the threads are gone, so the failed files need no lock */
+  for (lp = job->verify_failed; lp != NULL; lp = lp->next, ++n_failed)
+    thunar_transfer_job_journal_reset (job, lp->data);
 
-          /* update internals */
-          job->last_update_time = current_time;
-          job->last_total_progress = job->total_progress;
-        }
+  g_list_free_full (job->verify_failed, thunar_transfer_digest_free);
+  job->verify_failed = NULL;
+
+  if (G_UNLIKELY (n_failed > 0))
+    {
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                   ngettext ("%u copied file differs from the original or could not be read back",
+                             "%u copied files differ from the originals or could not be read back",
+                             n_failed),
+                   n_failed);
+      return FALSE;
     }
+
+  return TRUE;
 }
 
 
 
 static gboolean
-thunar_transfer_job_collect_node (ThunarTransferJob  *job,
-                                  ThunarTransferNode *node,
-                                  GError            **error)
+ttj_copy_regular_file (ThunarTransferJob *job,
+                       GFile             *source_file,
+                       GFile             *target_file,
+                       GFileCopyFlags     copy_flags,
+                       GError           **error)
 {
-  ThunarTransferNode *child_node;
-  GFileInfo          *info;
-  GError             *err = NULL;
-  GList              *file_list;
-  GList              *lp;
-
-  _thunar_return_val_if_fail (THUNAR_IS_TRANSFER_JOB (job), FALSE);
-  _thunar_return_val_if_fail (node != NULL && G_IS_FILE (node->source_file), FALSE);
-  _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
-
-  if (exo_job_set_error_if_cancelled (EXO_JOB (job), error))
-    return FALSE;
-
-  info = g_file_query_info (node->source_file,
+  ThunarTransferJournalEntry *entry = NULL;
+  GFileInfo                  *info;
+  GChecksum                  *checksum = NULL;
+  gboolean                    succeed;
+  guint64                     offset = 0;
+  guint64                     mtime;
+  guint64                     size;
+  gchar                      *source_digest = NULL;
+  gchar                      *target_uri;
+
+  info = g_file_query_info (source_file,
                             G_FILE_ATTRIBUTE_STANDARD_SIZE ","
-                            G_FILE_ATTRIBUTE_STANDARD_TYPE,
+                            G_FILE_ATTRIBUTE_TIME_MODIFIED,
                             G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
                             exo_job_get_cancellable (EXO_JOB (job)),
-                            &err);
-
+                            error);
   if (G_UNLIKELY (info == NULL))
     return FALSE;
 
-  job->total_size += g_file_info_get_size (info);
+  size = g_file_info_get_size (info);
+  mtime = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+  g_object_unref (info);
 
-  /* check if we have a directory here */
-  if (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY)
+  target_uri = g_file_get_uri (target_file);
+
+  /* check if an earlier run already handled this file, as long
+   * as the source did not change in the meantime */
+  if (job->journal != NULL)
+    entry = g_hash_table_lookup (job->journal, target_uri);
+  if (entry != NULL && entry->size == size && entry->mtime == mtime && entry->inode != 0)
     {
-      /* scan the directory for immediate children */
-      file_list = thunar_io_scan_directory (THUNAR_JOB (job), node->source_file,
-                                            G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
-                                            FALSE, FALSE, FALSE, &err);
+      info = g_file_query_info (target_file,
+                                G_FILE_ATTRIBUTE_STANDARD_SIZE ","
+                                G_FILE_ATTRIBUTE_UNIX_INODE,
+                                G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                exo_job_get_cancellable (EXO_JOB (job)), NULL);
 
-      /* add children to the transfer node */
-      for (lp = file_list; err == NULL && lp != NULL; lp = lp->next)
+      /* never replace a file the earlier run did not create itself */
+      if (info != NULL
+          && g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_UNIX_INODE) != entry->inode)
         {
-          /* allocate a new transfer node for the child */
-          child_node = g_slice_new0 (ThunarTransferNode);
-          child_node->source_file = g_object_ref (lp->data);
+          g_object_unref (info);
+          info = NULL;
+        }
 
-          /* hook the child node into the child list */
-          child_node->next = node->children;
-          node->children = child_node;
+      if (info != NULL)
+        {
+          if (entry->done && (guint64) g_file_info_get_size (info) == size)
+            {
+              /* copied completely, skip the file without asking */
+              thunar_job_add_progress (THUNAR_JOB (job), size);
+              g_object_unref (info);
+              g_free (target_uri);
 
-          /* collect the child node */
-          thunar_transfer_job_collect_node (job, child_node, &err);
-        }
+              /* but still compare the copy of the earlier run */
+              if (job->verify)
+                return thunar_transfer_job_verify (job, source_file, target_file, size, mtime, NULL, error);
 
-      /* release the child files */
-      thunar_g_file_list_free (file_list);
+              return TRUE;
+            }
+
+          /* continue a partial file from its last checkpoint */
+          if (!entry->done && (guint64) g_file_info_get_size (info) >= entry->offset)
+            offset = entry->offset;
+
+          g_object_unref (info);
+
+          /* the target is a left-over of the earlier run, not a file of the user */
+          copy_flags |= G_FILE_COPY_OVERWRITE;
+        }
     }
 
-  /* release file info */
-  g_object_unref (info);
+  /* local files are copied in chunks if they are verified, so the source is
+   * only read once, or if they are large, so they can be continued later */
+  if (g_file_is_native (source_file)
+      && g_file_is_native (target_file)
+      && (job->verify || (job->journal != NULL && size >= THUNAR_TRANSFER_JOB_CHECKPOINT_SIZE)))
+    {
+      /* a continued file has to be read from the start again */
+      if (job->verify && offset == 0)
+        checksum = g_checksum_new (G_CHECKSUM_SHA256);
 
-  if (G_UNLIKELY (err != NULL))
+      succeed = ttj_copy_file_chunked (job, source_file, target_file, target_uri,
+                                       copy_flags, size, mtime, offset, checksum, error);
+
+      if (checksum != NULL)
+        {
+          if (succeed)
+            source_digest = g_strdup (g_checksum_get_string (checksum));
+          g_checksum_free (checksum);
+        }
+    }
+  else
     {
-      g_propagate_error (error, err);
-      return FALSE;
+      /* the target of g_file_copy() is only recorded once it is complete,
+       * an interrupted copy asks the user again when the transfer resumes */
+      succeed = g_file_copy (source_file, target_file, copy_flags,
+                             exo_job_get_cancellable (EXO_JOB (job)),
+                             thunar_transfer_job_progress, job, error);
     }
 
-  return TRUE;
+  if (succeed)
+    {
+      thunar_transfer_job_journal_write (job, "D\t%s\t%" G_GUINT64_FORMAT "\t%" G_GUINT64_FORMAT "\t%" G_GUINT64_FORMAT "\n",
+                                         target_uri, size, mtime, ttj_query_inode (job, target_file));
+
+      if (job->verify)
+        succeed = thunar_transfer_job_verify (job, source_file, target_file, size, mtime, source_digest, error);
+      else
+        g_free (source_digest);
+    }
+
+  g_free (target_uri);
+
+  return succeed;
 }
 
 
@@ -393,9 +1628,16 @@ ttj_copy_file (ThunarTransferJob *job,
     }
 
   /* try to copy the file */
-  g_file_copy (source_file, target_file, copy_flags,
-               exo_job_get_cancellable (EXO_JOB (job)),
-               thunar_transfer_job_progress, job, &err);
+  if ((job->journal != NULL || job->verify) && source_type == G_FILE_TYPE_REGULAR)
+    {
+      ttj_copy_regular_file (job, source_file, target_file, copy_flags, &err);
+    }
+  else
+    {
+      g_file_copy (source_file, target_file, copy_flags,
+                   exo_job_get_cancellable (EXO_JOB (job)),
+                   thunar_transfer_job_progress, job, &err);
+    }
 
   /* check if there were errors */
   if (G_UNLIKELY (err != NULL && err->domain == G_IO_ERROR))
@@ -597,6 +1839,7 @@ thunar_transfer_job_copy_node (ThunarTransferJob  *job,
                                GError            **error)
 {
   ThunarThumbnailCache *thumbnail_cache;
+  ThunarTransferPhase   phase;
   ThunarApplication    *application;
   ThunarJobResponse     response;
   GFileInfo            *info;
@@ -658,10 +1901,14 @@ retry_copy:
           /* node->source_file == real_target_file means to skip the file */
           if (G_LIKELY (node->source_file != real_target_file))
             {
+              job->n_files++;
+
               /* notify the thumbnail cache of the copy operation */
+              phase = thunar_transfer_job_set_phase (job, THUNAR_TRANSFER_PHASE_THUMBNAILS);
               thunar_thumbnail_cache_copy_file (thumbnail_cache,
                                                 node->source_file,
                                                 real_target_file);
+              thunar_transfer_job_set_phase (job, phase);
 
               /* check if we have children to copy */
               if (node->children != NULL)
@@ -700,8 +1947,10 @@ retry_remove:
                                      &err))
                     {
                       /* notify the thumbnail cache of the delete operation */
+                      phase = thunar_transfer_job_set_phase (job, THUNAR_TRANSFER_PHASE_THUMBNAILS);
                       thunar_thumbnail_cache_delete_file (thumbnail_cache,
                                                           node->source_file);
+                      thunar_transfer_job_set_phase (job, phase);
                     }
                   else
                     {
@@ -756,6 +2005,176 @@ retry_remove:
 
 
 
+static gboolean
+thunar_transfer_job_same_filesystem (ThunarTransferJob *job,
+                                     GFile             *source_file,
+                                     GFile             *target_file)
+{
+  GFileInfo *source_info;
+  GFileInfo *target_info = NULL;
+  gboolean   result = FALSE;
+  GFile     *target_parent;
+
+  source_info = g_file_query_info (source_file, G_FILE_ATTRIBUTE_ID_FILESYSTEM,
+                                   G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                   exo_job_get_cancellable (EXO_JOB (job)), NULL);
+  if (G_UNLIKELY (source_info == NULL))
+    return FALSE;
+
+  /* the target usually does not exist yet, so use its parent */
+  target_parent = g_file_get_parent (target_file);
+  if (G_LIKELY (target_parent != NULL))
+    {
+      target_info = g_file_query_info (target_parent, G_FILE_ATTRIBUTE_ID_FILESYSTEM,
+                                       G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                       exo_job_get_cancellable (EXO_JOB (job)), NULL);
+      g_object_unref (target_parent);
+    }
+
+  if (G_LIKELY (target_info != NULL))
+    {
+      result = exo_str_is_equal (g_file_info_get_attribute_string (source_info, G_FILE_ATTRIBUTE_ID_FILESYSTEM),
+                                 g_file_info_get_attribute_string (target_info, G_FILE_ATTRIBUTE_ID_FILESYSTEM));
+      g_object_unref (target_info);
+    }
+
+  g_object_unref (source_info);
+
+  return result;
+}
+
+
+
+/**
+ * thunar_transfer_job_move_file:
+ * @job             : a #ThunarTransferJob.
+ * @source_file     : the #GFile to move.
+ * @target_file     : the destination of @source_file.
+ * @merge           : whether to merge into an existing folder.
+ * @thumbnail_cache : the #ThunarThumbnailCache to notify.
+ * @error           : return location for errors or %NULL.
+ *
+ * Moves @source_file to @target_file without falling back to
+ * copying. If @merge is %TRUE and @target_file is an existing
+ * folder, the children of @source_file are moved into it one
+ * by one, asking the user about existing files, so this only
+ * scans the folders that actually conflict.
+ *
+ * If this fails, the remaining files are still in place below
+ * @source_file and the caller can fall back to copying them.
+ *
+ * Return value: %TRUE if @source_file was moved or skipped by
+ *               the user, %FALSE on error or cancellation.
+ **/
+static gboolean
+thunar_transfer_job_move_file (ThunarTransferJob    *job,
+                               GFile                *source_file,
+                               GFile                *target_file,
+                               gboolean              merge,
+                               ThunarThumbnailCache *thumbnail_cache,
+                               GError              **error)
+{
+  ThunarTransferPhase phase;
+  ThunarJobResponse   response;
+  GFileCopyFlags      copy_flags = G_FILE_COPY_NOFOLLOW_SYMLINKS | G_FILE_COPY_NO_FALLBACK_FOR_MOVE;
+  GError             *err = NULL;
+  GList              *file_list;
+  GList              *lp;
+  GFile              *target_child;
+  gchar              *base_name;
+
+  _thunar_return_val_if_fail (THUNAR_IS_TRANSFER_JOB (job), FALSE);
+  _thunar_return_val_if_fail (G_IS_FILE (source_file), FALSE);
+  _thunar_return_val_if_fail (G_IS_FILE (target_file), FALSE);
+  _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+retry_move:
+  if (g_file_move (source_file, target_file, copy_flags,
+                   exo_job_get_cancellable (EXO_JOB (job)),
+                   NULL, NULL, &err))
+    {
+      job->n_files++;
+
+      /* notify the thumbnail cache of the move operation */
+      phase = thunar_transfer_job_set_phase (job, THUNAR_TRANSFER_PHASE_THUMBNAILS);
+      thunar_thumbnail_cache_move_file (thumbnail_cache, source_file, target_file);
+      thunar_transfer_job_set_phase (job, phase);
+
+      return TRUE;
+    }
+
+  if (!merge || err->domain != G_IO_ERROR || err->code != G_IO_ERROR_EXISTS)
+    {
+      g_propagate_error (error, err);
+      return FALSE;
+    }
+
+  g_clear_error (&err);
+
+  if (g_file_query_file_type (source_file, G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                              exo_job_get_cancellable (EXO_JOB (job))) == G_FILE_TYPE_DIRECTORY
+      && g_file_query_file_type (target_file, G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                 exo_job_get_cancellable (EXO_JOB (job))) == G_FILE_TYPE_DIRECTORY)
+    {
+      /* merge the folders by moving the immediate children */
+      file_list = thunar_io_scan_directory (THUNAR_JOB (job), source_file,
+                                            G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                            FALSE, FALSE, FALSE, &err);
+
+      for (lp = file_list; err == NULL && lp != NULL; lp = lp->next)
+        {
+          base_name = g_file_get_basename (lp->data);
+          target_child = g_file_get_child (target_file, base_name);
+          g_free (base_name);
+
+          thunar_transfer_job_move_file (job, lp->data, target_child, TRUE,
+                                         thumbnail_cache, &err);
+
+          g_object_unref (target_child);
+        }
+
+      thunar_g_file_list_free (file_list);
+
+      /* remove the source folder, it is not empty if the user skipped files */
+      if (err == NULL
+          && !g_file_delete (source_file, exo_job_get_cancellable (EXO_JOB (job)), &err)
+          && g_error_matches (err, G_IO_ERROR, G_IO_ERROR_NOT_EMPTY))
+        {
+          g_clear_error (&err);
+        }
+    }
+  else if (!exo_job_set_error_if_cancelled (EXO_JOB (job), &err))
+    {
+      /* ask the user whether to replace the target file */
+      response = thunar_job_ask_replace (THUNAR_JOB (job), source_file, target_file, &err);
+
+      if (err == NULL)
+        {
+          if (response == THUNAR_JOB_RESPONSE_RETRY)
+            goto retry_move;
+
+          if (response == THUNAR_JOB_RESPONSE_YES)
+            {
+              copy_flags |= G_FILE_COPY_OVERWRITE;
+              goto retry_move;
+            }
+
+          /* abort if the user cancelled the job */
+          exo_job_set_error_if_cancelled (EXO_JOB (job), &err);
+        }
+    }
+
+  if (G_UNLIKELY (err != NULL))
+    {
+      g_propagate_error (error, err);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+
+
 static gboolean
 thunar_transfer_job_verify_destination (ThunarTransferJob  *transfer_job,
                                         GError            **error)
@@ -849,14 +2268,46 @@ thunar_transfer_job_verify_destination (ThunarTransferJob  *transfer_job,
 static gboolean
 thunar_transfer_job_execute (ExoJob  *job,
                              GError **error)
+{
+  ThunarTransferJob *transfer_job = THUNAR_TRANSFER_JOB (job);
+  gboolean           succeed;
+
+  _thunar_return_val_if_fail (THUNAR_IS_TRANSFER_JOB (job), FALSE);
+  _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  /* register the job for the telemetry */
+  transfer_job->phase = THUNAR_TRANSFER_PHASE_COLLECT;
+  transfer_job->phase_start_time = g_get_monotonic_time ();
+  thunar_transfer_job_publish (transfer_job, TRUE);
+
+  G_LOCK (transfer_jobs);
+  transfer_jobs = g_list_prepend (transfer_jobs, transfer_job);
+  G_UNLOCK (transfer_jobs);
+
+  succeed = thunar_transfer_job_run (transfer_job, error);
+
+  G_LOCK (transfer_jobs);
+  transfer_jobs = g_list_remove (transfer_jobs, transfer_job);
+  G_UNLOCK (transfer_jobs);
+
+  return succeed;
+}
+
+
+
+static gboolean
+thunar_transfer_job_run (ThunarTransferJob *transfer_job,
+                         GError           **error)
 {
   ThunarThumbnailCache *thumbnail_cache;
   ThunarTransferNode   *node;
   ThunarApplication    *application;
   ThunarJobResponse     response;
-  ThunarTransferJob    *transfer_job = THUNAR_TRANSFER_JOB (job);
+  ExoJob               *job = EXO_JOB (transfer_job);
   GFileInfo            *info;
   gboolean              parent_exists;
+  gboolean              merge;
+  gboolean              moved;
   GError               *err = NULL;
   GList                *new_files_list = NULL;
   GList                *snext;
@@ -867,12 +2318,12 @@ thunar_transfer_job_execute (ExoJob  *job,
   gchar                *base_name;
   gchar                *parent_display_name;
 
-  _thunar_return_val_if_fail (THUNAR_IS_TRANSFER_JOB (job), FALSE);
-  _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
-
   if (exo_job_set_error_if_cancelled (job, error))
     return FALSE;
 
+  /* look for the journal of an interrupted run of this transfer */
+  thunar_transfer_job_journal_load (transfer_job);
+
   exo_job_info_message (job, _("Collecting files..."));
 
   /* take a reference on the thumbnail cache */
@@ -981,17 +2432,17 @@ thunar_transfer_job_execute (ExoJob  *job,
           exo_job_info_message (job, _("Trying to move \"%s\""),
                                 g_file_info_get_display_name (info));
 
-          if (g_file_move (node->source_file, tp->data,
-                           G_FILE_COPY_NOFOLLOW_SYMLINKS
-                           | G_FILE_COPY_NO_FALLBACK_FOR_MOVE,
-                           exo_job_get_cancellable (job),
-                           NULL, NULL, &err))
-            {
-              /* notify the thumbnail cache of the move operation */
-              thunar_thumbnail_cache_move_file (thumbnail_cache,
-                                                node->source_file,
-                                                tp->data);
+          /* on the same filesystem, folders are merged with renames too, so
+           * only moves across devices need to collect the source tree */
+          merge = thunar_transfer_job_same_filesystem (transfer_job, node->source_file, tp->data);
 
+          thunar_transfer_job_set_phase (transfer_job, THUNAR_TRANSFER_PHASE_COPY);
+          moved = thunar_transfer_job_move_file (transfer_job, node->source_file, tp->data,
+                                                 merge, thumbnail_cache, &err);
+          thunar_transfer_job_set_phase (transfer_job, THUNAR_TRANSFER_PHASE_COLLECT);
+
+          if (moved)
+            {
               /* add the target file to the new files list */
               new_files_list = thunar_g_file_list_prepend (new_files_list, tp->data);
 
@@ -1036,6 +2487,7 @@ thunar_transfer_job_execute (ExoJob  *job,
   if (G_LIKELY (err == NULL))
     {
       /* check destination */
+      thunar_transfer_job_set_phase (transfer_job, THUNAR_TRANSFER_PHASE_VERIFY);
       if (!thunar_transfer_job_verify_destination (transfer_job, &err))
         {
           if (err != NULL)
@@ -1051,7 +2503,9 @@ thunar_transfer_job_execute (ExoJob  *job,
         }
 
       /* transfer starts now */
-      transfer_job->start_time = g_get_real_time ();
+      thunar_transfer_job_set_phase (transfer_job, THUNAR_TRANSFER_PHASE_COPY);
+      thunar_job_set_total_size (THUNAR_JOB (job), transfer_job->total_size);
+      thunar_transfer_job_journal_open (transfer_job);
 
       /* perform the copy recursively for all source transfer nodes */
       for (sp = transfer_job->source_node_list, tp = transfer_job->target_file_list;
@@ -1061,6 +2515,22 @@ thunar_transfer_job_execute (ExoJob  *job,
           thunar_transfer_job_copy_node (transfer_job, sp->data, tp->data, NULL,
                                          &new_files_list, &err);
         }
+
+      /* compare the copies with the originals */
+      if (G_LIKELY (err == NULL))
+        {
+          if (transfer_job->n_verify > 0)
+            {
+              thunar_transfer_job_set_phase (transfer_job, THUNAR_TRANSFER_PHASE_VERIFY);
+              exo_job_info_message (job, _("Verifying copied files..."));
+            }
+
+          thunar_transfer_job_verify_finish (transfer_job, &err);
+        }
+      else
+        {
+          thunar_transfer_job_verify_abort (transfer_job);
+        }
     }
 
   /* check if we failed */
@@ -1071,6 +2541,7 @@ thunar_transfer_job_execute (ExoJob  *job,
     }
   else
     {
+      thunar_transfer_job_journal_close (transfer_job);
       thunar_job_new_files (THUNAR_JOB (job), new_files_list);
       thunar_g_file_list_free (new_files_list);
       return TRUE;
@@ -1154,67 +2625,44 @@ thunar_transfer_job_new (GList                *source_node_list,
 
 
 
-gchar *
-thunar_transfer_job_get_status (ThunarTransferJob *job)
+/**
+ * thunar_transfer_job_get_stats:
+ * @stats : return location for the summary.
+ *
+ * Sums up the telemetry of all running transfer jobs into
+ * @stats. The values are refreshed by the jobs about twice
+ * a second. This function may be called from any thread.
+ **/
+void
+thunar_transfer_job_get_stats (ThunarTransferStats *stats)
 {
-  gchar             *total_size_str;
-  gchar             *total_progress_str;
-  gchar             *transfer_rate_str;
-  GString           *status;
-  gulong             remaining_time;
-
-  _thunar_return_val_if_fail (THUNAR_IS_TRANSFER_JOB (job), NULL);
+  ThunarTransferStats *job_stats;
+  GList               *lp;
+  guint                n;
 
-  status = g_string_sized_new (100);
+  _thunar_return_if_fail (stats != NULL);
 
-  /* transfer status like "22.6MB of 134.1MB" */
-  total_size_str = g_format_size_full (job->total_size, job->file_size_binary ? G_FORMAT_SIZE_IEC_UNITS : G_FORMAT_SIZE_DEFAULT);
-  total_progress_str = g_format_size_full (job->total_progress, job->file_size_binary ? G_FORMAT_SIZE_IEC_UNITS : G_FORMAT_SIZE_DEFAULT);
-  g_string_append_printf (status, _("%s of %s"), total_progress_str, total_size_str);
-  g_free (total_size_str);
-  g_free (total_progress_str);
+  memset (stats, 0, sizeof (*stats));
 
-  /* show time and transfer rate after 10 seconds */
-  if (job->transfer_rate > 0
-      && (job->last_update_time - job->start_time) > MINIMUM_TRANSFER_TIME)
+  G_LOCK (transfer_jobs);
+  for (lp = transfer_jobs; lp != NULL; lp = lp->next)
     {
-      /* remaining time based on the transfer speed */
-      transfer_rate_str = g_format_size_full (job->transfer_rate, job->file_size_binary ? G_FORMAT_SIZE_IEC_UNITS : G_FORMAT_SIZE_DEFAULT);
-      remaining_time = (job->total_size - job->total_progress) / job->transfer_rate;
+      job_stats = &((ThunarTransferJob *) lp->data)->stats;
 
-      if (remaining_time > 0)
-        {
-          /* insert long dash */
-          g_string_append (status, " \xE2\x80\x94 ");
-
-          if (remaining_time > 60 * 60)
-            {
-              remaining_time = (gulong) (remaining_time / (60 * 60));
-              g_string_append_printf (status, ngettext ("%lu hour remaining (%s/sec)",
-                                                        "%lu hours remaining (%s/sec)",
-                                                        remaining_time),
-                                                        remaining_time, transfer_rate_str);
-            }
-          else if (remaining_time > 60)
-            {
-              remaining_time = (gulong) (remaining_time / 60);
-              g_string_append_printf (status, ngettext ("%lu minute remaining (%s/sec)",
-                                                        "%lu minutes remaining (%s/sec)",
-                                                        remaining_time),
-                                                        remaining_time, transfer_rate_str);
-            }
-          else
-            {
-              g_string_append_printf (status, ngettext ("%lu second remaining (%s/sec)",
-                                                        "%lu seconds remaining (%s/sec)",
-                                                        remaining_time),
-                                                        remaining_time, transfer_rate_str);
-            }
-        }
+      stats->n_jobs += 1;
+      stats->n_files += job_stats->n_files;
+      stats->bytes_done += job_stats->bytes_done;
+      stats->bytes_total += job_stats->bytes_total;
+      stats->bytes_per_second += job_stats->bytes_per_second;
+      stats->files_per_second += job_stats->files_per_second;
 
-      g_free (transfer_rate_str);
+      for (n = 0; n < THUNAR_TRANSFER_N_PHASES; ++n)
+        stats->phase_time[n] += job_stats->phase_time[n];
     }
+  G_UNLOCK (transfer_jobs);
 
-  return g_string_free (status, FALSE);
+  if (stats->bytes_per_second > 0 && stats->bytes_total > stats->bytes_done)
+    stats->remaining_time = (stats->bytes_total - stats->bytes_done) / stats->bytes_per_second;
+  else
+    stats->remaining_time = -1;
 }
-
@@ -21,7 +21,7 @@
 #ifndef __THUNAR_TRANSFER_JOB_H__
 #define __THUNAR_TRANSFER_JOB_H__
 
-#include <glib-object.h>
+#include <thunar/thunar-job.h>
 
 G_BEGIN_DECLS
 
@@ -38,6 +38,23 @@ typedef enum /*< enum >*/
   THUNAR_TRANSFER_JOB_TRASH,
 } ThunarTransferJobType;
 
+/**
+ * ThunarTransferPhase:
+ *
+ * The phases a transfer job goes through, used for the
+ * timings in #ThunarTransferStats.
+ **/
+typedef enum
+{
+  THUNAR_TRANSFER_PHASE_COLLECT,
+  THUNAR_TRANSFER_PHASE_VERIFY,
+  THUNAR_TRANSFER_PHASE_COPY,
+  THUNAR_TRANSFER_PHASE_THUMBNAILS,
+  THUNAR_TRANSFER_N_PHASES,
+} ThunarTransferPhase;
+
+typedef struct _ThunarTransferStats ThunarTransferStats;
+
 typedef struct _ThunarTransferJobPrivate ThunarTransferJobPrivate;
 typedef struct _ThunarTransferJobClass   ThunarTransferJobClass;
 typedef struct _ThunarTransferJob        ThunarTransferJob;
@@ -55,7 +72,33 @@ ThunarJob *thunar_transfer_job_new        (GList                *source_file_lis
                                            GList                *target_file_list,
                                            ThunarTransferJobType type) G_GNUC_MALLOC G_GNUC_WARN_UNUSED_RESULT;
 
-gchar     *thunar_transfer_job_get_status (ThunarTransferJob    *job);
+void       thunar_transfer_job_get_stats  (ThunarTransferStats  *stats);
+
+/**
+ * ThunarTransferStats:
+ * @n_jobs           : number of running transfer jobs.
+ * @n_files          : number of files transferred so far.
+ * @bytes_done       : number of bytes copied so far.
+ * @bytes_total      : total number of bytes to copy.
+ * @bytes_per_second : moving average of the copy rate.
+ * @files_per_second : average number of files per second.
+ * @remaining_time   : estimated seconds left or -1 if unknown.
+ * @phase_time       : microseconds spent in each #ThunarTransferPhase.
+ *
+ * Summary of all running transfer jobs, see
+ * thunar_transfer_job_get_stats().
+ **/
+struct _ThunarTransferStats
+{
+  guint   n_jobs;
+  guint64 n_files;
+  guint64 bytes_done;
+  guint64 bytes_total;
+  guint64 bytes_per_second;
+  gdouble files_per_second;
+  gint64  remaining_time;
+  gint64  phase_time[THUNAR_TRANSFER_N_PHASES];
+};
 
 G_END_DECLS
 
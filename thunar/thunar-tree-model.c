@@ -30,8 +30,9 @@
 #endif
 
 #include <thunar/thunar-file-monitor.h>
-#include <thunar/thunar-folder.h>
 #include <thunar/thunar-gio-extensions.h>
+#include <thunar/thunar-io-jobs.h>
+#include <thunar/thunar-monitor-registry.h>
 #include <thunar/thunar-pango-extensions.h>
 #include <thunar/thunar-preferences.h>
 #include <thunar/thunar-private.h>
@@ -47,6 +48,10 @@
                                       && node->children->data == NULL \
                                       && node->children->next == NULL)
 
+/* seconds before the listing of a folder, that is no longer
+ * shown in the view, is released */
+#define THUNAR_TREE_MODEL_RELEASE_DELAY (15)
+
 
 
 /* Property identifiers */
@@ -134,18 +139,25 @@ static ThunarTreeModelItem *thunar_tree_model_item_new_with_device    (ThunarTre
                                                                        ThunarDevice           *device) G_GNUC_MALLOC;
 static void                 thunar_tree_model_item_free               (ThunarTreeModelItem    *item);
 static void                 thunar_tree_model_item_reset              (ThunarTreeModelItem    *item);
+static void                 thunar_tree_model_item_unload             (ThunarTreeModelItem    *item);
 static void                 thunar_tree_model_item_load_folder        (ThunarTreeModelItem    *item);
+static void                 thunar_tree_model_item_list_folder        (ThunarTreeModelItem    *item);
 static void                 thunar_tree_model_item_files_added        (ThunarTreeModelItem    *item,
-                                                                       GList                  *files,
-                                                                       ThunarFolder           *folder);
+                                                                       GList                  *files);
 static void                 thunar_tree_model_item_files_removed      (ThunarTreeModelItem    *item,
-                                                                       GList                  *files,
-                                                                       ThunarFolder           *folder);
+                                                                       GList                  *files);
 static gboolean             thunar_tree_model_item_load_idle          (gpointer                user_data);
 static void                 thunar_tree_model_item_load_idle_destroy  (gpointer                user_data);
-static void                 thunar_tree_model_item_notify_loading     (ThunarTreeModelItem    *item,
-                                                                       GParamSpec             *pspec,
-                                                                       ThunarFolder           *folder);
+static gboolean             thunar_tree_model_item_files_ready        (ThunarJob              *job,
+                                                                       GList                  *files,
+                                                                       ThunarTreeModelItem    *item);
+static void                 thunar_tree_model_item_load_finished      (ThunarJob              *job,
+                                                                       ThunarTreeModelItem    *item);
+static void                 thunar_tree_model_item_monitor_changed    (GFileMonitor           *monitor,
+                                                                       GFile                  *event_file,
+                                                                       GFile                  *other_file,
+                                                                       GFileMonitorEvent       event_type,
+                                                                       ThunarTreeModelItem    *item);
 static void                 thunar_tree_model_node_insert_dummy       (GNode                  *parent,
                                                                        ThunarTreeModel        *model);
 static void                 thunar_tree_model_node_drop_dummy         (GNode                  *node,
@@ -205,10 +217,22 @@ struct _ThunarTreeModelItem
   gint             ref_count;
   guint            load_idle_id;
   ThunarFile      *file;
-  ThunarFolder    *folder;
   ThunarDevice    *device;
   ThunarTreeModel *model;
 
+  /* the sub folders are listed by the job
+   * and kept up to date by the monitor */
+  ThunarJob       *job;
+  GFileMonitor    *monitor;
+  GCancellable    *cancellable;
+  guint            loaded : 1;
+
+  /* sub folders found by a rescan, the others are dropped when it ends */
+  GHashTable      *rescan_files;
+
+  /* monotonic time the view dropped its last reference */
+  gint64           unused_since;
+
   /* list of children of this node that are
    * not visible in the treeview */
   GSList          *invisible_children;
@@ -220,6 +244,19 @@ typedef struct
   GNode *node;
 } SortTuple;
 
+typedef struct
+{
+  ThunarTreeModelItem *item;
+  GCancellable        *cancellable;
+} ThunarTreeModelLookup;
+
+typedef struct
+{
+  ThunarTreeModel *model;
+  gint64           now;
+  gboolean         pending;
+} CleanupData;
+
 
 
 G_DEFINE_TYPE_WITH_CODE (ThunarTreeModel, thunar_tree_model, G_TYPE_OBJECT,
@@ -819,7 +856,13 @@ thunar_tree_model_unref_node (GtkTreeModel *tree_model,
   /* check if this a non-dummy item, if so, decrement the reference count */
   item = node->data;
   if (G_LIKELY (item != NULL))
-    item->ref_count -= 1;
+    {
+      item->ref_count -= 1;
+
+      /* remember when the item became unused, see the cleanup */
+      if (item->ref_count == 0)
+        item->unused_since = g_get_monotonic_time ();
+    }
 
   /* NOTE: we don't cleanup nodes when the item ref count is zero,
    * because GtkTreeView also does a lot of reffing when scrolling the
@@ -917,16 +960,22 @@ static gboolean
 thunar_tree_model_cleanup_idle (gpointer user_data)
 {
   ThunarTreeModel *model = THUNAR_TREE_MODEL (user_data);
+  CleanupData      data;
 
   GDK_THREADS_ENTER ();
 
+  data.model = model;
+  data.now = g_get_monotonic_time ();
+  data.pending = FALSE;
+
   /* walk through the tree and release all the nodes with a ref count of 0 */
   g_node_traverse (model->root, G_PRE_ORDER, G_TRAVERSE_ALL, -1,
-                   thunar_tree_model_node_traverse_cleanup, model);
+                   thunar_tree_model_node_traverse_cleanup, &data);
 
   GDK_THREADS_LEAVE ();
 
-  return FALSE;
+  /* check again if some folders were not unused long enough */
+  return data.pending;
 }
 
 
@@ -1188,13 +1237,8 @@ thunar_tree_model_item_reset (ThunarTreeModelItem *item)
   if (G_UNLIKELY (item->load_idle_id != 0))
     g_source_remove (item->load_idle_id);
 
-  /* disconnect from the folder */
-  if (G_LIKELY (item->folder != NULL))
-    {
-      g_signal_handlers_disconnect_matched (G_OBJECT (item->folder), G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, item);
-      g_object_unref (G_OBJECT (item->folder));
-      item->folder = NULL;
-    }
+  /* release the listing */
+  thunar_tree_model_item_unload (item);
 
   /* free all the invisible children */
   if (item->invisible_children != NULL)
@@ -1218,13 +1262,52 @@ thunar_tree_model_item_reset (ThunarTreeModelItem *item)
 
 
 
+static void
+thunar_tree_model_item_unload (ThunarTreeModelItem *item)
+{
+  /* cancel a running listing */
+  if (G_UNLIKELY (item->job != NULL))
+    {
+      g_signal_handlers_disconnect_matched (G_OBJECT (item->job), G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, item);
+      exo_job_cancel (EXO_JOB (item->job));
+      g_object_unref (G_OBJECT (item->job));
+      item->job = NULL;
+    }
+
+  if (item->rescan_files != NULL)
+    {
+      g_hash_table_destroy (item->rescan_files);
+      item->rescan_files = NULL;
+    }
+
+  /* stop watching the folder */
+  if (G_LIKELY (item->monitor != NULL))
+    {
+      g_signal_handlers_disconnect_matched (G_OBJECT (item->monitor), G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, item);
+      thunar_monitor_registry_release (item->monitor);
+      item->monitor = NULL;
+    }
+
+  /* forget about the lookups of created folders */
+  if (item->cancellable != NULL)
+    {
+      g_cancellable_cancel (item->cancellable);
+      g_object_unref (item->cancellable);
+      item->cancellable = NULL;
+    }
+
+  item->loaded = FALSE;
+}
+
+
+
 static void
 thunar_tree_model_item_load_folder (ThunarTreeModelItem *item)
 {
   _thunar_return_if_fail (THUNAR_IS_FILE (item->file) || THUNAR_IS_DEVICE (item->device));
 
   /* schedule the "load" idle source (if not already done) */
-  if (G_LIKELY (item->load_idle_id == 0 && item->folder == NULL))
+  if (G_LIKELY (item->load_idle_id == 0 && !item->loaded))
     {
       item->load_idle_id = g_idle_add_full (G_PRIORITY_HIGH, thunar_tree_model_item_load_idle,
                                             item, thunar_tree_model_item_load_idle_destroy);
@@ -1235,22 +1318,43 @@ thunar_tree_model_item_load_folder (ThunarTreeModelItem *item)
 
 static void
 thunar_tree_model_item_files_added (ThunarTreeModelItem *item,
-                                    GList               *files,
-                                    ThunarFolder        *folder)
+                                    GList               *files)
 {
   ThunarTreeModelItem *child_item;
   ThunarTreeModel     *model = THUNAR_TREE_MODEL (item->model);
   GtkTreePath         *child_path;
   GtkTreeIter          child_iter;
   ThunarFile          *file;
+  gboolean             added = FALSE;
+  GHashTable          *known = NULL;
+  GSList              *sp;
   GNode               *child_node;
-  GNode               *node = NULL;
+  GNode               *node;
   GList               *lp;
 
-  _thunar_return_if_fail (THUNAR_IS_FOLDER (folder));
-  _thunar_return_if_fail (item->folder == folder);
+  _thunar_return_if_fail (item->loaded);
   _thunar_return_if_fail (model->visible_func != NULL);
 
+  /* lookup the node for the item */
+  node = g_node_find (model->root, G_POST_ORDER, G_TRAVERSE_ALL, item);
+  _thunar_return_if_fail (node != NULL);
+
+  /* the children known before this call: the monitor can report
+   * folders that were also found by the listing (and vice versa),
+   * within one call the files are unique */
+  if (!G_NODE_HAS_DUMMY (node) || item->invisible_children != NULL)
+    {
+      known = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+      if (!G_NODE_HAS_DUMMY (node))
+        for (child_node = g_node_first_child (node); child_node != NULL; child_node = g_node_next_sibling (child_node))
+          if (G_LIKELY (child_node->data != NULL))
+            g_hash_table_insert (known, THUNAR_TREE_MODEL_ITEM (child_node->data)->file, NULL);
+
+      for (sp = item->invisible_children; sp != NULL; sp = sp->next)
+        g_hash_table_insert (known, sp->data, NULL);
+    }
+
   /* process all specified files */
   for (lp = files; lp != NULL; lp = lp->next)
     {
@@ -1259,6 +1363,10 @@ thunar_tree_model_item_files_added (ThunarTreeModelItem *item,
       if (!thunar_file_is_directory (file))
         continue;
 
+      /* skip folders we already know about */
+      if (G_UNLIKELY (known != NULL && g_hash_table_lookup_extended (known, file, NULL, NULL)))
+        continue;
+
       /* if this file should be visible */
       if (!model->visible_func (model, file, model->visible_data))
         {
@@ -1268,11 +1376,6 @@ thunar_tree_model_item_files_added (ThunarTreeModelItem *item,
           continue;
         }
 
-      /* lookup the node for the item (on-demand) */
-      if (G_UNLIKELY (node == NULL))
-        node = g_node_find (model->root, G_POST_ORDER, G_TRAVERSE_ALL, item);
-      _thunar_return_if_fail (node != NULL);
-
       /* allocate a new item for the file */
       child_item = thunar_tree_model_item_new_with_file (model, file);
 
@@ -1307,10 +1410,15 @@ thunar_tree_model_item_files_added (ThunarTreeModelItem *item,
 
       /* add a dummy child node */
       thunar_tree_model_node_insert_dummy (child_node, model);
+
+      added = TRUE;
     }
 
+  if (known != NULL)
+    g_hash_table_destroy (known);
+
   /* sort the folders if any new ones were added */
-  if (G_LIKELY (node != NULL))
+  if (G_LIKELY (added))
     thunar_tree_model_sort (model, node);
 }
 
@@ -1318,8 +1426,7 @@ thunar_tree_model_item_files_added (ThunarTreeModelItem *item,
 
 static void
 thunar_tree_model_item_files_removed (ThunarTreeModelItem *item,
-                                      GList               *files,
-                                      ThunarFolder        *folder)
+                                      GList               *files)
 {
   ThunarTreeModel *model = item->model;
   GtkTreePath     *path;
@@ -1329,8 +1436,7 @@ thunar_tree_model_item_files_removed (ThunarTreeModelItem *item,
   GList           *lp;
   GSList          *inv_link;
 
-  _thunar_return_if_fail (THUNAR_IS_FOLDER (folder));
-  _thunar_return_if_fail (item->folder == folder);
+  _thunar_return_if_fail (item->loaded);
 
   /* determine the node for the folder */
   node = g_node_find (model->root, G_POST_ORDER, G_TRAVERSE_ALL, item);
@@ -1387,26 +1493,195 @@ thunar_tree_model_item_files_removed (ThunarTreeModelItem *item,
 
 
 static void
-thunar_tree_model_item_notify_loading (ThunarTreeModelItem *item,
-                                       GParamSpec          *pspec,
-                                       ThunarFolder        *folder)
+thunar_tree_model_item_list_folder (ThunarTreeModelItem *item)
 {
-  GNode *node;
+  _thunar_return_if_fail (item->job == NULL);
+  _thunar_return_if_fail (THUNAR_IS_FILE (item->file));
+
+  /* list the sub folders (and nothing else) in the background */
+  item->job = thunar_io_jobs_list_directories (thunar_file_get_file (item->file));
+  g_signal_connect (G_OBJECT (item->job), "files-ready", G_CALLBACK (thunar_tree_model_item_files_ready), item);
+  g_signal_connect (G_OBJECT (item->job), "finished", G_CALLBACK (thunar_tree_model_item_load_finished), item);
+}
+
+
 
-  _thunar_return_if_fail (THUNAR_IS_FOLDER (folder));
-  _thunar_return_if_fail (item->folder == folder);
+static gboolean
+thunar_tree_model_item_files_ready (ThunarJob           *job,
+                                    GList               *files,
+                                    ThunarTreeModelItem *item)
+{
+  GList *lp;
+
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
+  _thunar_return_val_if_fail (item->job == job, FALSE);
+
+  /* remember the folders that still exist */
+  if (item->rescan_files != NULL)
+    {
+      for (lp = files; lp != NULL; lp = lp->next)
+        g_hash_table_insert (item->rescan_files, g_object_ref (lp->data), NULL);
+    }
+
+  thunar_tree_model_item_files_added (item, files);
+
+  /* the job releases the files */
+  return FALSE;
+}
+
+
+
+static void
+thunar_tree_model_item_load_finished (ThunarJob           *job,
+                                      ThunarTreeModelItem *item)
+{
+  GNode  *child_node;
+  GNode  *node;
+  GList  *files = NULL;
+  GSList *sp;
+
+  _thunar_return_if_fail (THUNAR_IS_JOB (job));
+  _thunar_return_if_fail (item->job == job);
   _thunar_return_if_fail (THUNAR_IS_TREE_MODEL (item->model));
 
-  /* be sure to drop the dummy child node once the folder is loaded */
-  if (G_LIKELY (!thunar_folder_get_loading (folder)))
+  /* release the job */
+  g_signal_handlers_disconnect_matched (G_OBJECT (job), G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, item);
+  g_object_unref (G_OBJECT (job));
+  item->job = NULL;
+
+  /* lookup the node for the item... */
+  node = g_node_find (item->model->root, G_POST_ORDER, G_TRAVERSE_ALL, item);
+  _thunar_return_if_fail (node != NULL);
+
+  /* drop the folders the rescan did not find anymore, unless
+   * the rescan was cancelled */
+  if (item->rescan_files != NULL)
     {
-      /* lookup the node for the item... */
-      node = g_node_find (item->model->root, G_POST_ORDER, G_TRAVERSE_ALL, item);
-      _thunar_return_if_fail (node != NULL);
+      if (!exo_job_is_cancelled (EXO_JOB (job)))
+        {
+          for (child_node = g_node_first_child (node); child_node != NULL; child_node = g_node_next_sibling (child_node))
+            if (child_node->data != NULL
+                && !g_hash_table_lookup_extended (item->rescan_files, THUNAR_TREE_MODEL_ITEM (child_node->data)->file, NULL, NULL))
+              files = g_list_prepend (files, g_object_ref (THUNAR_TREE_MODEL_ITEM (child_node->data)->file));
+
+          for (sp = item->invisible_children; sp != NULL; sp = sp->next)
+            if (!g_hash_table_lookup_extended (item->rescan_files, sp->data, NULL, NULL))
+              files = g_list_prepend (files, g_object_ref (sp->data));
 
-      /* ...and drop the dummy for the node */
-      if (G_NODE_HAS_DUMMY (node))
-        thunar_tree_model_node_drop_dummy (node, item->model);
+          if (files != NULL)
+            {
+              thunar_tree_model_item_files_removed (item, files);
+              g_list_free_full (files, g_object_unref);
+            }
+        }
+
+      g_hash_table_destroy (item->rescan_files);
+      item->rescan_files = NULL;
+    }
+
+  /* ...and drop the dummy for the node */
+  if (G_NODE_HAS_DUMMY (node))
+    thunar_tree_model_node_drop_dummy (node, item->model);
+}
+
+
+
+static void
+thunar_tree_model_item_file_created (GFile      *location,
+                                     ThunarFile *file,
+                                     GError     *error,
+                                     gpointer    user_data)
+{
+  ThunarTreeModelLookup *lookup = user_data;
+  GList                  files;
+
+  /* the item is gone if the lookup was cancelled */
+  if (!g_cancellable_is_cancelled (lookup->cancellable)
+      && error == NULL
+      && thunar_file_is_directory (file))
+    {
+      _thunar_assert (lookup->item->cancellable == lookup->cancellable);
+
+      /* only new folders are interesting */
+      files.data = file;
+      files.next = NULL;
+      files.prev = NULL;
+      thunar_tree_model_item_files_added (lookup->item, &files);
+    }
+
+  g_object_unref (lookup->cancellable);
+  g_slice_free (ThunarTreeModelLookup, lookup);
+}
+
+
+
+static void
+thunar_tree_model_item_monitor_changed (GFileMonitor        *monitor,
+                                        GFile               *event_file,
+                                        GFile               *other_file,
+                                        GFileMonitorEvent    event_type,
+                                        ThunarTreeModelItem *item)
+{
+  ThunarTreeModelLookup *lookup;
+  ThunarFile            *file;
+  gboolean               is_directory;
+  GList                  files;
+
+  _thunar_return_if_fail (G_IS_FILE_MONITOR (monitor));
+  _thunar_return_if_fail (item->monitor == monitor);
+
+  if (event_type == G_FILE_MONITOR_EVENT_CREATED)
+    {
+      /* query the new file without blocking the main loop */
+      if (item->cancellable == NULL)
+        item->cancellable = g_cancellable_new ();
+
+      lookup = g_slice_new (ThunarTreeModelLookup);
+      lookup->item = item;
+      lookup->cancellable = g_object_ref (item->cancellable);
+
+      thunar_file_get_async (event_file, item->cancellable,
+                             thunar_tree_model_item_file_created, lookup);
+    }
+  else if (event_type == G_FILE_MONITOR_EVENT_CHANGED)
+    {
+      /* the polling fallback only reports that the folder itself
+       * changed, only sub folders we know of matter otherwise */
+      if (!g_file_equal (event_file, thunar_file_get_file (item->file)))
+        {
+          file = thunar_file_cache_lookup (event_file);
+          if (G_LIKELY (file == NULL))
+            return;
+
+          is_directory = thunar_file_is_directory (file);
+          g_object_unref (G_OBJECT (file));
+
+          if (!is_directory)
+            return;
+        }
+
+      /* rescan the folder in the background, the job refreshes the
+       * sub folders we know of and the tree is updated through the
+       * "file-changed" signal */
+      if (item->job == NULL)
+        {
+          item->rescan_files = g_hash_table_new_full (g_direct_hash, g_direct_equal, g_object_unref, NULL);
+          thunar_tree_model_item_list_folder (item);
+        }
+    }
+  else if (event_type == G_FILE_MONITOR_EVENT_DELETED)
+    {
+      /* a file we don't know cannot be in the tree */
+      file = thunar_file_cache_lookup (event_file);
+      if (G_UNLIKELY (file == NULL))
+        return;
+
+      files.data = file;
+      files.next = NULL;
+      files.prev = NULL;
+      thunar_tree_model_item_files_removed (item, &files);
+
+      g_object_unref (G_OBJECT (file));
     }
 }
 
@@ -1417,12 +1692,12 @@ thunar_tree_model_item_load_idle (gpointer user_data)
 {
   ThunarTreeModelItem *item = user_data;
   GFile               *mount_point;
-  GList               *files;
+  GFile               *location;
 #ifndef NDEBUG
   GNode               *node;
 #endif
 
-  _thunar_return_val_if_fail (item->folder == NULL, FALSE);
+  _thunar_return_val_if_fail (!item->loaded, FALSE);
 
 #ifndef NDEBUG
       /* find the node in the tree */
@@ -1451,24 +1726,16 @@ thunar_tree_model_item_load_idle (gpointer user_data)
   /* verify that we have a file */
   if (G_LIKELY (item->file != NULL))
     {
-      /* open the folder for the item */
-      item->folder = thunar_folder_get_for_file (item->file);
-      if (G_LIKELY (item->folder != NULL))
-        {
-          /* connect signals */
-          g_signal_connect_swapped (G_OBJECT (item->folder), "files-added", G_CALLBACK (thunar_tree_model_item_files_added), item);
-          g_signal_connect_swapped (G_OBJECT (item->folder), "files-removed", G_CALLBACK (thunar_tree_model_item_files_removed), item);
-          g_signal_connect_swapped (G_OBJECT (item->folder), "notify::loading", G_CALLBACK (thunar_tree_model_item_notify_loading), item);
-
-          /* load the initial set of files (if any) */
-          files = thunar_folder_get_files (item->folder);
-          if (G_UNLIKELY (files != NULL))
-            thunar_tree_model_item_files_added (item, files, item->folder);
-
-          /* notify for "loading" if already loaded */
-          if (!thunar_folder_get_loading (item->folder))
-            g_object_notify (G_OBJECT (item->folder), "loading");
-        }
+      item->loaded = TRUE;
+      location = thunar_file_get_file (item->file);
+
+      /* watch the folder before listing it, so no folder created in
+       * the meantime is missed, duplicates are skipped when added */
+      item->monitor = thunar_monitor_registry_get_directory (location, G_FILE_MONITOR_NONE);
+      if (G_LIKELY (item->monitor != NULL))
+        g_signal_connect (G_OBJECT (item->monitor), "changed", G_CALLBACK (thunar_tree_model_item_monitor_changed), item);
+
+      thunar_tree_model_item_list_folder (item);
     }
 
   GDK_THREADS_LEAVE ();
@@ -1555,14 +1822,20 @@ thunar_tree_model_node_traverse_cleanup (GNode    *node,
                                          gpointer  user_data)
 {
   ThunarTreeModelItem *item = node->data;
-  ThunarTreeModel     *model = THUNAR_TREE_MODEL (user_data);
+  CleanupData         *data = user_data;
+  ThunarTreeModel     *model = data->model;
 
-  if (item && item->folder != NULL && item->ref_count == 0)
+  if (item && item->loaded && item->ref_count == 0)
     {
-      /* disconnect from the folder */
-      g_signal_handlers_disconnect_matched (G_OBJECT (item->folder), G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, item);
-      g_object_unref (G_OBJECT (item->folder));
-      item->folder = NULL;
+      /* keep the folder for a while, the user might expand it again */
+      if (data->now - item->unused_since < THUNAR_TREE_MODEL_RELEASE_DELAY * G_USEC_PER_SEC)
+        {
+          data->pending = TRUE;
+          return FALSE;
+        }
+
+      /* release the listing and the monitor */
+      thunar_tree_model_item_unload (item);
 
       /* remove all the children of the node */
       while (node->children)
@@ -1915,7 +2188,8 @@ thunar_tree_model_refilter (ThunarTreeModel *model)
  * @model : a #ThunarTreeModel.
  *
  * Walks all the folders in the #ThunarTreeModel and release them when
- * they are unused by the treeview.
+ * they are unused by the treeview for THUNAR_TREE_MODEL_RELEASE_DELAY
+ * seconds.
  **/
 void
 thunar_tree_model_cleanup (ThunarTreeModel *model)
@@ -1925,8 +2199,9 @@ thunar_tree_model_cleanup (ThunarTreeModel *model)
   /* schedule an idle cleanup, if not already done */
   if (model->cleanup_idle_id == 0)
     {
-      model->cleanup_idle_id = g_timeout_add_full (G_PRIORITY_LOW, 500, thunar_tree_model_cleanup_idle,
-                                                   model, thunar_tree_model_cleanup_idle_destroy);
+      model->cleanup_idle_id = g_timeout_add_seconds_full (G_PRIORITY_LOW, THUNAR_TREE_MODEL_RELEASE_DELAY,
+                                                           thunar_tree_model_cleanup_idle, model,
+                                                           thunar_tree_model_cleanup_idle_destroy);
     }
 }
 
@@ -180,6 +180,15 @@ static void     thunar_window_action_tree_changed         (GtkToggleAction
                                                            ThunarWindow           *window);
 static void     thunar_window_action_statusbar_changed    (GtkToggleAction        *action,
                                                            ThunarWindow           *window);
+static void     thunar_window_action_filterbar_changed    (GtkToggleAction        *action,
+                                                           ThunarWindow           *window);
+static gboolean thunar_window_filter_key_press_event      (GtkWidget              *entry,
+                                                           GdkEventKey            *event,
+                                                           ThunarWindow           *window);
+static void     thunar_window_filter_icon_release         (GtkEntry               *entry,
+                                                           GtkEntryIconPosition    icon_pos,
+                                                           GdkEvent               *event,
+                                                           ThunarWindow           *window);
 static void     thunar_window_action_menubar_changed      (GtkToggleAction        *action,
                                                            ThunarWindow           *window);
 static void     thunar_window_action_zoom_in              (GtkAction              *action,
@@ -316,6 +325,8 @@ struct _ThunarWindow
   GtkWidget              *notebook;
   GtkWidget              *view;
   GtkWidget              *statusbar;
+  GtkWidget              *filterbar;
+  GtkWidget              *filter_entry;
 
   GType                   view_type;
   GSList                 *view_bindings;
@@ -384,6 +395,7 @@ static const GtkToggleActionEntry toggle_action_entries[] =
   { "view-side-pane-shortcuts", NULL, N_ ("_Shortcuts"), "<control>B", N_ ("Toggles the visibility of the shortcuts pane"), G_CALLBACK (thunar_window_action_shortcuts_changed), FALSE, },
   { "view-side-pane-tree", NULL, N_ ("_Tree"), "<control>E", N_ ("Toggles the visibility of the tree pane"), G_CALLBACK (thunar_window_action_tree_changed), FALSE, },
   { "view-statusbar", NULL, N_ ("St_atusbar"), NULL, N_ ("Change the visibility of this window's statusbar"), G_CALLBACK (thunar_window_action_statusbar_changed), FALSE, },
+  { "view-filterbar", NULL, N_ ("_Filter Bar"), "<control>F", N_ ("Only show the files whose name contains the entered text"), G_CALLBACK (thunar_window_action_filterbar_changed), FALSE, },
   { "view-menubar", NULL, N_ ("_Menubar"), "<control>M", N_ ("Change the visibility of this window's menubar"), G_CALLBACK (thunar_window_action_menubar_changed), TRUE, },
 };
 
@@ -858,7 +870,7 @@ thunar_window_init (ThunarWindow *window)
   g_signal_connect_swapped (window->paned, "accept-position", G_CALLBACK (thunar_window_save_paned), window);
   g_signal_connect_swapped (window->paned, "button-release-event", G_CALLBACK (thunar_window_save_paned), window);
 
-  window->view_box = gtk_table_new (3, 1, FALSE);
+  window->view_box = gtk_table_new (4, 1, FALSE);
   gtk_paned_pack2 (GTK_PANED (window->paned), window->view_box, TRUE, FALSE);
   gtk_widget_show (window->view_box);
 
@@ -1399,6 +1411,7 @@ thunar_window_notebook_switch_page (GtkWidget    *notebook,
   GtkAction  *action;
   GSList     *view_bindings;
   ThunarFile *current_directory;
+  gchar      *filter_text;
 
   _thunar_return_if_fail (THUNAR_IS_WINDOW (window));
   _thunar_return_if_fail (GTK_IS_NOTEBOOK (notebook));
@@ -1464,9 +1477,29 @@ thunar_window_notebook_switch_page (GtkWidget    *notebook,
                                     G_BINDING_SYNC_CREATE);
     }
 
+  /* connect to the filter bar (if any) */
+  if (G_UNLIKELY (window->filterbar != NULL))
+    {
+      thunar_window_binding_create (window, page, "filter-text",
+                                    window->filter_entry, "text",
+                                    G_BINDING_SYNC_CREATE | G_BINDING_BIDIRECTIONAL);
+    }
+
   /* activate new view */
   window->view = page;
 
+  /* show the filter bar if the new view is filtered */
+  if (window->filterbar == NULL)
+    {
+      g_object_get (G_OBJECT (page), "filter-text", &filter_text, NULL);
+      if (G_UNLIKELY (filter_text != NULL && *filter_text != '\0'))
+        {
+          action = gtk_action_group_get_action (window->action_group, "view-filterbar");
+          gtk_toggle_action_set_active (GTK_TOGGLE_ACTION (action), TRUE);
+        }
+      g_free (filter_text);
+    }
+
   /* integrate the standard view action in the ui */
   thunar_component_set_ui_manager (THUNAR_COMPONENT (page), window->ui_manager);
 
@@ -2668,7 +2701,7 @@ thunar_window_action_statusbar_changed (GtkToggleAction *action,
     {
       /* setup a new statusbar */
       window->statusbar = thunar_statusbar_new ();
-      gtk_table_attach (GTK_TABLE (window->view_box), window->statusbar, 0, 1, 2, 3, GTK_EXPAND | GTK_FILL, GTK_FILL, 0, 0);
+      gtk_table_attach (GTK_TABLE (window->view_box), window->statusbar, 0, 1, 3, 4, GTK_EXPAND | GTK_FILL, GTK_FILL, 0, 0);
       gtk_widget_show (window->statusbar);
 
       /* connect to the view (if any) */
@@ -2683,6 +2716,119 @@ thunar_window_action_statusbar_changed (GtkToggleAction *action,
 
 
 
+static void
+thunar_window_action_filterbar_changed (GtkToggleAction *action,
+                                        ThunarWindow    *window)
+{
+  GtkWidget *label;
+  gboolean   active;
+
+  _thunar_return_if_fail (GTK_IS_TOGGLE_ACTION (action));
+  _thunar_return_if_fail (THUNAR_IS_WINDOW (window));
+
+  /* determine the new state of the action */
+  active = gtk_toggle_action_get_active (action);
+
+  /* check if we should drop the filter bar */
+  if (!active && window->filterbar != NULL)
+    {
+      /* show all files again */
+      if (G_LIKELY (window->view != NULL))
+        g_object_set (G_OBJECT (window->view), "filter-text", NULL, NULL);
+
+      /* just get rid of the filter bar, the binding to the view is
+       * released together with the entry */
+      gtk_widget_destroy (window->filterbar);
+      window->filterbar = NULL;
+      window->filter_entry = NULL;
+
+      /* give the focus back to the view */
+      if (G_LIKELY (window->view != NULL))
+        gtk_widget_grab_focus (window->view);
+    }
+  else if (active && window->filterbar == NULL)
+    {
+      /* setup a new filter bar */
+      window->filterbar = gtk_hbox_new (FALSE, 6);
+      gtk_container_set_border_width (GTK_CONTAINER (window->filterbar), 2);
+      gtk_table_attach (GTK_TABLE (window->view_box), window->filterbar, 0, 1, 2, 3, GTK_EXPAND | GTK_FILL, GTK_FILL, 0, 0);
+      gtk_widget_show (window->filterbar);
+
+      label = gtk_label_new_with_mnemonic (_("_Filter:"));
+      gtk_box_pack_start (GTK_BOX (window->filterbar), label, FALSE, FALSE, 0);
+      gtk_widget_show (label);
+
+      window->filter_entry = gtk_entry_new ();
+      gtk_entry_set_icon_from_stock (GTK_ENTRY (window->filter_entry), GTK_ENTRY_ICON_SECONDARY, GTK_STOCK_CLEAR);
+      gtk_entry_set_icon_tooltip_text (GTK_ENTRY (window->filter_entry), GTK_ENTRY_ICON_SECONDARY, _("Show all files"));
+      g_signal_connect (G_OBJECT (window->filter_entry), "icon-release", G_CALLBACK (thunar_window_filter_icon_release), window);
+      g_signal_connect (G_OBJECT (window->filter_entry), "key-press-event", G_CALLBACK (thunar_window_filter_key_press_event), window);
+      gtk_label_set_mnemonic_widget (GTK_LABEL (label), window->filter_entry);
+      gtk_box_pack_start (GTK_BOX (window->filterbar), window->filter_entry, TRUE, TRUE, 0);
+      gtk_widget_show (window->filter_entry);
+
+      /* connect to the view (if any) */
+      if (G_LIKELY (window->view != NULL))
+        {
+          thunar_window_binding_create (window, window->view, "filter-text",
+                                        window->filter_entry, "text",
+                                        G_BINDING_SYNC_CREATE | G_BINDING_BIDIRECTIONAL);
+        }
+
+      gtk_widget_grab_focus (window->filter_entry);
+    }
+}
+
+
+
+static gboolean
+thunar_window_filter_key_press_event (GtkWidget    *entry,
+                                      GdkEventKey  *event,
+                                      ThunarWindow *window)
+{
+  GtkAction *action;
+
+  _thunar_return_val_if_fail (THUNAR_IS_WINDOW (window), FALSE);
+  _thunar_return_val_if_fail (window->filter_entry == entry, FALSE);
+
+  switch (event->keyval)
+    {
+    case GDK_Escape:
+      /* hide the filter bar */
+      action = gtk_action_group_get_action (window->action_group, "view-filterbar");
+      gtk_toggle_action_set_active (GTK_TOGGLE_ACTION (action), FALSE);
+      return TRUE;
+
+    case GDK_Return:
+    case GDK_KP_Enter:
+    case GDK_Down:
+      /* continue in the filtered view */
+      if (G_LIKELY (window->view != NULL))
+        gtk_widget_grab_focus (window->view);
+      return TRUE;
+
+    default:
+      return FALSE;
+    }
+}
+
+
+
+static void
+thunar_window_filter_icon_release (GtkEntry             *entry,
+                                   GtkEntryIconPosition  icon_pos,
+                                   GdkEvent             *event,
+                                   ThunarWindow         *window)
+{
+  _thunar_return_if_fail (THUNAR_IS_WINDOW (window));
+  _thunar_return_if_fail (GTK_IS_ENTRY (entry));
+
+  if (icon_pos == GTK_ENTRY_ICON_SECONDARY)
+    gtk_entry_set_text (entry, "");
+}
+
+
+
 static void
 thunar_window_action_menubar_changed (GtkToggleAction *action,
                                       ThunarWindow    *window)
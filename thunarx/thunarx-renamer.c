@@ -73,6 +73,8 @@ static void     thunarx_renamer_real_save         (ThunarxRenamer         *renam
 static GList   *thunarx_renamer_real_get_actions  (ThunarxRenamer         *renamer,
                                                    GtkWindow              *window,
                                                    GList                  *files);
+static void     thunarx_renamer_real_prepare      (ThunarxRenamer         *renamer,
+                                                   GList                  *files);
 
 
 
@@ -110,6 +112,7 @@ thunarx_renamer_class_init (ThunarxRenamerClass *klass)
   klass->load = thunarx_renamer_real_load;
   klass->save = thunarx_renamer_real_save;
   klass->get_actions = thunarx_renamer_real_get_actions;
+  klass->prepare = thunarx_renamer_real_prepare;
 
   /**
    * ThunarxRenamer:help-url:
@@ -389,6 +392,15 @@ thunarx_renamer_real_get_actions (ThunarxRenamer *renamer,
 
 
 
+static void
+thunarx_renamer_real_prepare (ThunarxRenamer *renamer,
+                              GList          *files)
+{
+  /* nothing to prepare, derived classes may override this method */
+}
+
+
+
 /**
  * thunarx_renamer_get_help_url:
  * @renamer : a #ThunarxRenamer.
@@ -689,6 +701,33 @@ thunarx_renamer_get_actions (ThunarxRenamer *renamer,
 
 
 
+/**
+ * thunarx_renamer_prepare:
+ * @renamer : a #ThunarxRenamer.
+ * @files   : a #GList of #ThunarxFileInfo<!---->s.
+ *
+ * Tells @renamer that the @files were added to the bulk renamer
+ * dialog and thunarx_renamer_process() will be called for them
+ * soon. By default, this method does nothing, but derived classes
+ * may override this method to start loading expensive information
+ * about the @files (like tags stored in the files) in the background,
+ * so processing the files later on is fast.
+ *
+ * Implementations must not block, and must take a reference on the
+ * @files they keep using after this method returns.
+ *
+ * Since: 1.6.11
+ **/
+void
+thunarx_renamer_prepare (ThunarxRenamer *renamer,
+                         GList          *files)
+{
+  g_return_if_fail (THUNARX_IS_RENAMER (renamer));
+  (*THUNARX_RENAMER_GET_CLASS (renamer)->prepare) (renamer, files);
+}
+
+
+
 /**
  * thunarx_renamer_changed:
  * @renamer : a #ThunarxRenamer.
@@ -64,8 +64,10 @@ struct _ThunarxRenamerClass
                          GtkWindow       *window,
                          GList           *files);
 
+  void   (*prepare)     (ThunarxRenamer  *renamer,
+                         GList           *files);
+
   /*< private >*/
-  void (*reserved0) (void);
   void (*reserved1) (void);
   void (*reserved2) (void);
   void (*reserved3) (void);
@@ -114,6 +116,9 @@ GList       *thunarx_renamer_get_actions  (ThunarxRenamer   *renamer,
                                            GtkWindow        *window,
                                            GList            *files) G_GNUC_MALLOC;
 
+void         thunarx_renamer_prepare      (ThunarxRenamer   *renamer,
+                                           GList            *files);
+
 void         thunarx_renamer_changed      (ThunarxRenamer   *renamer);
 
 G_END_DECLS;